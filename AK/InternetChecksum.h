@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Assertions.h>
+#include <AK/Types.h>
+
+#ifdef __SSE2__
+#    include <emmintrin.h>
+#endif
+
+namespace AK {
+
+// Incremental RFC 1071 Internet checksum, as used by IPv4, ICMP, UDP and TCP.
+//
+// The ones' complement sum does not depend on byte order, so we add up whole
+// native 32-bit words and fold at the end. The folded value has the correct
+// in-memory layout for a header field, so callers never have to byte swap.
+// Only the last chunk passed to add() may have an odd length.
+class InternetChecksum {
+public:
+    InternetChecksum() { }
+
+    void add(const void* data, size_t size)
+    {
+        ASSERT(!m_has_odd_tail);
+        auto* bytes = (const u8*)data;
+
+#ifdef __SSE2__
+        if (size >= 64) {
+            auto zero = _mm_setzero_si128();
+            auto accumulator_a = zero;
+            auto accumulator_b = zero;
+            while (size >= 32) {
+                auto a = _mm_loadu_si128((const __m128i*)bytes);
+                auto b = _mm_loadu_si128((const __m128i*)(bytes + 16));
+                accumulator_a = _mm_add_epi64(accumulator_a, _mm_unpacklo_epi32(a, zero));
+                accumulator_b = _mm_add_epi64(accumulator_b, _mm_unpackhi_epi32(a, zero));
+                accumulator_a = _mm_add_epi64(accumulator_a, _mm_unpacklo_epi32(b, zero));
+                accumulator_b = _mm_add_epi64(accumulator_b, _mm_unpackhi_epi32(b, zero));
+                bytes += 32;
+                size -= 32;
+            }
+            u64 lanes[2];
+            _mm_storeu_si128((__m128i*)lanes, _mm_add_epi64(accumulator_a, accumulator_b));
+            m_sum += lanes[0];
+            m_sum += lanes[1];
+        }
+#endif
+
+        u64 sum = m_sum;
+        while (size >= 16) {
+            sum += load_u32(bytes);
+            sum += load_u32(bytes + 4);
+            sum += load_u32(bytes + 8);
+            sum += load_u32(bytes + 12);
+            bytes += 16;
+            size -= 16;
+        }
+        while (size >= 4) {
+            sum += load_u32(bytes);
+            bytes += 4;
+            size -= 4;
+        }
+        if (size >= 2) {
+            u16 word;
+            __builtin_memcpy(&word, bytes, sizeof(word));
+            sum += word;
+            bytes += 2;
+            size -= 2;
+        }
+        if (size) {
+            // The odd byte is padded with a zero byte on the right.
+            u16 word = 0;
+            __builtin_memcpy(&word, bytes, 1);
+            sum += word;
+            m_has_odd_tail = true;
+        }
+        m_sum = sum;
+    }
+
+    // The folded sum without the final inversion. This is what goes into the
+    // checksum field when the rest is summed by someone else (e.g. a NIC).
+    u16 partial() const
+    {
+        u64 sum = (m_sum & 0xffffffff) + (m_sum >> 32);
+        sum = (sum & 0xffffffff) + (sum >> 32);
+        u32 folded = (u32)sum;
+        folded = (folded & 0xffff) + (folded >> 16);
+        folded = (folded & 0xffff) + (folded >> 16);
+        return (u16)folded;
+    }
+
+    u16 finish() const { return ~partial(); }
+
+private:
+    ALWAYS_INLINE static u32 load_u32(const u8* bytes)
+    {
+        u32 word;
+        __builtin_memcpy(&word, bytes, sizeof(word));
+        return word;
+    }
+
+    u64 m_sum { 0 };
+    bool m_has_odd_tail { false };
+};
+
+}
+
+using AK::InternetChecksum;
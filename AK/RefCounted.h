@@ -72,6 +72,21 @@ public:
         ASSERT(!Checked<RefCountType>::addition_would_overflow(old_ref_count, 1));
     }
 
+    // Like ref(), but fails instead of resurrecting an object whose last
+    // reference is already gone. The caller must otherwise know that the
+    // object hasn't been freed yet.
+    [[nodiscard]] ALWAYS_INLINE bool try_ref() const
+    {
+        RefCountType expected = m_ref_count.load(AK::MemoryOrder::memory_order_relaxed);
+        for (;;) {
+            if (expected == 0)
+                return false;
+            ASSERT(!Checked<RefCountType>::addition_would_overflow(expected, 1));
+            if (m_ref_count.compare_exchange_strong(expected, expected + 1, AK::MemoryOrder::memory_order_acquire))
+                return true;
+        }
+    }
+
     ALWAYS_INLINE RefCountType ref_count() const
     {
         return m_ref_count;
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/TestSuite.h>
+
+#include <AK/InternetChecksum.h>
+
+// The straightforward byte-pair implementation the kernel used to have.
+static u16 reference_checksum(const u8* data, size_t size)
+{
+    u32 checksum = 0;
+    while (size > 1) {
+        checksum += (data[0] << 8) | data[1];
+        if (checksum & 0x80000000)
+            checksum = (checksum & 0xffff) | (checksum >> 16);
+        data += 2;
+        size -= 2;
+    }
+    if (size)
+        checksum += data[0] << 8;
+    while (checksum >> 16)
+        checksum = (checksum & 0xffff) + (checksum >> 16);
+    return ~checksum & 0xffff;
+}
+
+static u16 checksum_in_network_order(const u8* data, size_t size)
+{
+    InternetChecksum checksum;
+    checksum.add(data, size);
+    u16 value = checksum.finish();
+    auto* bytes = (const u8*)&value;
+    return (bytes[0] << 8) | bytes[1];
+}
+
+static void fill(u8* buffer, size_t size, u32 seed)
+{
+    for (size_t i = 0; i < size; ++i) {
+        seed = seed * 1103515245 + 12345;
+        buffer[i] = seed >> 16;
+    }
+}
+
+TEST_CASE(empty)
+{
+    InternetChecksum checksum;
+    EXPECT_EQ(checksum.finish(), 0xffff);
+}
+
+TEST_CASE(rfc1071_example)
+{
+    // Example from RFC 1071 section 3: the folded sum is 0xddf2.
+    const u8 data[] = { 0x00, 0x01, 0xf2, 0x03, 0xf4, 0xf5, 0xf6, 0xf7 };
+    EXPECT_EQ(checksum_in_network_order(data, sizeof(data)), 0xffff - 0xddf2);
+}
+
+TEST_CASE(matches_reference_for_all_sizes_and_alignments)
+{
+    u8 buffer[2048 + 16];
+    fill(buffer, sizeof(buffer), 42);
+    for (size_t offset = 0; offset < 8; ++offset) {
+        for (size_t size = 0; size <= 2048; size += (size < 128 ? 1 : 61)) {
+            EXPECT_EQ(checksum_in_network_order(buffer + offset, size), reference_checksum(buffer + offset, size));
+        }
+    }
+}
+
+TEST_CASE(all_ones_does_not_overflow)
+{
+    u8 buffer[65536];
+    __builtin_memset(buffer, 0xff, sizeof(buffer));
+    EXPECT_EQ(checksum_in_network_order(buffer, sizeof(buffer)), reference_checksum(buffer, sizeof(buffer)));
+}
+
+TEST_CASE(incremental)
+{
+    u8 buffer[1500];
+    fill(buffer, sizeof(buffer), 1234);
+    InternetChecksum checksum;
+    checksum.add(buffer, 12);
+    checksum.add(buffer + 12, 20);
+    checksum.add(buffer + 32, sizeof(buffer) - 32 - 1);
+    u16 incremental = checksum.finish();
+
+    InternetChecksum whole;
+    whole.add(buffer, sizeof(buffer) - 1);
+    EXPECT_EQ(incremental, whole.finish());
+}
+
+TEST_CASE(partial_can_be_completed_later)
+{
+    // A NIC doing checksum offload sums the payload including the seeded
+    // partial value, which must yield the same result as doing it all at once.
+    u8 buffer[1024];
+    fill(buffer, sizeof(buffer), 99);
+    InternetChecksum pseudo_header;
+    pseudo_header.add(buffer, 12);
+    u16 seed = pseudo_header.partial();
+
+    InternetChecksum offloaded;
+    offloaded.add(&seed, sizeof(seed));
+    offloaded.add(buffer + 12, sizeof(buffer) - 12);
+
+    InternetChecksum software;
+    software.add(buffer, sizeof(buffer));
+    EXPECT_EQ(offloaded.finish(), software.finish());
+}
+
+static u8 s_benchmark_buffer[1500];
+
+BENCHMARK_CASE(reference_1500_bytes)
+{
+    fill(s_benchmark_buffer, sizeof(s_benchmark_buffer), 7);
+    u32 accumulator = 0;
+    for (size_t i = 0; i < 200000; ++i) {
+        accumulator += reference_checksum(s_benchmark_buffer, sizeof(s_benchmark_buffer));
+        s_benchmark_buffer[i % sizeof(s_benchmark_buffer)]++;
+    }
+    EXPECT(accumulator != 1);
+}
+
+BENCHMARK_CASE(internet_checksum_1500_bytes)
+{
+    fill(s_benchmark_buffer, sizeof(s_benchmark_buffer), 7);
+    u32 accumulator = 0;
+    for (size_t i = 0; i < 200000; ++i) {
+        InternetChecksum checksum;
+        checksum.add(s_benchmark_buffer, sizeof(s_benchmark_buffer));
+        accumulator += checksum.finish();
+        s_benchmark_buffer[i % sizeof(s_benchmark_buffer)]++;
+    }
+    EXPECT(accumulator != 1);
+}
+
+TEST_MAIN(InternetChecksum)
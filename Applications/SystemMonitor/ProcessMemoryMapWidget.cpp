@@ -91,6 +91,8 @@ ProcessMemoryMapWidget::ProcessMemoryMapWidget()
             builder.append('S');
         if (object.get("stack").to_bool())
             builder.append('T');
+        if (object.get("large_pages").to_bool())
+            builder.append('L');
         return builder.to_string();
     });
     pid_vm_fields.empend("vmobject", "VMObject type", Gfx::TextAlignment::CenterLeft);
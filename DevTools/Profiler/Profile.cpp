@@ -27,13 +27,16 @@
 #include "Profile.h"
 #include "DisassemblyModel.h"
 #include "ProfileModel.h"
+#include <AK/HashMap.h>
 #include <AK/HashTable.h>
 #include <AK/MappedFile.h>
 #include <AK/QuickSort.h>
 #include <AK/RefPtr.h>
+#include <Kernel/API/Profiling.h>
 #include <LibCore/File.h>
 #include <LibELF/Loader.h>
 #include <stdio.h>
+#include <string.h>
 
 static void sort_profile_nodes(Vector<NonnullRefPtr<ProfileNode>>& nodes)
 {
@@ -45,8 +48,9 @@ static void sort_profile_nodes(Vector<NonnullRefPtr<ProfileNode>>& nodes)
         child->sort_children();
 }
 
-Profile::Profile(String executable_path, Vector<Event> events)
+Profile::Profile(String executable_path, Vector<Stack> stacks, Vector<Event> events)
     : m_executable_path(move(executable_path))
+    , m_stacks(move(stacks))
     , m_events(move(events))
 {
     m_first_timestamp = m_events.first().timestamp;
@@ -54,8 +58,8 @@ Profile::Profile(String executable_path, Vector<Event> events)
 
     m_model = ProfileModel::create(*this);
 
-    for (auto& event : m_events) {
-        m_deepest_stack_depth = max((u32)event.frames.size(), m_deepest_stack_depth);
+    for (auto& stack : m_stacks) {
+        m_deepest_stack_depth = max((u32)stack.frames.size(), m_deepest_stack_depth);
     }
 
     rebuild_tree();
@@ -87,8 +91,17 @@ void Profile::rebuild_tree()
         return new_root;
     };
 
-    HashTable<FlatPtr> live_allocations;
+    // Events with the same stack all take the same path through the tree,
+    // so count them up first and then walk each distinct stack only once.
+    Vector<u32> event_count_per_stack;
+    Vector<u64> first_timestamp_per_stack;
+    event_count_per_stack.resize(m_stacks.size());
+    first_timestamp_per_stack.resize(m_stacks.size());
+    for (size_t i = 0; i < m_stacks.size(); ++i)
+        event_count_per_stack[i] = 0;
 
+    // Only allocations that are still live at the end of the range are shown.
+    HashTable<FlatPtr> live_allocations;
     for (auto& event : m_events) {
         if (has_timestamp_filter_range()) {
             auto timestamp = event.timestamp;
@@ -96,9 +109,9 @@ void Profile::rebuild_tree()
                 continue;
         }
 
-        if (event.type == "malloc")
+        if (event.type == Event::Type::Malloc)
             live_allocations.set(event.ptr);
-        else if (event.type == "free")
+        else if (event.type == Event::Type::Free)
             live_allocations.remove(event.ptr);
     }
 
@@ -109,24 +122,36 @@ void Profile::rebuild_tree()
                 continue;
         }
 
-        if (event.type == "malloc" && !live_allocations.contains(event.ptr))
+        if (event.type == Event::Type::Malloc && !live_allocations.contains(event.ptr))
             continue;
 
-        if (event.type == "free")
+        if (event.type == Event::Type::Free)
             continue;
 
+        if (!event_count_per_stack[event.stack_index]++)
+            first_timestamp_per_stack[event.stack_index] = event.timestamp;
+        ++filtered_event_count;
+    }
+
+    for (size_t stack_index = 0; stack_index < m_stacks.size(); ++stack_index) {
+        u32 event_count = event_count_per_stack[stack_index];
+        if (!event_count)
+            continue;
+        auto& frames = m_stacks[stack_index].frames;
+        u64 timestamp = first_timestamp_per_stack[stack_index];
+
         ProfileNode* node = nullptr;
 
         auto for_each_frame = [&]<typename Callback>(Callback callback)
         {
             if (!m_inverted) {
-                for (size_t i = 0; i < event.frames.size(); ++i) {
-                    if (callback(event.frames.at(i), i == event.frames.size() - 1) == IterationDecision::Break)
+                for (size_t i = 0; i < frames.size(); ++i) {
+                    if (callback(frames.at(i), i == frames.size() - 1) == IterationDecision::Break)
                         break;
                 }
             } else {
-                for (ssize_t i = event.frames.size() - 1; i >= 0; --i) {
-                    if (callback(event.frames.at(i), static_cast<size_t>(i) == event.frames.size() - 1) == IterationDecision::Break)
+                for (ssize_t i = frames.size() - 1; i >= 0; --i) {
+                    if (callback(frames.at(i), static_cast<size_t>(i) == frames.size() - 1) == IterationDecision::Break)
                         break;
                 }
             }
@@ -141,19 +166,17 @@ void Profile::rebuild_tree()
                 return IterationDecision::Break;
 
             if (!node)
-                node = &find_or_create_root(symbol, address, offset, event.timestamp);
+                node = &find_or_create_root(symbol, address, offset, timestamp);
             else
-                node = &node->find_or_create_child(symbol, address, offset, event.timestamp);
+                node = &node->find_or_create_child(symbol, address, offset, timestamp);
 
-            node->increment_event_count();
+            node->increment_event_count(event_count);
             if (is_innermost_frame) {
-                node->add_event_address(address);
-                node->increment_self_count();
+                node->add_event_address(address, event_count);
+                node->increment_self_count(event_count);
             }
             return IterationDecision::Continue;
         });
-
-        ++filtered_event_count;
     }
 
     sort_profile_nodes(roots);
@@ -163,92 +186,223 @@ void Profile::rebuild_tree()
     m_model->update();
 }
 
-OwnPtr<Profile> Profile::load_from_perfcore_file(const StringView& path)
-{
-    auto file = Core::File::construct(path);
-    if (!file->open(Core::IODevice::ReadOnly)) {
-        fprintf(stderr, "Unable to open %s, error: %s\n", path.to_string().characters(), file->error_string());
-        return nullptr;
+// Reads the records of a perfcore file front to back, see Kernel/API/Profiling.h.
+class PerfcoreReader {
+public:
+    PerfcoreReader(const u8* data, size_t size)
+        : m_data(data)
+        , m_size(size)
+    {
     }
 
-    auto json = JsonValue::from_string(file->read_all());
-    ASSERT(json.has_value());
-    if (!json.value().is_object()) {
-        fprintf(stderr, "Invalid perfcore format (not a JSON object)\n");
-        return nullptr;
+    template<typename T>
+    bool read(T& value)
+    {
+        if (m_position + sizeof(T) > m_size)
+            return false;
+        memcpy(&value, m_data + m_position, sizeof(T));
+        m_position += sizeof(T);
+        return true;
     }
 
-    auto& object = json.value().as_object();
-    auto executable_path = object.get("executable").to_string();
+    const u8* read_bytes(size_t size)
+    {
+        if (m_position + size > m_size || m_position + size < m_position)
+            return nullptr;
+        auto* bytes = m_data + m_position;
+        m_position += size;
+        return bytes;
+    }
 
-    MappedFile elf_file(executable_path);
-    if (!elf_file.is_valid()) {
-        fprintf(stderr, "Unable to open executable '%s' for symbolication.\n", executable_path.characters());
-        return nullptr;
+    bool at_end() const { return m_position == m_size; }
+
+private:
+    const u8* m_data { nullptr };
+    size_t m_size { 0 };
+    size_t m_position { 0 };
+};
+
+// Symbolicates addresses in one executable, remembering the results since
+// the same return addresses show up in many different stacks.
+class Symbolicator {
+public:
+    explicit Symbolicator(const String& path)
+        : m_file(path)
+    {
+        if (m_file.is_valid())
+            m_loader = ELF::Loader::create(static_cast<const u8*>(m_file.data()), m_file.size());
     }
 
-    auto elf_loader = ELF::Loader::create(static_cast<const u8*>(elf_file.data()), elf_file.size());
+    Profile::Frame symbolicate(u32 address)
+    {
+        auto it = m_cache.find(address);
+        if (it != m_cache.end())
+            return it->value;
+        Profile::Frame frame { "??", address, 0 };
+        if (m_loader)
+            frame.symbol = m_loader->symbolicate(address, &frame.offset);
+        m_cache.set(address, frame);
+        return frame;
+    }
 
-    MappedFile kernel_elf_file("/boot/Kernel");
-    RefPtr<ELF::Loader> kernel_elf_loader;
-    if (kernel_elf_file.is_valid())
-        kernel_elf_loader = ELF::Loader::create(static_cast<const u8*>(kernel_elf_file.data()), kernel_elf_file.size());
+private:
+    MappedFile m_file;
+    RefPtr<ELF::Loader> m_loader;
+    HashMap<u32, Profile::Frame> m_cache;
+};
 
-    auto events_value = object.get("events");
-    if (!events_value.is_array())
-        return nullptr;
+OwnPtr<Profile> Profile::load_from_perfcore_file(const StringView& path)
+{
+    // Files in /proc are generated when read and can't be mapped.
+    MappedFile mapped_file;
+    ByteBuffer buffer;
+    const u8* data = nullptr;
+    size_t size = 0;
+    if (!path.starts_with("/proc/")) {
+        mapped_file = MappedFile(path);
+        if (!mapped_file.is_valid()) {
+            fprintf(stderr, "Unable to open %s\n", path.to_string().characters());
+            return nullptr;
+        }
+        data = static_cast<const u8*>(mapped_file.data());
+        size = mapped_file.size();
+    } else {
+        auto file = Core::File::construct(path);
+        if (!file->open(Core::IODevice::ReadOnly)) {
+            fprintf(stderr, "Unable to open %s, error: %s\n", path.to_string().characters(), file->error_string());
+            return nullptr;
+        }
+        buffer = file->read_all();
+        data = buffer.data();
+        size = buffer.size();
+    }
 
-    auto& perf_events = events_value.as_array();
-    if (perf_events.is_empty())
-        return nullptr;
+    PerfcoreReader reader(data, size);
 
-    Vector<Event> events;
+    ProfileHeader header;
+    if (!reader.read(header) || header.magic != PROFILE_MAGIC || header.version != PROFILE_VERSION) {
+        fprintf(stderr, "Invalid perfcore format (bad header)\n");
+        return nullptr;
+    }
 
-    for (auto& perf_event_value : perf_events.values()) {
-        auto& perf_event = perf_event_value.as_object();
+    Vector<String> strings;
+    HashMap<pid_t, u32> executable_string_id_by_pid;
+    HashMap<u32, OwnPtr<Symbolicator>> symbolicators_by_string_id;
+    Symbolicator kernel_symbolicator("/boot/Kernel");
+
+    auto symbolicator_for_pid = [&](pid_t pid) -> Symbolicator* {
+        auto string_id = executable_string_id_by_pid.get(pid);
+        if (!string_id.has_value())
+            return nullptr;
+        auto it = symbolicators_by_string_id.find(string_id.value());
+        if (it != symbolicators_by_string_id.end())
+            return it->value.ptr();
+        auto symbolicator = make<Symbolicator>(strings[string_id.value()]);
+        auto* symbolicator_ptr = symbolicator.ptr();
+        symbolicators_by_string_id.set(string_id.value(), move(symbolicator));
+        return symbolicator_ptr;
+    };
 
-        Event event;
+    Vector<Stack> stacks;
+    Vector<Event> events;
 
-        event.timestamp = perf_event.get("timestamp").to_number<u64>();
-        event.type = perf_event.get("type").to_string();
+    auto fail = [](const char* what) {
+        fprintf(stderr, "Invalid perfcore format (%s)\n", what);
+        return nullptr;
+    };
 
-        if (event.type == "malloc") {
-            event.ptr = perf_event.get("ptr").to_number<FlatPtr>();
-            event.size = perf_event.get("size").to_number<size_t>();
-        } else if (event.type == "free") {
-            event.ptr = perf_event.get("ptr").to_number<FlatPtr>();
+    while (!reader.at_end()) {
+        ProfileRecordType type;
+        if (!reader.read(type))
+            return fail("truncated record");
+
+        switch (type) {
+        case ProfileRecordType::String: {
+            ProfileStringRecord record;
+            if (!reader.read(record))
+                return fail("truncated string");
+            auto* characters = reader.read_bytes(record.length);
+            if (!characters)
+                return fail("truncated string");
+            strings.append(String((const char*)characters, record.length));
+            break;
         }
-
-        auto stack_array = perf_event.get("stack").as_array();
-        for (ssize_t i = stack_array.values().size() - 1; i >= 0; --i) {
-            auto& frame = stack_array.at(i);
-            auto ptr = frame.to_number<u32>();
-            u32 offset = 0;
-            String symbol;
-
-            if (ptr >= 0xc0000000) {
-                if (kernel_elf_loader) {
-                    symbol = kernel_elf_loader->symbolicate(ptr, &offset);
-                } else {
-                    symbol = "??";
-                }
-            } else {
-                symbol = elf_loader->symbolicate(ptr, &offset);
+        case ProfileRecordType::Process: {
+            ProfileProcessRecord record;
+            if (!reader.read(record) || record.executable_string_id >= strings.size())
+                return fail("bad process");
+            executable_string_id_by_pid.set(record.pid, record.executable_string_id);
+            break;
+        }
+        case ProfileRecordType::Stack: {
+            ProfileStackRecord record;
+            if (!reader.read(record))
+                return fail("truncated stack");
+            auto* frames = (const u8*)reader.read_bytes(record.frame_count * sizeof(u32));
+            if (!frames)
+                return fail("truncated stack");
+
+            auto* symbolicator = symbolicator_for_pid(record.pid);
+            Stack stack;
+            stack.frames.ensure_capacity(record.frame_count);
+            for (ssize_t i = record.frame_count - 1; i >= 0; --i) {
+                u32 address;
+                memcpy(&address, frames + i * sizeof(u32), sizeof(u32));
+                if (address >= 0xc0000000)
+                    stack.frames.append(kernel_symbolicator.symbolicate(address));
+                else if (symbolicator)
+                    stack.frames.append(symbolicator->symbolicate(address));
+                else
+                    stack.frames.append({ "??", address, 0 });
             }
-
-            event.frames.append({ symbol, ptr, offset });
+            if (!stack.frames.is_empty())
+                stack.in_kernel = stack.frames.last().address >= 0xc0000000;
+            stacks.append(move(stack));
+            break;
         }
+        case ProfileRecordType::Sample: {
+            ProfileSampleRecord record;
+            if (!reader.read(record) || record.stack_id >= stacks.size())
+                return fail("bad sample");
+            auto& stack = stacks[record.stack_id];
+            if (stack.frames.size() < 2)
+                break;
+            events.append({ Event::Type::Sample, record.timestamp, record.stack_id, stack.in_kernel });
+            break;
+        }
+        case ProfileRecordType::Malloc: {
+            ProfileMallocRecord record;
+            if (!reader.read(record) || record.stack_id >= stacks.size())
+                return fail("bad malloc");
+            auto& stack = stacks[record.stack_id];
+            if (stack.frames.size() < 2)
+                break;
+            events.append({ Event::Type::Malloc, record.timestamp, record.stack_id, stack.in_kernel, record.ptr, record.size });
+            break;
+        }
+        case ProfileRecordType::Free: {
+            ProfileFreeRecord record;
+            if (!reader.read(record) || record.stack_id >= stacks.size())
+                return fail("bad free");
+            events.append({ Event::Type::Free, record.timestamp, record.stack_id, stacks[record.stack_id].in_kernel, record.ptr, 0 });
+            break;
+        }
+        default:
+            return fail("unknown record type");
+        }
+    }
 
-        if (event.frames.size() < 2)
-            continue;
-
-        FlatPtr innermost_frame_address = event.frames.at(1).address;
-        event.in_kernel = innermost_frame_address >= 0xc0000000;
+    if (events.is_empty())
+        return nullptr;
 
-        events.append(move(event));
+    String executable_path;
+    if (header.pid != PROFILE_ALL_PROCESSES) {
+        auto string_id = executable_string_id_by_pid.get(header.pid);
+        if (string_id.has_value())
+            executable_path = strings[string_id.value()];
     }
 
-    return NonnullOwnPtr<Profile>(NonnullOwnPtr<Profile>::Adopt, *new Profile(executable_path, move(events)));
+    return NonnullOwnPtr<Profile>(NonnullOwnPtr<Profile>::Adopt, *new Profile(executable_path, move(stacks), move(events)));
 }
 
 void ProfileNode::sort_children()
@@ -80,19 +80,19 @@ public:
     ProfileNode* parent() { return m_parent; }
     const ProfileNode* parent() const { return m_parent; }
 
-    void increment_event_count() { ++m_event_count; }
-    void increment_self_count() { ++m_self_count; }
+    void increment_event_count(u32 count = 1) { m_event_count += count; }
+    void increment_self_count(u32 count = 1) { m_self_count += count; }
 
     void sort_children();
 
     const HashMap<FlatPtr, size_t>& events_per_address() const { return m_events_per_address; }
-    void add_event_address(FlatPtr address)
+    void add_event_address(FlatPtr address, size_t count = 1)
     {
         auto it = m_events_per_address.find(address);
         if (it == m_events_per_address.end())
-            m_events_per_address.set(address, 1);
+            m_events_per_address.set(address, count);
         else
-            m_events_per_address.set(address, it->value + 1);
+            m_events_per_address.set(address, it->value + count);
     }
 
 private:
@@ -133,18 +133,30 @@ public:
         u32 offset { 0 };
     };
 
+    // Frames are stored outermost first. Many events share the same stack.
+    struct Stack {
+        Vector<Frame> frames;
+        bool in_kernel { false };
+    };
+
     struct Event {
+        enum class Type : u8 {
+            Sample,
+            Malloc,
+            Free,
+        };
+        Type type { Type::Sample };
         u64 timestamp { 0 };
-        String type;
+        u32 stack_index { 0 };
+        bool in_kernel { false };
         FlatPtr ptr { 0 };
         size_t size { 0 };
-        bool in_kernel { false };
-        Vector<Frame> frames;
     };
 
     u32 filtered_event_count() const { return m_filtered_event_count; }
 
     const Vector<Event>& events() const { return m_events; }
+    const Stack& stack_of(const Event& event) const { return m_stacks[event.stack_index]; }
 
     u64 length_in_ms() const { return m_last_timestamp - m_first_timestamp; }
     u64 first_timestamp() const { return m_first_timestamp; }
@@ -164,7 +176,7 @@ public:
     const String& executable_path() const { return m_executable_path; }
 
 private:
-    Profile(String executable_path, Vector<Event>);
+    Profile(String executable_path, Vector<Stack>, Vector<Event>);
 
     void rebuild_tree();
 
@@ -180,6 +192,7 @@ private:
     u64 m_first_timestamp { 0 };
     u64 m_last_timestamp { 0 };
 
+    Vector<Stack> m_stacks;
     Vector<Event> m_events;
 
     bool m_has_timestamp_filter_range { false };
@@ -56,7 +56,7 @@ void ProfileTimelineWidget::paint_event(GUI::PaintEvent& event)
         int x = (int)((float)t * column_width);
         int cw = max(1, (int)column_width);
 
-        int column_height = frame_inner_rect().height() - (int)((float)event.frames.size() * frame_height);
+        int column_height = frame_inner_rect().height() - (int)((float)m_profile.stack_of(event).frames.size() * frame_height);
 
         bool in_kernel = event.in_kernel;
         Color color = in_kernel ? Color::from_rgb(0xc25e5a) : Color::from_rgb(0x5a65c2);
@@ -86,6 +86,9 @@ void Emulator::setup_stack(const Vector<String>& arguments)
         argv_entries.append(m_cpu.esp().value());
     }
 
+    m_cpu.push32(shadow_wrap_as_initialized<u32>(0)); // auxv_t auxv[] = { { AT_NULL, 0 } }
+    m_cpu.push32(shadow_wrap_as_initialized<u32>(0));
+
     m_cpu.push32(shadow_wrap_as_initialized<u32>(0)); // char** envp = { nullptr }
     u32 envp = m_cpu.esp().value();
 
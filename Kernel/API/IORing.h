@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+// The layout shared between the kernel and userspace for an I/O ring.
+//
+// io_ring_setup() returns a file descriptor that is mmap()ed (MAP_SHARED,
+// offset 0) with the size it reports. The mapping begins with an IORingHeader,
+// followed by the submission and completion arrays at the offsets it gives.
+//
+// Userspace fills in submissions at submission_tail and then advances it.
+// The kernel consumes from submission_head during io_ring_enter(). Completions
+// are produced by the kernel at completion_tail and consumed by userspace,
+// which advances completion_head. Each head/tail is a free-running counter;
+// index the arrays with (counter & mask). Completions that don't fit in the
+// completion queue are held by the kernel until there is room again.
+
+enum class IORingOpcode : u8 {
+    Nop,
+    Read,
+    Write,
+    Accept,
+    Connect,
+    RecvFrom,
+    SendTo,
+    Open,
+    Fsync,
+};
+
+struct IORingSubmission {
+    u64 user_data;
+    IORingOpcode opcode;
+    u8 reserved[3];
+    int fd;        // The target descriptor, or the dirfd for Open.
+    u32 flags;     // recvfrom/sendto flags, or the options for Open.
+    void* buffer;  // The data buffer, or the path for Open.
+    u32 length;    // The buffer length, or the path length for Open.
+    i32 offset;    // The file offset for Read/Write (-1 to use the current offset), or the mode for Open.
+    void* address; // The sockaddr for Accept, Connect, RecvFrom and SendTo.
+    u32 address_length;
+};
+
+struct IORingCompletion {
+    u64 user_data;
+    i32 result; // The return value of the equivalent syscall, or a negated errno.
+    u32 flags;  // For Accept and RecvFrom with an address: the peer address length.
+};
+
+struct IORingHeader {
+    u32 submission_head;
+    u32 submission_tail;
+    u32 submission_mask;
+    u32 completion_head;
+    u32 completion_tail;
+    u32 completion_mask;
+    u32 submissions_offset;
+    u32 completions_offset;
+};
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+// What read() on a file descriptor from watch_file() returns: as many whole
+// events as fit in the buffer. Each event is an InodeWatcherEvent followed by
+// `name_length` bytes of child name (not NUL-terminated), padded to a multiple
+// of 4 bytes.
+//
+// Events are coalesced while they wait to be read, so a batch describes the net
+// change since the last read(): duplicates are dropped, and a child that was
+// added and removed again in the meantime doesn't show up at all. If changes pile
+// up faster than they are read, everything queued is replaced by a single
+// QueueOverflowed event, after which the watcher should rescan what it watches.
+
+struct [[gnu::packed]] InodeWatcherEvent {
+    enum class Type : u32 {
+        Invalid = 0,
+        Modified,
+        ChildAdded,
+        ChildRemoved,
+        QueueOverflowed,
+    };
+
+    Type type { Type::Invalid };
+    u32 name_length { 0 };
+
+    size_t record_size() const { return sizeof(InodeWatcherEvent) + ((name_length + 3) & ~3); }
+    const char* name() const { return reinterpret_cast<const char*>(this + 1); }
+};
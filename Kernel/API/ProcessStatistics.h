@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+// The binary format returned by the get_process_statistics() syscall.
+//
+// The buffer starts with a ProcessStatisticsHeader followed by `process_count`
+// processes. Each process is a ProcessStatisticsRecord, then a
+// ProcessIdentityRecord if ProcessStatisticsIdentity is set in the record's
+// `fields`, then `thread_count` ThreadStatisticsRecords if threads were
+// requested.
+//
+// The identity of a process (its name, ids, tty, pledge and veil state) rarely
+// changes, so it is only included if it changed after `since_generation`.
+// Callers pass the `generation` from the previous header to get only what
+// changed; passing 0 always gets everything. Every live process gets a record,
+// so processes missing from the result have exited.
+
+#define PROCESS_STATISTICS_VERSION 1
+
+enum ProcessStatisticsFields : u32 {
+    ProcessStatisticsIdentity = 1 << 0,
+    ProcessStatisticsMemory = 1 << 1,
+    ProcessStatisticsThreads = 1 << 2,
+    ProcessStatisticsAll = ProcessStatisticsIdentity | ProcessStatisticsMemory | ProcessStatisticsThreads,
+};
+
+struct [[gnu::packed]] ProcessStatisticsHeader {
+    u32 version;
+    u32 generation;
+    u32 process_count;
+    u32 total_size;
+};
+
+struct [[gnu::packed]] ProcessStatisticsRecord {
+    i32 pid;
+    u32 fields;
+    u32 thread_count;
+    u32 nfds;
+    // Only filled in if ProcessStatisticsMemory was requested.
+    u32 amount_virtual;
+    u32 amount_resident;
+    u32 amount_dirty_private;
+    u32 amount_clean_inode;
+    u32 amount_shared;
+    u32 amount_purgeable_volatile;
+    u32 amount_purgeable_nonvolatile;
+};
+
+struct [[gnu::packed]] ProcessIdentityRecord {
+    i32 pgid;
+    i32 pgp;
+    i32 sid;
+    u32 uid;
+    u32 gid;
+    i32 ppid;
+    i32 icon_id;
+    char name[64];
+    char tty[32];
+    char pledge[256];
+    char veil[16];
+};
+
+struct [[gnu::packed]] ThreadStatisticsRecord {
+    i32 tid;
+    u32 times_scheduled;
+    u32 ticks;
+    u32 cpu;
+    u32 priority;
+    u32 effective_priority;
+    u32 syscall_count;
+    u32 inode_faults;
+    u32 zero_faults;
+    u32 cow_faults;
+    u32 file_read_bytes;
+    u32 file_write_bytes;
+    u32 unix_socket_read_bytes;
+    u32 unix_socket_write_bytes;
+    u32 ipv4_socket_read_bytes;
+    u32 ipv4_socket_write_bytes;
+    char state[32];
+    char name[64];
+};
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+// The binary format of /proc/profile and of the perfcore.<pid> files written
+// for processes that recorded events with perf_event() ("perfcore").
+//
+// The file starts with a ProfileHeader, followed by a stream of records until
+// the end of the file. Each record is a ProfileRecordType byte followed by the
+// matching record struct. Records only ever refer to records that came before
+// them, so a reader can consume the file in one pass and a writer never has to
+// go back. All values are little-endian.
+//
+// - String: `length` bytes follow (not NUL-terminated). Strings are numbered
+//   from 0 in the order they appear.
+// - Process: The executable of a pid, as a string id.
+// - Stack: A call stack seen in process `pid`. `frame_count` return addresses
+//   (u32) follow, innermost first. Stacks are numbered from 0 in the order they
+//   appear, and each distinct stack is written only once.
+// - Sample: One sample, referring to its call stack by id.
+// - Malloc, Free: An event recorded with perf_event(), with the call stack it
+//   was recorded from.
+
+#define PROFILE_MAGIC 0x46525050 // "PPRF"
+#define PROFILE_VERSION 2
+
+// Value of ProfileHeader::pid for a profile of the whole system.
+#define PROFILE_ALL_PROCESSES -1
+
+struct [[gnu::packed]] ProfileHeader {
+    u32 magic;
+    u32 version;
+    i32 pid;
+    u32 samples_per_second;
+};
+
+enum class ProfileRecordType : u8 {
+    String,
+    Process,
+    Stack,
+    Sample,
+    Malloc,
+    Free,
+};
+
+struct [[gnu::packed]] ProfileStringRecord {
+    u32 length;
+};
+
+struct [[gnu::packed]] ProfileProcessRecord {
+    i32 pid;
+    u32 executable_string_id;
+};
+
+struct [[gnu::packed]] ProfileStackRecord {
+    i32 pid;
+    u32 frame_count;
+};
+
+struct [[gnu::packed]] ProfileSampleRecord {
+    i32 tid;
+    u32 cpu;
+    u32 stack_id;
+    u64 timestamp;
+};
+
+struct [[gnu::packed]] ProfileMallocRecord {
+    i32 tid;
+    u32 stack_id;
+    u64 timestamp;
+    u32 ptr;
+    u32 size;
+};
+
+struct [[gnu::packed]] ProfileFreeRecord {
+    i32 tid;
+    u32 stack_id;
+    u64 timestamp;
+    u32 ptr;
+};
@@ -35,6 +35,8 @@
 constexpr int syscall_vector = 0x82;
 
 extern "C" {
+struct epoll_event;
+struct iovec;
 struct pollfd;
 struct timeval;
 struct timespec;
@@ -45,154 +47,168 @@ typedef u32 socklen_t;
 
 namespace Kernel {
 
-#define ENUMERATE_SYSCALLS                  \
-    __ENUMERATE_SYSCALL(sleep)              \
-    __ENUMERATE_SYSCALL(yield)              \
-    __ENUMERATE_SYSCALL(open)               \
-    __ENUMERATE_SYSCALL(close)              \
-    __ENUMERATE_SYSCALL(read)               \
-    __ENUMERATE_SYSCALL(lseek)              \
-    __ENUMERATE_SYSCALL(kill)               \
-    __ENUMERATE_SYSCALL(getuid)             \
-    __ENUMERATE_SYSCALL(exit)               \
-    __ENUMERATE_SYSCALL(geteuid)            \
-    __ENUMERATE_SYSCALL(getegid)            \
-    __ENUMERATE_SYSCALL(getgid)             \
-    __ENUMERATE_SYSCALL(getpid)             \
-    __ENUMERATE_SYSCALL(getppid)            \
-    __ENUMERATE_SYSCALL(getresuid)          \
-    __ENUMERATE_SYSCALL(getresgid)          \
-    __ENUMERATE_SYSCALL(waitid)             \
-    __ENUMERATE_SYSCALL(mmap)               \
-    __ENUMERATE_SYSCALL(munmap)             \
-    __ENUMERATE_SYSCALL(get_dir_entries)    \
-    __ENUMERATE_SYSCALL(getcwd)             \
-    __ENUMERATE_SYSCALL(gettimeofday)       \
-    __ENUMERATE_SYSCALL(gethostname)        \
-    __ENUMERATE_SYSCALL(sethostname)        \
-    __ENUMERATE_SYSCALL(chdir)              \
-    __ENUMERATE_SYSCALL(uname)              \
-    __ENUMERATE_SYSCALL(set_mmap_name)      \
-    __ENUMERATE_SYSCALL(readlink)           \
-    __ENUMERATE_SYSCALL(write)              \
-    __ENUMERATE_SYSCALL(ttyname_r)          \
-    __ENUMERATE_SYSCALL(stat)               \
-    __ENUMERATE_SYSCALL(getsid)             \
-    __ENUMERATE_SYSCALL(setsid)             \
-    __ENUMERATE_SYSCALL(getpgid)            \
-    __ENUMERATE_SYSCALL(setpgid)            \
-    __ENUMERATE_SYSCALL(getpgrp)            \
-    __ENUMERATE_SYSCALL(fork)               \
-    __ENUMERATE_SYSCALL(execve)             \
-    __ENUMERATE_SYSCALL(dup)                \
-    __ENUMERATE_SYSCALL(dup2)               \
-    __ENUMERATE_SYSCALL(sigaction)          \
-    __ENUMERATE_SYSCALL(umask)              \
-    __ENUMERATE_SYSCALL(getgroups)          \
-    __ENUMERATE_SYSCALL(setgroups)          \
-    __ENUMERATE_SYSCALL(sigreturn)          \
-    __ENUMERATE_SYSCALL(sigprocmask)        \
-    __ENUMERATE_SYSCALL(sigpending)         \
-    __ENUMERATE_SYSCALL(pipe)               \
-    __ENUMERATE_SYSCALL(killpg)             \
-    __ENUMERATE_SYSCALL(seteuid)            \
-    __ENUMERATE_SYSCALL(setegid)            \
-    __ENUMERATE_SYSCALL(setuid)             \
-    __ENUMERATE_SYSCALL(setgid)             \
-    __ENUMERATE_SYSCALL(setresuid)          \
-    __ENUMERATE_SYSCALL(setresgid)          \
-    __ENUMERATE_SYSCALL(alarm)              \
-    __ENUMERATE_SYSCALL(fstat)              \
-    __ENUMERATE_SYSCALL(access)             \
-    __ENUMERATE_SYSCALL(fcntl)              \
-    __ENUMERATE_SYSCALL(ioctl)              \
-    __ENUMERATE_SYSCALL(mkdir)              \
-    __ENUMERATE_SYSCALL(times)              \
-    __ENUMERATE_SYSCALL(utime)              \
-    __ENUMERATE_SYSCALL(sync)               \
-    __ENUMERATE_SYSCALL(ptsname_r)          \
-    __ENUMERATE_SYSCALL(select)             \
-    __ENUMERATE_SYSCALL(unlink)             \
-    __ENUMERATE_SYSCALL(poll)               \
-    __ENUMERATE_SYSCALL(rmdir)              \
-    __ENUMERATE_SYSCALL(chmod)              \
-    __ENUMERATE_SYSCALL(usleep)             \
-    __ENUMERATE_SYSCALL(socket)             \
-    __ENUMERATE_SYSCALL(bind)               \
-    __ENUMERATE_SYSCALL(accept)             \
-    __ENUMERATE_SYSCALL(listen)             \
-    __ENUMERATE_SYSCALL(connect)            \
-    __ENUMERATE_SYSCALL(shbuf_create)       \
-    __ENUMERATE_SYSCALL(shbuf_allow_pid)    \
-    __ENUMERATE_SYSCALL(shbuf_get)          \
-    __ENUMERATE_SYSCALL(shbuf_release)      \
-    __ENUMERATE_SYSCALL(link)               \
-    __ENUMERATE_SYSCALL(chown)              \
-    __ENUMERATE_SYSCALL(fchmod)             \
-    __ENUMERATE_SYSCALL(symlink)            \
-    __ENUMERATE_SYSCALL(shbuf_seal)         \
-    __ENUMERATE_SYSCALL(sendto)             \
-    __ENUMERATE_SYSCALL(recvfrom)           \
-    __ENUMERATE_SYSCALL(getsockopt)         \
-    __ENUMERATE_SYSCALL(setsockopt)         \
-    __ENUMERATE_SYSCALL(create_thread)      \
-    __ENUMERATE_SYSCALL(gettid)             \
-    __ENUMERATE_SYSCALL(donate)             \
-    __ENUMERATE_SYSCALL(rename)             \
-    __ENUMERATE_SYSCALL(ftruncate)          \
-    __ENUMERATE_SYSCALL(exit_thread)        \
-    __ENUMERATE_SYSCALL(mknod)              \
-    __ENUMERATE_SYSCALL(writev)             \
-    __ENUMERATE_SYSCALL(beep)               \
-    __ENUMERATE_SYSCALL(getsockname)        \
-    __ENUMERATE_SYSCALL(getpeername)        \
-    __ENUMERATE_SYSCALL(sched_setparam)     \
-    __ENUMERATE_SYSCALL(sched_getparam)     \
-    __ENUMERATE_SYSCALL(fchown)             \
-    __ENUMERATE_SYSCALL(halt)               \
-    __ENUMERATE_SYSCALL(reboot)             \
-    __ENUMERATE_SYSCALL(mount)              \
-    __ENUMERATE_SYSCALL(umount)             \
-    __ENUMERATE_SYSCALL(dump_backtrace)     \
-    __ENUMERATE_SYSCALL(dbgputch)           \
-    __ENUMERATE_SYSCALL(dbgputstr)          \
-    __ENUMERATE_SYSCALL(watch_file)         \
-    __ENUMERATE_SYSCALL(shbuf_allow_all)    \
-    __ENUMERATE_SYSCALL(set_process_icon)   \
-    __ENUMERATE_SYSCALL(mprotect)           \
-    __ENUMERATE_SYSCALL(realpath)           \
-    __ENUMERATE_SYSCALL(get_process_name)   \
-    __ENUMERATE_SYSCALL(fchdir)             \
-    __ENUMERATE_SYSCALL(getrandom)          \
-    __ENUMERATE_SYSCALL(setkeymap)          \
-    __ENUMERATE_SYSCALL(clock_gettime)      \
-    __ENUMERATE_SYSCALL(clock_settime)      \
-    __ENUMERATE_SYSCALL(clock_nanosleep)    \
-    __ENUMERATE_SYSCALL(join_thread)        \
-    __ENUMERATE_SYSCALL(module_load)        \
-    __ENUMERATE_SYSCALL(module_unload)      \
-    __ENUMERATE_SYSCALL(detach_thread)      \
-    __ENUMERATE_SYSCALL(set_thread_name)    \
-    __ENUMERATE_SYSCALL(get_thread_name)    \
-    __ENUMERATE_SYSCALL(madvise)            \
-    __ENUMERATE_SYSCALL(purge)              \
-    __ENUMERATE_SYSCALL(shbuf_set_volatile) \
-    __ENUMERATE_SYSCALL(profiling_enable)   \
-    __ENUMERATE_SYSCALL(profiling_disable)  \
-    __ENUMERATE_SYSCALL(futex)              \
-    __ENUMERATE_SYSCALL(set_thread_boost)   \
-    __ENUMERATE_SYSCALL(set_process_boost)  \
-    __ENUMERATE_SYSCALL(chroot)             \
-    __ENUMERATE_SYSCALL(pledge)             \
-    __ENUMERATE_SYSCALL(unveil)             \
-    __ENUMERATE_SYSCALL(perf_event)         \
-    __ENUMERATE_SYSCALL(shutdown)           \
-    __ENUMERATE_SYSCALL(get_stack_bounds)   \
-    __ENUMERATE_SYSCALL(ptrace)             \
-    __ENUMERATE_SYSCALL(minherit)           \
-    __ENUMERATE_SYSCALL(sendfd)             \
-    __ENUMERATE_SYSCALL(recvfd)             \
-    __ENUMERATE_SYSCALL(sysconf)
+#define ENUMERATE_SYSCALLS                      \
+    __ENUMERATE_SYSCALL(sleep)                  \
+    __ENUMERATE_SYSCALL(yield)                  \
+    __ENUMERATE_SYSCALL(open)                   \
+    __ENUMERATE_SYSCALL(close)                  \
+    __ENUMERATE_SYSCALL(read)                   \
+    __ENUMERATE_SYSCALL(lseek)                  \
+    __ENUMERATE_SYSCALL(kill)                   \
+    __ENUMERATE_SYSCALL(getuid)                 \
+    __ENUMERATE_SYSCALL(exit)                   \
+    __ENUMERATE_SYSCALL(geteuid)                \
+    __ENUMERATE_SYSCALL(getegid)                \
+    __ENUMERATE_SYSCALL(getgid)                 \
+    __ENUMERATE_SYSCALL(getpid)                 \
+    __ENUMERATE_SYSCALL(getppid)                \
+    __ENUMERATE_SYSCALL(getresuid)              \
+    __ENUMERATE_SYSCALL(getresgid)              \
+    __ENUMERATE_SYSCALL(waitid)                 \
+    __ENUMERATE_SYSCALL(mmap)                   \
+    __ENUMERATE_SYSCALL(munmap)                 \
+    __ENUMERATE_SYSCALL(get_dir_entries)        \
+    __ENUMERATE_SYSCALL(getcwd)                 \
+    __ENUMERATE_SYSCALL(gettimeofday)           \
+    __ENUMERATE_SYSCALL(gethostname)            \
+    __ENUMERATE_SYSCALL(sethostname)            \
+    __ENUMERATE_SYSCALL(chdir)                  \
+    __ENUMERATE_SYSCALL(uname)                  \
+    __ENUMERATE_SYSCALL(set_mmap_name)          \
+    __ENUMERATE_SYSCALL(readlink)               \
+    __ENUMERATE_SYSCALL(write)                  \
+    __ENUMERATE_SYSCALL(ttyname_r)              \
+    __ENUMERATE_SYSCALL(stat)                   \
+    __ENUMERATE_SYSCALL(getsid)                 \
+    __ENUMERATE_SYSCALL(setsid)                 \
+    __ENUMERATE_SYSCALL(getpgid)                \
+    __ENUMERATE_SYSCALL(setpgid)                \
+    __ENUMERATE_SYSCALL(getpgrp)                \
+    __ENUMERATE_SYSCALL(fork)                   \
+    __ENUMERATE_SYSCALL(execve)                 \
+    __ENUMERATE_SYSCALL(dup)                    \
+    __ENUMERATE_SYSCALL(dup2)                   \
+    __ENUMERATE_SYSCALL(sigaction)              \
+    __ENUMERATE_SYSCALL(umask)                  \
+    __ENUMERATE_SYSCALL(getgroups)              \
+    __ENUMERATE_SYSCALL(setgroups)              \
+    __ENUMERATE_SYSCALL(sigreturn)              \
+    __ENUMERATE_SYSCALL(sigprocmask)            \
+    __ENUMERATE_SYSCALL(sigpending)             \
+    __ENUMERATE_SYSCALL(pipe)                   \
+    __ENUMERATE_SYSCALL(killpg)                 \
+    __ENUMERATE_SYSCALL(seteuid)                \
+    __ENUMERATE_SYSCALL(setegid)                \
+    __ENUMERATE_SYSCALL(setuid)                 \
+    __ENUMERATE_SYSCALL(setgid)                 \
+    __ENUMERATE_SYSCALL(setresuid)              \
+    __ENUMERATE_SYSCALL(setresgid)              \
+    __ENUMERATE_SYSCALL(alarm)                  \
+    __ENUMERATE_SYSCALL(fstat)                  \
+    __ENUMERATE_SYSCALL(access)                 \
+    __ENUMERATE_SYSCALL(fcntl)                  \
+    __ENUMERATE_SYSCALL(ioctl)                  \
+    __ENUMERATE_SYSCALL(mkdir)                  \
+    __ENUMERATE_SYSCALL(times)                  \
+    __ENUMERATE_SYSCALL(utime)                  \
+    __ENUMERATE_SYSCALL(sync)                   \
+    __ENUMERATE_SYSCALL(ptsname_r)              \
+    __ENUMERATE_SYSCALL(select)                 \
+    __ENUMERATE_SYSCALL(unlink)                 \
+    __ENUMERATE_SYSCALL(poll)                   \
+    __ENUMERATE_SYSCALL(rmdir)                  \
+    __ENUMERATE_SYSCALL(chmod)                  \
+    __ENUMERATE_SYSCALL(usleep)                 \
+    __ENUMERATE_SYSCALL(socket)                 \
+    __ENUMERATE_SYSCALL(bind)                   \
+    __ENUMERATE_SYSCALL(accept)                 \
+    __ENUMERATE_SYSCALL(listen)                 \
+    __ENUMERATE_SYSCALL(connect)                \
+    __ENUMERATE_SYSCALL(shbuf_create)           \
+    __ENUMERATE_SYSCALL(shbuf_allow_pid)        \
+    __ENUMERATE_SYSCALL(shbuf_get)              \
+    __ENUMERATE_SYSCALL(shbuf_release)          \
+    __ENUMERATE_SYSCALL(link)                   \
+    __ENUMERATE_SYSCALL(chown)                  \
+    __ENUMERATE_SYSCALL(fchmod)                 \
+    __ENUMERATE_SYSCALL(symlink)                \
+    __ENUMERATE_SYSCALL(shbuf_seal)             \
+    __ENUMERATE_SYSCALL(sendto)                 \
+    __ENUMERATE_SYSCALL(recvfrom)               \
+    __ENUMERATE_SYSCALL(getsockopt)             \
+    __ENUMERATE_SYSCALL(setsockopt)             \
+    __ENUMERATE_SYSCALL(create_thread)          \
+    __ENUMERATE_SYSCALL(gettid)                 \
+    __ENUMERATE_SYSCALL(donate)                 \
+    __ENUMERATE_SYSCALL(rename)                 \
+    __ENUMERATE_SYSCALL(ftruncate)              \
+    __ENUMERATE_SYSCALL(exit_thread)            \
+    __ENUMERATE_SYSCALL(mknod)                  \
+    __ENUMERATE_SYSCALL(writev)                 \
+    __ENUMERATE_SYSCALL(beep)                   \
+    __ENUMERATE_SYSCALL(getsockname)            \
+    __ENUMERATE_SYSCALL(getpeername)            \
+    __ENUMERATE_SYSCALL(sched_setparam)         \
+    __ENUMERATE_SYSCALL(sched_getparam)         \
+    __ENUMERATE_SYSCALL(fchown)                 \
+    __ENUMERATE_SYSCALL(halt)                   \
+    __ENUMERATE_SYSCALL(reboot)                 \
+    __ENUMERATE_SYSCALL(mount)                  \
+    __ENUMERATE_SYSCALL(umount)                 \
+    __ENUMERATE_SYSCALL(dump_backtrace)         \
+    __ENUMERATE_SYSCALL(dbgputch)               \
+    __ENUMERATE_SYSCALL(dbgputstr)              \
+    __ENUMERATE_SYSCALL(watch_file)             \
+    __ENUMERATE_SYSCALL(shbuf_allow_all)        \
+    __ENUMERATE_SYSCALL(set_process_icon)       \
+    __ENUMERATE_SYSCALL(mprotect)               \
+    __ENUMERATE_SYSCALL(realpath)               \
+    __ENUMERATE_SYSCALL(get_process_name)       \
+    __ENUMERATE_SYSCALL(fchdir)                 \
+    __ENUMERATE_SYSCALL(getrandom)              \
+    __ENUMERATE_SYSCALL(setkeymap)              \
+    __ENUMERATE_SYSCALL(clock_gettime)          \
+    __ENUMERATE_SYSCALL(clock_settime)          \
+    __ENUMERATE_SYSCALL(clock_nanosleep)        \
+    __ENUMERATE_SYSCALL(join_thread)            \
+    __ENUMERATE_SYSCALL(module_load)            \
+    __ENUMERATE_SYSCALL(module_unload)          \
+    __ENUMERATE_SYSCALL(detach_thread)          \
+    __ENUMERATE_SYSCALL(set_thread_name)        \
+    __ENUMERATE_SYSCALL(get_thread_name)        \
+    __ENUMERATE_SYSCALL(madvise)                \
+    __ENUMERATE_SYSCALL(purge)                  \
+    __ENUMERATE_SYSCALL(shbuf_set_volatile)     \
+    __ENUMERATE_SYSCALL(profiling_enable)       \
+    __ENUMERATE_SYSCALL(profiling_disable)      \
+    __ENUMERATE_SYSCALL(futex)                  \
+    __ENUMERATE_SYSCALL(set_thread_boost)       \
+    __ENUMERATE_SYSCALL(set_process_boost)      \
+    __ENUMERATE_SYSCALL(chroot)                 \
+    __ENUMERATE_SYSCALL(pledge)                 \
+    __ENUMERATE_SYSCALL(unveil)                 \
+    __ENUMERATE_SYSCALL(perf_event)             \
+    __ENUMERATE_SYSCALL(shutdown)               \
+    __ENUMERATE_SYSCALL(get_stack_bounds)       \
+    __ENUMERATE_SYSCALL(ptrace)                 \
+    __ENUMERATE_SYSCALL(minherit)               \
+    __ENUMERATE_SYSCALL(sendfd)                 \
+    __ENUMERATE_SYSCALL(recvfd)                 \
+    __ENUMERATE_SYSCALL(sysconf)                \
+    __ENUMERATE_SYSCALL(epoll_create)           \
+    __ENUMERATE_SYSCALL(epoll_ctl)              \
+    __ENUMERATE_SYSCALL(epoll_wait)             \
+    __ENUMERATE_SYSCALL(readv)                  \
+    __ENUMERATE_SYSCALL(pread)                  \
+    __ENUMERATE_SYSCALL(pwrite)                 \
+    __ENUMERATE_SYSCALL(preadv)                 \
+    __ENUMERATE_SYSCALL(pwritev)                \
+    __ENUMERATE_SYSCALL(sendfile)               \
+    __ENUMERATE_SYSCALL(io_ring_setup)          \
+    __ENUMERATE_SYSCALL(io_ring_enter)          \
+    __ENUMERATE_SYSCALL(posix_spawn)            \
+    __ENUMERATE_SYSCALL(get_process_statistics) \
+    __ENUMERATE_SYSCALL(watch_memory_pressure)
 
 namespace Syscall {
 
@@ -284,6 +300,54 @@ struct SC_poll_params {
     const u32* sigmask;
 };
 
+struct SC_pread_params {
+    int fd;
+    MutableBufferArgument<void, size_t> buffer;
+    ssize_t offset;
+};
+
+struct SC_pwrite_params {
+    int fd;
+    ImmutableBufferArgument<void, size_t> data;
+    ssize_t offset;
+};
+
+struct SC_preadv_params {
+    int fd;
+    const struct iovec* iov;
+    int iov_count;
+    ssize_t offset;
+};
+
+struct SC_pwritev_params {
+    int fd;
+    const struct iovec* iov;
+    int iov_count;
+    ssize_t offset;
+};
+
+struct SC_sendfile_params {
+    int out_fd;
+    int in_fd;
+    ssize_t* offset;
+    size_t count;
+};
+
+struct SC_epoll_ctl_params {
+    int epoll_fd;
+    int op;
+    int fd;
+    const struct epoll_event* event;
+};
+
+struct SC_epoll_wait_params {
+    int epoll_fd;
+    struct epoll_event* events;
+    int max_events;
+    const struct timespec* timeout;
+    const u32* sigmask;
+};
+
 struct SC_clock_nanosleep_params {
     int clock_id;
     int flags;
@@ -340,6 +404,9 @@ struct SC_futex_params {
     int futex_op;
     i32 val;
     const timespec* timeout;
+    i32* userspace_address2;
+    i32 val2;
+    i32 val3;
 };
 
 struct SC_setkeymap_params {
@@ -380,6 +447,41 @@ struct SC_execve_params {
     StringListArgument environment;
 };
 
+enum class SpawnFileActionType : u32 {
+    Open,
+    Close,
+    Dup2,
+    Chdir,
+    Fchdir,
+};
+
+struct SC_posix_spawn_file_action {
+    SpawnFileActionType type;
+    int fd;
+    int new_fd;
+    int options;
+    u16 mode;
+    StringArgument path;
+};
+
+struct SC_posix_spawn_params {
+    StringArgument path;
+    StringListArgument arguments;
+    StringListArgument environment;
+    const SC_posix_spawn_file_action* file_actions;
+    size_t file_action_count;
+    short flags;
+    pid_t pgroup;
+    int sched_priority;
+    u32 sigmask;
+};
+
+struct SC_get_process_statistics_params {
+    u32 since_generation;
+    u32 fields;
+    MutableBufferArgument<void, size_t> buffer;
+};
+
 struct SC_readlink_params {
     StringArgument path;
     MutableBufferArgument<char, size_t> buffer;
@@ -457,13 +559,34 @@ struct SC_ptrace_peek_params {
 void initialize();
 int sync();
 
+#ifdef KERNEL
+constexpr size_t latency_histogram_bucket_count = 20;
+
+struct Statistics {
+    u32 call_count { 0 };
+    u64 total_cycles { 0 };
+    u32 latency_histogram[latency_histogram_bucket_count] {};
+};
+
+Statistics statistics(Function);
+
+// The address of the userspace SYSENTER stub, or 0 if it's not in use.
+FlatPtr fast_syscall_entry();
+#endif
+
+#ifndef KERNEL
+// Points at LibC's `int 0x82` stub, or at the SYSENTER stub if the kernel
+// offers one through AT_SYSINFO. Both take the syscall number and arguments
+// in the same registers, and either may clobber %ecx and %edx.
+extern "C" FlatPtr __syscall_entry;
+
 inline u32 invoke(Function function)
 {
     u32 result;
-    asm volatile("int $0x82"
+    asm volatile("call *%[entry]"
                  : "=a"(result)
-                 : "a"(function)
-                 : "memory");
+                 : "a"(function), [entry] "m"(__syscall_entry)
+                 : "ecx", "edx", "memory");
     return result;
 }
 
@@ -471,10 +594,11 @@ template<typename T1>
 inline u32 invoke(Function function, T1 arg1)
 {
     u32 result;
-    asm volatile("int $0x82"
-                 : "=a"(result)
-                 : "a"(function), "d"((u32)arg1)
-                 : "memory");
+    u32 edx = (u32)arg1;
+    asm volatile("call *%[entry]"
+                 : "=a"(result), "+d"(edx)
+                 : "a"(function), [entry] "m"(__syscall_entry)
+                 : "ecx", "memory");
     return result;
 }
 
@@ -482,9 +606,11 @@ template<typename T1, typename T2>
 inline u32 invoke(Function function, T1 arg1, T2 arg2)
 {
     u32 result;
-    asm volatile("int $0x82"
-                 : "=a"(result)
-                 : "a"(function), "d"((u32)arg1), "c"((u32)arg2)
+    u32 edx = (u32)arg1;
+    u32 ecx = (u32)arg2;
+    asm volatile("call *%[entry]"
+                 : "=a"(result), "+d"(edx), "+c"(ecx)
+                 : "a"(function), [entry] "m"(__syscall_entry)
                  : "memory");
     return result;
 }
@@ -493,13 +619,16 @@ template<typename T1, typename T2, typename T3>
 inline u32 invoke(Function function, T1 arg1, T2 arg2, T3 arg3)
 {
     u32 result;
-    asm volatile("int $0x82"
-                 : "=a"(result)
-                 : "a"(function), "d"((u32)arg1), "c"((u32)arg2), "b"((u32)arg3)
+    u32 edx = (u32)arg1;
+    u32 ecx = (u32)arg2;
+    asm volatile("call *%[entry]"
+                 : "=a"(result), "+d"(edx), "+c"(ecx)
+                 : "a"(function), "b"((u32)arg3), [entry] "m"(__syscall_entry)
                  : "memory");
     return result;
 }
 #endif
+#endif
 
 }
 
@@ -58,7 +58,10 @@ static Descriptor s_idt[256];
 
 static GenericInterruptHandler* s_interrupt_handler[GENERIC_INTERRUPT_HANDLERS_COUNT];
 
+bool g_cpu_supports_erms;
+
 extern "C" void handle_interrupt(TrapFrame*);
+extern "C" void fast_syscall_asm_entry();
 
 #define EH_ENTRY(ec, title)                         \
     extern "C" void title##_asm_entry();            \
@@ -714,6 +717,12 @@ u32 read_cr3()
 
 void write_cr3(u32 cr3)
 {
+    // NOTE: Publish the address space we're switching to before loading it.
+    //       A TLB shootdown that doesn't see us using it yet will have made
+    //       its page table changes visible by the time we walk them, since
+    //       the CR3 write is serializing.
+    if (Processor::is_initialized())
+        Processor::current().set_active_cr3(cr3);
     asm volatile("movl %%eax, %%cr3" ::"a"(cr3)
                  : "memory");
 }
@@ -739,6 +748,7 @@ FPUState Processor::s_clean_fpu_state;
 static Vector<Processor*>* s_processors;
 static SpinLock s_processor_lock;
 volatile u32 Processor::g_total_processors;
+TLBShootdownStatistics Processor::s_tlb_shootdown_statistics;
 static volatile bool s_smp_enabled;
 
 Vector<Processor*>& Processor::processors()
@@ -812,6 +822,8 @@ void Processor::cpu_detect()
         set_feature(CPUFeature::UMIP);
     if (extended_features.ebx() & (1 << 18))
         set_feature(CPUFeature::RDSEED);
+    if (extended_features.ebx() & (1 << 9))
+        set_feature(CPUFeature::ERMS);
 }
 
 void Processor::cpu_setup()
@@ -821,6 +833,11 @@ void Processor::cpu_setup()
     //       initialized yet!
     cpu_detect();
 
+    if (m_cpu == 0)
+        g_cpu_supports_erms = has_feature(CPUFeature::ERMS);
+    else if (!has_feature(CPUFeature::ERMS))
+        g_cpu_supports_erms = false;
+
     if (has_feature(CPUFeature::SSE))
         sse_init();
 
@@ -909,6 +926,8 @@ String Processor::features_string() const
                     return "sep";
                 case CPUFeature::SYSCALL:
                     return "syscall";
+                case CPUFeature::ERMS:
+                    return "erms";
                 // no default statement here intentionally so that we get
                 // a warning if a new feature is forgotten to be added here
             }
@@ -941,6 +960,7 @@ void Processor::early_initialize(u32 cpu)
     m_scheduler_initialized = false;
 
     m_message_queue = nullptr;
+    m_active_cr3 = read_cr3();
     m_idle_thread = nullptr;
     m_current_thread = nullptr;
     m_mm_data = nullptr;
@@ -973,6 +993,12 @@ void Processor::initialize(u32 cpu)
     else
         flush_idt();
 
+    if (has_feature(CPUFeature::SEP)) {
+        // The stack pointer is per-thread, see enter_thread_context().
+        MSR(MSR_IA32_SYSENTER_CS).set(GDT_SELECTOR_CODE0, 0);
+        MSR(MSR_IA32_SYSENTER_EIP).set((FlatPtr)fast_syscall_asm_entry, 0);
+    }
+
     if (cpu == 0) {
         ASSERT((FlatPtr(&s_clean_fpu_state) & 0xF) == 0);
         asm volatile("fninit");
@@ -1102,6 +1128,11 @@ extern "C" void enter_thread_context(Thread* from_thread, Thread* to_thread)
     if (from_tss.cr3 != to_tss.cr3)
         write_cr3(to_tss.cr3);
 
+    // SYSENTER lands directly on top of the kernel stack of whichever
+    // thread is running, just like an interrupt from userspace would.
+    if (processor.has_feature(CPUFeature::SEP))
+        MSR(MSR_IA32_SYSENTER_ESP).set(to_tss.esp0, 0);
+
     to_thread->set_cpu(processor.id());
 
     asm volatile("fxrstor %0"
@@ -1436,6 +1467,13 @@ void Processor::check_invoke_scheduler()
 
 void Processor::flush_tlb_local(VirtualAddress vaddr, size_t page_count)
 {
+    // Kernel mappings are global and survive a CR3 reload, so those always
+    // have to be invalidated one by one.
+    if (page_count > tlb_full_flush_threshold && is_user_range(vaddr, page_count * PAGE_SIZE)) {
+        atomic_fetch_add(&s_tlb_shootdown_statistics.full_flushes, 1u, AK::MemoryOrder::memory_order_relaxed);
+        flush_entire_tlb_local();
+        return;
+    }
     auto ptr = vaddr.as_ptr();
     while (page_count > 0) {
         asm volatile("invlpg %0"
@@ -1447,11 +1485,28 @@ void Processor::flush_tlb_local(VirtualAddress vaddr, size_t page_count)
     }
 }
 
-void Processor::flush_tlb(VirtualAddress vaddr, size_t page_count)
+void Processor::flush_tlb(const PageDirectory* page_directory, VirtualAddress vaddr, size_t page_count)
 {
     flush_tlb_local(vaddr, page_count);
     if (s_smp_enabled)
-        smp_broadcast_flush_tlb(vaddr, page_count);
+        smp_broadcast_flush_tlb(page_directory, vaddr, page_count);
+}
+
+TLBShootdownStatistics Processor::tlb_shootdown_statistics()
+{
+    auto& stats = s_tlb_shootdown_statistics;
+    TLBShootdownStatistics snapshot;
+    snapshot.shootdowns = atomic_load(&stats.shootdowns, AK::MemoryOrder::memory_order_relaxed);
+    snapshot.ipis_sent = atomic_load(&stats.ipis_sent, AK::MemoryOrder::memory_order_relaxed);
+    snapshot.cpus_skipped = atomic_load(&stats.cpus_skipped, AK::MemoryOrder::memory_order_relaxed);
+    snapshot.full_flushes = atomic_load(&stats.full_flushes, AK::MemoryOrder::memory_order_relaxed);
+    snapshot.batched_flushes = atomic_load(&stats.batched_flushes, AK::MemoryOrder::memory_order_relaxed);
+    return snapshot;
+}
+
+void Processor::did_batch_tlb_flush()
+{
+    atomic_fetch_add(&s_tlb_shootdown_statistics.batched_flushes, 1u, AK::MemoryOrder::memory_order_relaxed);
 }
 
 static volatile ProcessorMessage* s_message_pool;
@@ -1663,13 +1718,78 @@ void Processor::smp_broadcast(void(*callback)(), bool async)
     smp_broadcast_message(msg, async);
 }
 
-void Processor::smp_broadcast_flush_tlb(VirtualAddress vaddr, size_t page_count)
+void Processor::smp_multicast_message(ProcessorMessage& msg, u32 cpu_mask, bool async)
+{
+    auto& cur_proc = Processor::current();
+    ASSERT(!(cpu_mask & (1u << cur_proc.id())));
+    msg.async = async;
+    atomic_store(&msg.refs, (u32)__builtin_popcount(cpu_mask), AK::MemoryOrder::memory_order_release);
+    ASSERT(msg.refs > 0);
+    for_each(
+        [&](Processor& proc) -> IterationDecision
+        {
+            if (!(cpu_mask & (1u << proc.id())))
+                return IterationDecision::Continue;
+            // If the queue wasn't empty, whoever queued the first message has
+            // already sent an IPI, and the target will process ours with it.
+            if (proc.smp_queue_message(msg)) {
+                APIC::the().send_ipi(proc.id());
+                atomic_fetch_add(&s_tlb_shootdown_statistics.ipis_sent, 1u, AK::MemoryOrder::memory_order_relaxed);
+            }
+            return IterationDecision::Continue;
+        });
+
+    if (!async) {
+        while (atomic_load(&msg.refs, AK::MemoryOrder::memory_order_consume) != 0) {
+            // TODO: pause for a bit?
+        }
+
+        smp_cleanup_message(msg);
+        smp_return_to_pool(msg);
+    }
+}
+
+void Processor::smp_broadcast_flush_tlb(const PageDirectory* page_directory, VirtualAddress vaddr, size_t page_count)
 {
+    if (!s_smp_enabled)
+        return;
+    ScopedCritical critical;
+    auto& cur_proc = Processor::current();
+
+    // Kernel mappings are shared by every address space. For user mappings,
+    // only processors currently running the address space can have cached
+    // them; everybody else will start from a clean TLB when they switch to it.
+    bool flush_everywhere = !page_directory || !is_user_range(vaddr, page_count * PAGE_SIZE);
+
+    // Order our page table updates before looking at which address spaces
+    // the other processors are using. See write_cr3().
+    atomic_thread_fence(AK::MemoryOrder::memory_order_seq_cst);
+
+    u32 cpu_mask = 0;
+    u32 skipped_count = 0;
+    for_each(
+        [&](Processor& proc) -> IterationDecision
+        {
+            if (&proc == &cur_proc)
+                return IterationDecision::Continue;
+            if (flush_everywhere || atomic_load(&proc.m_active_cr3, AK::MemoryOrder::memory_order_relaxed) == page_directory->cr3())
+                cpu_mask |= 1u << proc.id();
+            else
+                ++skipped_count;
+            return IterationDecision::Continue;
+        });
+
+    if (skipped_count)
+        atomic_fetch_add(&s_tlb_shootdown_statistics.cpus_skipped, skipped_count, AK::MemoryOrder::memory_order_relaxed);
+    if (!cpu_mask)
+        return;
+
+    atomic_fetch_add(&s_tlb_shootdown_statistics.shootdowns, 1u, AK::MemoryOrder::memory_order_relaxed);
     auto& msg = smp_get_from_pool();
     msg.type = ProcessorMessage::FlushTlb;
     msg.flush_tlb.ptr = vaddr.as_ptr();
     msg.flush_tlb.page_count = page_count;
-    smp_broadcast_message(msg, false);
+    smp_multicast_message(msg, cpu_mask, false);
 }
 
 void Processor::smp_broadcast_halt()
@@ -34,6 +34,8 @@
 #include <Kernel/VirtualAddress.h>
 
 #define PAGE_SIZE 4096
+// NOTE: With PAE enabled, a page directory entry with the PS bit set maps 2 MiB.
+#define LARGE_PAGE_SIZE (2 * MB)
 #define GENERIC_INTERRUPT_HANDLERS_COUNT (256 - IRQ_VECTOR_BASE)
 #define PAGE_MASK ((FlatPtr)0xfffff000u)
 
@@ -140,6 +142,13 @@ public:
         m_raw |= value & 0xfffff000;
     }
 
+    u32 large_page_base() const { return m_raw & 0xffe00000u; }
+    void set_large_page_base(u32 value)
+    {
+        m_raw &= 0x8000000000001fffULL;
+        m_raw |= value & 0xffe00000;
+    }
+
     void clear() { m_raw = 0; }
 
     u64 raw() const { return m_raw; }
@@ -209,6 +218,7 @@ public:
         UserSupervisor = 1 << 2,
         WriteThrough = 1 << 3,
         CacheDisabled = 1 << 4,
+        Accessed = 1 << 5,
         Global = 1 << 8,
         NoExecute = 0x8000000000000000ULL,
     };
@@ -228,6 +238,9 @@ public:
     bool is_cache_disabled() const { return raw() & CacheDisabled; }
     void set_cache_disabled(bool b) { set_bit(CacheDisabled, b); }
 
+    bool is_accessed() const { return raw() & Accessed; }
+    void set_accessed(bool b) { set_bit(Accessed, b); }
+
     bool is_global() const { return raw() & Global; }
     void set_global(bool b) { set_bit(Global, b); }
 
@@ -601,12 +614,25 @@ enum class CPUFeature : u32 {
     TSC = (1 << 8),
     UMIP = (1 << 9),
     SEP = (1 << 10),
-    SYSCALL = (1 << 11)
+    SYSCALL = (1 << 11),
+    ERMS = (1 << 12)
 };
 
+// Set during early CPU setup if every processor supports enhanced "rep movsb/stosb".
+// memcpy() and memset() read this directly since they run before Processor::current() is usable.
+extern bool g_cpu_supports_erms;
+
 class Thread;
 struct TrapFrame;
 
+struct TLBShootdownStatistics {
+    u32 shootdowns { 0 };
+    u32 ipis_sent { 0 };
+    u32 cpus_skipped { 0 };
+    u32 full_flushes { 0 };
+    u32 batched_flushes { 0 };
+};
+
 #define GDT_SELECTOR_CODE0 0x08
 #define GDT_SELECTOR_DATA0 0x10
 #define GDT_SELECTOR_CODE3 0x18
@@ -687,6 +713,8 @@ class Processor {
     Thread* m_idle_thread;
 
     volatile ProcessorMessageEntry* m_message_queue; // atomic, LIFO
+    volatile u32 m_active_cr3; // atomic
+    static TLBShootdownStatistics s_tlb_shootdown_statistics; // atomic
 
     bool m_invoke_scheduler_async;
     bool m_scheduler_initialized;
@@ -702,6 +730,7 @@ class Processor {
     static void smp_cleanup_message(ProcessorMessage& msg);
     bool smp_queue_message(ProcessorMessage& msg);
     static void smp_broadcast_message(ProcessorMessage& msg, bool async);
+    static void smp_multicast_message(ProcessorMessage& msg, u32 cpu_mask, bool async);
     static void smp_broadcast_halt();
 
     void cpu_detect();
@@ -735,8 +764,19 @@ public:
         write_cr3(read_cr3());
     }
 
+    // Past this many pages, reloading CR3 is cheaper than invalidating page by page.
+    static constexpr size_t tlb_full_flush_threshold = 64;
+
     static void flush_tlb_local(VirtualAddress vaddr, size_t page_count);
-    static void flush_tlb(VirtualAddress vaddr, size_t page_count);
+    static void flush_tlb(const PageDirectory*, VirtualAddress vaddr, size_t page_count);
+
+    ALWAYS_INLINE void set_active_cr3(u32 cr3)
+    {
+        atomic_store(&m_active_cr3, cr3, AK::MemoryOrder::memory_order_relaxed);
+    }
+
+    static TLBShootdownStatistics tlb_shootdown_statistics();
+    static void did_batch_tlb_flush();
 
     Descriptor& get_gdt_entry(u16 selector);
     void flush_gdt();
@@ -891,7 +931,7 @@ public:
     }
     static void smp_broadcast(void (*callback)(), bool async);
     static void smp_broadcast(void (*callback)(void*), void* data, void (*free_data)(void*), bool async);
-    static void smp_broadcast_flush_tlb(VirtualAddress vaddr, size_t page_count);
+    static void smp_broadcast_flush_tlb(const PageDirectory*, VirtualAddress vaddr, size_t page_count);
 
     ALWAYS_INLINE bool has_feature(CPUFeature f) const
     {
@@ -978,6 +1018,10 @@ extern "C" void enter_trap_no_irq(TrapFrame*);
 extern "C" void enter_trap(TrapFrame*);
 extern "C" void exit_trap(TrapFrame*);
 
+#define MSR_IA32_SYSENTER_CS 0x174
+#define MSR_IA32_SYSENTER_ESP 0x175
+#define MSR_IA32_SYSENTER_EIP 0x176
+
 class MSR {
     uint32_t m_msr;
 
@@ -82,8 +82,10 @@ void PS2MouseDevice::handle_irq(const RegisterState&)
             IO::in8(I8042_BUFFER);
             auto packet = backdoor->receive_mouse_packet();
             m_entropy_source.add_random_event(packet);
-            if (packet.has_value())
+            if (packet.has_value()) {
                 m_queue.enqueue(packet.value());
+                did_change_readiness();
+            }
             return;
         }
     }
@@ -169,6 +171,7 @@ void PS2MouseDevice::parse_data_packet()
     dbg() << "Mouse: X " << packet.x << ", Y " << packet.y << ", Z " << packet.z;
 #endif
     m_queue.enqueue(packet);
+    did_change_readiness();
 }
 
 void PS2MouseDevice::wait_then_write(u8 port, u8 data)
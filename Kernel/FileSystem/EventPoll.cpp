@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <Kernel/FileSystem/EventPoll.h>
+#include <Kernel/FileSystem/FileDescription.h>
+
+//#define EVENTPOLL_DEBUG
+
+namespace Kernel {
+
+EventPollEntry::EventPollEntry(EventPoll& poll, int fd, FileDescription& description, const epoll_event& event)
+    : m_poll(poll)
+    , m_description(description)
+    , m_file(description.file())
+    , m_fd(fd)
+    , m_events(event.events)
+    , m_data(event.data)
+{
+}
+
+u32 EventPollEntry::current_events(const FileDescription& description) const
+{
+    u32 events = 0;
+    if ((m_events & EPOLLIN) && description.can_read())
+        events |= EPOLLIN;
+    if ((m_events & EPOLLOUT) && description.can_write())
+        events |= EPOLLOUT;
+    // Hang-ups and errors are always reported, whether they were asked for or not.
+    if (description.file().is_hung_up(description))
+        events |= EPOLLHUP;
+    if (description.file().has_pending_error(description))
+        events |= EPOLLERR;
+    return events;
+}
+
+NonnullRefPtr<EventPoll> EventPoll::create()
+{
+    return adopt(*new EventPoll);
+}
+
+EventPoll::EventPoll()
+{
+}
+
+EventPoll::~EventPoll()
+{
+    for (auto& it : m_entries)
+        it.value->m_file->remove_readiness_observer({}, *it.value);
+}
+
+KResult EventPoll::add(int fd, FileDescription& description, const epoll_event& event)
+{
+    // Nested interest sets would need loop detection and lock ordering
+    // between sets, and nobody needs them yet.
+    if (description.file().is_event_poll())
+        return KResult(-EINVAL);
+
+    LOCKER(m_lock);
+    reap_if_closed(fd);
+    if (m_entries.contains(fd))
+        return KResult(-EEXIST);
+
+    auto entry = adopt_own(*new EventPollEntry(*this, fd, description, event));
+    auto& entry_ref = *entry;
+    m_entries.set(fd, move(entry));
+    description.file().add_readiness_observer({}, entry_ref);
+
+    // The file may already be ready, in which case there won't be a push for
+    // it. Queue it once so that the next harvest takes a look.
+    ScopedSpinLock lock(m_ready_lock);
+    enqueue(entry_ref);
+    return KSuccess;
+}
+
+KResult EventPoll::modify(int fd, const epoll_event& event)
+{
+    LOCKER(m_lock);
+    reap_if_closed(fd);
+    auto it = m_entries.find(fd);
+    if (it == m_entries.end())
+        return KResult(-ENOENT);
+
+    auto& entry = *it->value;
+    ScopedSpinLock lock(m_ready_lock);
+    entry.m_events = event.events;
+    entry.m_data = event.data;
+    entry.m_disarmed = false;
+    enqueue(entry);
+    return KSuccess;
+}
+
+KResult EventPoll::remove(int fd)
+{
+    LOCKER(m_lock);
+    reap_if_closed(fd);
+    auto it = m_entries.find(fd);
+    if (it == m_entries.end())
+        return KResult(-ENOENT);
+
+    auto& entry = *it->value;
+    entry.m_file->remove_readiness_observer({}, entry);
+    remove_entry(entry);
+    return KSuccess;
+}
+
+void EventPoll::reap_if_closed(int fd)
+{
+    ASSERT(m_lock.is_locked());
+    auto it = m_entries.find(fd);
+    if (it == m_entries.end())
+        return;
+    {
+        ScopedSpinLock lock(m_ready_lock);
+        if (!it->value->m_closed)
+            return;
+    }
+    remove_entry(*it->value);
+}
+
+void EventPoll::remove_entry(EventPollEntry& entry)
+{
+    // The entry must no longer be reachable from its File at this point.
+    {
+        ScopedSpinLock lock(m_ready_lock);
+        if (entry.m_state == EventPollEntry::State::Queued) {
+            m_ready_entries.remove(&entry);
+            --m_ready_count;
+        }
+        entry.m_state = EventPollEntry::State::Idle;
+    }
+    m_entries.remove(entry.m_fd);
+}
+
+void EventPoll::enqueue(EventPollEntry& entry)
+{
+    ASSERT(m_ready_lock.is_locked());
+    switch (entry.m_state) {
+    case EventPollEntry::State::Idle:
+        entry.m_state = EventPollEntry::State::Queued;
+        m_ready_entries.append(&entry);
+        ++m_ready_count;
+        break;
+    case EventPollEntry::State::Queued:
+        break;
+    case EventPollEntry::State::Checking:
+        entry.m_notified_while_checking = true;
+        break;
+    }
+}
+
+void EventPoll::notify_ready(Badge<File>, EventPollEntry& entry)
+{
+    ScopedSpinLock lock(m_ready_lock);
+    if (entry.m_disarmed || entry.m_closed)
+        return;
+    enqueue(entry);
+}
+
+void EventPoll::notify_closed(Badge<File>, EventPollEntry& entry)
+{
+    // The description is going away. Queue the entry so that it gets reaped,
+    // and make sure nobody looks at its description again.
+    ScopedSpinLock lock(m_ready_lock);
+    entry.m_closed = true;
+    enqueue(entry);
+}
+
+size_t EventPoll::harvest(epoll_event* events, size_t max_events)
+{
+    LOCKER(m_lock);
+
+    // Only look at each entry that is ready right now once, otherwise ready
+    // level-triggered entries would keep us going forever.
+    size_t budget;
+    {
+        ScopedSpinLock lock(m_ready_lock);
+        budget = m_ready_count;
+    }
+
+    size_t event_count = 0;
+    while (event_count < max_events && budget-- > 0) {
+        EventPollEntry* entry;
+        RefPtr<FileDescription> description;
+        bool closed;
+        {
+            ScopedSpinLock lock(m_ready_lock);
+            entry = m_ready_entries.remove_head();
+            if (!entry)
+                break;
+            --m_ready_count;
+            // Until notify_closed() has run, which needs m_ready_lock, the
+            // description is still there. Its last reference may already be
+            // gone though, in which case notify_closed() is on its way and
+            // will queue the entry again for reaping.
+            closed = entry->m_closed;
+            if (!closed && entry->m_description.try_ref())
+                description = adopt(entry->m_description);
+            entry->m_state = description ? EventPollEntry::State::Checking : EventPollEntry::State::Idle;
+            entry->m_notified_while_checking = false;
+        }
+
+        if (!description) {
+            if (closed)
+                m_entries.remove(entry->m_fd);
+            continue;
+        }
+
+        u32 ready_events = entry->current_events(*description);
+
+        {
+            ScopedSpinLock lock(m_ready_lock);
+            if (ready_events && (entry->m_events & EPOLLONESHOT))
+                entry->m_disarmed = true;
+            bool stays_ready = ready_events && !(entry->m_events & EPOLLET);
+            bool requeue = entry->m_closed || (!entry->m_disarmed && (entry->m_notified_while_checking || stays_ready));
+            entry->m_state = EventPollEntry::State::Idle;
+            if (requeue)
+                enqueue(*entry);
+        }
+
+        // This may be the last reference, so drop it without holding m_ready_lock.
+        description = nullptr;
+
+        if (!ready_events)
+            continue;
+
+#ifdef EVENTPOLL_DEBUG
+        dbg() << "EventPoll: fd " << entry->m_fd << " ready with events " << String::format("%x", ready_events);
+#endif
+        events[event_count].events = ready_events;
+        events[event_count].data = entry->m_data;
+        ++event_count;
+    }
+
+    return event_count;
+}
+
+bool EventPoll::has_ready_entries() const
+{
+    ScopedSpinLock lock(m_ready_lock);
+    return m_ready_count != 0;
+}
+
+bool EventPoll::can_read(const FileDescription&, size_t) const
+{
+    return has_ready_entries();
+}
+
+bool EventPoll::can_write(const FileDescription&, size_t) const
+{
+    return false;
+}
+
+ssize_t EventPoll::read(FileDescription&, size_t, u8*, ssize_t)
+{
+    return -EINVAL;
+}
+
+ssize_t EventPoll::write(FileDescription&, size_t, const u8*, ssize_t)
+{
+    return -EINVAL;
+}
+
+String EventPoll::absolute_path(const FileDescription&) const
+{
+    return "EventPoll";
+}
+
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Badge.h>
+#include <AK/HashMap.h>
+#include <AK/InlineLinkedList.h>
+#include <AK/NonnullOwnPtr.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/Lock.h>
+#include <Kernel/SpinLock.h>
+#include <Kernel/UnixTypes.h>
+
+namespace Kernel {
+
+class EventPollEntry : public InlineLinkedListNode<EventPollEntry> {
+    AK_MAKE_NONCOPYABLE(EventPollEntry);
+    AK_MAKE_NONMOVABLE(EventPollEntry);
+
+public:
+    EventPoll& poll() { return m_poll; }
+    FileDescription& description() { return m_description; }
+
+private:
+    friend class EventPoll;
+    friend class InlineLinkedListNode<EventPollEntry>;
+
+    EventPollEntry(EventPoll&, int fd, FileDescription&, const epoll_event&);
+
+    u32 current_events(const FileDescription&) const;
+
+    enum class State {
+        Idle,
+        Queued,
+        Checking,
+    };
+
+    EventPoll& m_poll;
+    // Not a RefPtr: the entry goes away with the description, not the other way around.
+    FileDescription& m_description;
+    NonnullRefPtr<File> m_file;
+    int m_fd { -1 };
+    u32 m_events { 0 };
+    epoll_data_t m_data;
+
+    // These are protected by EventPoll::m_ready_lock.
+    State m_state { State::Idle };
+    bool m_notified_while_checking { false };
+    bool m_disarmed { false };
+    bool m_closed { false };
+
+    EventPollEntry* m_prev { nullptr };
+    EventPollEntry* m_next { nullptr };
+};
+
+// EventPoll is the File behind an epoll file descriptor: a persistent set of
+// file descriptors that the caller is interested in. Rather than rescanning
+// the whole set, each watched File pushes its entry onto the ready list when
+// its readiness may have changed (see File::did_change_readiness()), so both
+// waiting and harvesting cost is proportional to the number of ready entries.
+//
+// Readiness is always re-checked when harvesting. Level-triggered entries stay
+// on the ready list for as long as they are ready, edge-triggered (EPOLLET)
+// entries leave it until the next push, and EPOLLONESHOT entries are disarmed
+// after one report until they are re-armed with EPOLL_CTL_MOD.
+
+class EventPoll final : public File {
+public:
+    static NonnullRefPtr<EventPoll> create();
+    virtual ~EventPoll() override;
+
+    KResult add(int fd, FileDescription&, const epoll_event&);
+    KResult modify(int fd, const epoll_event&);
+    KResult remove(int fd);
+
+    // Fills in up to max_events events and returns how many were filled in.
+    size_t harvest(epoll_event* events, size_t max_events);
+
+    bool has_ready_entries() const;
+
+    void notify_ready(Badge<File>, EventPollEntry&);
+    void notify_closed(Badge<File>, EventPollEntry&);
+
+    virtual bool can_read(const FileDescription&, size_t) const override;
+    virtual bool can_write(const FileDescription&, size_t) const override;
+    virtual ssize_t read(FileDescription&, size_t, u8*, ssize_t) override;
+    virtual ssize_t write(FileDescription&, size_t, const u8*, ssize_t) override;
+    virtual String absolute_path(const FileDescription&) const override;
+    virtual const char* class_name() const override { return "EventPoll"; }
+    virtual bool is_event_poll() const override { return true; }
+
+private:
+    EventPoll();
+
+    void enqueue(EventPollEntry&);
+    void reap_if_closed(int fd);
+    void remove_entry(EventPollEntry&);
+
+    Lock m_lock { "EventPoll" };
+    HashMap<int, NonnullOwnPtr<EventPollEntry>> m_entries;
+
+    mutable SpinLock<u8> m_ready_lock;
+    InlineLinkedList<EventPollEntry> m_ready_entries;
+    size_t m_ready_count { 0 };
+};
+
+}
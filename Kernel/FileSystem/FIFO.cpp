@@ -116,6 +116,7 @@ void FIFO::attach(Direction direction)
         klog() << "open writer (" << m_writers << ")";
 #endif
     }
+    did_change_readiness();
 }
 
 void FIFO::detach(Direction direction)
@@ -133,6 +134,7 @@ void FIFO::detach(Direction direction)
         ASSERT(m_writers);
         --m_writers;
     }
+    did_change_readiness();
 }
 
 bool FIFO::can_read(const FileDescription&, size_t) const
@@ -145,6 +147,16 @@ bool FIFO::can_write(const FileDescription&, size_t) const
     return m_buffer.space_for_writing() || !m_readers;
 }
 
+bool FIFO::is_hung_up(const FileDescription& description) const
+{
+    return description.fifo_direction() == Direction::Reader && !m_writers;
+}
+
+bool FIFO::has_pending_error(const FileDescription& description) const
+{
+    return description.fifo_direction() == Direction::Writer && !m_readers;
+}
+
 ssize_t FIFO::read(FileDescription&, size_t, u8* buffer, ssize_t size)
 {
     if (!m_writers && m_buffer.is_empty())
@@ -156,19 +168,26 @@ ssize_t FIFO::read(FileDescription&, size_t, u8* buffer, ssize_t size)
 #ifdef FIFO_DEBUG
     dbg() << "   -> read (" << String::format("%c", buffer[0]) << ") " << nread;
 #endif
+    if (nread > 0)
+        did_change_readiness();
     return nread;
 }
 
 ssize_t FIFO::write(FileDescription&, size_t, const u8* buffer, ssize_t size)
 {
     if (!m_readers) {
-        Thread::current()->send_signal(SIGPIPE, Process::current());
+        // Kernel threads can't take signals. IORing raises this one when the result is reaped.
+        if (!Process::current()->is_ring0())
+            Thread::current()->send_signal(SIGPIPE, Process::current());
         return -EPIPE;
     }
 #ifdef FIFO_DEBUG
     dbg() << "fifo: write(" << (const void*)buffer << ", " << size << ")";
 #endif
-    return m_buffer.write(buffer, size);
+    ssize_t nwritten = m_buffer.write(buffer, size);
+    if (nwritten > 0)
+        did_change_readiness();
+    return nwritten;
 }
 
 String FIFO::absolute_path(const FileDescription&) const
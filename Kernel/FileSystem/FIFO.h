@@ -26,9 +26,9 @@
 
 #pragma once
 
-#include <Kernel/DoubleBuffer.h>
 #include <Kernel/FileSystem/File.h>
 #include <Kernel/Lock.h>
+#include <Kernel/RingBuffer.h>
 #include <Kernel/UnixTypes.h>
 #include <Kernel/WaitQueue.h>
 
@@ -55,12 +55,17 @@ public:
     void attach(Direction);
     void detach(Direction);
 
+    size_t buffer_capacity() const { return m_buffer.capacity(); }
+    KResult set_buffer_capacity(size_t capacity) { return m_buffer.set_capacity(capacity); }
+
 private:
     // ^File
     virtual ssize_t write(FileDescription&, size_t, const u8*, ssize_t) override;
     virtual ssize_t read(FileDescription&, size_t, u8*, ssize_t) override;
     virtual bool can_read(const FileDescription&, size_t) const override;
     virtual bool can_write(const FileDescription&, size_t) const override;
+    virtual bool is_hung_up(const FileDescription&) const override;
+    virtual bool has_pending_error(const FileDescription&) const override;
     virtual String absolute_path(const FileDescription&) const override;
     virtual const char* class_name() const override { return "FIFO"; }
     virtual bool is_fifo() const override { return true; }
@@ -69,7 +74,7 @@ private:
 
     unsigned m_writers { 0 };
     unsigned m_readers { 0 };
-    DoubleBuffer m_buffer;
+    RingBuffer m_buffer;
 
     uid_t m_uid { 0 };
 
@@ -25,6 +25,7 @@
  */
 
 #include <AK/StringView.h>
+#include <Kernel/FileSystem/EventPoll.h>
 #include <Kernel/FileSystem/File.h>
 #include <Kernel/FileSystem/FileDescription.h>
 
@@ -36,6 +37,7 @@ File::File()
 
 File::~File()
 {
+    ASSERT(m_readiness_observers.is_empty());
 }
 
 KResultOr<NonnullRefPtr<FileDescription>> File::open(int options)
@@ -61,4 +63,39 @@ KResultOr<Region*> File::mmap(Process&, FileDescription&, VirtualAddress, size_t
     return KResult(-ENODEV);
 }
 
+void File::add_readiness_observer(Badge<EventPoll>, EventPollEntry& entry)
+{
+    ScopedSpinLock lock(m_readiness_observers_lock);
+    m_readiness_observers.append(&entry);
+}
+
+void File::remove_readiness_observer(Badge<EventPoll>, EventPollEntry& entry)
+{
+    ScopedSpinLock lock(m_readiness_observers_lock);
+    m_readiness_observers.remove_first_matching([&](auto* observer) { return observer == &entry; });
+}
+
+void File::detach_readiness_observers(Badge<FileDescription>, FileDescription& description)
+{
+    ScopedSpinLock lock(m_readiness_observers_lock);
+    m_readiness_observers.remove_all_matching([&](auto* entry) {
+        if (&entry->description() != &description)
+            return false;
+        entry->poll().notify_closed({}, *entry);
+        return true;
+    });
+}
+
+void File::did_change_readiness()
+{
+    // This is on the hot path of every read, write and packet, so skip the
+    // lock when nobody is watching. An observer racing in here is harmless,
+    // since EventPoll checks readiness itself right after registering.
+    if (m_readiness_observers.is_empty())
+        return;
+    ScopedSpinLock lock(m_readiness_observers_lock);
+    for (auto* entry : m_readiness_observers)
+        entry->poll().notify_ready({}, *entry);
+}
+
 }
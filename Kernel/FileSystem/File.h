@@ -26,12 +26,15 @@
 
 #pragma once
 
+#include <AK/Badge.h>
 #include <AK/NonnullRefPtr.h>
 #include <AK/RefCounted.h>
 #include <AK/String.h>
 #include <AK/Types.h>
+#include <AK/Vector.h>
 #include <Kernel/Forward.h>
 #include <Kernel/KResult.h>
+#include <Kernel/SpinLock.h>
 #include <Kernel/UnixTypes.h>
 #include <Kernel/VirtualAddress.h>
 
@@ -51,6 +54,13 @@ namespace Kernel {
 //   - Return true if read() or write() would succeed, respectively.
 //   - Note that can_read() should return true in EOF conditions,
 //     and a subsequent call to read() should return 0.
+//   - Subclasses must call did_change_readiness() whenever the answer
+//     may have changed, so that epoll interest sets get to hear about it.
+//
+// is_hung_up() and has_pending_error()
+//
+//   - Optional. Reported by epoll as EPOLLHUP and EPOLLERR, respectively.
+//   - Changes to these must also be followed by did_change_readiness().
 //
 // ioctl()
 //
@@ -73,6 +83,8 @@ public:
 
     virtual bool can_read(const FileDescription&, size_t) const = 0;
     virtual bool can_write(const FileDescription&, size_t) const = 0;
+    virtual bool is_hung_up(const FileDescription&) const { return false; }
+    virtual bool has_pending_error(const FileDescription&) const { return false; }
 
     virtual ssize_t read(FileDescription&, size_t, u8*, ssize_t) = 0;
     virtual ssize_t write(FileDescription&, size_t, const u8*, ssize_t) = 0;
@@ -97,9 +109,23 @@ public:
     virtual bool is_block_device() const { return false; }
     virtual bool is_character_device() const { return false; }
     virtual bool is_socket() const { return false; }
+    virtual bool is_event_poll() const { return false; }
+    virtual bool is_io_ring() const { return false; }
+
+    void add_readiness_observer(Badge<EventPoll>, EventPollEntry&);
+    void remove_readiness_observer(Badge<EventPoll>, EventPollEntry&);
+    void detach_readiness_observers(Badge<FileDescription>, FileDescription&);
+
+    // Push a readiness event to every epoll entry watching this File.
+    // Safe to call from any context, including IRQ handlers.
+    void did_change_readiness();
 
 protected:
     File();
+
+private:
+    SpinLock<u8> m_readiness_observers_lock;
+    Vector<EventPollEntry*> m_readiness_observers;
 };
 
 }
@@ -66,6 +66,7 @@ FileDescription::FileDescription(File& file)
 
 FileDescription::~FileDescription()
 {
+    m_file->detach_readiness_observers({}, *this);
     if (is_socket())
         socket()->detach(*this);
     if (is_fifo())
@@ -148,6 +149,32 @@ ssize_t FileDescription::write(const u8* data, ssize_t size)
     return nwritten;
 }
 
+ssize_t FileDescription::read_at(off_t offset, u8* buffer, ssize_t count)
+{
+    if (!m_file->is_seekable())
+        return -ESPIPE;
+    if (offset < 0)
+        return -EINVAL;
+    if ((offset + count) < 0)
+        return -EOVERFLOW;
+    LOCKER(m_lock, Lock::Mode::Shared);
+    SmapDisabler disabler;
+    return m_file->read(*this, offset, buffer, count);
+}
+
+ssize_t FileDescription::write_at(off_t offset, const u8* data, ssize_t size)
+{
+    if (!m_file->is_seekable())
+        return -ESPIPE;
+    if (offset < 0)
+        return -EINVAL;
+    if ((offset + size) < 0)
+        return -EOVERFLOW;
+    LOCKER(m_lock, Lock::Mode::Shared);
+    SmapDisabler disabler;
+    return m_file->write(*this, offset, data, size);
+}
+
 bool FileDescription::can_write() const
 {
     return m_file->can_write(*this, offset());
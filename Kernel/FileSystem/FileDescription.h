@@ -70,6 +70,11 @@ public:
     off_t seek(off_t, int whence);
     ssize_t read(u8*, ssize_t);
     ssize_t write(const u8* data, ssize_t);
+
+    // Positional I/O: these leave the current offset alone, so several threads
+    // can use the same description without racing on seek().
+    ssize_t read_at(off_t, u8*, ssize_t);
+    ssize_t write_at(off_t, const u8* data, ssize_t);
     KResult fstat(stat&);
 
     KResult chmod(mode_t);
@@ -125,7 +130,7 @@ public:
 
     bool is_fifo() const;
     FIFO* fifo();
-    FIFO::Direction fifo_direction() { return m_fifo_direction; }
+    FIFO::Direction fifo_direction() const { return m_fifo_direction; }
     void set_fifo_direction(Badge<FIFO>, FIFO::Direction direction) { m_fifo_direction = direction; }
 
     Optional<KBuffer>& generator_cache() { return m_generator_cache; }
@@ -136,6 +141,8 @@ public:
 
     off_t offset() const { return m_current_offset; }
 
+    Lock& lock() { return m_lock; }
+
     KResult chown(uid_t, gid_t);
 
 private:
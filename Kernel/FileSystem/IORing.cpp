@@ -0,0 +1,568 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Optional.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/FileSystem/IORing.h>
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/Net/Socket.h>
+#include <Kernel/Process.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <Kernel/WaitQueue.h>
+
+//#define IORING_DEBUG
+
+namespace Kernel {
+
+struct IORing::Operation {
+    RefPtr<IORing> ring;
+    IORingSubmission submission;
+    RefPtr<FileDescription> description;
+    Optional<KBuffer> buffer;
+    u8 address[sizeof(sockaddr_un)];
+    socklen_t address_length { 0 };
+    i32 result { 0 };
+};
+
+// Blocking operations from every ring are serviced by one pool of kernel
+// threads. The pool starts out empty and grows on demand, up to a fixed size.
+static constexpr u32 max_worker_count = 16;
+
+static Lock* s_work_lock;
+static SinglyLinkedList<NonnullOwnPtr<IORing::Operation>>* s_work;
+static WaitQueue* s_work_wait_queue;
+static Process* s_worker_process;
+static u32 s_worker_count;
+static u32 s_idle_worker_count;
+
+void IORing::initialize()
+{
+    s_work_lock = new Lock("IORing work");
+    s_work = new SinglyLinkedList<NonnullOwnPtr<Operation>>;
+    s_work_wait_queue = new WaitQueue;
+}
+
+KResultOr<NonnullRefPtr<IORing>> IORing::create(u32 entries)
+{
+    if (!entries || entries > max_entries || (entries & (entries - 1)))
+        return KResult(-EINVAL);
+
+    // The completion queue is twice as large as the submission queue, so
+    // that completions can keep flowing while the caller is busy submitting.
+    u32 completion_entries = entries * 2;
+    size_t submissions_offset = round_up_to_power_of_two(sizeof(IORingHeader), 64);
+    size_t completions_offset = round_up_to_power_of_two(submissions_offset + entries * sizeof(IORingSubmission), 64);
+    size_t mapping_size = PAGE_ROUND_UP(completions_offset + completion_entries * sizeof(IORingCompletion));
+
+    auto vmobject = AnonymousVMObject::create_with_size(mapping_size);
+    auto region = MM.allocate_kernel_region_with_vmobject(*vmobject, mapping_size, "IORing", Region::Access::Read | Region::Access::Write);
+    if (!region || !region->commit())
+        return KResult(-ENOMEM);
+
+    auto ring = adopt(*new IORing(move(vmobject), region.release_nonnull(), entries, mapping_size));
+    auto& header = ring->header();
+    header.submission_mask = entries - 1;
+    header.completion_mask = completion_entries - 1;
+    header.submissions_offset = submissions_offset;
+    header.completions_offset = completions_offset;
+    return ring;
+}
+
+IORing::IORing(NonnullRefPtr<AnonymousVMObject> vmobject, NonnullOwnPtr<Region> kernel_region, u32 entries, size_t mapping_size)
+    : m_vmobject(move(vmobject))
+    , m_kernel_region(move(kernel_region))
+    , m_submission_entries(entries)
+    , m_completion_entries(entries * 2)
+    , m_mapping_size(mapping_size)
+{
+}
+
+IORing::~IORing()
+{
+}
+
+KResult IORing::close()
+{
+    m_closed.store(true, AK::MemoryOrder::memory_order_release);
+
+    // Nobody is left to reap the results, so drop whatever hasn't been
+    // picked up by a worker yet. Workers notice m_closed by themselves.
+    SinglyLinkedList<NonnullOwnPtr<Operation>> cancelled;
+    {
+        LOCKER(*s_work_lock);
+        SinglyLinkedList<NonnullOwnPtr<Operation>> remaining;
+        while (!s_work->is_empty()) {
+            auto operation = s_work->take_first();
+            if (operation->ring == this)
+                cancelled.append(move(operation));
+            else
+                remaining.append(move(operation));
+        }
+        *s_work = move(remaining);
+    }
+    while (!cancelled.is_empty()) {
+        cancelled.take_first();
+        --m_in_flight_count;
+    }
+    return KSuccess;
+}
+
+bool IORing::can_read(const FileDescription&, size_t) const
+{
+    return m_completed_count.load(AK::MemoryOrder::memory_order_relaxed) > 0;
+}
+
+KResultOr<Region*> IORing::mmap(Process& process, FileDescription&, VirtualAddress preferred_vaddr, size_t offset, size_t size, int prot, bool shared)
+{
+    if (!shared || offset != 0 || size != m_mapping_size)
+        return KResult(-EINVAL);
+    if (prot & PROT_EXEC)
+        return KResult(-EACCES);
+    auto* region = process.allocate_region_with_vmobject(preferred_vaddr, m_mapping_size, m_vmobject, 0, "IORing", prot);
+    if (!region)
+        return KResult(-ENOMEM);
+    return region;
+}
+
+KResultOr<u32> IORing::enter(Process& process, u32 to_submit, u32 min_complete)
+{
+    if (min_complete > m_completion_entries)
+        return KResult(-EINVAL);
+
+    u32 submission_tail = header().submission_tail;
+    u32 pending = submission_tail - m_submission_head;
+    if (pending > m_submission_entries)
+        return KResult(-EINVAL);
+
+    u32 submitted = 0;
+    for (; submitted < min(to_submit, pending); ++submitted) {
+        // Take a snapshot, since userspace may change the entry under our feet.
+        IORingSubmission submission = submissions()[m_submission_head & (m_submission_entries - 1)];
+        ++m_submission_head;
+        header().submission_head = m_submission_head;
+        submit(process, submission);
+    }
+
+    for (;;) {
+        reap_completed(process);
+
+        u32 available = m_completion_tail - header().completion_head;
+        if (available >= min_complete)
+            break;
+        if (!completion_queue_space())
+            break;
+        if (!m_in_flight_count.load() && !m_completed_count.load())
+            break;
+
+        auto result = Thread::current()->block_until("IORing", [this] {
+            return m_completed_count.load(AK::MemoryOrder::memory_order_relaxed) > 0 || !m_in_flight_count.load(AK::MemoryOrder::memory_order_relaxed);
+        });
+        if (result.was_interrupted()) {
+            if (submitted)
+                break;
+            return KResult(-EINTR);
+        }
+    }
+
+    return submitted;
+}
+
+void IORing::submit(Process& process, const IORingSubmission& submission)
+{
+    auto operation = make<Operation>();
+    operation->submission = submission;
+    auto& op = *operation;
+
+    auto complete_now = [&](i32 result) {
+        op.result = result;
+        did_complete(move(operation));
+    };
+
+    if (submission.opcode == IORingOpcode::Nop)
+        return complete_now(0);
+
+    if (submission.opcode == IORingOpcode::Open) {
+        // Path resolution needs the caller's credentials, working directory
+        // and unveil state, and only rarely blocks, so do it right here.
+        return complete_now(process.do_open(submission.fd, (const char*)submission.buffer, submission.length, submission.flags, (u16)submission.offset));
+    }
+
+    op.description = process.file_description(submission.fd);
+    if (!op.description)
+        return complete_now(-EBADF);
+    auto& description = *op.description;
+    // An operation waiting on a ring would keep it open, and so keep itself from being cancelled.
+    if (description.file().is_io_ring())
+        return complete_now(-EINVAL);
+
+    auto allocate_buffer = [&]() -> bool {
+        op.submission.length = min(op.submission.length, max_transfer_size);
+        if (!op.submission.length)
+            return true;
+        op.buffer = KBuffer::try_create_with_size(op.submission.length, Region::Access::Read | Region::Access::Write, "IORing");
+        return op.buffer.has_value();
+    };
+
+    switch (submission.opcode) {
+    case IORingOpcode::Read:
+    case IORingOpcode::RecvFrom:
+        if (!description.is_readable())
+            return complete_now(-EBADF);
+        if (!process.validate_write(submission.buffer, submission.length))
+            return complete_now(-EFAULT);
+        if (submission.opcode == IORingOpcode::RecvFrom) {
+            if (!description.is_socket())
+                return complete_now(-ENOTSOCK);
+            if (submission.address) {
+                if (!process.validate_write(submission.address, submission.address_length))
+                    return complete_now(-EFAULT);
+                op.address_length = min(sizeof(op.address), (size_t)submission.address_length);
+            }
+        }
+        if (!allocate_buffer())
+            return complete_now(-ENOMEM);
+        break;
+    case IORingOpcode::Write:
+    case IORingOpcode::SendTo:
+        if (!description.is_writable())
+            return complete_now(-EBADF);
+        if (!process.validate_read(submission.buffer, submission.length))
+            return complete_now(-EFAULT);
+        if (submission.opcode == IORingOpcode::SendTo) {
+            if (!description.is_socket())
+                return complete_now(-ENOTSOCK);
+            if (submission.address) {
+                if (submission.address_length > sizeof(op.address))
+                    return complete_now(-EINVAL);
+                if (!process.validate_read(submission.address, submission.address_length))
+                    return complete_now(-EFAULT);
+                copy_from_user(op.address, submission.address, submission.address_length);
+                op.address_length = submission.address_length;
+            }
+        }
+        if (!allocate_buffer())
+            return complete_now(-ENOMEM);
+        if (op.buffer.has_value())
+            copy_from_user(op.buffer.value().data(), submission.buffer, op.submission.length);
+        break;
+    case IORingOpcode::Accept:
+        REQUIRE_PROMISE(accept);
+        if (!description.is_socket())
+            return complete_now(-ENOTSOCK);
+        if (submission.address) {
+            if (!process.validate_write(submission.address, submission.address_length))
+                return complete_now(-EFAULT);
+            op.address_length = min(sizeof(op.address), (size_t)submission.address_length);
+        }
+        break;
+    case IORingOpcode::Connect: {
+        if (!description.is_socket())
+            return complete_now(-ENOTSOCK);
+        auto& socket = *description.socket();
+        if (socket.domain() == AF_INET)
+            REQUIRE_PROMISE(inet);
+        else if (socket.domain() == AF_LOCAL)
+            REQUIRE_PROMISE(unix);
+        if (!process.validate_read(submission.address, submission.address_length))
+            return complete_now(-EFAULT);
+        op.address_length = min(sizeof(op.address), (size_t)submission.address_length);
+        copy_from_user(op.address, submission.address, op.address_length);
+        // Start connecting right away; only the wait for the handshake is
+        // handed to a worker.
+        auto result = socket.connect(description, (const sockaddr*)op.address, op.address_length, ShouldBlock::No);
+        if (result.error() != -EINPROGRESS)
+            return complete_now(result);
+        break;
+    }
+    case IORingOpcode::Fsync:
+        if (!description.inode())
+            return complete_now(-EINVAL);
+        break;
+    default:
+        return complete_now(-EINVAL);
+    }
+
+    op.ring = this;
+    ++m_in_flight_count;
+    dispatch(move(operation));
+}
+
+void IORing::dispatch(NonnullOwnPtr<Operation>&& operation)
+{
+    LOCKER(*s_work_lock);
+    s_work->append(move(operation));
+    if (s_idle_worker_count) {
+        --s_idle_worker_count;
+        s_work_wait_queue->wake_one();
+        return;
+    }
+    if (s_worker_count >= max_worker_count)
+        return;
+    ++s_worker_count;
+    if (!s_worker_process) {
+        Thread* thread = nullptr;
+        s_worker_process = Process::create_kernel_process(thread, "IORing", worker_main);
+    } else {
+        s_worker_process->create_kernel_thread(worker_main, THREAD_PRIORITY_NORMAL, "IORing");
+    }
+}
+
+i32 IORing::execute(Operation& op)
+{
+    auto& submission = op.submission;
+    auto& description = *op.description;
+    u8* data = op.buffer.has_value() ? op.buffer.value().data() : nullptr;
+
+    // Waits for the condition to become true, or for the ring to be closed.
+    auto& ring = *op.ring;
+    auto wait_until = [&](auto condition) {
+        if (condition())
+            return;
+        (void)Thread::current()->block_until("IORing", [&] {
+            return ring.m_closed.load(AK::MemoryOrder::memory_order_relaxed) || condition();
+        });
+    };
+    auto wait_until_readable = [&](FileDescription& description) {
+        wait_until([&] { return description.can_read(); });
+    };
+    auto wait_until_writable = [&](FileDescription& description) {
+        wait_until([&] { return description.can_write(); });
+    };
+
+    switch (submission.opcode) {
+    case IORingOpcode::Read:
+        if (submission.offset >= 0)
+            return description.read_at(submission.offset, data, submission.length);
+        wait_until_readable(description);
+        if (ring.m_closed.load())
+            return -ECANCELED;
+        if (!description.can_read())
+            return -EAGAIN;
+        return description.read(data, submission.length);
+    case IORingOpcode::Write: {
+        if (submission.offset >= 0)
+            return description.write_at(submission.offset, data, submission.length);
+        size_t nwritten = 0;
+        while (nwritten < submission.length) {
+            wait_until_writable(description);
+            if (ring.m_closed.load())
+                return nwritten ? nwritten : -ECANCELED;
+            if (!description.can_write())
+                return nwritten ? nwritten : -EAGAIN;
+            ssize_t rc = description.write(data + nwritten, submission.length - nwritten);
+            if (rc < 0)
+                return nwritten ? nwritten : rc;
+            if (rc == 0)
+                break;
+            nwritten += rc;
+        }
+        return nwritten;
+    }
+    case IORingOpcode::RecvFrom: {
+        wait_until_readable(description);
+        if (ring.m_closed.load())
+            return -ECANCELED;
+        if (!description.can_read())
+            return -EAGAIN;
+        auto* address = op.address_length ? (sockaddr*)op.address : nullptr;
+        auto* address_length = op.address_length ? &op.address_length : nullptr;
+        return description.socket()->recvfrom(description, data, submission.length, submission.flags, address, address_length);
+    }
+    case IORingOpcode::SendTo: {
+        wait_until_writable(description);
+        if (ring.m_closed.load())
+            return -ECANCELED;
+        if (!description.can_write())
+            return -EAGAIN;
+        auto* address = op.address_length ? (const sockaddr*)op.address : nullptr;
+        return description.socket()->sendto(description, data, submission.length, submission.flags, address, op.address_length);
+    }
+    case IORingOpcode::Accept:
+        // The connection itself is dequeued in IORing::reap(), since it
+        // has to be accepted on behalf of the submitting process.
+        wait_until([&] { return description.socket()->can_accept(); });
+        return ring.m_closed.load() ? -ECANCELED : 0;
+    case IORingOpcode::Connect: {
+        auto& socket = *description.socket();
+        wait_until([&] { return socket.setup_state() == Socket::SetupState::Completed; });
+        if (ring.m_closed.load())
+            return -ECANCELED;
+        return socket.is_connected() ? 0 : -ECONNREFUSED;
+    }
+    case IORingOpcode::Fsync: {
+        auto& inode = *description.inode();
+        inode.flush_metadata();
+        inode.fs().flush_writes();
+        return 0;
+    }
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+void IORing::worker_main()
+{
+    for (;;) {
+        OwnPtr<Operation> operation;
+        {
+            LOCKER(*s_work_lock);
+            if (s_work->is_empty())
+                ++s_idle_worker_count;
+            else
+                operation = s_work->take_first();
+        }
+        if (!operation) {
+            Thread::current()->wait_on(*s_work_wait_queue, "IORing");
+            continue;
+        }
+
+        operation->result = execute(*operation);
+#ifdef IORING_DEBUG
+        dbg() << "IORing: Operation " << (int)operation->submission.opcode << " on fd " << operation->submission.fd << " finished with " << operation->result;
+#endif
+        auto ring = operation->ring.release_nonnull();
+        ring->did_complete(operation.release_nonnull());
+        --ring->m_in_flight_count;
+    }
+}
+
+void IORing::did_complete(NonnullOwnPtr<Operation>&& operation)
+{
+    {
+        LOCKER(m_completed_lock);
+        m_completed.append(move(operation));
+    }
+    ++m_completed_count;
+    did_change_readiness();
+}
+
+u32 IORing::completion_queue_space()
+{
+    u32 used = m_completion_tail - header().completion_head;
+    if (used >= m_completion_entries)
+        return 0;
+    return m_completion_entries - used;
+}
+
+void IORing::post_completion(u64 user_data, i32 result, u32 flags)
+{
+    auto& completion = completions()[m_completion_tail & (m_completion_entries - 1)];
+    completion.user_data = user_data;
+    completion.result = result;
+    completion.flags = flags;
+    ++m_completion_tail;
+    header().completion_tail = m_completion_tail;
+}
+
+bool IORing::reap(Process& process, Operation& op)
+{
+    auto& submission = op.submission;
+    u32 flags = 0;
+
+    switch (submission.opcode) {
+    case IORingOpcode::Read:
+    case IORingOpcode::RecvFrom:
+        if (op.result <= 0)
+            break;
+        // The process lock was dropped while the operation was in flight,
+        // so the buffer may have been unmapped in the meantime.
+        if (!process.validate_write(submission.buffer, op.result)) {
+            op.result = -EFAULT;
+            break;
+        }
+        copy_to_user(submission.buffer, op.buffer.value().data(), op.result);
+        if (submission.opcode == IORingOpcode::RecvFrom && submission.address) {
+            if (!process.validate_write(submission.address, op.address_length)) {
+                op.result = -EFAULT;
+                break;
+            }
+            copy_to_user(submission.address, op.address, op.address_length);
+            flags = op.address_length;
+        }
+        break;
+    case IORingOpcode::Accept: {
+        if (op.result < 0)
+            break;
+        auto& socket = *op.description->socket();
+        int fd = process.alloc_fd();
+        if (fd < 0) {
+            op.result = fd;
+            break;
+        }
+        auto accepted_socket = socket.accept();
+        if (!accepted_socket) {
+            // Someone else got to the connection first, so go back to waiting.
+            return false;
+        }
+        if (submission.address) {
+            accepted_socket->get_peer_address((sockaddr*)op.address, &op.address_length);
+            if (process.validate_write(submission.address, op.address_length)) {
+                copy_to_user(submission.address, op.address, op.address_length);
+                flags = op.address_length;
+            }
+        }
+        auto accepted_socket_description = FileDescription::create(*accepted_socket);
+        accepted_socket_description->set_readable(true);
+        accepted_socket_description->set_writable(true);
+        // NOTE: The accepted socket inherits fd flags from the accepting socket.
+        //       I'm not sure if this matches other systems but it makes sense to me.
+        accepted_socket_description->set_blocking(op.description->is_blocking());
+        process.m_fds[fd].set(move(accepted_socket_description), process.m_fds[submission.fd].flags);
+        op.result = fd;
+        break;
+    }
+    case IORingOpcode::Write:
+        // The worker that ran the operation couldn't take the signal, so it's ours.
+        if (op.result == -EPIPE && op.description->is_fifo())
+            Thread::current()->send_signal(SIGPIPE, &process);
+        break;
+    default:
+        break;
+    }
+
+    post_completion(submission.user_data, op.result, flags);
+    return true;
+}
+
+void IORing::reap_completed(Process& process)
+{
+    while (m_completed_count.load() && completion_queue_space()) {
+        OwnPtr<Operation> operation;
+        {
+            LOCKER(m_completed_lock);
+            operation = m_completed.take_first();
+        }
+        --m_completed_count;
+        if (!reap(process, *operation)) {
+            operation->ring = this;
+            ++m_in_flight_count;
+            dispatch(operation.release_nonnull());
+        }
+    }
+}
+
+}
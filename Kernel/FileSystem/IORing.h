@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/SinglyLinkedList.h>
+#include <Kernel/API/IORing.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/Lock.h>
+#include <Kernel/VM/AnonymousVMObject.h>
+#include <Kernel/VM/Region.h>
+
+namespace Kernel {
+
+// IORing is the File behind an io_ring_setup() file descriptor: a pair of
+// queues shared with userspace through mmap(). Submissions are consumed in
+// io_ring_enter(), and anything that could block is handed off to a small pool
+// of kernel worker threads so that the caller can keep many operations in
+// flight with a single syscall. Results are posted back to the completion
+// queue from io_ring_enter(), in the context of the owning process.
+//
+// Workers never act on behalf of a process: signals that an operation would
+// have raised (SIGPIPE) are raised when the result is reaped instead. When the
+// ring is closed, which also happens when its owner exits, operations that
+// haven't started are dropped and waiting ones give up with -ECANCELED.
+
+class IORing final : public File {
+public:
+    static constexpr u32 max_entries = 4096;
+    // Longer reads and writes are cut short, like they would be by a pipe or socket.
+    static constexpr u32 max_transfer_size = 1 * MB;
+
+    static void initialize();
+
+    static KResultOr<NonnullRefPtr<IORing>> create(u32 entries);
+    virtual ~IORing() override;
+
+    size_t mapping_size() const { return m_mapping_size; }
+
+    // Consumes up to to_submit submissions and returns how many were consumed.
+    // Then waits until at least min_complete completions are available.
+    KResultOr<u32> enter(Process&, u32 to_submit, u32 min_complete);
+
+    virtual KResult close() override;
+    virtual bool can_read(const FileDescription&, size_t) const override;
+    virtual bool can_write(const FileDescription&, size_t) const override { return false; }
+    virtual ssize_t read(FileDescription&, size_t, u8*, ssize_t) override { return -EINVAL; }
+    virtual ssize_t write(FileDescription&, size_t, const u8*, ssize_t) override { return -EINVAL; }
+    virtual KResultOr<Region*> mmap(Process&, FileDescription&, VirtualAddress preferred_vaddr, size_t offset, size_t size, int prot, bool shared) override;
+    virtual String absolute_path(const FileDescription&) const override { return "io-ring"; }
+    virtual const char* class_name() const override { return "IORing"; }
+    virtual bool is_io_ring() const override { return true; }
+
+    // An operation that has been handed to the worker pool.
+    struct Operation;
+
+private:
+    IORing(NonnullRefPtr<AnonymousVMObject>, NonnullOwnPtr<Region>, u32 entries, size_t mapping_size);
+
+    IORingHeader& header() { return *reinterpret_cast<IORingHeader*>(m_kernel_region->vaddr().as_ptr()); }
+    IORingSubmission* submissions() { return reinterpret_cast<IORingSubmission*>(m_kernel_region->vaddr().offset(header().submissions_offset).as_ptr()); }
+    IORingCompletion* completions() { return reinterpret_cast<IORingCompletion*>(m_kernel_region->vaddr().offset(header().completions_offset).as_ptr()); }
+
+    void submit(Process&, const IORingSubmission&);
+    void post_completion(u64 user_data, i32 result, u32 flags = 0);
+    u32 completion_queue_space();
+    bool reap(Process&, Operation&);
+    void reap_completed(Process&);
+    void did_complete(NonnullOwnPtr<Operation>&&);
+
+    static void dispatch(NonnullOwnPtr<Operation>&&);
+    static i32 execute(Operation&);
+    static void worker_main();
+
+    NonnullRefPtr<AnonymousVMObject> m_vmobject;
+    NonnullOwnPtr<Region> m_kernel_region;
+    u32 m_submission_entries { 0 };
+    u32 m_completion_entries { 0 };
+    size_t m_mapping_size { 0 };
+
+    // Our own copies of the queue positions that only the kernel may move,
+    // so that a misbehaving process can't confuse us by scribbling on them.
+    u32 m_submission_head { 0 };
+    u32 m_completion_tail { 0 };
+
+    Atomic<bool> m_closed { false };
+
+    Lock m_completed_lock { "IORing" };
+    SinglyLinkedList<NonnullOwnPtr<Operation>> m_completed;
+    Atomic<u32> m_completed_count { 0 };
+    Atomic<u32> m_in_flight_count { 0 };
+};
+
+}
@@ -39,6 +39,7 @@
 #include <Kernel/Forward.h>
 #include <Kernel/KResult.h>
 #include <Kernel/Lock.h>
+#include <Kernel/VM/PhysicalPage.h>
 
 namespace Kernel {
 
@@ -105,6 +106,12 @@ public:
     SharedInodeVMObject* shared_vmobject() { return m_shared_vmobject.ptr(); }
     const SharedInodeVMObject* shared_vmobject() const { return m_shared_vmobject.ptr(); }
 
+    // File systems that keep file contents in physical pages (like TmpFS) return
+    // them here, so that mappings of the file use those very pages instead of copies.
+    // A null page means there is none to share, and the caller should read the
+    // contents into a page of its own. This is called with the MM lock held.
+    virtual KResultOr<RefPtr<PhysicalPage>> physical_page_for_mapping(size_t) { return RefPtr<PhysicalPage>(); }
+
     static void sync();
 
     bool has_watchers() const { return !m_watchers.is_empty(); }
@@ -25,8 +25,10 @@
  */
 
 #include <AK/Memory.h>
+#include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/InodeWatcher.h>
+#include <LibC/errno_numbers.h>
 
 namespace Kernel {
 
@@ -49,7 +51,7 @@ InodeWatcher::~InodeWatcher()
 
 bool InodeWatcher::can_read(const FileDescription&, size_t) const
 {
-    return !m_queue.is_empty() || !m_inode;
+    return !m_queue.is_empty() || m_queue_overflowed || !m_inode;
 }
 
 bool InodeWatcher::can_write(const FileDescription&, size_t) const
@@ -57,19 +59,54 @@ bool InodeWatcher::can_write(const FileDescription&, size_t) const
     return true;
 }
 
-ssize_t InodeWatcher::read(FileDescription&, size_t, u8* buffer, ssize_t buffer_size)
+ssize_t InodeWatcher::read(FileDescription& description, size_t, u8* buffer, ssize_t buffer_size)
 {
     LOCKER(m_lock);
-    ASSERT(!m_queue.is_empty() || !m_inode);
-
     if (!m_inode)
         return 0;
 
-    // FIXME: What should we do if the output buffer is too small?
-    ASSERT(buffer_size >= (int)sizeof(Event));
-    auto event = m_queue.dequeue();
-    memcpy(buffer, &event, sizeof(event));
-    return sizeof(event);
+    if (m_queue_overflowed) {
+        InodeWatcherEvent event;
+        event.type = Event::Type::QueueOverflowed;
+        if (buffer_size < (ssize_t)sizeof(event))
+            return -EINVAL;
+        memcpy(buffer, &event, sizeof(event));
+        m_queue_overflowed = false;
+        return sizeof(event);
+    }
+
+    // The events that made us readable cancelled each other out after sys$read() checked
+    // can_read(). Don't sleep here with the description locked: hand back an empty read,
+    // and the next read() will wait in sys$read() since can_read() now sees the empty queue.
+    if (m_queue.is_empty())
+        return description.is_blocking() ? 0 : -EAGAIN;
+
+    size_t nwritten = 0;
+    size_t event_count = 0;
+    for (auto& event : m_queue) {
+        InodeWatcherEvent header;
+        header.type = event.type;
+        header.name_length = event.name.length();
+        size_t record_size = header.record_size();
+        if (nwritten + record_size > (size_t)buffer_size)
+            break;
+        memcpy(buffer + nwritten, &header, sizeof(header));
+        memcpy(buffer + nwritten + sizeof(header), event.name.characters(), header.name_length);
+        memset(buffer + nwritten + sizeof(header) + header.name_length, 0, record_size - sizeof(header) - header.name_length);
+        nwritten += record_size;
+        ++event_count;
+    }
+
+    if (!event_count)
+        return -EINVAL;
+
+    if (event_count == m_queue.size()) {
+        m_queue.clear();
+    } else {
+        for (size_t i = 0; i < event_count; ++i)
+            m_queue.remove(0);
+    }
+    return nwritten;
 }
 
 ssize_t InodeWatcher::write(FileDescription&, size_t, const u8*, ssize_t)
@@ -84,22 +121,51 @@ String InodeWatcher::absolute_path(const FileDescription&) const
     return String::format("InodeWatcher:%s", m_inode->identifier().to_string().characters());
 }
 
-void InodeWatcher::notify_inode_event(Badge<Inode>, Event::Type event_type)
+void InodeWatcher::enqueue(Event::Type type, const String& name)
 {
     LOCKER(m_lock);
-    m_queue.enqueue({ event_type, {} });
+    // Whoever reads the overflow is going to rescan everything anyway.
+    if (m_queue_overflowed)
+        return;
+
+    // Only the most recent event about the same thing matters for coalescing.
+    for (ssize_t i = m_queue.size() - 1; i >= 0; --i) {
+        auto& queued_event = m_queue[i];
+        if (queued_event.name != name)
+            continue;
+        if (queued_event.type == type)
+            return;
+        if (queued_event.type == Event::Type::ChildAdded && type == Event::Type::ChildRemoved) {
+            // A child that came and went since the last read() is nobody's business.
+            m_queue.remove(i);
+            did_change_readiness();
+            return;
+        }
+        break;
+    }
+
+    if (m_queue.size() >= max_queued_events) {
+        m_queue.clear();
+        m_queue_overflowed = true;
+    } else {
+        m_queue.append({ type, name });
+    }
+    did_change_readiness();
+}
+
+void InodeWatcher::notify_inode_event(Badge<Inode>, Event::Type event_type)
+{
+    enqueue(event_type, {});
 }
 
 void InodeWatcher::notify_child_added(Badge<Inode>, const String& child_name)
 {
-    LOCKER(m_lock);
-    m_queue.enqueue({ Event::Type::ChildAdded, child_name });
+    enqueue(Event::Type::ChildAdded, child_name);
 }
 
 void InodeWatcher::notify_child_removed(Badge<Inode>, const String& child_name)
 {
-    LOCKER(m_lock);
-    m_queue.enqueue({ Event::Type::ChildRemoved, child_name });
+    enqueue(Event::Type::ChildRemoved, child_name);
 }
 
 }
@@ -27,8 +27,9 @@
 #pragma once
 
 #include <AK/Badge.h>
-#include <AK/CircularQueue.h>
+#include <AK/Vector.h>
 #include <AK/WeakPtr.h>
+#include <Kernel/API/InodeWatcherEvent.h>
 #include <Kernel/FileSystem/File.h>
 #include <Kernel/Lock.h>
 
@@ -42,15 +43,10 @@ public:
     virtual ~InodeWatcher() override;
 
     struct Event {
-        enum class Type {
-            Invalid = 0,
-            Modified,
-            ChildAdded,
-            ChildRemoved,
-        };
+        using Type = InodeWatcherEvent::Type;
 
         Type type { Type::Invalid };
-        String string;
+        String name;
     };
 
     virtual bool can_read(const FileDescription&, size_t) const override;
@@ -67,9 +63,14 @@ public:
 private:
     explicit InodeWatcher(Inode&);
 
+    void enqueue(Event::Type, const String& name);
+
+    static constexpr size_t max_queued_events = 128;
+
     Lock m_lock;
     WeakPtr<Inode> m_inode;
-    CircularQueue<Event, 32> m_queue;
+    Vector<Event> m_queue;
+    bool m_queue_overflowed { false };
 };
 
 }
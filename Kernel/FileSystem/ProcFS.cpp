@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/HashTable.h>
 #include <AK/JsonArraySerializer.h>
 #include <AK/JsonObject.h>
 #include <AK/JsonObjectSerializer.h>
@@ -55,6 +56,7 @@
 #include <Kernel/Scheduler.h>
 #include <Kernel/StdLib.h>
 #include <Kernel/TTY/TTY.h>
+#include <Kernel/VM/CompressedSwap.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/PurgeableVMObject.h>
 #include <LibC/errno_numbers.h>
@@ -85,6 +87,8 @@ enum ProcFileType {
     FI_Root_inodes,
     FI_Root_dmesg,
     FI_Root_interrupts,
+    FI_Root_syscalls,
+    FI_Root_locks,
     FI_Root_pci,
     FI_Root_devices,
     FI_Root_uptime,
@@ -304,6 +308,7 @@ Optional<KBuffer> procfs$pid_vm(InodeIdentifier identifier)
         region_object.add("stack", region.is_stack());
         region_object.add("shared", region.is_shared());
         region_object.add("user_accessible", region.is_user_accessible());
+        region_object.add("large_pages", region.is_using_large_pages());
         region_object.add("purgeable", region.vmobject().is_purgeable());
         if (region.vmobject().is_purgeable()) {
             region_object.add("volatile", static_cast<const PurgeableVMObject&>(region.vmobject()).is_volatile());
@@ -372,6 +377,43 @@ Optional<KBuffer> procfs$interrupts(InodeIdentifier)
     return builder.build();
 }
 
+Optional<KBuffer> procfs$syscalls(InodeIdentifier)
+{
+    KBufferBuilder builder;
+    JsonArraySerializer array { builder };
+    for (u32 i = 0; i < Syscall::Function::__Count; ++i) {
+        auto function = (Syscall::Function)i;
+        auto statistics = Syscall::statistics(function);
+        auto obj = array.add_object();
+        obj.add("name", Syscall::to_string(function));
+        obj.add("call_count", statistics.call_count);
+        obj.add("total_cycles", statistics.total_cycles);
+        // Bucket N counts calls that took less than 2^(N + 8) cycles.
+        auto histogram = obj.add_array("latency_histogram");
+        for (auto count : statistics.latency_histogram)
+            histogram.add(count);
+        histogram.finish();
+    }
+    array.finish();
+    return builder.build();
+}
+
+Optional<KBuffer> procfs$locks(InodeIdentifier)
+{
+    KBufferBuilder builder;
+    JsonArraySerializer array { builder };
+    for_each_lock_statistics([&](auto& statistics) {
+        auto obj = array.add_object();
+        obj.add("name", statistics.name);
+        obj.add("acquisitions", statistics.acquisitions.load(AK::MemoryOrder::memory_order_relaxed));
+        obj.add("contended_acquisitions", statistics.contended_acquisitions.load(AK::MemoryOrder::memory_order_relaxed));
+        obj.add("total_wait_cycles", statistics.total_wait_cycles.load(AK::MemoryOrder::memory_order_relaxed));
+        obj.add("max_hold_cycles", statistics.max_hold_cycles.load(AK::MemoryOrder::memory_order_relaxed));
+    });
+    array.finish();
+    return builder.build();
+}
+
 Optional<KBuffer> procfs$devices(InodeIdentifier)
 {
     KBufferBuilder builder;
@@ -430,33 +472,11 @@ Optional<KBuffer> procfs$modules(InodeIdentifier)
 
 Optional<KBuffer> procfs$profile(InodeIdentifier)
 {
-    InterruptDisabler disabler;
-    KBufferBuilder builder;
+    if (Profiling::pid() == PROFILE_ALL_PROCESSES && !Process::current()->is_superuser())
+        return {};
 
-    JsonObjectSerializer object(builder);
-    object.add("pid", Profiling::pid());
-    object.add("executable", Profiling::executable_path());
-
-    auto array = object.add_array("events");
-    bool mask_kernel_addresses = !Process::current()->is_superuser();
-    Profiling::for_each_sample([&](auto& sample) {
-        auto object = array.add_object();
-        object.add("type", "sample");
-        object.add("tid", sample.tid);
-        object.add("timestamp", sample.timestamp);
-        auto frames_array = object.add_array("stack");
-        for (size_t i = 0; i < Profiling::max_stack_frame_count; ++i) {
-            if (sample.frames[i] == 0)
-                break;
-            u32 address = (u32)sample.frames[i];
-            if (mask_kernel_addresses && !is_user_address(VirtualAddress(address)))
-                address = 0xdeadc0de;
-            frames_array.add(address);
-        }
-        frames_array.finish();
-    });
-    array.finish();
-    object.finish();
+    KBufferBuilder builder(Profiling::max_perfcore_size() + PAGE_SIZE);
+    Profiling::write_perfcore(builder, !Process::current()->is_superuser());
     return builder.build();
 }
 
@@ -504,7 +524,11 @@ Optional<KBuffer> procfs$net_tcp(InodeIdentifier)
 {
     KBufferBuilder builder;
     JsonArraySerializer array { builder };
-    TCPSocket::for_each([&array](auto& socket) {
+    // A socket moving from the connected table to the listening one may briefly be in both.
+    HashTable<const TCPSocket*> seen_sockets;
+    TCPSocket::for_each([&array, &seen_sockets](auto& socket) {
+        if (seen_sockets.set(&socket) == AK::HashSetResult::ReplacedExistingEntry)
+            return;
         auto obj = array.add_object();
         obj.add("local_address", socket.local_address().to_string());
         obj.add("local_port", socket.local_port());
@@ -770,8 +794,18 @@ Optional<KBuffer> procfs$memstat(InodeIdentifier)
     json.add("user_physical_available", MM.user_physical_pages() - MM.user_physical_pages_used());
     json.add("super_physical_allocated", MM.super_physical_pages_used());
     json.add("super_physical_available", MM.super_physical_pages() - MM.super_physical_pages_used());
+    json.add("large_pages_mapped", MM.large_pages_mapped());
+    json.add("memory_pressure", (u32)MM.memory_pressure());
+    json.add("compressed_swap_pages", CompressedSwap::the().stored_page_count());
+    json.add("compressed_swap_storage_pages", CompressedSwap::the().storage_page_count());
     json.add("kmalloc_call_count", g_kmalloc_call_count);
     json.add("kfree_call_count", g_kfree_call_count);
+    auto tlb_statistics = Processor::tlb_shootdown_statistics();
+    json.add("tlb_shootdowns", tlb_statistics.shootdowns);
+    json.add("tlb_shootdown_ipis", tlb_statistics.ipis_sent);
+    json.add("tlb_shootdown_cpus_skipped", tlb_statistics.cpus_skipped);
+    json.add("tlb_full_flushes", tlb_statistics.full_flushes);
+    json.add("tlb_batched_flushes", tlb_statistics.batched_flushes);
     slab_alloc_stats([&json](size_t slab_size, size_t num_allocated, size_t num_free) {
         auto prefix = String::format("slab_%zu", slab_size);
         json.add(String::format("%s_num_allocated", prefix.characters()), num_allocated);
@@ -1568,6 +1602,8 @@ ProcFS::ProcFS()
     m_entries[FI_Root_self] = { "self", FI_Root_self, false, procfs$self };
     m_entries[FI_Root_pci] = { "pci", FI_Root_pci, false, procfs$pci };
     m_entries[FI_Root_interrupts] = { "interrupts", FI_Root_interrupts, false, procfs$interrupts };
+    m_entries[FI_Root_syscalls] = { "syscalls", FI_Root_syscalls, false, procfs$syscalls };
+    m_entries[FI_Root_locks] = { "locks", FI_Root_locks, false, procfs$locks };
     m_entries[FI_Root_devices] = { "devices", FI_Root_devices, false, procfs$devices };
     m_entries[FI_Root_uptime] = { "uptime", FI_Root_uptime, false, procfs$uptime };
     m_entries[FI_Root_cmdline] = { "cmdline", FI_Root_cmdline, true, procfs$cmdline };
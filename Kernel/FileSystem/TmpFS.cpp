@@ -27,6 +27,7 @@
 #include <Kernel/FileSystem/TmpFS.h>
 #include <Kernel/Process.h>
 #include <Kernel/Thread.h>
+#include <Kernel/VM/MemoryManager.h>
 
 namespace Kernel {
 
@@ -139,6 +140,38 @@ KResult TmpFSInode::traverse_as_directory(Function<bool(const FS::DirectoryEntry
     return KSuccess;
 }
 
+RefPtr<PhysicalPage> TmpFSInode::page(size_t page_index) const
+{
+    ScopedSpinLock lock(m_pages_lock);
+    if (page_index >= m_pages.size())
+        return nullptr;
+    return m_pages[page_index];
+}
+
+KResultOr<RefPtr<PhysicalPage>> TmpFSInode::ensure_page(size_t page_index)
+{
+    if (auto existing_page = page(page_index))
+        return existing_page;
+
+    auto new_page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::Yes);
+    if (!new_page)
+        return KResult(-ENOMEM);
+
+    ScopedSpinLock lock(m_pages_lock);
+    // The file may have shrunk, or someone else may have filled the hole, while we were allocating.
+    if (page_index >= m_pages.size())
+        return RefPtr<PhysicalPage>();
+    auto& slot = m_pages[page_index];
+    if (!slot)
+        slot = move(new_page);
+    return RefPtr<PhysicalPage>(slot);
+}
+
+KResultOr<RefPtr<PhysicalPage>> TmpFSInode::physical_page_for_mapping(size_t page_index)
+{
+    return ensure_page(page_index);
+}
+
 ssize_t TmpFSInode::read_bytes(off_t offset, ssize_t size, u8* buffer, FileDescription*) const
 {
     LOCKER(m_lock, Lock::Mode::Shared);
@@ -146,17 +179,34 @@ ssize_t TmpFSInode::read_bytes(off_t offset, ssize_t size, u8* buffer, FileDescr
     ASSERT(size >= 0);
     ASSERT(offset >= 0);
 
-    if (!m_content.has_value())
-        return 0;
-
     if (offset >= m_metadata.size)
         return 0;
 
     if (static_cast<off_t>(size) > m_metadata.size - offset)
         size = m_metadata.size - offset;
 
-    memcpy(buffer, m_content.value().data() + offset, size);
-    return size;
+    // The buffer may be in userspace, so don't touch it while a page is quickmapped.
+    u8 page_buffer[PAGE_SIZE];
+    ssize_t nread = 0;
+    while (nread < size) {
+        size_t page_index = (offset + nread) / PAGE_SIZE;
+        size_t offset_in_page = (offset + nread) % PAGE_SIZE;
+        size_t chunk_size = min(PAGE_SIZE - offset_in_page, (size_t)(size - nread));
+
+        if (auto page = this->page(page_index)) {
+            {
+                ScopedSpinLock lock(s_mm_lock);
+                auto* page_ptr = MM.quickmap_page(*page);
+                memcpy(page_buffer, page_ptr + offset_in_page, chunk_size);
+                MM.unquickmap_page();
+            }
+            memcpy(buffer + nread, page_buffer, chunk_size);
+        } else {
+            memset(buffer + nread, 0, chunk_size);
+        }
+        nread += chunk_size;
+    }
+    return nread;
 }
 
 ssize_t TmpFSInode::write_bytes(off_t offset, ssize_t size, const u8* buffer, FileDescription*)
@@ -175,21 +225,10 @@ ssize_t TmpFSInode::write_bytes(off_t offset, ssize_t size, const u8* buffer, Fi
         new_size = offset + size;
 
     if (new_size > old_size) {
-        if (m_content.has_value() && m_content.value().capacity() >= (size_t)new_size) {
-            m_content.value().set_size(new_size);
-        } else {
-            // Grow the content buffer 2x the new sizeto accomodate repeating write() calls.
-            // Note that we're not actually committing physical memory to the buffer
-            // until it's needed. We only grow VM here.
-
-            // FIXME: Fix this so that no memcpy() is necessary, and we can just grow the
-            //        KBuffer and it will add physical pages as needed while keeping the
-            //        existing ones.
-            auto tmp = KBuffer::create_with_size(new_size * 2);
-            tmp.set_size(new_size);
-            if (m_content.has_value())
-                memcpy(tmp.data(), m_content.value().data(), old_size);
-            m_content = move(tmp);
+        // Only the page table grows here, pages are allocated as they are written.
+        {
+            ScopedSpinLock lock(m_pages_lock);
+            m_pages.resize(PAGE_ROUND_UP(new_size) / PAGE_SIZE);
         }
         m_metadata.size = new_size;
         set_metadata_dirty(true);
@@ -197,10 +236,32 @@ ssize_t TmpFSInode::write_bytes(off_t offset, ssize_t size, const u8* buffer, Fi
         inode_size_changed(old_size, new_size);
     }
 
-    memcpy(m_content.value().data() + offset, buffer, size);
-    inode_contents_changed(offset, size, buffer);
+    u8 page_buffer[PAGE_SIZE];
+    ssize_t nwritten = 0;
+    while (nwritten < size) {
+        size_t page_index = (offset + nwritten) / PAGE_SIZE;
+        size_t offset_in_page = (offset + nwritten) % PAGE_SIZE;
+        size_t chunk_size = min(PAGE_SIZE - offset_in_page, (size_t)(size - nwritten));
+
+        memcpy(page_buffer, buffer + nwritten, chunk_size);
+
+        // We hold m_lock, so nobody can shrink the file under us.
+        auto page_or_error = ensure_page(page_index);
+        if (page_or_error.is_error())
+            return nwritten ? nwritten : page_or_error.error();
+        auto page = page_or_error.value();
+        ASSERT(page);
+        {
+            ScopedSpinLock lock(s_mm_lock);
+            auto* page_ptr = MM.quickmap_page(*page);
+            memcpy(page_ptr + offset_in_page, page_buffer, chunk_size);
+            MM.unquickmap_page();
+        }
+        nwritten += chunk_size;
+    }
 
-    return size;
+    // Mappings of this file share our pages, so there is nothing to invalidate.
+    return nwritten;
 }
 
 RefPtr<Inode> TmpFSInode::lookup(StringView name)
@@ -322,31 +383,29 @@ KResult TmpFSInode::truncate(u64 size)
     LOCKER(m_lock);
     ASSERT(!is_directory());
 
-    if (size == 0)
-        m_content.clear();
-    else if (!m_content.has_value()) {
-        m_content = KBuffer::create_with_size(size);
-    } else if (static_cast<size_t>(size) < m_content.value().capacity()) {
-        size_t prev_size = m_metadata.size;
-        m_content.value().set_size(size);
-        if (prev_size < static_cast<size_t>(size))
-            memset(m_content.value().data() + prev_size, 0, size - prev_size);
-    } else {
-        size_t prev_size = m_metadata.size;
-        KBuffer tmp = KBuffer::create_with_size(size);
-        memcpy(tmp.data(), m_content.value().data(), prev_size);
-        m_content = move(tmp);
+    size_t old_size = m_metadata.size;
+    RefPtr<PhysicalPage> last_page;
+    {
+        ScopedSpinLock lock(m_pages_lock);
+        m_pages.resize(PAGE_ROUND_UP(size) / PAGE_SIZE);
+        if (!m_pages.is_empty())
+            last_page = m_pages.last();
+    }
+
+    // Keep the bytes past the end of the file zeroed, so that growing it again reads zeroes.
+    size_t offset_in_last_page = size % PAGE_SIZE;
+    if (size < old_size && offset_in_last_page && last_page) {
+        ScopedSpinLock lock(s_mm_lock);
+        auto* page_ptr = MM.quickmap_page(*last_page);
+        memset(page_ptr + offset_in_last_page, 0, PAGE_SIZE - offset_in_last_page);
+        MM.unquickmap_page();
     }
 
-    size_t old_size = m_metadata.size;
     m_metadata.size = size;
     notify_watchers();
 
-    if (old_size != (size_t)size) {
+    if (old_size != (size_t)size)
         inode_size_changed(old_size, size);
-        if (m_content.has_value())
-            inode_contents_changed(0, size, m_content.value().data());
-    }
 
     return KSuccess;
 }
@@ -30,7 +30,8 @@
 #include <AK/Optional.h>
 #include <Kernel/FileSystem/FileSystem.h>
 #include <Kernel/FileSystem/Inode.h>
-#include <Kernel/KBuffer.h>
+#include <Kernel/SpinLock.h>
+#include <Kernel/VM/PhysicalPage.h>
 
 namespace Kernel {
 
@@ -91,6 +92,7 @@ public:
     virtual int set_ctime(time_t) override;
     virtual int set_mtime(time_t) override;
     virtual void one_ref_left() override;
+    virtual KResultOr<RefPtr<PhysicalPage>> physical_page_for_mapping(size_t page_index) override;
 
 private:
     TmpFSInode(TmpFS& fs, InodeMetadata metadata, InodeIdentifier parent);
@@ -99,10 +101,20 @@ private:
 
     void notify_watchers();
 
+    RefPtr<PhysicalPage> page(size_t page_index) const;
+    KResultOr<RefPtr<PhysicalPage>> ensure_page(size_t page_index);
+
     InodeMetadata m_metadata;
     InodeIdentifier m_parent;
 
-    Optional<KBuffer> m_content;
+    // The file's contents, one physical page per PAGE_SIZE bytes. Holes are null
+    // and read as zeroes. Bytes past the end of the file in the last page are
+    // always zero. m_lock serializes changes to the contents, while m_pages_lock
+    // protects the vector itself, since page faults look into it without m_lock.
+    // Page faults hold the MM lock when they do, so nothing may allocate, quickmap
+    // or otherwise take the MM lock while holding m_pages_lock.
+    Vector<RefPtr<PhysicalPage>> m_pages;
+    mutable SpinLock<u8> m_pages_lock;
     struct Child {
         FS::DirectoryEntry entry;
         NonnullRefPtr<TmpFSInode> inode;
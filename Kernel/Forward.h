@@ -34,8 +34,11 @@ class Custody;
 class Device;
 class DiskCache;
 class DoubleBuffer;
+class EventPoll;
+class EventPollEntry;
 class File;
 class FileDescription;
+class FutexQueue;
 class IPv4Socket;
 class Inode;
 class InodeIdentifier;
@@ -45,6 +48,7 @@ class KBuffer;
 class KResult;
 class LocalSocket;
 class MappedROM;
+class MemoryPressureWatcher;
 class PageDirectory;
 class PerformanceEventBuffer;
 class PhysicalPage;
@@ -63,6 +67,7 @@ class RecursiveSpinLock;
 template <typename BaseType, typename LockType> class ScopedSpinLock;
 class TCPSocket;
 class TTY;
+class TLBFlushBatch;
 class Thread;
 class UDPSocket;
 class VFS;
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/HashMap.h>
+#include <Kernel/FutexQueue.h>
+#include <Kernel/Lock.h>
+#include <Kernel/SpinLock.h>
+#include <Kernel/Thread.h>
+
+namespace Kernel {
+
+struct SharedFutexKey {
+    const VMObject* vmobject { nullptr };
+    size_t offset { 0 };
+
+    bool operator==(const SharedFutexKey& other) const { return vmobject == other.vmobject && offset == other.offset; }
+};
+
+}
+
+namespace AK {
+template<>
+struct Traits<Kernel::SharedFutexKey> : public GenericTraits<Kernel::SharedFutexKey> {
+    static unsigned hash(const Kernel::SharedFutexKey& key) { return pair_int_hash(ptr_hash(key.vmobject), key.offset); }
+};
+}
+
+namespace Kernel {
+
+static Lock& shared_futex_lock()
+{
+    static Lock* lock;
+    if (!lock)
+        lock = new Lock("SharedFutexQueues");
+    return *lock;
+}
+
+static HashMap<SharedFutexKey, NonnullRefPtr<FutexQueue>>& shared_futex_queues()
+{
+    static HashMap<SharedFutexKey, NonnullRefPtr<FutexQueue>>* map;
+    if (!map)
+        map = new HashMap<SharedFutexKey, NonnullRefPtr<FutexQueue>>;
+    return *map;
+}
+
+NonnullRefPtr<FutexQueue> FutexQueue::find_or_create_shared(VMObject& vmobject, size_t offset_in_vmobject)
+{
+    LOCKER(shared_futex_lock());
+    SharedFutexKey key { &vmobject, offset_in_vmobject };
+    auto it = shared_futex_queues().find(key);
+    if (it != shared_futex_queues().end())
+        return it->value;
+    auto queue = adopt(*new FutexQueue(vmobject, offset_in_vmobject));
+    shared_futex_queues().set(key, queue);
+    return queue;
+}
+
+RefPtr<FutexQueue> FutexQueue::find_shared(VMObject& vmobject, size_t offset_in_vmobject)
+{
+    LOCKER(shared_futex_lock());
+    auto it = shared_futex_queues().find({ &vmobject, offset_in_vmobject });
+    if (it == shared_futex_queues().end())
+        return nullptr;
+    return it->value;
+}
+
+void FutexQueue::release(RefPtr<FutexQueue>& queue)
+{
+    if (!queue)
+        return;
+    if (!queue->is_shared()) {
+        queue = nullptr;
+        return;
+    }
+    RefPtr<FutexQueue> unused_queue;
+    {
+        LOCKER(shared_futex_lock());
+        // The table and the caller hold the only references, and nobody is
+        // sleeping on it (including threads requeued here from elsewhere).
+        if (queue->ref_count() == 2 && queue->m_wait_queue.is_empty()) {
+            auto it = shared_futex_queues().find({ queue->m_vmobject.ptr(), queue->m_offset_in_vmobject });
+            ASSERT(it != shared_futex_queues().end());
+            unused_queue = it->value;
+            shared_futex_queues().remove(it);
+        }
+        queue = nullptr;
+    }
+    // Let go of the VMObject outside the lock.
+    unused_queue = nullptr;
+}
+
+// Keeps a waiter's queue from changing under us, taken before any WaitQueue lock.
+static SpinLock<u8> s_waiter_queue_lock;
+
+void FutexQueue::start_waiting(Thread& thread, RefPtr<FutexQueue>&& queue)
+{
+    // Nobody can requeue us before we're actually on the queue.
+    ASSERT(!thread.futex_queue());
+    thread.futex_queue() = move(queue);
+}
+
+RefPtr<FutexQueue> FutexQueue::stop_waiting(Thread& thread)
+{
+    ScopedSpinLock lock(s_waiter_queue_lock);
+    auto queue = move(thread.futex_queue());
+    if (queue)
+        queue->m_wait_queue.dequeue(thread);
+    return queue;
+}
+
+u32 FutexQueue::requeue_to(FutexQueue& target, u32 count)
+{
+    ScopedSpinLock lock(s_waiter_queue_lock);
+    // We hold a reference to ourselves, so handing each waiter's over can't be the last one.
+    return m_wait_queue.move_to(target.m_wait_queue, count, [&](Thread& thread) {
+        ASSERT(thread.futex_queue() == this);
+        thread.futex_queue() = target;
+    });
+}
+
+FutexQueue::~FutexQueue()
+{
+}
+
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/NonnullRefPtr.h>
+#include <AK/RefCounted.h>
+#include <AK/RefPtr.h>
+#include <Kernel/VM/VMObject.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+class FutexQueue : public RefCounted<FutexQueue> {
+public:
+    static NonnullRefPtr<FutexQueue> create() { return adopt(*new FutexQueue(nullptr, 0)); }
+
+    // Futexes in shared memory are keyed by the VMObject and offset backing them
+    // rather than by virtual address, so every process mapping the object finds
+    // the same queue.
+    static NonnullRefPtr<FutexQueue> find_or_create_shared(VMObject&, size_t offset_in_vmobject);
+
+    // Like find_or_create_shared(), but for callers that only want to wake or
+    // move existing waiters: if there's no queue, there's nobody to wake.
+    static RefPtr<FutexQueue> find_shared(VMObject&, size_t offset_in_vmobject);
+
+    // Drops the caller's reference, removing a shared queue from the global
+    // table once nobody else is using or waiting on it. Waiters hold their
+    // reference from before they check the futex value until they're done
+    // sleeping, so a wake that finds nobody sleeping yet is never lost.
+    static void release(RefPtr<FutexQueue>&);
+
+    // A waiter hands its reference to its thread while it sleeps, so that
+    // requeue_to() can pass it on to whichever queue the waiter ends up on.
+    // stop_waiting() takes the waiter off that queue (in case it timed out
+    // there) and gives the reference back for the waiter to release().
+    static void start_waiting(Thread&, RefPtr<FutexQueue>&&);
+    static RefPtr<FutexQueue> stop_waiting(Thread&);
+
+    // Moves up to count waiters over to the target queue without waking them.
+    u32 requeue_to(FutexQueue& target, u32 count);
+
+    ~FutexQueue();
+
+    bool is_shared() const { return !m_vmobject.is_null(); }
+    WaitQueue& wait_queue() { return m_wait_queue; }
+
+private:
+    FutexQueue(RefPtr<VMObject>&& vmobject, size_t offset_in_vmobject)
+        : m_vmobject(move(vmobject))
+        , m_offset_in_vmobject(offset_in_vmobject)
+    {
+    }
+
+    WaitQueue m_wait_queue;
+    RefPtr<VMObject> m_vmobject;
+    size_t m_offset_in_vmobject { 0 };
+};
+
+}
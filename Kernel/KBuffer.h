@@ -40,6 +40,7 @@
 #include <AK/ByteBuffer.h>
 #include <AK/LogStream.h>
 #include <AK/Memory.h>
+#include <AK/Optional.h>
 #include <AK/StringView.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/Region.h>
@@ -55,6 +56,16 @@ public:
         return adopt(*new KBufferImpl(region.release_nonnull(), size));
     }
 
+    // Commits all of the memory up front, and returns null instead of asserting
+    // if that isn't possible. Use this for sizes that userspace gets to choose.
+    static RefPtr<KBufferImpl> try_create_with_size(size_t size, u8 access, const char* name)
+    {
+        auto region = MM.allocate_kernel_region(PAGE_ROUND_UP(size), name, access, false, false);
+        if (!region || !region->commit())
+            return nullptr;
+        return adopt(*new KBufferImpl(region.release_nonnull(), size));
+    }
+
     static NonnullRefPtr<KBufferImpl> copy(const void* data, size_t size, u8 access, const char* name)
     {
         auto buffer = create_with_size(size, access, name);
@@ -95,6 +106,14 @@ public:
         return KBuffer(KBufferImpl::create_with_size(size, access, name));
     }
 
+    static Optional<KBuffer> try_create_with_size(size_t size, u8 access = Region::Access::Read | Region::Access::Write, const char* name = "KBuffer")
+    {
+        auto impl = KBufferImpl::try_create_with_size(size, access, name);
+        if (!impl)
+            return {};
+        return KBuffer(impl.release_nonnull());
+    }
+
     static KBuffer copy(const void* data, size_t size, u8 access = Region::Access::Read | Region::Access::Write, const char* name = "KBuffer")
     {
         return KBuffer(KBufferImpl::copy(data, size, access, name));
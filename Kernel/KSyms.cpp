@@ -24,7 +24,9 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Atomic.h>
 #include <AK/Demangle.h>
+#include <AK/QuickSort.h>
 #include <AK/TemporaryChange.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/KSyms.h>
@@ -58,15 +60,44 @@ u32 address_for_kernel_symbol(const StringView& name)
     return 0;
 }
 
+// A small direct-mapped cache in front of the binary search, since backtraces
+// and profiles keep asking about the same few return addresses. Each slot only
+// remembers a symbol index which is validated against the address on use, so
+// racing updates from several CPUs can at worst cause a miss.
+static constexpr size_t symbol_cache_size = 256;
+static Atomic<u32> s_symbol_cache[symbol_cache_size];
+
+static bool symbol_contains_address(size_t index, u32 address)
+{
+    if (index >= s_symbol_count || address < s_symbols[index].address)
+        return false;
+    return index == s_symbol_count - 1 || address < s_symbols[index + 1].address;
+}
+
 const KernelSymbol* symbolicate_kernel_address(u32 address)
 {
     if (address < g_lowest_kernel_symbol_address || address > g_highest_kernel_symbol_address)
         return nullptr;
-    for (unsigned i = 0; i < s_symbol_count; ++i) {
-        if (address < s_symbols[i + 1].address)
-            return &s_symbols[i];
+
+    auto& cache_slot = s_symbol_cache[(address >> 2) % symbol_cache_size];
+    size_t cached_index = cache_slot.load(AK::MemoryOrder::memory_order_relaxed);
+    if (symbol_contains_address(cached_index, address))
+        return &s_symbols[cached_index];
+
+    // Find the last symbol whose address is <= the given address.
+    size_t low = 0;
+    size_t high = s_symbol_count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (s_symbols[middle].address > address)
+            high = middle;
+        else
+            low = middle + 1;
     }
-    return nullptr;
+    if (low == 0)
+        return nullptr;
+    cache_slot.store(low - 1, AK::MemoryOrder::memory_order_relaxed);
+    return &s_symbols[low - 1];
 }
 
 static void load_kernel_sybols_from_data(const ByteBuffer& buffer)
@@ -112,6 +143,21 @@ static void load_kernel_sybols_from_data(const ByteBuffer& buffer)
         ++bufptr;
         ++current_symbol_index;
     }
+    s_symbol_count = current_symbol_index;
+
+    // The map is generated sorted by nm, but lookups rely on it, so make sure.
+    for (size_t i = 1; i < s_symbol_count; ++i) {
+        if (s_symbols[i].address < s_symbols[i - 1].address) {
+            quick_sort(s_symbols, s_symbols + s_symbol_count, [](auto& a, auto& b) {
+                return a.address < b.address;
+            });
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < symbol_cache_size; ++i)
+        s_symbol_cache[i].store(s_symbol_count, AK::MemoryOrder::memory_order_relaxed);
+
     g_kernel_symbols_available = true;
 }
 
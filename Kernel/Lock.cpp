@@ -27,10 +27,22 @@
 #include <AK/TemporaryChange.h>
 #include <Kernel/KSyms.h>
 #include <Kernel/Lock.h>
+#include <Kernel/StdLib.h>
 #include <Kernel/Thread.h>
 
 namespace Kernel {
 
+// Locks are grouped by name, and there are only a few dozen distinct names.
+// Anything past the table's capacity is counted under a catch-all entry.
+static constexpr size_t max_lock_statistics = 128;
+static LockStatistics s_lock_statistics[max_lock_statistics];
+static size_t s_lock_statistics_count;
+static SpinLock<u8> s_lock_statistics_lock;
+
+// How often a thread re-checks a lock whose holder is running on another
+// processor before giving up and going to sleep.
+static constexpr u32 max_lock_spins = 100;
+
 static bool modes_conflict(Lock::Mode mode1, Lock::Mode mode2)
 {
     if (mode1 == Lock::Mode::Unlocked || mode2 == Lock::Mode::Unlocked)
@@ -42,6 +54,93 @@ static bool modes_conflict(Lock::Mode mode1, Lock::Mode mode2)
     return true;
 }
 
+static bool should_record_lock_statistics()
+{
+    return Processor::current().has_feature(CPUFeature::TSC);
+}
+
+void for_each_lock_statistics(Function<void(const LockStatistics&)> callback)
+{
+    size_t count;
+    {
+        ScopedSpinLock lock(s_lock_statistics_lock);
+        count = s_lock_statistics_count;
+    }
+    for (size_t i = 0; i < count; ++i)
+        callback(s_lock_statistics[i]);
+}
+
+LockStatistics* Lock::statistics()
+{
+    if (m_statistics)
+        return m_statistics;
+
+    const char* name = m_name ? m_name : "(unnamed)";
+    ScopedSpinLock lock(s_lock_statistics_lock);
+    for (size_t i = 0; i < s_lock_statistics_count; ++i) {
+        if (!strcmp(s_lock_statistics[i].name, name)) {
+            m_statistics = &s_lock_statistics[i];
+            return m_statistics;
+        }
+    }
+    if (s_lock_statistics_count == max_lock_statistics - 1) {
+        m_statistics = &s_lock_statistics[max_lock_statistics - 1];
+        if (!m_statistics->name) {
+            m_statistics->name = "(other)";
+            ++s_lock_statistics_count;
+        }
+        return m_statistics;
+    }
+    if (s_lock_statistics_count == max_lock_statistics) {
+        m_statistics = &s_lock_statistics[max_lock_statistics - 1];
+        return m_statistics;
+    }
+    m_statistics = &s_lock_statistics[s_lock_statistics_count++];
+    m_statistics->name = name;
+    return m_statistics;
+}
+
+void Lock::did_acquire(bool contended, u64 wait_start_cycles)
+{
+    auto* statistics = this->statistics();
+    statistics->acquisitions.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+    if (!contended)
+        return;
+    statistics->contended_acquisitions.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+    // We may have been migrated to a processor whose TSC is behind.
+    u64 now = read_tsc();
+    if (now > wait_start_cycles)
+        statistics->total_wait_cycles.fetch_add(now - wait_start_cycles, AK::MemoryOrder::memory_order_relaxed);
+}
+
+void Lock::did_release()
+{
+    if (!m_hold_start_cycles)
+        return;
+    u64 now = read_tsc();
+    if (now <= m_hold_start_cycles)
+        return;
+    u64 held_cycles = now - m_hold_start_cycles;
+    auto& max_hold_cycles = statistics()->max_hold_cycles;
+    u64 previous_max = max_hold_cycles.load(AK::MemoryOrder::memory_order_relaxed);
+    while (held_cycles > previous_max) {
+        if (max_hold_cycles.compare_exchange_strong(previous_max, held_cycles, AK::MemoryOrder::memory_order_relaxed))
+            break;
+    }
+}
+
+bool Lock::should_spin_on_holder() const
+{
+    // Sleeping and being woken up again costs a lot more than a short
+    // wait for a holder that is busy on another processor.
+    if (Processor::count() < 2)
+        return false;
+    auto* holder = m_holder;
+    if (!holder || holder == Thread::current())
+        return false;
+    return holder->state() == Thread::Running && holder->cpu() != Processor::current().id();
+}
+
 void Lock::lock(Mode mode)
 {
     ASSERT(mode != Mode::Unlocked);
@@ -51,23 +150,54 @@ void Lock::lock(Mode mode)
         Processor::halt();
     }
     auto current_thread = Thread::current();
+    bool record_statistics = should_record_lock_statistics();
+    bool contended = false;
+    bool counted_as_exclusive_waiter = false;
+    u64 wait_start_cycles = 0;
+    u32 spins_left = max_lock_spins;
     for (;;) {
         bool expected = false;
         if (m_lock.compare_exchange_strong(expected, true, AK::memory_order_acq_rel)) {
             do {
-                // FIXME: Do not add new readers if writers are queued.
                 bool modes_dont_conflict = !modes_conflict(m_mode, mode);
                 bool already_hold_exclusive_lock = m_mode == Mode::Exclusive && m_holder == current_thread;
-                if (modes_dont_conflict || already_hold_exclusive_lock) {
+                // Readers let queued writers go first, so that a steady stream of them
+                // can't starve writers. A thread that already holds some lock shared
+                // is exempt, since it may be holding this one and would deadlock.
+                bool must_wait_for_writers = mode == Mode::Shared && m_exclusive_waiters && !current_thread->holds_shared_locks();
+                if (already_hold_exclusive_lock || (modes_dont_conflict && !must_wait_for_writers)) {
                     // We got the lock!
-                    if (!already_hold_exclusive_lock)
+                    if (counted_as_exclusive_waiter)
+                        --m_exclusive_waiters;
+                    if (!already_hold_exclusive_lock) {
                         m_mode = mode;
+                        if (mode == Mode::Shared)
+                            current_thread->did_lock_shared();
+                    }
                     m_holder = current_thread;
-                    m_times_locked++;
+                    if (m_times_locked++ == 0)
+                        m_hold_start_cycles = record_statistics ? read_tsc() : 0;
                     m_lock.store(false, AK::memory_order_release);
+                    if (record_statistics)
+                        did_acquire(contended, wait_start_cycles);
                     return;
                 }
-             } while (current_thread->wait_on(m_queue, m_name, nullptr, &m_lock, m_holder) == Thread::BlockResult::NotBlocked);
+                if (!contended) {
+                    contended = true;
+                    if (record_statistics)
+                        wait_start_cycles = read_tsc();
+                }
+                if (mode == Mode::Exclusive && !counted_as_exclusive_waiter) {
+                    counted_as_exclusive_waiter = true;
+                    ++m_exclusive_waiters;
+                }
+                if (spins_left && should_spin_on_holder()) {
+                    --spins_left;
+                    m_lock.store(false, AK::memory_order_release);
+                    Processor::wait_check();
+                    break;
+                }
+            } while (current_thread->wait_on(m_queue, m_name, nullptr, &m_lock, m_holder) == Thread::BlockResult::NotBlocked);
         } else if (Processor::current().in_critical()) {
             // If we're in a critical section and trying to lock, no context
             // switch will happen, so yield.
@@ -84,6 +214,36 @@ void Lock::lock(Mode mode)
     }
 }
 
+bool Lock::try_lock(Mode mode)
+{
+    ASSERT(mode != Mode::Unlocked);
+    auto current_thread = Thread::current();
+    bool expected = false;
+    if (!m_lock.compare_exchange_strong(expected, true, AK::memory_order_acq_rel))
+        return false;
+
+    bool already_hold_exclusive_lock = m_mode == Mode::Exclusive && m_holder == current_thread;
+    bool must_wait_for_writers = mode == Mode::Shared && m_exclusive_waiters && !current_thread->holds_shared_locks();
+    if (!already_hold_exclusive_lock && (modes_conflict(m_mode, mode) || must_wait_for_writers)) {
+        m_lock.store(false, AK::memory_order_release);
+        return false;
+    }
+
+    if (!already_hold_exclusive_lock) {
+        m_mode = mode;
+        if (mode == Mode::Shared)
+            current_thread->did_lock_shared();
+    }
+    m_holder = current_thread;
+    bool record_statistics = should_record_lock_statistics();
+    if (m_times_locked++ == 0)
+        m_hold_start_cycles = record_statistics ? read_tsc() : 0;
+    m_lock.store(false, AK::memory_order_release);
+    if (record_statistics)
+        did_acquire(false, 0);
+    return true;
+}
+
 void Lock::unlock()
 {
     auto current_thread = Thread::current();
@@ -96,6 +256,8 @@ void Lock::unlock()
             ASSERT(m_mode != Mode::Unlocked);
             if (m_mode == Mode::Exclusive)
                 ASSERT(m_holder == current_thread);
+            else
+                current_thread->did_unlock_shared();
             if (m_holder == current_thread && (m_mode == Mode::Shared || m_times_locked == 0))
                 m_holder = nullptr;
 
@@ -103,7 +265,15 @@ void Lock::unlock()
                 m_lock.store(false, AK::memory_order_release);
                 return;
             }
+            did_release();
             m_mode = Mode::Unlocked;
+            if (m_exclusive_waiters) {
+                // The first waiter may be a reader that would only go back to
+                // sleep behind the writers, so let everyone have another go.
+                m_lock.store(false, AK::memory_order_release);
+                m_queue.wake_all();
+                return;
+            }
             m_queue.wake_one(&m_lock);
             return;
         }
@@ -130,7 +300,11 @@ bool Lock::force_unlock_if_locked()
     m_holder = nullptr;
     m_mode = Mode::Unlocked;
     m_times_locked = 0;
-    m_queue.wake_one();
+    did_release();
+    if (m_exclusive_waiters)
+        m_queue.wake_all();
+    else
+        m_queue.wake_one();
     return true;
 }
 
@@ -28,6 +28,7 @@
 
 #include <AK/Assertions.h>
 #include <AK/Atomic.h>
+#include <AK/Function.h>
 #include <AK/Types.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Forward.h>
@@ -35,6 +36,15 @@
 
 namespace Kernel {
 
+// Contention statistics, aggregated over all locks that share a name.
+struct LockStatistics {
+    const char* name { nullptr };
+    Atomic<u32> acquisitions;
+    Atomic<u32> contended_acquisitions;
+    Atomic<u64> total_wait_cycles;
+    Atomic<u64> max_hold_cycles;
+};
+
 class Lock {
 public:
     Lock(const char* name = nullptr)
@@ -50,6 +60,9 @@ public:
     };
 
     void lock(Mode = Mode::Exclusive);
+    // Takes the lock only if that can be done without waiting. Unlike lock(),
+    // this may be called with interrupts disabled.
+    [[nodiscard]] bool try_lock(Mode = Mode::Exclusive);
     void unlock();
     bool force_unlock_if_locked();
     bool is_locked() const { return m_holder; }
@@ -58,11 +71,24 @@ public:
     const char* name() const { return m_name; }
 
 private:
+    bool should_spin_on_holder() const;
+    LockStatistics* statistics();
+    void did_acquire(bool contended, u64 wait_start_cycles);
+    void did_release();
+
     Atomic<bool> m_lock { false };
     const char* m_name { nullptr };
     WaitQueue m_queue;
     Mode m_mode { Mode::Unlocked };
 
+    // Threads waiting to lock exclusively. New shared lockers queue up
+    // behind them instead of joining the current readers.
+    u32 m_exclusive_waiters { 0 };
+
+    // TSC value at the time the lock went from unlocked to locked.
+    u64 m_hold_start_cycles { 0 };
+    LockStatistics* m_statistics { nullptr };
+
     // When locked exclusively, only the thread already holding the lock can
     // lock it again. When locked in shared mode, any thread can do that.
     u32 m_times_locked { 0 };
@@ -92,6 +118,8 @@ private:
 
 #define LOCKER(...) Locker locker(__VA_ARGS__)
 
+void for_each_lock_statistics(Function<void(const LockStatistics&)>);
+
 template<typename T>
 class Lockable {
 public:
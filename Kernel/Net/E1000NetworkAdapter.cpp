@@ -57,6 +57,7 @@ namespace Kernel {
 #define REG_RADV 0x282C             // RX Int. Absolute Delay Timer
 #define REG_RSRPD 0x2C00            // RX Small Packet Detect Interrupt
 #define REG_TIPG 0x0410             // Transmit Inter Packet Gap
+#define REG_RXCSUM 0x5000           // RX Checksum Control
 #define ECTRL_SLU 0x40              //set link up
 #define RCTL_EN (1 << 1)            // Receiver Enable
 #define RCTL_SBP (1 << 2)           // Store Bad Packets
@@ -96,9 +97,29 @@ namespace Kernel {
 #define CMD_IC (1 << 2)   // Insert Checksum
 #define CMD_RS (1 << 3)   // Report Status
 #define CMD_RPS (1 << 4)  // Report Packet Sent
+#define CMD_DEXT (1 << 5) // Descriptor Extension
 #define CMD_VLE (1 << 6)  // VLAN Packet Enable
 #define CMD_IDE (1 << 7)  // Interrupt Delay Enable
 
+// Extended transmit descriptors (stored where legacy descriptors have CSO and CSS)
+
+#define DTYP_DATA (1 << 4)   // Data descriptor (a context descriptor has DTYP 0)
+#define POPTS_TXSM (1 << 1)  // Insert TCP/UDP checksum
+
+// RXCSUM Register
+
+#define RXCSUM_IPOFL (1 << 8) // IP Checksum Offload Enable
+#define RXCSUM_TUOFL (1 << 9) // TCP/UDP Checksum Offload Enable
+
+// Receive descriptor status and errors
+
+#define RXSTATUS_DD (1 << 0)    // Descriptor Done
+#define RXSTATUS_IXSM (1 << 2)  // Ignore Checksum Indication
+#define RXSTATUS_TCPCS (1 << 5) // TCP/UDP Checksum Calculated
+#define RXSTATUS_IPCS (1 << 6)  // IP Checksum Calculated
+#define RXERROR_TCPE (1 << 5)   // TCP/UDP Checksum Error
+#define RXERROR_IPE (1 << 6)    // IP Checksum Error
+
 // TCTL Register
 
 #define TCTL_EN (1 << 1)      // Transmit Enable
@@ -295,6 +316,7 @@ void E1000NetworkAdapter::initialize_rx_descriptors()
     out32(REG_RXDESCHEAD, 0);
     out32(REG_RXDESCTAIL, number_of_rx_descriptors - 1);
 
+    out32(REG_RXCSUM, in32(REG_RXCSUM) | RXCSUM_IPOFL | RXCSUM_TUOFL);
     out32(REG_RCTRL, RCTL_EN | RCTL_SBP | RCTL_UPE | RCTL_MPE | RCTL_LBM_NONE | RTCL_RDMTS_HALF | RCTL_BAM | RCTL_SECRC | RCTL_BSIZE_8192);
 }
 
@@ -390,6 +412,18 @@ u32 E1000NetworkAdapter::in32(u16 address)
 }
 
 void E1000NetworkAdapter::send_raw(const u8* data, size_t length)
+{
+    send_packet(data, length, {});
+}
+
+void E1000NetworkAdapter::send_raw_with_checksum_offload(const u8* data, size_t length, size_t checksum_start, size_t checksum_offset)
+{
+    ASSERT(checksum_start <= 0xff);
+    ASSERT(checksum_offset <= 0xff);
+    send_packet(data, length, ChecksumOffload { (u8)checksum_start, (u8)checksum_offset });
+}
+
+void E1000NetworkAdapter::send_packet(const u8* data, size_t length, Optional<ChecksumOffload> checksum_offload)
 {
     disable_irq();
     size_t tx_current = in32(REG_TXDESCTAIL) % number_of_tx_descriptors;
@@ -397,13 +431,43 @@ void E1000NetworkAdapter::send_raw(const u8* data, size_t length)
     klog() << "E1000: Sending packet (" << length << " bytes)";
 #endif
     auto* tx_descriptors = (e1000_tx_desc*)m_tx_descriptors_region->vaddr().as_ptr();
+
+    // The checksum start and offset are set up by a context descriptor, which
+    // the device remembers, so we only queue one when they change.
+    if (checksum_offload.has_value() && (!m_tx_checksum_context.has_value() || m_tx_checksum_context.value() != checksum_offload.value())) {
+        auto& context = *(e1000_tx_context_desc*)&tx_descriptors[tx_current];
+        context.ipcss = 0;
+        context.ipcso = 0;
+        context.ipcse = 0;
+        context.tucss = checksum_offload.value().start;
+        context.tucso = checksum_offload.value().offset;
+        context.tucse = 0; // Checksum up to the end of the packet.
+        context.cmd_and_length = CMD_DEXT << 24;
+        context.status = 0;
+        context.hdr_len = 0;
+        context.mss = 0;
+        m_tx_checksum_context = checksum_offload;
+        tx_current = (tx_current + 1) % number_of_tx_descriptors;
+    }
+
     auto& descriptor = tx_descriptors[tx_current];
     ASSERT(length <= 8192);
     auto* vptr = (void*)m_tx_buffers_regions[tx_current].vaddr().as_ptr();
     memcpy(vptr, data, length);
+    // This slot may have been used for a context descriptor before.
+    descriptor.addr = m_tx_buffers_regions[tx_current].physical_page(0)->paddr().get();
     descriptor.length = length;
     descriptor.status = 0;
-    descriptor.cmd = CMD_EOP | CMD_IFCS | CMD_RS;
+    descriptor.special = 0;
+    if (checksum_offload.has_value()) {
+        descriptor.cso = DTYP_DATA;
+        descriptor.cmd = CMD_EOP | CMD_IFCS | CMD_RS | CMD_DEXT;
+        descriptor.css = POPTS_TXSM;
+    } else {
+        descriptor.cso = 0;
+        descriptor.cmd = CMD_EOP | CMD_IFCS | CMD_RS;
+        descriptor.css = 0;
+    }
 #ifdef E1000_DEBUG
     klog() << "E1000: Using tx descriptor " << tx_current << " (head is at " << in32(REG_TXDESCHEAD) << ")";
 #endif
@@ -425,23 +489,32 @@ void E1000NetworkAdapter::send_raw(const u8* data, size_t length)
 
 void E1000NetworkAdapter::receive()
 {
-    auto* rx_descriptors = (e1000_tx_desc*)m_rx_descriptors_region->vaddr().as_ptr();
+    auto* rx_descriptors = (e1000_rx_desc*)m_rx_descriptors_region->vaddr().as_ptr();
     u32 rx_current;
     for (;;) {
         rx_current = in32(REG_RXDESCTAIL) % number_of_rx_descriptors;
         if (rx_current == (in32(REG_RXDESCHEAD) % number_of_rx_descriptors))
             return;
         rx_current = (rx_current + 1) % number_of_rx_descriptors;
-        if (!(rx_descriptors[rx_current].status & 1))
+        auto& descriptor = rx_descriptors[rx_current];
+        if (!(descriptor.status & RXSTATUS_DD))
             break;
         auto* buffer = m_rx_buffers_regions[rx_current].vaddr().as_ptr();
-        u16 length = rx_descriptors[rx_current].length;
+        u16 length = descriptor.length;
         ASSERT(length <= 8192);
 #ifdef E1000_DEBUG
         klog() << "E1000: Received 1 packet @ " << buffer << " (" << length << ") bytes!";
 #endif
-        did_receive(buffer, length);
-        rx_descriptors[rx_current].status = 0;
+        bool checksum_verified = !(descriptor.status & RXSTATUS_IXSM) && (descriptor.status & (RXSTATUS_IPCS | RXSTATUS_TCPCS));
+        if (checksum_verified && (descriptor.errors & (RXERROR_IPE | RXERROR_TCPE))) {
+#ifdef E1000_DEBUG
+            klog() << "E1000: Dropping packet with bad checksum (errors=" << String::format("%b", descriptor.errors) << ")";
+#endif
+        } else {
+            did_receive(buffer, length);
+        }
+        descriptor.errors = 0;
+        descriptor.status = 0;
         out32(REG_RXDESCTAIL, rx_current);
     }
 }
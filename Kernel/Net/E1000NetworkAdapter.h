@@ -46,6 +46,8 @@ public:
     virtual ~E1000NetworkAdapter() override;
 
     virtual void send_raw(const u8*, size_t) override;
+    virtual bool has_transport_checksum_offload() const override { return true; }
+    virtual void send_raw_with_checksum_offload(const u8*, size_t, size_t checksum_start, size_t checksum_offset) override;
     virtual bool link_up() override;
 
     virtual const char* purpose() const override { return class_name(); }
@@ -75,6 +77,31 @@ private:
         volatile uint16_t special { 0 };
     };
 
+    // Overlays an e1000_tx_desc slot; sets up TCP/UDP checksum insertion
+    // for the extended data descriptors that follow it.
+    struct [[gnu::packed]] e1000_tx_context_desc
+    {
+        volatile uint8_t ipcss { 0 };
+        volatile uint8_t ipcso { 0 };
+        volatile uint16_t ipcse { 0 };
+        volatile uint8_t tucss { 0 };
+        volatile uint8_t tucso { 0 };
+        volatile uint16_t tucse { 0 };
+        volatile uint32_t cmd_and_length { 0 };
+        volatile uint8_t status { 0 };
+        volatile uint8_t hdr_len { 0 };
+        volatile uint16_t mss { 0 };
+    };
+
+    struct ChecksumOffload {
+        u8 start { 0 };
+        u8 offset { 0 };
+        bool operator==(const ChecksumOffload& other) const { return start == other.start && offset == other.offset; }
+        bool operator!=(const ChecksumOffload& other) const { return !(*this == other); }
+    };
+
+    void send_packet(const u8*, size_t, Optional<ChecksumOffload>);
+
     void detect_eeprom();
     u32 read_eeprom(u8 address);
     void read_mac_address();
@@ -104,6 +131,7 @@ private:
     u8 m_interrupt_line { 0 };
     bool m_has_eeprom { false };
     bool m_use_mmio { false };
+    Optional<ChecksumOffload> m_tx_checksum_context;
     EntropySource m_entropy_source;
 
     static const size_t number_of_rx_descriptors = 32;
@@ -28,6 +28,7 @@
 
 #include <AK/Assertions.h>
 #include <AK/IPv4Address.h>
+#include <AK/InternetChecksum.h>
 #include <AK/NetworkOrdered.h>
 #include <AK/String.h>
 #include <AK/Types.h>
@@ -128,17 +129,27 @@ const LogStream& operator<<(const LogStream& stream, const IPv4Packet& packet);
 
 inline NetworkOrdered<u16> internet_checksum(const void* ptr, size_t count)
 {
-    u32 checksum = 0;
-    auto* w = (const u16*)ptr;
-    while (count > 1) {
-        checksum += convert_between_host_and_network(*w++);
-        if (checksum & 0x80000000)
-            checksum = (checksum & 0xffff) | (checksum >> 16);
-        count -= 2;
-    }
-    while (checksum >> 16)
-        checksum = (checksum & 0xffff) + (checksum >> 16);
-    return ~checksum & 0xffff;
+    InternetChecksum checksum;
+    checksum.add(ptr, count);
+    return convert_between_host_and_network(checksum.finish());
+}
+
+// Starts a TCP/UDP checksum with the IPv4 pseudo-header already summed in.
+inline InternetChecksum ipv4_pseudo_header_checksum(const IPv4Address& source, const IPv4Address& destination, IPv4Protocol protocol, u16 transport_length)
+{
+    struct [[gnu::packed]] PseudoHeader
+    {
+        IPv4Address source;
+        IPv4Address destination;
+        u8 zero;
+        u8 protocol;
+        NetworkOrdered<u16> transport_length;
+    };
+
+    PseudoHeader pseudo_header { source, destination, 0, (u8)protocol, transport_length };
+    InternetChecksum checksum;
+    checksum.add(&pseudo_header, sizeof(pseudo_header));
+    return checksum;
 }
 
 }
@@ -45,7 +45,7 @@
 
 namespace Kernel {
 
-Lockable<HashTable<IPv4Socket*>>& IPv4Socket::all_sockets()
+Lockable<HashTable<IPv4Socket*>>& IPv4Socket::raw_sockets()
 {
     static Lockable<HashTable<IPv4Socket*>>* s_table;
     if (!s_table)
@@ -74,14 +74,20 @@ IPv4Socket::IPv4Socket(int type, int protocol)
     if (m_buffer_mode == BufferMode::Bytes) {
         m_scratch_buffer = KBuffer::create_with_size(65536);
     }
-    LOCKER(all_sockets().lock());
-    all_sockets().resource().set(this);
+    // TCP and UDP sockets are found through their own lookup tables;
+    // only raw sockets need to see every incoming packet.
+    if (type == SOCK_RAW) {
+        LOCKER(raw_sockets().lock());
+        raw_sockets().resource().set(this);
+    }
 }
 
 IPv4Socket::~IPv4Socket()
 {
-    LOCKER(all_sockets().lock());
-    all_sockets().resource().remove(this);
+    if (type() == SOCK_RAW) {
+        LOCKER(raw_sockets().lock());
+        raw_sockets().resource().remove(this);
+    }
 }
 
 void IPv4Socket::get_local_address(sockaddr* address, socklen_t* address_size)
@@ -393,6 +399,7 @@ bool IPv4Socket::did_receive(const IPv4Address& source_address, u16 source_port,
     else
         dbg() << "IPv4Socket(" << this << "): did_receive " << packet_size << " bytes, total_received=" << m_bytes_received << ", packets in queue: " << m_receive_queue.size_slow();
 #endif
+    did_change_readiness();
     return true;
 }
 
@@ -428,10 +435,10 @@ String IPv4Socket::absolute_path(const FileDescription&) const
     return builder.to_string();
 }
 
-KResult IPv4Socket::setsockopt(int level, int option, const void* value, socklen_t value_size)
+KResult IPv4Socket::setsockopt(FileDescription& description, int level, int option, const void* value, socklen_t value_size)
 {
     if (level != IPPROTO_IP)
-        return Socket::setsockopt(level, option, value, value_size);
+        return Socket::setsockopt(description, level, option, value, value_size);
 
     switch (option) {
     case IP_TTL:
@@ -46,7 +46,7 @@ public:
     static KResultOr<NonnullRefPtr<Socket>> create(int type, int protocol);
     virtual ~IPv4Socket() override;
 
-    static Lockable<HashTable<IPv4Socket*>>& all_sockets();
+    static Lockable<HashTable<IPv4Socket*>>& raw_sockets();
 
     virtual KResult close() override;
     virtual KResult bind(const sockaddr*, socklen_t) override;
@@ -60,7 +60,7 @@ public:
     virtual bool can_write(const FileDescription&, size_t) const override;
     virtual ssize_t sendto(FileDescription&, const void*, size_t, int, const sockaddr*, socklen_t) override;
     virtual ssize_t recvfrom(FileDescription&, void*, size_t, int flags, sockaddr*, socklen_t*) override;
-    virtual KResult setsockopt(int level, int option, const void*, socklen_t) override;
+    virtual KResult setsockopt(FileDescription&, int level, int option, const void*, socklen_t) override;
     virtual KResult getsockopt(FileDescription&, int level, int option, void*, socklen_t*) override;
 
     virtual int ioctl(FileDescription&, unsigned request, FlatPtr arg) override;
@@ -173,6 +173,7 @@ KResult LocalSocket::connect(FileDescription& description, const sockaddr* addre
 
     if (is_connected()) {
         m_connect_side_role = Role::Connected;
+        did_change_readiness();
         return KSuccess;
     }
 
@@ -190,6 +191,7 @@ KResult LocalSocket::connect(FileDescription& description, const sockaddr* addre
         return KResult(-ECONNREFUSED);
     }
     m_connect_side_role = Role::Connected;
+    did_change_readiness();
     return KSuccess;
 }
 
@@ -216,6 +218,7 @@ void LocalSocket::attach(FileDescription& description)
         ASSERT(m_connect_side_fd != &description);
         m_accept_side_fd_open = true;
     }
+    did_change_readiness();
 }
 
 void LocalSocket::detach(FileDescription& description)
@@ -226,6 +229,7 @@ void LocalSocket::detach(FileDescription& description)
         ASSERT(m_accept_side_fd_open);
         m_accept_side_fd_open = false;
     }
+    did_change_readiness();
 }
 
 bool LocalSocket::can_read(const FileDescription& description, size_t) const
@@ -260,17 +264,27 @@ bool LocalSocket::can_write(const FileDescription& description, size_t) const
     return false;
 }
 
+bool LocalSocket::is_hung_up(const FileDescription& description) const
+{
+    if (Socket::is_hung_up(description))
+        return true;
+    auto role = this->role(description);
+    return (role == Role::Accepted || role == Role::Connected) && !has_attached_peer(description);
+}
+
 ssize_t LocalSocket::sendto(FileDescription& description, const void* data, size_t data_size, int, const sockaddr*, socklen_t)
 {
     if (!has_attached_peer(description))
         return -EPIPE;
     ssize_t nwritten = send_buffer_for(description).write((const u8*)data, data_size);
-    if (nwritten > 0)
+    if (nwritten > 0) {
         Thread::current()->did_unix_socket_write(nwritten);
+        did_change_readiness();
+    }
     return nwritten;
 }
 
-DoubleBuffer& LocalSocket::receive_buffer_for(FileDescription& description)
+RingBuffer& LocalSocket::receive_buffer_for(FileDescription& description)
 {
     auto role = this->role(description);
     if (role == Role::Accepted)
@@ -280,7 +294,7 @@ DoubleBuffer& LocalSocket::receive_buffer_for(FileDescription& description)
     ASSERT_NOT_REACHED();
 }
 
-DoubleBuffer& LocalSocket::send_buffer_for(FileDescription& description)
+RingBuffer& LocalSocket::send_buffer_for(FileDescription& description)
 {
     auto role = this->role(description);
     if (role == Role::Connected)
@@ -307,8 +321,10 @@ ssize_t LocalSocket::recvfrom(FileDescription& description, void* buffer, size_t
         return 0;
     ASSERT(!buffer_for_me.is_empty());
     int nread = buffer_for_me.read((u8*)buffer, buffer_size);
-    if (nread > 0)
+    if (nread > 0) {
         Thread::current()->did_unix_socket_read(nread);
+        did_change_readiness();
+    }
     return nread;
 }
 
@@ -344,12 +360,52 @@ String LocalSocket::absolute_path(const FileDescription& description) const
     return builder.to_string();
 }
 
+KResult LocalSocket::setsockopt(FileDescription& description, int level, int option, const void* value, socklen_t value_size)
+{
+    if (level != SOL_SOCKET)
+        return Socket::setsockopt(description, level, option, value, value_size);
+
+    switch (option) {
+    case SO_SNDBUF:
+    case SO_RCVBUF: {
+        if (value_size != sizeof(int))
+            return KResult(-EINVAL);
+        int size = *(const int*)value;
+        if (size < 0)
+            return KResult(-EINVAL);
+        auto role = this->role(description);
+        if (role != Role::Accepted && role != Role::Connected)
+            return KResult(-ENOTCONN);
+        auto& buffer = option == SO_SNDBUF ? send_buffer_for(description) : receive_buffer_for(description);
+        auto result = buffer.set_capacity(size);
+        if (result.is_error())
+            return result;
+        did_change_readiness();
+        return KSuccess;
+    }
+    default:
+        return Socket::setsockopt(description, level, option, value, value_size);
+    }
+}
+
 KResult LocalSocket::getsockopt(FileDescription& description, int level, int option, void* value, socklen_t* value_size)
 {
     if (level != SOL_SOCKET)
         return Socket::getsockopt(description, level, option, value, value_size);
 
     switch (option) {
+    case SO_SNDBUF:
+    case SO_RCVBUF: {
+        if (*value_size < sizeof(int))
+            return KResult(-EINVAL);
+        auto role = this->role(description);
+        if (role != Role::Accepted && role != Role::Connected)
+            return KResult(-ENOTCONN);
+        auto& buffer = option == SO_SNDBUF ? send_buffer_for(description) : receive_buffer_for(description);
+        *(int*)value = buffer.capacity();
+        *value_size = sizeof(int);
+        return KSuccess;
+    }
     case SO_PEERCRED: {
         if (*value_size < sizeof(ucred))
             return KResult(-EINVAL);
@@ -24,7 +24,11 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/InternetChecksum.h>
+#include <Kernel/Net/IPv4Socket.h>
 #include <Kernel/Net/LoopbackAdapter.h>
+#include <Kernel/Net/NetworkTask.h>
+#include <Kernel/Process.h>
 
 namespace Kernel {
 
@@ -47,10 +51,127 @@ LoopbackAdapter::~LoopbackAdapter()
 {
 }
 
+static void finish_transport_checksum(u8* transport, size_t size, size_t checksum_offset)
+{
+    // The checksum field already holds the pseudo-header sum.
+    InternetChecksum checksum;
+    checksum.add(transport, size);
+    u16 value = checksum.finish();
+    memcpy(transport + checksum_offset, &value, sizeof(value));
+}
+
+static bool has_raw_socket_for_protocol(u8 protocol)
+{
+    LOCKER(IPv4Socket::raw_sockets().lock(), Lock::Mode::Shared);
+    for (auto* socket : IPv4Socket::raw_sockets().resource()) {
+        if (socket->protocol() == protocol)
+            return true;
+    }
+    return false;
+}
+
 void LoopbackAdapter::send_raw(const u8* data, size_t size)
 {
     dbg() << "LoopbackAdapter: Sending " << size << " byte(s) to myself.";
     did_receive(data, size);
 }
 
+void LoopbackAdapter::send_raw_with_checksum_offload(const u8* data, size_t size, size_t checksum_start, size_t checksum_offset)
+{
+    // Only reached for packets too large for send_ipv4() to queue, so don't bother skipping anything.
+    auto copy = ByteBuffer::copy(data, size);
+    finish_transport_checksum(copy.data() + checksum_start, size - checksum_start, checksum_offset - checksum_start);
+    send_raw(copy.data(), copy.size());
+}
+
+void LoopbackAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, const u8* payload, size_t payload_size, u8 ttl, Optional<size_t> transport_checksum_offset)
+{
+    size_t ipv4_packet_size = sizeof(IPv4Packet) + payload_size;
+    if (ipv4_packet_size > mtu() || ipv4_packet_size > 0xffff) {
+        NetworkAdapter::send_ipv4(destination_mac, destination_ipv4, protocol, payload, payload_size, ttl, transport_checksum_offset);
+        return;
+    }
+
+    Optional<KBuffer> buffer;
+    {
+        ScopedSpinLock lock(m_ipv4_queue_lock);
+        if (!m_unused_ipv4_buffers.is_empty() && m_unused_ipv4_buffers.first().capacity() >= ipv4_packet_size) {
+            buffer = m_unused_ipv4_buffers.take_first();
+            --m_unused_ipv4_buffers_count;
+        }
+    }
+    // Buffers are sized for the largest packet so they can always be reused;
+    // only the pages a packet actually touches get committed.
+    if (!buffer.has_value())
+        buffer = KBuffer::create_with_size(mtu(), Region::Access::Read | Region::Access::Write, "Loopback packet");
+    buffer.value().set_size(ipv4_packet_size);
+
+    memset(buffer.value().data(), 0, sizeof(IPv4Packet));
+    auto& ipv4 = *(IPv4Packet*)buffer.value().data();
+    ipv4.set_version(4);
+    ipv4.set_internet_header_length(5);
+    ipv4.set_source(ipv4_address());
+    ipv4.set_destination(destination_ipv4);
+    ipv4.set_protocol((u8)protocol);
+    ipv4.set_length(ipv4_packet_size);
+    ipv4.set_ident(1);
+    ipv4.set_ttl(ttl);
+    ipv4.set_checksum(ipv4.compute_checksum());
+    memcpy(ipv4.payload(), payload, payload_size);
+
+    {
+        ScopedSpinLock lock(m_ipv4_queue_lock);
+        m_ipv4_queue.append({ buffer.release_value(), transport_checksum_offset });
+        m_has_queued_ipv4_packets.store(true, AK::memory_order_release);
+    }
+
+    // Userspace only sends from syscalls, and will deliver on the way out.
+    auto* current_thread = Thread::current();
+    if (current_thread && !current_thread->process().is_ring0() && !Processor::current().in_irq()) {
+        current_thread->set_has_undelivered_loopback_packets(true);
+        return;
+    }
+
+    hand_off_queued_ipv4_packets();
+}
+
+void LoopbackAdapter::hand_off_queued_ipv4_packets()
+{
+    if (has_queued_ipv4_packets() && on_ipv4_packet_queued)
+        on_ipv4_packet_queued();
+}
+
+bool LoopbackAdapter::deliver_queued_ipv4_packets()
+{
+    // Only one thread delivers at a time so packets arrive in the order they were sent.
+    if (m_delivering_ipv4_packets.exchange(true, AK::memory_order_acq_rel))
+        return false;
+
+    for (;;) {
+        Optional<QueuedIPv4Packet> packet;
+        {
+            ScopedSpinLock lock(m_ipv4_queue_lock);
+            if (m_ipv4_queue.is_empty()) {
+                m_has_queued_ipv4_packets.store(false, AK::memory_order_relaxed);
+                m_delivering_ipv4_packets.store(false, AK::memory_order_release);
+                return true;
+            }
+            packet = m_ipv4_queue.take_first();
+        }
+
+        auto& buffer = packet.value().buffer;
+        auto& ipv4 = *(IPv4Packet*)buffer.data();
+        if (packet.value().transport_checksum_offset.has_value() && has_raw_socket_for_protocol(ipv4.protocol()))
+            finish_transport_checksum((u8*)ipv4.payload(), ipv4.payload_size(), packet.value().transport_checksum_offset.value());
+
+        NetworkTask::handle_ipv4_packet(mac_address(), ipv4, buffer.size());
+
+        ScopedSpinLock lock(m_ipv4_queue_lock);
+        if (m_unused_ipv4_buffers_count < 16) {
+            m_unused_ipv4_buffers.append(move(buffer));
+            ++m_unused_ipv4_buffers_count;
+        }
+    }
+}
+
 }
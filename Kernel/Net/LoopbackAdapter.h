@@ -26,7 +26,9 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
 #include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/SpinLock.h>
 
 namespace Kernel {
 
@@ -38,10 +40,41 @@ public:
     virtual ~LoopbackAdapter() override;
 
     virtual void send_raw(const u8*, size_t) override;
+    virtual void send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, const u8* payload, size_t payload_size, u8 ttl, Optional<size_t> transport_checksum_offset = {}) override;
     virtual const char* class_name() const override { return "LoopbackAdapter"; }
 
+    // IPv4 packets sent to ourselves skip Ethernet framing and the regular
+    // receive queue. A userspace thread delivers the packets it sent itself on
+    // its way out of the syscall, without waking anyone. Packets sent from
+    // kernel threads, or by a thread that blocks before it gets that far, are
+    // handed off to the NetworkTask instead (see on_ipv4_packet_queued).
+    bool has_queued_ipv4_packets() const { return m_has_queued_ipv4_packets.load(AK::memory_order_relaxed); }
+    // Returns false if another thread is already delivering; it will drain the queue.
+    bool deliver_queued_ipv4_packets();
+    void hand_off_queued_ipv4_packets();
+
+    Function<void()> on_ipv4_packet_queued;
+
 private:
     LoopbackAdapter();
+
+    // Nothing on the receiving end verifies transport checksums for packets
+    // that never left this machine, so they are only finished if a raw socket
+    // could get to see them.
+    virtual bool has_transport_checksum_offload() const override { return true; }
+    virtual void send_raw_with_checksum_offload(const u8*, size_t, size_t checksum_start, size_t checksum_offset) override;
+
+    struct QueuedIPv4Packet {
+        KBuffer buffer;
+        Optional<size_t> transport_checksum_offset;
+    };
+
+    SpinLock<u8> m_ipv4_queue_lock;
+    SinglyLinkedList<QueuedIPv4Packet> m_ipv4_queue;
+    SinglyLinkedList<KBuffer> m_unused_ipv4_buffers;
+    size_t m_unused_ipv4_buffers_count { 0 };
+    Atomic<bool> m_has_queued_ipv4_packets { false };
+    Atomic<bool> m_delivering_ipv4_packets { false };
 };
 
 }
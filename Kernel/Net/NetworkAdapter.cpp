@@ -100,10 +100,11 @@ void NetworkAdapter::send(const MACAddress& destination, const ARPPacket& packet
     send_raw((const u8*)eth, size_in_bytes);
 }
 
-void NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, const u8* payload, size_t payload_size, u8 ttl)
+void NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, const u8* payload, size_t payload_size, u8 ttl, Optional<size_t> transport_checksum_offset)
 {
     size_t ipv4_packet_size = sizeof(IPv4Packet) + payload_size;
     if (ipv4_packet_size > mtu()) {
+        ASSERT(!transport_checksum_offset.has_value());
         send_ipv4_fragmented(destination_mac, destination_ipv4, protocol, payload, payload_size, ttl);
         return;
     }
@@ -127,9 +128,21 @@ void NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Addr
     m_packets_out++;
     m_bytes_out += ethernet_frame_size;
     memcpy(ipv4.payload(), payload, payload_size);
+    if (transport_checksum_offset.has_value()) {
+        ASSERT(has_transport_checksum_offload());
+        size_t checksum_start = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet);
+        send_raw_with_checksum_offload((const u8*)&eth, ethernet_frame_size, checksum_start, checksum_start + transport_checksum_offset.value());
+        return;
+    }
     send_raw((const u8*)&eth, ethernet_frame_size);
 }
 
+void NetworkAdapter::send_raw_with_checksum_offload(const u8*, size_t, size_t, size_t)
+{
+    // Adapters that claim has_transport_checksum_offload() must override this.
+    ASSERT_NOT_REACHED();
+}
+
 void NetworkAdapter::send_ipv4_fragmented(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, const u8* payload, size_t payload_size, u8 ttl)
 {
     // packets must be split on the 64-bit boundary
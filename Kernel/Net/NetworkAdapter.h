@@ -63,13 +63,18 @@ public:
     void set_ipv4_gateway(const IPv4Address&);
 
     void send(const MACAddress&, const ARPPacket&);
-    void send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, const u8* payload, size_t payload_size, u8 ttl);
+    // If transport_checksum_offset is given, the transport header's checksum
+    // field already holds the pseudo-header sum and the adapter will finish
+    // the checksum over the rest of the payload (see can_offload_transport_checksum()).
+    virtual void send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, const u8* payload, size_t payload_size, u8 ttl, Optional<size_t> transport_checksum_offset = {});
     void send_ipv4_fragmented(const MACAddress&, const IPv4Address&, IPv4Protocol, const u8* payload, size_t payload_size, u8 ttl);
 
     size_t dequeue_packet(u8* buffer, size_t buffer_size);
 
     bool has_queued_packets() const { return !m_packet_queue.is_empty(); }
 
+    bool can_offload_transport_checksum(size_t transport_size) const { return has_transport_checksum_offload() && sizeof(IPv4Packet) + transport_size <= m_mtu; }
+
     u32 mtu() const { return m_mtu; }
     void set_mtu(u32 mtu) { m_mtu = mtu; }
 
@@ -85,6 +90,8 @@ protected:
     void set_interface_name(const StringView& basename);
     void set_mac_address(const MACAddress& mac_address) { m_mac_address = mac_address; }
     virtual void send_raw(const u8*, size_t) = 0;
+    virtual bool has_transport_checksum_offload() const { return false; }
+    virtual void send_raw_with_checksum_offload(const u8*, size_t, size_t checksum_start, size_t checksum_offset);
     void did_receive(const u8*, size_t);
 
 private:
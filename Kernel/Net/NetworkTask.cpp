@@ -53,7 +53,7 @@ namespace Kernel {
 
 static void handle_arp(const EthernetFrameHeader&, size_t frame_size);
 static void handle_ipv4(const EthernetFrameHeader&, size_t frame_size);
-static void handle_icmp(const EthernetFrameHeader&, const IPv4Packet&);
+static void handle_icmp(const MACAddress& source, const IPv4Packet&);
 static void handle_udp(const IPv4Packet&);
 static void handle_tcp(const IPv4Packet&);
 
@@ -89,6 +89,10 @@ void NetworkTask_main()
         };
     });
 
+    LoopbackAdapter::the().on_ipv4_packet_queued = [&]() {
+        packet_wait_queue.wake_all();
+    };
+
     auto dequeue_packet = [&pending_packets](u8* buffer, size_t buffer_size) -> size_t {
         if (pending_packets == 0)
             return 0;
@@ -111,8 +115,18 @@ void NetworkTask_main()
 
     klog() << "NetworkTask: Enter main loop.";
     for (;;) {
+        // Loopback packets are normally delivered by their senders; pick up any
+        // that were sent from kernel threads or by threads that went to sleep
+        // before doing so. If someone else is already delivering, they'll
+        // drain the queue, so there's no need to spin here.
+        bool loopback_busy_elsewhere = false;
+        if (LoopbackAdapter::the().has_queued_ipv4_packets())
+            loopback_busy_elsewhere = !LoopbackAdapter::the().deliver_queued_ipv4_packets();
+
         size_t packet_size = dequeue_packet(buffer, buffer_size);
         if (!packet_size) {
+            if (!loopback_busy_elsewhere && LoopbackAdapter::the().has_queued_ipv4_packets())
+                continue;
             Thread::current()->wait_on(packet_wait_queue, "NetworkTask");
             continue;
         }
@@ -221,13 +235,16 @@ void handle_ipv4(const EthernetFrameHeader& eth, size_t frame_size)
         return;
     }
     auto& packet = *static_cast<const IPv4Packet*>(eth.payload());
+    NetworkTask::handle_ipv4_packet(eth.source(), packet, frame_size - sizeof(EthernetFrameHeader));
+}
 
+void NetworkTask::handle_ipv4_packet(const MACAddress& source, const IPv4Packet& packet, size_t actual_ipv4_packet_length)
+{
     if (packet.length() < sizeof(IPv4Packet)) {
         klog() << "handle_ipv4: IPv4 packet too short (" << packet.length() << ", need " << sizeof(IPv4Packet) << ")";
         return;
     }
 
-    size_t actual_ipv4_packet_length = frame_size - sizeof(EthernetFrameHeader);
     if (packet.length() > actual_ipv4_packet_length) {
         klog() << "handle_ipv4: IPv4 packet claims to be longer than it is (" << packet.length() << ", actually " << actual_ipv4_packet_length << ")";
         return;
@@ -239,7 +256,7 @@ void handle_ipv4(const EthernetFrameHeader& eth, size_t frame_size)
 
     switch ((IPv4Protocol)packet.protocol()) {
     case IPv4Protocol::ICMP:
-        return handle_icmp(eth, packet);
+        return handle_icmp(source, packet);
     case IPv4Protocol::UDP:
         return handle_udp(packet);
     case IPv4Protocol::TCP:
@@ -250,7 +267,7 @@ void handle_ipv4(const EthernetFrameHeader& eth, size_t frame_size)
     }
 }
 
-void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet)
+void handle_icmp(const MACAddress& source, const IPv4Packet& ipv4_packet)
 {
     auto& icmp_header = *static_cast<const ICMPHeader*>(ipv4_packet.payload());
 #ifdef ICMP_DEBUG
@@ -258,8 +275,8 @@ void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet)
 #endif
 
     {
-        LOCKER(IPv4Socket::all_sockets().lock());
-        for (RefPtr<IPv4Socket> socket : IPv4Socket::all_sockets().resource()) {
+        LOCKER(IPv4Socket::raw_sockets().lock(), Lock::Mode::Shared);
+        for (RefPtr<IPv4Socket> socket : IPv4Socket::raw_sockets().resource()) {
             LOCKER(socket->lock());
             if (socket->protocol() != (unsigned)IPv4Protocol::ICMP)
                 continue;
@@ -285,7 +302,7 @@ void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet)
             memcpy(response.payload(), request.payload(), icmp_payload_size);
         response.header.set_checksum(internet_checksum(&response, icmp_packet_size));
         // FIXME: What is the right TTL value here? Is 64 ok? Should we use the same TTL as the echo request?
-        adapter->send_ipv4(eth.source(), ipv4_packet.source(), IPv4Protocol::ICMP, buffer.data(), buffer.size(), 64);
+        adapter->send_ipv4(source, ipv4_packet.source(), IPv4Protocol::ICMP, buffer.data(), buffer.size(), 64);
     }
 }
 
@@ -26,9 +26,19 @@
 
 #pragma once
 
+#include <AK/MACAddress.h>
+#include <AK/Types.h>
+
 namespace Kernel {
+
+class IPv4Packet;
+
 class NetworkTask {
 public:
     static void spawn();
+
+    // Input path for an IPv4 packet that has already been stripped of its
+    // link-layer framing. packet_size is the number of valid bytes.
+    static void handle_ipv4_packet(const MACAddress& source, const IPv4Packet&, size_t packet_size);
 };
 }
@@ -70,6 +70,7 @@ void Socket::set_setup_state(SetupState new_setup_state)
 #endif
 
     m_setup_state = new_setup_state;
+    did_change_readiness();
 }
 
 RefPtr<Socket> Socket::accept()
@@ -86,6 +87,7 @@ RefPtr<Socket> Socket::accept()
     client->m_acceptor = { process.pid(), process.uid(), process.gid() };
     client->m_connected = true;
     client->m_role = Role::Accepted;
+    client->did_change_readiness();
     return client;
 }
 
@@ -98,10 +100,11 @@ KResult Socket::queue_connection_from(NonnullRefPtr<Socket> peer)
     if (m_pending.size() >= m_backlog)
         return KResult(-ECONNREFUSED);
     m_pending.append(peer);
+    did_change_readiness();
     return KSuccess;
 }
 
-KResult Socket::setsockopt(int level, int option, const void* value, socklen_t value_size)
+KResult Socket::setsockopt(FileDescription&, int level, int option, const void* value, socklen_t value_size)
 {
     ASSERT(level == SOL_SOCKET);
     switch (option) {
@@ -202,6 +205,7 @@ KResult Socket::shutdown(int how)
         shut_down_for_reading();
     m_shut_down_for_reading |= (how & SHUT_RD) != 0;
     m_shut_down_for_writing |= (how & SHUT_WR) != 0;
+    did_change_readiness();
     return KSuccess;
 }
 
@@ -91,7 +91,13 @@ public:
     virtual Role role(const FileDescription&) const { return m_role; }
 
     bool is_connected() const { return m_connected; }
-    void set_connected(bool connected) { m_connected = connected; }
+    void set_connected(bool connected)
+    {
+        if (m_connected == connected)
+            return;
+        m_connected = connected;
+        did_change_readiness();
+    }
 
     bool can_accept() const { return !m_pending.is_empty(); }
     RefPtr<Socket> accept();
@@ -110,7 +116,7 @@ public:
     virtual ssize_t sendto(FileDescription&, const void*, size_t, int flags, const sockaddr*, socklen_t) = 0;
     virtual ssize_t recvfrom(FileDescription&, void*, size_t, int flags, sockaddr*, socklen_t*) = 0;
 
-    virtual KResult setsockopt(int level, int option, const void*, socklen_t);
+    virtual KResult setsockopt(FileDescription&, int level, int option, const void*, socklen_t);
     virtual KResult getsockopt(FileDescription&, int level, int option, void*, socklen_t*);
 
     pid_t origin_pid() const { return m_origin.pid; }
@@ -127,6 +133,7 @@ public:
     virtual ssize_t read(FileDescription&, size_t, u8*, ssize_t) override final;
     virtual ssize_t write(FileDescription&, size_t, const u8*, ssize_t) override final;
     virtual String absolute_path(const FileDescription&) const override = 0;
+    virtual bool is_hung_up(const FileDescription&) const override { return m_shut_down_for_reading && m_shut_down_for_writing; }
 
     bool has_receive_timeout() const { return m_receive_timeout.tv_sec || m_receive_timeout.tv_usec; }
     const timeval& receive_timeout() const { return m_receive_timeout; }
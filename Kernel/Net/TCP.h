@@ -77,6 +77,7 @@ public:
 
     u16 checksum() const { return m_checksum; }
     void set_checksum(u16 checksum) { m_checksum = checksum; }
+    static size_t checksum_offset() { return __builtin_offsetof(TCPPacket, m_checksum); }
 
     u16 urgent() const { return m_urgent; }
     void set_urgent(u16 urgent) { m_urgent = urgent; }
@@ -38,11 +38,27 @@
 
 namespace Kernel {
 
+static Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>* connected_socket_shards()
+{
+    static Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>* s_shards;
+    if (!s_shards)
+        s_shards = new Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>[TCPSocket::connected_socket_shard_count];
+    return s_shards;
+}
+
 void TCPSocket::for_each(Function<void(const TCPSocket&)> callback)
 {
-    LOCKER(sockets_by_tuple().lock(), Lock::Mode::Shared);
-    for (auto& it : sockets_by_tuple().resource())
-        callback(*it.value);
+    {
+        LOCKER(listening_sockets().lock(), Lock::Mode::Shared);
+        for (auto& it : listening_sockets().resource())
+            callback(*it.value);
+    }
+    for (size_t i = 0; i < connected_socket_shard_count; ++i) {
+        auto& shard = connected_socket_shards()[i];
+        LOCKER(shard.lock(), Lock::Mode::Shared);
+        for (auto& it : shard.resource())
+            callback(*it.value);
+    }
 }
 
 void TCPSocket::set_state(State new_state)
@@ -60,6 +76,8 @@ void TCPSocket::set_state(State new_state)
         LOCKER(closing_sockets().lock());
         closing_sockets().resource().remove(tuple());
     }
+
+    did_change_readiness();
 }
 
 Lockable<HashMap<IPv4SocketTuple, RefPtr<TCPSocket>>>& TCPSocket::closing_sockets()
@@ -70,7 +88,12 @@ Lockable<HashMap<IPv4SocketTuple, RefPtr<TCPSocket>>>& TCPSocket::closing_socket
     return *s_map;
 }
 
-Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& TCPSocket::sockets_by_tuple()
+Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& TCPSocket::connected_sockets(const IPv4SocketTuple& tuple)
+{
+    return connected_socket_shards()[Traits<IPv4SocketTuple>::hash(tuple) % connected_socket_shard_count];
+}
+
+Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& TCPSocket::listening_sockets()
 {
     static Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>* s_map;
     if (!s_map)
@@ -80,19 +103,23 @@ Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& TCPSocket::sockets_by_tuple()
 
 RefPtr<TCPSocket> TCPSocket::from_tuple(const IPv4SocketTuple& tuple)
 {
-    LOCKER(sockets_by_tuple().lock(), Lock::Mode::Shared);
+    {
+        auto& shard = connected_sockets(tuple);
+        LOCKER(shard.lock(), Lock::Mode::Shared);
+        auto exact_match = shard.resource().get(tuple);
+        if (exact_match.has_value())
+            return { *exact_match.value() };
+    }
 
-    auto exact_match = sockets_by_tuple().resource().get(tuple);
-    if (exact_match.has_value())
-        return { *exact_match.value() };
+    LOCKER(listening_sockets().lock(), Lock::Mode::Shared);
 
     auto address_tuple = IPv4SocketTuple(tuple.local_address(), tuple.local_port(), IPv4Address(), 0);
-    auto address_match = sockets_by_tuple().resource().get(address_tuple);
+    auto address_match = listening_sockets().resource().get(address_tuple);
     if (address_match.has_value())
         return { *address_match.value() };
 
     auto wildcard_tuple = IPv4SocketTuple(IPv4Address(), tuple.local_port(), IPv4Address(), 0);
-    auto wildcard_match = sockets_by_tuple().resource().get(wildcard_tuple);
+    auto wildcard_match = listening_sockets().resource().get(wildcard_tuple);
     if (wildcard_match.has_value())
         return { *wildcard_match.value() };
 
@@ -108,8 +135,9 @@ RefPtr<TCPSocket> TCPSocket::create_client(const IPv4Address& new_local_address,
 {
     auto tuple = IPv4SocketTuple(new_local_address, new_local_port, new_peer_address, new_peer_port);
 
-    LOCKER(sockets_by_tuple().lock());
-    if (sockets_by_tuple().resource().contains(tuple))
+    auto& shard = connected_sockets(tuple);
+    LOCKER(shard.lock());
+    if (shard.resource().contains(tuple))
         return {};
 
     auto client = TCPSocket::create(protocol());
@@ -121,11 +149,14 @@ RefPtr<TCPSocket> TCPSocket::create_client(const IPv4Address& new_local_address,
     client->set_peer_port(new_peer_port);
     client->set_direction(Direction::Incoming);
     client->set_originator(*this);
+    // We may be running in whatever process sent the SYN, so don't let the
+    // client claim that process as its origin; it belongs to our listener.
+    client->m_origin = m_origin;
 
     m_pending_release_for_accept.set(tuple, client);
-    sockets_by_tuple().resource().set(tuple, client);
+    shard.resource().set(tuple, client);
 
-    return from_tuple(tuple);
+    return client;
 }
 
 void TCPSocket::release_to_originator()
@@ -148,8 +179,15 @@ TCPSocket::TCPSocket(int protocol)
 
 TCPSocket::~TCPSocket()
 {
-    LOCKER(sockets_by_tuple().lock());
-    sockets_by_tuple().resource().remove(tuple());
+    // We don't know which table we ended up in, if any.
+    auto remove_from = [this](auto& table) {
+        LOCKER(table.lock());
+        auto it = table.resource().find(tuple());
+        if (it != table.resource().end() && (*it).value == this)
+            table.resource().remove(it);
+    };
+    remove_from(listening_sockets());
+    remove_from(connected_sockets(tuple()));
 
 #ifdef TCP_SOCKET_DEBUG
     dbg() << "~TCPSocket in state " << to_string(state());
@@ -183,6 +221,9 @@ int TCPSocket::protocol_send(const void* data, size_t data_length)
 
 void TCPSocket::send_tcp_packet(u16 flags, const void* payload, size_t payload_size)
 {
+    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
+    ASSERT(!routing_decision.is_zero());
+
     auto buffer = ByteBuffer::create_zeroed(sizeof(TCPPacket) + payload_size);
     auto& tcp_packet = *(TCPPacket*)(buffer.data());
     ASSERT(local_port());
@@ -203,21 +244,25 @@ void TCPSocket::send_tcp_packet(u16 flags, const void* payload, size_t payload_s
     }
 
     memcpy(tcp_packet.payload(), payload, payload_size);
-    tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
+
+    // Let the adapter finish the checksum if it can; it only needs the pseudo-header sum.
+    bool checksum_offloaded = routing_decision.adapter->can_offload_transport_checksum(buffer.size());
+    if (checksum_offloaded)
+        tcp_packet.set_checksum(convert_between_host_and_network(ipv4_pseudo_header_checksum(local_address(), peer_address(), IPv4Protocol::TCP, buffer.size()).partial()));
+    else
+        tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
 
     if (tcp_packet.has_syn() || payload_size > 0) {
         LOCKER(m_not_acked_lock);
-        m_not_acked.append({ m_sequence_number, move(buffer) });
+        m_not_acked.append({ m_sequence_number, move(buffer), 0, { 0, 0 }, checksum_offloaded });
         send_outgoing_packets();
         return;
     }
 
-    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
-    ASSERT(!routing_decision.is_zero());
-
     routing_decision.adapter->send_ipv4(
         routing_decision.next_hop, peer_address(), IPv4Protocol::TCP,
-        buffer.data(), buffer.size(), ttl());
+        buffer.data(), buffer.size(), ttl(),
+        checksum_offloaded ? TCPPacket::checksum_offset() : Optional<size_t>());
 
     m_packets_out++;
     m_bytes_out += buffer.size();
@@ -243,9 +288,18 @@ void TCPSocket::send_outgoing_packets()
         auto& tcp_packet = *(TCPPacket*)(packet.buffer.data());
         klog() << "sending tcp packet from " << local_address().to_string().characters() << ":" << local_port() << " to " << peer_address().to_string().characters() << ":" << peer_port() << " with (" << (tcp_packet.has_syn() ? "SYN " : "") << (tcp_packet.has_ack() ? "ACK " : "") << (tcp_packet.has_fin() ? "FIN " : "") << (tcp_packet.has_rst() ? "RST " : "") << ") seq_no=" << tcp_packet.sequence_number() << ", ack_no=" << tcp_packet.ack_number() << ", tx_counter=" << packet.tx_counter;
 #endif
+        if (packet.checksum_offloaded && !routing_decision.adapter->can_offload_transport_checksum(packet.buffer.size())) {
+            // The route changed to an adapter without checksum offload.
+            auto& tcp_packet = *(TCPPacket*)(packet.buffer.data());
+            tcp_packet.set_checksum(0);
+            tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, packet.buffer.size() - sizeof(TCPPacket)));
+            packet.checksum_offloaded = false;
+        }
+
         routing_decision.adapter->send_ipv4(
             routing_decision.next_hop, peer_address(), IPv4Protocol::TCP,
-            packet.buffer.data(), packet.buffer.size(), ttl());
+            packet.buffer.data(), packet.buffer.size(), ttl(),
+            packet.checksum_offloaded ? TCPPacket::checksum_offset() : Optional<size_t>());
 
         m_packets_out++;
         m_bytes_out += packet.buffer.size();
@@ -289,44 +343,10 @@ void TCPSocket::receive_tcp_packet(const TCPPacket& packet, u16 size)
 
 NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket& packet, u16 payload_size)
 {
-    struct [[gnu::packed]] PseudoHeader
-    {
-        IPv4Address source;
-        IPv4Address destination;
-        u8 zero;
-        u8 protocol;
-        NetworkOrdered<u16> payload_size;
-    };
-
-    PseudoHeader pseudo_header { source, destination, 0, (u8)IPv4Protocol::TCP, sizeof(TCPPacket) + payload_size };
-
-    u32 checksum = 0;
-    auto* w = (const NetworkOrdered<u16>*)&pseudo_header;
-    for (size_t i = 0; i < sizeof(pseudo_header) / sizeof(u16); ++i) {
-        checksum += w[i];
-        if (checksum > 0xffff)
-            checksum = (checksum >> 16) + (checksum & 0xffff);
-    }
-    w = (const NetworkOrdered<u16>*)&packet;
-    for (size_t i = 0; i < sizeof(packet) / sizeof(u16); ++i) {
-        checksum += w[i];
-        if (checksum > 0xffff)
-            checksum = (checksum >> 16) + (checksum & 0xffff);
-    }
     ASSERT(packet.data_offset() * 4 == sizeof(TCPPacket));
-    w = (const NetworkOrdered<u16>*)packet.payload();
-    for (size_t i = 0; i < payload_size / sizeof(u16); ++i) {
-        checksum += w[i];
-        if (checksum > 0xffff)
-            checksum = (checksum >> 16) + (checksum & 0xffff);
-    }
-    if (payload_size & 1) {
-        u16 expanded_byte = ((const u8*)packet.payload())[payload_size - 1] << 8;
-        checksum += expanded_byte;
-        if (checksum > 0xffff)
-            checksum = (checksum >> 16) + (checksum & 0xffff);
-    }
-    return ~(checksum & 0xffff);
+    auto checksum = ipv4_pseudo_header_checksum(source, destination, IPv4Protocol::TCP, sizeof(TCPPacket) + payload_size);
+    checksum.add(&packet, sizeof(TCPPacket) + payload_size);
+    return convert_between_host_and_network(checksum.finish());
 }
 
 KResult TCPSocket::protocol_bind()
@@ -342,10 +362,21 @@ KResult TCPSocket::protocol_bind()
 
 KResult TCPSocket::protocol_listen()
 {
-    LOCKER(sockets_by_tuple().lock());
-    if (sockets_by_tuple().resource().contains(tuple()))
-        return KResult(-EADDRINUSE);
-    sockets_by_tuple().resource().set(tuple(), this);
+    {
+        LOCKER(listening_sockets().lock());
+        if (listening_sockets().resource().contains(tuple()))
+            return KResult(-EADDRINUSE);
+        listening_sockets().resource().set(tuple(), this);
+    }
+    {
+        // If we listen() without bind(), protocol_allocate_local_port() reserved our port
+        // in the connected table. We're only reachable through the listening table now.
+        auto& shard = connected_sockets(tuple());
+        LOCKER(shard.lock());
+        auto it = shard.resource().find(tuple());
+        if (it != shard.resource().end() && (*it).value == this)
+            shard.resource().remove(it);
+    }
     set_direction(Direction::Passive);
     set_state(State::Listen);
     set_setup_state(SetupState::Completed);
@@ -366,10 +397,10 @@ KResult TCPSocket::protocol_connect(FileDescription& description, ShouldBlock sh
     m_ack_number = 0;
 
     set_setup_state(SetupState::InProgress);
-    send_tcp_packet(TCPFlags::SYN);
     m_state = State::SynSent;
     m_role = Role::Connecting;
     m_direction = Direction::Outgoing;
+    send_tcp_packet(TCPFlags::SYN);
 
     if (should_block == ShouldBlock::Yes) {
         if (Thread::current()->block<Thread::ConnectBlocker>(description).was_interrupted())
@@ -392,14 +423,15 @@ int TCPSocket::protocol_allocate_local_port()
     static const u16 ephemeral_port_range_size = last_ephemeral_port - first_ephemeral_port;
     u16 first_scan_port = first_ephemeral_port + get_good_random<u16>() % ephemeral_port_range_size;
 
-    LOCKER(sockets_by_tuple().lock());
     for (u16 port = first_scan_port;;) {
         IPv4SocketTuple proposed_tuple(local_address(), port, peer_address(), peer_port());
 
-        auto it = sockets_by_tuple().resource().find(proposed_tuple);
-        if (it == sockets_by_tuple().resource().end()) {
+        auto& shard = connected_sockets(proposed_tuple);
+        LOCKER(shard.lock());
+        auto it = shard.resource().find(proposed_tuple);
+        if (it == shard.resource().end()) {
             set_local_port(port);
-            sockets_by_tuple().resource().set(proposed_tuple, this);
+            shard.resource().set(proposed_tuple, this);
             return port;
         }
         ++port;
@@ -411,6 +443,16 @@ int TCPSocket::protocol_allocate_local_port()
     return -EADDRINUSE;
 }
 
+bool TCPSocket::is_hung_up(const FileDescription& description) const
+{
+    if (Socket::is_hung_up(description))
+        return true;
+    // A socket that never tried to connect is closed, but hasn't hung up on anyone.
+    if (m_role == Role::None || m_role == Role::Listener)
+        return false;
+    return m_state == State::Closed || m_state == State::TimeWait;
+}
+
 bool TCPSocket::protocol_is_disconnected() const
 {
     switch (m_state) {
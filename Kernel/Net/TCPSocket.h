@@ -138,7 +138,11 @@ public:
 
     bool has_error() const { return m_error != Error::None; }
     Error error() const { return m_error; }
-    void set_error(Error error) { m_error = error; }
+    void set_error(Error error)
+    {
+        m_error = error;
+        did_change_readiness();
+    }
 
     void set_ack_number(u32 n) { m_ack_number = n; }
     void set_sequence_number(u32 n) { m_sequence_number = n; }
@@ -153,7 +157,14 @@ public:
     void send_outgoing_packets();
     void receive_tcp_packet(const TCPPacket&, u16 size);
 
-    static Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& sockets_by_tuple();
+    // Connected sockets are spread over a number of independently locked
+    // shards keyed by the full tuple, so packet demultiplexing is a single
+    // hash lookup that rarely contends with sockets coming and going.
+    // Listening sockets live in their own (small) table keyed by local
+    // address and port only.
+    static constexpr size_t connected_socket_shard_count = 16;
+    static Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& connected_sockets(const IPv4SocketTuple&);
+    static Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& listening_sockets();
     static RefPtr<TCPSocket> from_tuple(const IPv4SocketTuple& tuple);
     static RefPtr<TCPSocket> from_endpoints(const IPv4Address& local_address, u16 local_port, const IPv4Address& peer_address, u16 peer_port);
 
@@ -166,6 +177,8 @@ public:
     void release_for_accept(RefPtr<TCPSocket>);
 
     virtual KResult close() override;
+    virtual bool is_hung_up(const FileDescription&) const override;
+    virtual bool has_pending_error(const FileDescription&) const override { return has_error(); }
 
 protected:
     void set_direction(Direction direction) { m_direction = direction; }
@@ -204,6 +217,7 @@ private:
         ByteBuffer buffer;
         int tx_counter { 0 };
         timeval tx_time { 0, 0 };
+        bool checksum_offloaded { false };
     };
 
     Lock m_not_acked_lock { "TCPSocket unacked packets" };
@@ -101,6 +101,11 @@ int UDPSocket::protocol_send(const void* data, size_t data_length)
     udp_packet.set_destination_port(peer_port());
     udp_packet.set_length(sizeof(UDPPacket) + data_length);
     memcpy(udp_packet.payload(), data, data_length);
+    auto checksum = ipv4_pseudo_header_checksum(routing_decision.adapter->ipv4_address(), peer_address(), IPv4Protocol::UDP, udp_packet.length());
+    checksum.add(&udp_packet, udp_packet.length());
+    // A computed checksum of zero is transmitted as all ones, since zero means "no checksum".
+    u16 checksum_value = checksum.finish();
+    udp_packet.set_checksum(checksum_value ? convert_between_host_and_network(checksum_value) : 0xffff);
     klog() << "sending as udp packet from " << routing_decision.adapter->ipv4_address().to_string().characters() << ":" << local_port() << " to " << peer_address().to_string().characters() << ":" << peer_port() << "!";
     routing_decision.adapter->send_ipv4(routing_decision.next_hop, peer_address(), IPv4Protocol::UDP, buffer.data(), buffer.size(), ttl());
     return data_length;
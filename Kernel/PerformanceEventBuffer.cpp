@@ -24,11 +24,10 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/JsonArraySerializer.h>
-#include <AK/JsonObject.h>
-#include <AK/JsonObjectSerializer.h>
+#include <Kernel/API/Profiling.h>
 #include <Kernel/KBufferBuilder.h>
 #include <Kernel/PerformanceEventBuffer.h>
+#include <Kernel/Process.h>
 
 namespace Kernel {
 
@@ -37,31 +36,24 @@ PerformanceEventBuffer::PerformanceEventBuffer()
 {
 }
 
-KResult PerformanceEventBuffer::append(int type, FlatPtr arg1, FlatPtr arg2)
+bool PerformanceEventBuffer::append_record(u8 type, const void* record, size_t record_size, const void* trailer, size_t trailer_size)
 {
-    if (count() >= capacity())
-        return KResult(-ENOBUFS);
-
-    PerformanceEvent event;
-    event.type = type;
+    size_t total_size = sizeof(type) + record_size + trailer_size;
+    if (m_size + total_size > capacity())
+        return false;
+    auto* data = m_buffer.data() + m_size;
+    *data = type;
+    memcpy(data + sizeof(type), record, record_size);
+    if (trailer_size)
+        memcpy(data + sizeof(type) + record_size, trailer, trailer_size);
+    m_size += total_size;
+    return true;
+}
 
-    switch (type) {
-    case PERF_EVENT_MALLOC:
-        event.data.malloc.size = arg1;
-        event.data.malloc.ptr = arg2;
-#ifdef VERY_DEBUG
-        dbg() << "PERF_EVENT_MALLOC: " << (void*)event.data.malloc.ptr << " (" << event.data.malloc.size << ")";
-#endif
-        break;
-    case PERF_EVENT_FREE:
-        event.data.free.ptr = arg1;
-#ifdef VERY_DEBUG
-        dbg() << "PERF_EVENT_FREE: " << (void*)event.data.free.ptr;
-#endif
-        break;
-    default:
+KResult PerformanceEventBuffer::append(int type, FlatPtr arg1, FlatPtr arg2)
+{
+    if (type != PERF_EVENT_MALLOC && type != PERF_EVENT_FREE)
         return KResult(-EINVAL);
-    }
 
     FlatPtr ebp;
     asm volatile("movl %%ebp, %%eax"
@@ -74,59 +66,63 @@ KResult PerformanceEventBuffer::append(int type, FlatPtr arg1, FlatPtr arg2)
         SmapDisabler disabler;
         backtrace = current_thread->raw_backtrace(ebp, eip);
     }
-    event.stack_size = min(sizeof(event.stack) / sizeof(FlatPtr), static_cast<size_t>(backtrace.size()));
-    memcpy(event.stack, backtrace.data(), event.stack_size * sizeof(FlatPtr));
+    u32 frame_count = min((size_t)32, backtrace.size());
 
 #ifdef VERY_DEBUG
-    for (size_t i = 0; i < event.stack_size; ++i)
-        dbg() << "    " << (void*)event.stack[i];
+    for (size_t i = 0; i < frame_count; ++i)
+        dbg() << "    " << (void*)backtrace[i];
 #endif
 
-    event.timestamp = g_uptime;
-    at(m_count++) = event;
+    // Stacks are written the first time they are seen, and referred to by id after that.
+    pid_t pid = current_thread->pid();
+    u32 hash = ProfileStackTable::hash(pid, backtrace.data(), frame_count);
+    auto stack_id = m_stacks.find(pid, backtrace.data(), frame_count, hash);
+    if (!stack_id.has_value()) {
+        ProfileStackRecord stack { pid, frame_count };
+        if (!append_record((u8)ProfileRecordType::Stack, &stack, sizeof(stack), backtrace.data(), frame_count * sizeof(u32)))
+            return KResult(-ENOBUFS);
+        stack_id = m_stacks.add(pid, backtrace.data(), frame_count, hash);
+    }
+
+    if (type == PERF_EVENT_MALLOC) {
+#ifdef VERY_DEBUG
+        dbg() << "PERF_EVENT_MALLOC: " << (void*)arg2 << " (" << arg1 << ")";
+#endif
+        ProfileMallocRecord record { current_thread->tid(), stack_id.value(), g_uptime, arg2, arg1 };
+        if (!append_record((u8)ProfileRecordType::Malloc, &record, sizeof(record)))
+            return KResult(-ENOBUFS);
+    } else {
+#ifdef VERY_DEBUG
+        dbg() << "PERF_EVENT_FREE: " << (void*)arg1;
+#endif
+        ProfileFreeRecord record { current_thread->tid(), stack_id.value(), g_uptime, arg1 };
+        if (!append_record((u8)ProfileRecordType::Free, &record, sizeof(record)))
+            return KResult(-ENOBUFS);
+    }
     return KSuccess;
 }
 
-PerformanceEvent& PerformanceEventBuffer::at(size_t index)
+KBuffer PerformanceEventBuffer::to_perfcore(pid_t pid, const String& executable_path) const
 {
-    ASSERT(index < capacity());
-    auto* events = reinterpret_cast<PerformanceEvent*>(m_buffer.data());
-    return events[index];
-}
+    KBufferBuilder builder(sizeof(ProfileHeader) + executable_path.length() + 64 + m_size);
 
-KBuffer PerformanceEventBuffer::to_json(pid_t pid, const String& executable_path) const
-{
-    KBufferBuilder builder;
+    ProfileHeader header;
+    header.magic = PROFILE_MAGIC;
+    header.version = PROFILE_VERSION;
+    header.pid = pid;
+    header.samples_per_second = 0;
+    builder.append((const char*)&header, sizeof(header));
 
-    JsonObjectSerializer object(builder);
-    object.add("pid", pid);
-    object.add("executable", executable_path);
+    ProfileStringRecord string { (u32)executable_path.length() };
+    builder.append((char)ProfileRecordType::String);
+    builder.append((const char*)&string, sizeof(string));
+    builder.append(executable_path);
 
-    auto array = object.add_array("events");
-    for (size_t i = 0; i < m_count; ++i) {
-        auto& event = at(i);
-        auto event_object = array.add_object();
-        switch (event.type) {
-        case PERF_EVENT_MALLOC:
-            event_object.add("type", "malloc");
-            event_object.add("ptr", static_cast<u64>(event.data.malloc.ptr));
-            event_object.add("size", static_cast<u64>(event.data.malloc.size));
-            break;
-        case PERF_EVENT_FREE:
-            event_object.add("type", "free");
-            event_object.add("ptr", static_cast<u64>(event.data.free.ptr));
-            break;
-        }
-        event_object.add("timestamp", event.timestamp);
-        auto stack_array = event_object.add_array("stack");
-        for (size_t j = 0; j < event.stack_size; ++j) {
-            stack_array.add(event.stack[j]);
-        }
-        stack_array.finish();
-        event_object.finish();
-    }
-    array.finish();
-    object.finish();
+    ProfileProcessRecord process { pid, 0 };
+    builder.append((char)ProfileRecordType::Process);
+    builder.append((const char*)&process, sizeof(process));
+
+    builder.append((const char*)m_buffer.data(), m_size);
     return builder.build();
 }
 
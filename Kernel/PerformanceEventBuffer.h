@@ -28,53 +28,30 @@
 
 #include <Kernel/KBuffer.h>
 #include <Kernel/KResult.h>
+#include <Kernel/ProfileStackTable.h>
 
 namespace Kernel {
 
-struct [[gnu::packed]] MallocPerformanceEvent
-{
-    size_t size;
-    FlatPtr ptr;
-};
-
-struct [[gnu::packed]] FreePerformanceEvent
-{
-    size_t size;
-    FlatPtr ptr;
-};
-
-struct [[gnu::packed]] PerformanceEvent
-{
-    u8 type { 0 };
-    u8 stack_size { 0 };
-    u64 timestamp;
-    union {
-        MallocPerformanceEvent malloc;
-        FreePerformanceEvent free;
-    } data;
-    FlatPtr stack[32];
-};
-
+// Collects the events a process records with perf_event(), already encoded as
+// perfcore records (see Kernel/API/Profiling.h), so that writing them out when
+// the process exits is a single copy.
 class PerformanceEventBuffer {
 public:
     PerformanceEventBuffer();
 
     KResult append(int type, FlatPtr arg1, FlatPtr arg2);
 
-    size_t capacity() const { return m_buffer.size() / sizeof(PerformanceEvent); }
-    size_t count() const { return m_count; }
-    const PerformanceEvent& at(size_t index) const
-    {
-        return const_cast<PerformanceEventBuffer&>(*this).at(index);
-    }
+    size_t capacity() const { return m_buffer.size(); }
+    size_t size() const { return m_size; }
 
-    KBuffer to_json(pid_t, const String& executable_path) const;
+    KBuffer to_perfcore(pid_t, const String& executable_path) const;
 
 private:
-    PerformanceEvent& at(size_t index);
+    bool append_record(u8 type, const void* record, size_t record_size, const void* trailer = nullptr, size_t trailer_size = 0);
 
-    size_t m_count { 0 };
+    size_t m_size { 0 };
     KBuffer m_buffer;
+    ProfileStackTable m_stacks;
 };
 
 }
@@ -33,6 +33,7 @@
 #include <AK/Time.h>
 #include <AK/Types.h>
 #include <Kernel/ACPI/Parser.h>
+#include <Kernel/API/ProcessStatistics.h>
 #include <Kernel/API/Syscall.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Console.h>
@@ -43,14 +44,17 @@
 #include <Kernel/Devices/RandomDevice.h>
 #include <Kernel/FileSystem/Custody.h>
 #include <Kernel/FileSystem/DevPtsFS.h>
+#include <Kernel/FileSystem/EventPoll.h>
 #include <Kernel/FileSystem/Ext2FileSystem.h>
 #include <Kernel/FileSystem/FIFO.h>
 #include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/FileSystem/IORing.h>
 #include <Kernel/FileSystem/InodeWatcher.h>
 #include <Kernel/FileSystem/Plan9FileSystem.h>
 #include <Kernel/FileSystem/ProcFS.h>
 #include <Kernel/FileSystem/TmpFS.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
+#include <Kernel/FutexQueue.h>
 #include <Kernel/Heap/kmalloc.h>
 #include <Kernel/IO.h>
 #include <Kernel/KBufferBuilder.h>
@@ -73,6 +77,7 @@
 #include <Kernel/Thread.h>
 #include <Kernel/ThreadTracer.h>
 #include <Kernel/Time/TimeManagement.h>
+#include <Kernel/VM/MemoryPressureWatcher.h>
 #include <Kernel/VM/PageDirectory.h>
 #include <Kernel/VM/PrivateInodeVMObject.h>
 #include <Kernel/VM/ProcessPagingScope.h>
@@ -97,6 +102,7 @@
 namespace Kernel {
 
 static void create_signal_trampolines();
+static pid_t get_sid_from_pgid(pid_t pgid);
 
 RecursiveSpinLock g_processes_lock;
 static Atomic<pid_t> next_pid;
@@ -414,6 +420,14 @@ void* Process::sys$mmap(const Syscall::SC_mmap_params* user_params)
     if (map_stack && (!map_private || !map_anonymous))
         return (void*)-EINVAL;
 
+    // MAP_FIXED replaces whatever was mapped there before, which lets callers reserve
+    // address space up front and fill it in piece by piece.
+    if (map_fixed && region_containing({ VirtualAddress(addr), size })) {
+        auto result = unmap_mmap_range({ VirtualAddress(addr), PAGE_ROUND_UP(size) });
+        if (result.is_error())
+            return (void*)(int)result.error();
+    }
+
     Region* region = nullptr;
 
     auto range = allocate_range(VirtualAddress(addr), size, alignment);
@@ -429,7 +443,12 @@ void* Process::sys$mmap(const Syscall::SC_mmap_params* user_params)
         region = allocate_region(range, !name.is_null() ? name : "mmap", prot, false);
         if (!region && (!map_fixed && addr != 0))
             region = allocate_region(allocate_range({}, size), !name.is_null() ? name : "mmap", prot, false);
+        if (region)
+            static_cast<AnonymousVMObject&>(region->vmobject()).set_swappable(true);
     } else {
+        // The file picks its own range, so give back the one we reserved above.
+        // Otherwise an address hint could never be honored for file mappings.
+        page_directory().range_allocator().deallocate(range);
         if (offset < 0)
             return (void*)-EINVAL;
         if (static_cast<size_t>(offset) & ~PAGE_MASK)
@@ -484,38 +503,48 @@ int Process::sys$munmap(void* addr, size_t size)
     if (!is_user_range(VirtualAddress(addr), size))
         return -EFAULT;
 
-    Range range_to_unmap { VirtualAddress(addr), size };
+    return unmap_mmap_range({ VirtualAddress(addr), size });
+}
+
+KResult Process::unmap_mmap_range(const Range& range_to_unmap)
+{
     if (auto* whole_region = region_from_range(range_to_unmap)) {
         if (!whole_region->is_mmap())
-            return -EPERM;
+            return KResult(-EPERM);
         bool success = deallocate_region(*whole_region);
         ASSERT(success);
-        return 0;
+        return KSuccess;
     }
 
     if (auto* old_region = region_containing(range_to_unmap)) {
         if (!old_region->is_mmap())
-            return -EPERM;
+            return KResult(-EPERM);
 
         auto new_regions = split_region_around_range(*old_region, range_to_unmap);
 
-        // We manually unmap the old region here, specifying that we *don't* want the VM deallocated.
-        old_region->unmap(Region::ShouldDeallocateVirtualMemoryRange::No);
-        deallocate_region(*old_region);
+        {
+            // The pieces we keep share the old region's VMObject, so no pages
+            // are freed here and the flushes can be batched.
+            TLBFlushBatch tlb_flush_batch(page_directory());
 
-        // Instead we give back the unwanted VM manually.
-        page_directory().range_allocator().deallocate(range_to_unmap);
+            // We manually unmap the old region here, specifying that we *don't* want the VM deallocated.
+            old_region->unmap(Region::ShouldDeallocateVirtualMemoryRange::No);
+            deallocate_region(*old_region);
 
-        // And finally we map the new region(s) using our page directory (they were just allocated and don't have one).
-        for (auto* new_region : new_regions) {
-            new_region->map(page_directory());
+            // Instead we give back the unwanted VM manually.
+            page_directory().range_allocator().deallocate(range_to_unmap);
+
+            // And finally we map the new region(s) using our page directory (they were just allocated and don't have one).
+            for (auto* new_region : new_regions) {
+                new_region->map(page_directory());
+            }
         }
-        return 0;
+        return KSuccess;
     }
 
     // FIXME: We should also support munmap() across multiple regions. (#175)
 
-    return -EINVAL;
+    return KResult(-EINVAL);
 }
 
 int Process::sys$mprotect(void* addr, size_t size, int prot)
@@ -571,6 +600,8 @@ int Process::sys$mprotect(void* addr, size_t size, int prot)
         new_region.set_writable(prot & PROT_WRITE);
         new_region.set_executable(prot & PROT_EXEC);
 
+        TLBFlushBatch tlb_flush_batch(page_directory());
+
         // Unmap the old region here, specifying that we *don't* want the VM deallocated.
         old_region->unmap(Region::ShouldDeallocateVirtualMemoryRange::No);
         deallocate_region(*old_region);
@@ -765,16 +796,23 @@ pid_t Process::sys$fork(RegisterState& regs)
     dbg() << "fork: child will begin executing at " << String::format("%w", child_tss.cs) << ":" << String::format("%x", child_tss.eip) << " with stack " << String::format("%w", child_tss.ss) << ":" << String::format("%x", child_tss.esp) << ", kstack " << String::format("%w", child_tss.ss0) << ":" << String::format("%x", child_tss.esp0);
 #endif
 
-    ScopedSpinLock lock(m_lock);
-    for (auto& region : m_regions) {
+    {
+        // Cloning write-protects the mapped pages of our writable regions one by one.
+        // Shoot down the stale translations on other processors once we're done,
+        // before the child can run.
+        TLBFlushBatch tlb_flush_batch(page_directory());
+        ScopedSpinLock lock(m_lock);
+        for (auto& region : m_regions) {
 #ifdef FORK_DEBUG
-        dbg() << "fork: cloning Region{" << &region << "} '" << region.name() << "' @ " << region.vaddr();
+            dbg() << "fork: cloning Region{" << &region << "} '" << region.name() << "' @ " << region.vaddr();
 #endif
-        auto& child_region = child->add_region(region.clone());
-        child_region.map(child->page_directory());
+            auto& child_region = child->add_region(region.clone());
+            // The child's page tables are filled in by the page fault handler as it touches its memory.
+            child_region.map_on_demand(child->page_directory());
 
-        if (&region == m_master_tls_region)
-            child->m_master_tls_region = child_region.make_weak_ptr();
+            if (&region == m_master_tls_region)
+                child->m_master_tls_region = child_region.make_weak_ptr();
+        }
     }
 
     {
@@ -912,7 +950,6 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
     RefPtr<ELF::Loader> loader;
     {
         ArmedScopeGuard rollback_regions_guard([&]() {
-            ASSERT(Process::current() == this);
             // Need to make sure we don't swap contexts in the middle
             ScopedCritical critical;
             m_page_directory = move(old_page_directory);
@@ -935,6 +972,13 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
                 prot |= PROT_WRITE;
             if (is_executable)
                 prot |= PROT_EXEC;
+            if (is_writable) {
+                // Data is copy-on-write: clean pages come from the image's page cache and are shared with every other instance.
+                auto private_vmobject = PrivateInodeVMObject::create_with_inode(inode);
+                if (auto* region = allocate_region_with_vmobject(vaddr.offset(m_load_offset), size, move(private_vmobject), offset_in_image, String(name), prot))
+                    return region->vaddr().as_ptr();
+                return nullptr;
+            }
             if (auto* region = allocate_region_with_vmobject(vaddr.offset(m_load_offset), size, *vmobject, offset_in_image, String(name), prot)) {
                 region->set_shared(true);
                 return region->vaddr().as_ptr();
@@ -1014,10 +1058,6 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
             m_egid = m_sgid = main_program_metadata.gid;
     }
 
-    current_thread->set_default_signal_dispositions();
-    current_thread->m_signal_mask = 0;
-    current_thread->m_pending_signals = 0;
-
     m_futex_queues.clear();
 
     m_region_lookup_cache = {};
@@ -1043,6 +1083,12 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
     }
     ASSERT(new_main_thread);
 
+    new_main_thread->set_default_signal_dispositions();
+    new_main_thread->m_pending_signals = 0;
+    // NOTE: A freshly spawned process keeps the signal mask its spawner gave it.
+    if (new_main_thread == current_thread)
+        new_main_thread->m_signal_mask = 0;
+
     auto auxv = generate_auxiliary_vector();
 
     // NOTE: We create the new stack before disabling interrupts since it will zero-fault
@@ -1082,8 +1128,8 @@ int Process::do_exec(NonnullRefPtr<FileDescription> main_program_description, Ve
     klog() << "Process " << VirtualAddress(this) << " thread " << VirtualAddress(new_main_thread) << " exec'd " << path.characters() << " @ " << String::format("%p", m_entry_eip);
 #endif
 
-    if (was_profiling)
-        Profiling::did_exec(path);
+    if (was_profiling || Profiling::is_profiling_all_processes())
+        Profiling::did_exec(*this, path);
 
     new_main_thread->set_state(Thread::State::Skip1SchedulerPass);
     big_lock().force_unlock_if_locked();
@@ -1124,6 +1170,9 @@ Vector<AuxiliaryValue> Process::generate_auxiliary_vector() const
 
     auxv.append({ AuxiliaryValue::ExecFilename, m_executable->absolute_path() });
 
+    if (auto fast_syscall_entry = Syscall::fast_syscall_entry())
+        auxv.append({ AuxiliaryValue::SysInfo, (void*)fast_syscall_entry });
+
     auxv.append({ AuxiliaryValue::Null, 0L });
     return auxv;
 }
@@ -1346,29 +1395,12 @@ int Process::sys$execve(const Syscall::SC_execve_params* user_params)
         path = path_arg.value();
     }
 
-    auto copy_user_strings = [&](const auto& list, auto& output) {
-        if (!list.length)
-            return true;
-        if (!validate_read_typed(list.strings, list.length))
-            return false;
-        Vector<Syscall::StringArgument, 32> strings;
-        strings.resize(list.length);
-        copy_from_user(strings.data(), list.strings, list.length * sizeof(Syscall::StringArgument));
-        for (size_t i = 0; i < list.length; ++i) {
-            auto string = validate_and_copy_string_from_user(strings[i]);
-            if (string.is_null())
-                return false;
-            output.append(move(string));
-        }
-        return true;
-    };
-
     Vector<String> arguments;
-    if (!copy_user_strings(params.arguments, arguments))
+    if (!copy_string_list_from_user(params.arguments, arguments))
         return -EFAULT;
 
     Vector<String> environment;
-    if (!copy_user_strings(params.environment, environment))
+    if (!copy_string_list_from_user(params.environment, environment))
         return -EFAULT;
 
     int rc = exec(move(path), move(arguments), move(environment));
@@ -1376,6 +1408,222 @@ int Process::sys$execve(const Syscall::SC_execve_params* user_params)
     return rc;
 }
 
+bool Process::copy_string_list_from_user(const Syscall::StringListArgument& list, Vector<String>& output)
+{
+    if (!list.length)
+        return true;
+    if (!validate_read_typed(list.strings, list.length))
+        return false;
+    Vector<Syscall::StringArgument, 32> strings;
+    strings.resize(list.length);
+    copy_from_user(strings.data(), list.strings, list.length * sizeof(Syscall::StringArgument));
+    for (size_t i = 0; i < list.length; ++i) {
+        auto string = validate_and_copy_string_from_user(strings[i]);
+        if (string.is_null())
+            return false;
+        output.append(move(string));
+    }
+    return true;
+}
+
+KResult Process::apply_spawn_file_action(Process& child, const Syscall::SC_posix_spawn_file_action& action)
+{
+    switch (action.type) {
+    case Syscall::SpawnFileActionType::Open: {
+        if (action.options & O_WRONLY)
+            REQUIRE_PROMISE(wpath);
+        else if (action.options & O_RDONLY)
+            REQUIRE_PROMISE(rpath);
+        if (action.options & O_CREAT)
+            REQUIRE_PROMISE(cpath);
+        if (action.options & (O_NOFOLLOW_NOERROR | O_UNLINK_INTERNAL))
+            return KResult(-EINVAL);
+        if (action.fd < 0 || action.fd >= m_max_open_file_descriptors)
+            return KResult(-EBADF);
+        auto path = get_syscall_path_argument(action.path);
+        if (path.is_error())
+            return path.error();
+        auto result = VFS::the().open(path.value(), action.options, (action.mode & 04777) & ~child.umask(), child.current_directory());
+        if (result.is_error())
+            return result.error();
+        auto description = result.value();
+        if (description->inode() && description->inode()->socket())
+            return KResult(-ENXIO);
+        if (auto& existing = child.m_fds[action.fd]; existing.description) {
+            existing.description->close();
+            existing = {};
+        }
+        child.m_fds[action.fd].set(move(description), (action.options & O_CLOEXEC) ? FD_CLOEXEC : 0);
+        return KSuccess;
+    }
+    case Syscall::SpawnFileActionType::Close: {
+        auto description = child.file_description(action.fd);
+        if (!description)
+            return KResult(-EBADF);
+        description->close();
+        child.m_fds[action.fd] = {};
+        return KSuccess;
+    }
+    case Syscall::SpawnFileActionType::Dup2: {
+        auto description = child.file_description(action.fd);
+        if (!description)
+            return KResult(-EBADF);
+        if (action.new_fd < 0 || action.new_fd >= m_max_open_file_descriptors)
+            return KResult(-EBADF);
+        child.m_fds[action.new_fd].set(*description);
+        return KSuccess;
+    }
+    case Syscall::SpawnFileActionType::Chdir: {
+        REQUIRE_PROMISE(rpath);
+        auto path = get_syscall_path_argument(action.path);
+        if (path.is_error())
+            return path.error();
+        auto directory_or_error = VFS::the().open_directory(path.value(), child.current_directory());
+        if (directory_or_error.is_error())
+            return directory_or_error.error();
+        child.m_cwd = *directory_or_error.value();
+        return KSuccess;
+    }
+    case Syscall::SpawnFileActionType::Fchdir: {
+        auto description = child.file_description(action.fd);
+        if (!description)
+            return KResult(-EBADF);
+        if (!description->is_directory())
+            return KResult(-ENOTDIR);
+        if (!description->metadata().may_execute(child))
+            return KResult(-EACCES);
+        child.m_cwd = description->custody();
+        return KSuccess;
+    }
+    }
+    return KResult(-EINVAL);
+}
+
+pid_t Process::sys$posix_spawn(const Syscall::SC_posix_spawn_params* user_params)
+{
+    REQUIRE_PROMISE(proc);
+    REQUIRE_PROMISE(exec);
+
+    Syscall::SC_posix_spawn_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+
+    if (params.arguments.length > ARG_MAX || params.environment.length > ARG_MAX)
+        return -E2BIG;
+
+    auto path = get_syscall_path_argument(params.path);
+    if (path.is_error())
+        return path.error();
+
+    Vector<String> arguments;
+    if (!copy_string_list_from_user(params.arguments, arguments))
+        return -EFAULT;
+
+    Vector<String> environment;
+    if (!copy_string_list_from_user(params.environment, environment))
+        return -EFAULT;
+
+    Vector<Syscall::SC_posix_spawn_file_action> file_actions;
+    if (params.file_action_count) {
+        if (params.file_action_count > (size_t)m_max_open_file_descriptors * 4)
+            return -EINVAL;
+        if (!validate_read_typed(params.file_actions, params.file_action_count))
+            return -EFAULT;
+        file_actions.resize(params.file_action_count);
+        copy_from_user(file_actions.data(), params.file_actions, params.file_action_count * sizeof(Syscall::SC_posix_spawn_file_action));
+    }
+
+    if ((params.flags & POSIX_SPAWN_SETSCHEDPARAM) && (params.sched_priority < THREAD_PRIORITY_MIN || params.sched_priority > THREAD_PRIORITY_MAX))
+        return -EINVAL;
+    if ((params.flags & POSIX_SPAWN_SETPGROUP) && params.pgroup < 0)
+        return -EINVAL;
+
+    // Unlike fork(), the child starts out with an empty address space that exec() fills in directly,
+    // so nothing from our own address space is ever cloned or write-protected.
+    Thread* child_first_thread = nullptr;
+    auto* child = new Process(child_first_thread, m_name, m_uid, m_gid, m_pid, m_ring, m_cwd, nullptr, m_tty);
+    child->m_euid = m_euid;
+    child->m_egid = m_egid;
+    child->m_suid = m_suid;
+    child->m_sgid = m_sgid;
+    child->m_extra_gids = m_extra_gids;
+    child->m_root_directory = m_root_directory;
+    child->m_root_directory_relative_to_global_root = m_root_directory_relative_to_global_root;
+    child->m_promises = m_promises;
+    child->m_execpromises = m_execpromises;
+    child->m_veil_state = m_veil_state;
+    child->m_unveiled_paths = m_unveiled_paths;
+    child->m_fds = m_fds;
+    child->m_sid = m_sid;
+    child->m_pgid = m_pgid;
+    child->m_umask = m_umask;
+    child_first_thread->m_signal_mask = Thread::current()->m_signal_mask;
+
+    auto destroy_child = [&] {
+        delete child_first_thread;
+        delete child;
+    };
+
+    if (params.flags & POSIX_SPAWN_RESETIDS) {
+        child->m_euid = m_uid;
+        child->m_egid = m_gid;
+    }
+    if (params.flags & POSIX_SPAWN_SETPGROUP) {
+        pid_t new_pgid = params.pgroup ? params.pgroup : child->m_pid;
+        if (new_pgid != child->m_pid && get_sid_from_pgid(new_pgid) != m_sid) {
+            destroy_child();
+            return -EPERM;
+        }
+        child->m_pgid = new_pgid;
+    }
+    if (params.flags & POSIX_SPAWN_SETSCHEDPARAM)
+        child_first_thread->set_priority((u32)params.sched_priority);
+    if (params.flags & POSIX_SPAWN_SETSIGMASK)
+        child_first_thread->m_signal_mask = params.sigmask;
+    if (params.flags & POSIX_SPAWN_SETSID) {
+        child->m_sid = child->m_pid;
+        child->m_pgid = child->m_pid;
+    }
+    // NOTE: POSIX_SPAWN_SETSIGDEF needs no work here, exec() resets every signal disposition anyway.
+
+    // File actions are performed as the child, which matters once POSIX_SPAWN_RESETIDS
+    // has dropped its effective ids. Only this thread's permission checks see them.
+    Thread::current()->set_access_credentials_override(Thread::AccessCredentials { child->m_euid, child->m_egid });
+    for (auto& action : file_actions) {
+        auto result = apply_spawn_file_action(*child, action);
+        if (result.is_error()) {
+            Thread::current()->set_access_credentials_override({});
+            destroy_child();
+            return result;
+        }
+    }
+    Thread::current()->set_access_credentials_override({});
+
+    // Like fork(), make the child visible before exec() lets its thread run.
+    {
+        ScopedSpinLock lock(g_processes_lock);
+        g_processes->prepend(child);
+    }
+
+    int rc = child->exec(path.value(), move(arguments), move(environment));
+
+    // exec() loaded the child from within our thread, so switch back to our own address space.
+    MM.enter_process_paging_scope(*this);
+
+    if (rc < 0) {
+        {
+            ScopedSpinLock lock(g_processes_lock);
+            g_processes->remove(child);
+        }
+        destroy_child();
+        return rc;
+    }
+#ifdef TASK_DEBUG
+    klog() << "Process " << child->pid() << " (" << child->name().characters() << ") spawned by " << m_pid << " @ " << String::format("%p", child_first_thread->tss().eip);
+#endif
+    return child->pid();
+}
+
 Process* Process::create_user_process(Thread*& first_thread, const String& path, uid_t uid, gid_t gid, pid_t parent_pid, int& error, Vector<String>&& arguments, Vector<String>&& environment, TTY* tty)
 {
     auto parts = path.split('/');
@@ -1704,26 +1952,35 @@ int Process::sys$ptsname_r(int fd, char* buffer, ssize_t size)
     return 0;
 }
 
-ssize_t Process::sys$writev(int fd, const struct iovec* iov, int iov_count)
+KResult Process::copy_iovecs_from_user(Vector<iovec, 32>& vecs, const iovec* iov, int iov_count, IovecAccess access)
 {
-    REQUIRE_PROMISE(stdio);
     if (iov_count < 0)
-        return -EINVAL;
+        return KResult(-EINVAL);
 
     if (!validate_read_typed(iov, iov_count))
-        return -EFAULT;
+        return KResult(-EFAULT);
 
     u64 total_length = 0;
-    Vector<iovec, 32> vecs;
     vecs.resize(iov_count);
     copy_from_user(vecs.data(), iov, iov_count * sizeof(iovec));
     for (auto& vec : vecs) {
-        if (!validate_read(vec.iov_base, vec.iov_len))
-            return -EFAULT;
+        bool valid = access == IovecAccess::Read ? validate_read(vec.iov_base, vec.iov_len) : validate_write(vec.iov_base, vec.iov_len);
+        if (!valid)
+            return KResult(-EFAULT);
         total_length += vec.iov_len;
         if (total_length > INT32_MAX)
-            return -EINVAL;
+            return KResult(-EINVAL);
     }
+    return KSuccess;
+}
+
+ssize_t Process::sys$writev(int fd, const struct iovec* iov, int iov_count)
+{
+    REQUIRE_PROMISE(stdio);
+    Vector<iovec, 32> vecs;
+    auto result = copy_iovecs_from_user(vecs, iov, iov_count, IovecAccess::Read);
+    if (result.is_error())
+        return result;
 
     auto description = file_description(fd);
     if (!description)
@@ -1746,6 +2003,94 @@ ssize_t Process::sys$writev(int fd, const struct iovec* iov, int iov_count)
     return nwritten;
 }
 
+ssize_t Process::sys$sendfile(const Syscall::SC_sendfile_params* user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_sendfile_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+    if ((ssize_t)params.count < 0)
+        return -EINVAL;
+
+    off_t offset = 0;
+    if (params.offset) {
+        if (!validate_write_typed(params.offset))
+            return -EFAULT;
+        copy_from_user(&offset, params.offset);
+        if (offset < 0)
+            return -EINVAL;
+    }
+
+    auto in_description = file_description(params.in_fd);
+    if (!in_description)
+        return -EBADF;
+    if (!in_description->is_readable())
+        return -EBADF;
+    // The source has to be something we can read at an arbitrary offset without
+    // blocking, which in practice means a regular file.
+    if (!in_description->inode() || in_description->is_directory())
+        return -EINVAL;
+
+    auto out_description = file_description(params.out_fd);
+    if (!out_description)
+        return -EBADF;
+    if (!out_description->is_writable())
+        return -EBADF;
+
+    if (params.count == 0)
+        return 0;
+
+    // Data goes from the file system (and its block cache) into this buffer
+    // and straight back out to the destination, never touching userspace.
+    static constexpr size_t max_chunk_size = 64 * KB;
+    auto buffer = KBuffer::create_with_size(min((size_t)PAGE_ROUND_UP(params.count), max_chunk_size), Region::Access::Read | Region::Access::Write, "sendfile");
+
+    auto transfer = [&](off_t& offset) -> ssize_t {
+        ssize_t total_nwritten = 0;
+        while ((size_t)total_nwritten < params.count) {
+            size_t chunk_size = min(params.count - total_nwritten, buffer.capacity());
+            ssize_t nread = in_description->read_at(offset, buffer.data(), chunk_size);
+            if (nread < 0) {
+                if (total_nwritten == 0)
+                    return nread;
+                break;
+            }
+            if (nread == 0)
+                break;
+            ssize_t nwritten = do_write(*out_description, buffer.data(), nread);
+            if (nwritten < 0) {
+                if (total_nwritten == 0)
+                    return nwritten;
+                break;
+            }
+            offset += nwritten;
+            total_nwritten += nwritten;
+            if (nwritten < nread)
+                break;
+        }
+        return total_nwritten;
+    };
+
+    if (!params.offset) {
+        // Like read(), use and advance the description's own offset under its lock,
+        // so that concurrent reads and sendfiles don't see the same data twice.
+        LOCKER(in_description->lock());
+        offset = in_description->offset();
+        ssize_t rc = transfer(offset);
+        if (rc > 0)
+            in_description->seek(offset, SEEK_SET);
+        return rc;
+    }
+
+    ssize_t rc = transfer(offset);
+    if (rc < 0)
+        return rc;
+    if (!validate_write_typed(params.offset))
+        return -EFAULT;
+    copy_to_user(params.offset, &offset);
+    return rc;
+}
+
 ssize_t Process::do_write(FileDescription& description, const u8* data, int data_size)
 {
     ssize_t nwritten = 0;
@@ -1835,15 +2180,164 @@ ssize_t Process::sys$read(int fd, u8* buffer, ssize_t size)
         return -EBADF;
     if (description->is_directory())
         return -EISDIR;
-    if (description->is_blocking()) {
-        if (!description->can_read()) {
-            if (Thread::current()->block<Thread::ReadBlocker>(*description).was_interrupted())
+    return do_read(*description, buffer, size);
+}
+
+ssize_t Process::do_read(FileDescription& description, u8* buffer, ssize_t size)
+{
+    if (description.is_blocking()) {
+        if (!description.can_read()) {
+            if (Thread::current()->block<Thread::ReadBlocker>(description).was_interrupted())
                 return -EINTR;
-            if (!description->can_read())
+            if (!description.can_read())
                 return -EAGAIN;
         }
     }
-    return description->read(buffer, size);
+    return description.read(buffer, size);
+}
+
+ssize_t Process::sys$readv(int fd, const struct iovec* iov, int iov_count)
+{
+    REQUIRE_PROMISE(stdio);
+    Vector<iovec, 32> vecs;
+    auto result = copy_iovecs_from_user(vecs, iov, iov_count, IovecAccess::Write);
+    if (result.is_error())
+        return result;
+
+    auto description = file_description(fd);
+    if (!description)
+        return -EBADF;
+    if (!description->is_readable())
+        return -EBADF;
+    if (description->is_directory())
+        return -EISDIR;
+
+    ssize_t nread = 0;
+    for (auto& vec : vecs) {
+        // Only block for the first buffer, like a single read() would.
+        if (nread > 0 && !description->can_read())
+            break;
+        ssize_t rc = do_read(*description, (u8*)vec.iov_base, vec.iov_len);
+        if (rc < 0) {
+            if (nread == 0)
+                return rc;
+            break;
+        }
+        nread += rc;
+        if ((size_t)rc < vec.iov_len)
+            break;
+    }
+    return nread;
+}
+
+ssize_t Process::sys$pread(const Syscall::SC_pread_params* user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_pread_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+    if ((ssize_t)params.buffer.size < 0)
+        return -EINVAL;
+    if (params.buffer.size == 0)
+        return 0;
+    if (!validate(params.buffer))
+        return -EFAULT;
+
+    auto description = file_description(params.fd);
+    if (!description)
+        return -EBADF;
+    if (!description->is_readable())
+        return -EBADF;
+    if (description->is_directory())
+        return -EISDIR;
+    return description->read_at(params.offset, (u8*)params.buffer.data, params.buffer.size);
+}
+
+ssize_t Process::sys$pwrite(const Syscall::SC_pwrite_params* user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_pwrite_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+    if ((ssize_t)params.data.size < 0)
+        return -EINVAL;
+    if (params.data.size == 0)
+        return 0;
+    if (!validate(params.data))
+        return -EFAULT;
+
+    auto description = file_description(params.fd);
+    if (!description)
+        return -EBADF;
+    if (!description->is_writable())
+        return -EBADF;
+    return description->write_at(params.offset, (const u8*)params.data.data, params.data.size);
+}
+
+ssize_t Process::sys$preadv(const Syscall::SC_preadv_params* user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_preadv_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+    Vector<iovec, 32> vecs;
+    auto result = copy_iovecs_from_user(vecs, params.iov, params.iov_count, IovecAccess::Write);
+    if (result.is_error())
+        return result;
+
+    auto description = file_description(params.fd);
+    if (!description)
+        return -EBADF;
+    if (!description->is_readable())
+        return -EBADF;
+    if (description->is_directory())
+        return -EISDIR;
+
+    ssize_t nread = 0;
+    for (auto& vec : vecs) {
+        ssize_t rc = description->read_at(params.offset + nread, (u8*)vec.iov_base, vec.iov_len);
+        if (rc < 0) {
+            if (nread == 0)
+                return rc;
+            break;
+        }
+        nread += rc;
+        if ((size_t)rc < vec.iov_len)
+            break;
+    }
+    return nread;
+}
+
+ssize_t Process::sys$pwritev(const Syscall::SC_pwritev_params* user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_pwritev_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+    Vector<iovec, 32> vecs;
+    auto result = copy_iovecs_from_user(vecs, params.iov, params.iov_count, IovecAccess::Read);
+    if (result.is_error())
+        return result;
+
+    auto description = file_description(params.fd);
+    if (!description)
+        return -EBADF;
+    if (!description->is_writable())
+        return -EBADF;
+
+    ssize_t nwritten = 0;
+    for (auto& vec : vecs) {
+        ssize_t rc = description->write_at(params.offset + nwritten, (const u8*)vec.iov_base, vec.iov_len);
+        if (rc < 0) {
+            if (nwritten == 0)
+                return rc;
+            break;
+        }
+        nwritten += rc;
+        if ((size_t)rc < vec.iov_len)
+            break;
+    }
+    return nwritten;
 }
 
 int Process::sys$close(int fd)
@@ -1921,6 +2415,20 @@ int Process::sys$fcntl(int fd, int cmd, u32 arg)
         break;
     case F_ISTTY:
         return description->is_tty();
+    case F_GETPIPE_SZ:
+        if (!description->is_fifo())
+            return -EINVAL;
+        return description->fifo()->buffer_capacity();
+    case F_SETPIPE_SZ: {
+        if (!description->is_fifo())
+            return -EINVAL;
+        auto* fifo = description->fifo();
+        auto result = fifo->set_buffer_capacity(arg);
+        if (result.is_error())
+            return result;
+        fifo->did_change_readiness();
+        return fifo->buffer_capacity();
+    }
     default:
         return -EINVAL;
     }
@@ -2088,10 +2596,11 @@ int Process::sys$open(const Syscall::SC_open_params* user_params)
     if (!validate_read_and_copy_typed(&params, user_params))
         return -EFAULT;
 
-    int dirfd = params.dirfd;
-    int options = params.options;
-    u16 mode = params.mode;
+    return do_open(params.dirfd, params.path.characters, params.path.length, params.options, params.mode);
+}
 
+int Process::do_open(int dirfd, const char* user_path, size_t path_length, int options, u16 mode)
+{
     if (options & O_NOFOLLOW_NOERROR)
         return -EINVAL;
 
@@ -2109,7 +2618,7 @@ int Process::sys$open(const Syscall::SC_open_params* user_params)
     // Ignore everything except permission bits.
     mode &= 04777;
 
-    auto path = get_syscall_path_argument(params.path);
+    auto path = get_syscall_path_argument(user_path, path_length);
     if (path.is_error())
         return path.error();
 #ifdef DEBUG_IO
@@ -3307,8 +3816,8 @@ void Process::finalize()
         auto description_or_error = VFS::the().open(String::format("perfcore.%d", m_pid), O_CREAT | O_EXCL, 0400, current_directory(), UidAndGid { m_uid, m_gid });
         if (!description_or_error.is_error()) {
             auto& description = description_or_error.value();
-            auto json = m_perf_event_buffer->to_json(m_pid, m_executable ? m_executable->absolute_path() : "");
-            description->write(json.data(), json.size());
+            auto perfcore = m_perf_event_buffer->to_perfcore(m_pid, m_executable ? m_executable->absolute_path() : "");
+            description->write(perfcore.data(), perfcore.size());
         }
     }
 
@@ -3809,7 +4318,7 @@ int Process::sys$setsockopt(const Syscall::SC_setsockopt_params* params)
         return -ENOTSOCK;
     auto& socket = *description->socket();
     REQUIRE_PROMISE_FOR_SOCKET_DOMAIN(socket.domain());
-    return socket.setsockopt(level, option, value, value_size);
+    return socket.setsockopt(*description, level, option, value, value_size);
 }
 
 void Process::disown_all_shared_buffers()
@@ -4252,6 +4761,18 @@ int Process::sys$watch_file(const char* user_path, size_t path_length)
     return fd;
 }
 
+int Process::sys$watch_memory_pressure()
+{
+    REQUIRE_PROMISE(stdio);
+    int fd = alloc_fd();
+    if (fd < 0)
+        return fd;
+
+    m_fds[fd].set(FileDescription::create(*MemoryPressureWatcher::create()));
+    m_fds[fd].description->set_readable(true);
+    return fd;
+}
+
 int Process::sys$halt()
 {
     if (!is_superuser())
@@ -4815,9 +5336,15 @@ int Process::sys$module_unload(const char* user_name, size_t name_length)
     return 0;
 }
 
-int Process::sys$profiling_enable(pid_t pid)
+int Process::sys$profiling_enable(pid_t pid, u32 samples_per_second)
 {
     REQUIRE_NO_PROMISES;
+    if (pid == PROFILE_ALL_PROCESSES) {
+        if (!is_superuser())
+            return -EPERM;
+        Profiling::start(nullptr, samples_per_second);
+        return 0;
+    }
     ScopedSpinLock lock(g_processes_lock);
     auto* process = Process::from_pid(pid);
     if (!process)
@@ -4826,13 +5353,19 @@ int Process::sys$profiling_enable(pid_t pid)
         return -ESRCH;
     if (!is_superuser() && process->uid() != m_uid)
         return -EPERM;
-    Profiling::start(*process);
+    Profiling::start(process, samples_per_second);
     process->set_profiling(true);
     return 0;
 }
 
 int Process::sys$profiling_disable(pid_t pid)
 {
+    if (pid == PROFILE_ALL_PROCESSES) {
+        if (!is_superuser())
+            return -EPERM;
+        Profiling::stop();
+        return 0;
+    }
     ScopedSpinLock lock(g_processes_lock);
     auto* process = Process::from_pid(pid);
     if (!process)
@@ -4844,12 +5377,271 @@ int Process::sys$profiling_disable(pid_t pid)
     return 0;
 }
 
-WaitQueue& Process::futex_queue(i32* userspace_address)
+u32 Process::statistics_identity_hash() const
+{
+    u32 hash = pair_int_hash(m_pid, m_ppid);
+    hash = pair_int_hash(hash, pair_int_hash(m_pgid, m_sid));
+    hash = pair_int_hash(hash, pair_int_hash(m_uid, m_gid));
+    hash = pair_int_hash(hash, pair_int_hash(m_promises, (u32)m_veil_state));
+    hash = pair_int_hash(hash, pair_int_hash(m_icon_id, m_name.hash()));
+    if (m_tty)
+        hash = pair_int_hash(hash, pair_int_hash(ptr_hash(m_tty.ptr()), m_tty->pgid()));
+    return hash;
+}
+
+static Atomic<u32> s_process_statistics_generation;
+
+struct ProcessStatisticsSnapshot {
+    ProcessStatisticsRecord record;
+    ProcessIdentityRecord identity;
+    u32 promises { 0 };
+    VeilState veil_state { VeilState::None };
+};
+
+static void copy_statistics_string(char* destination, size_t size, const StringView& string)
+{
+    size_t length = min(size - 1, string.length());
+    memcpy(destination, string.characters_without_null_termination(), length);
+    destination[length] = '\0';
+}
+
+int Process::sys$get_process_statistics(const Syscall::SC_get_process_statistics_params* user_params)
 {
+    REQUIRE_PROMISE(rpath);
+
+    Syscall::SC_get_process_statistics_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+    if (!validate(params.buffer))
+        return -EFAULT;
+
+    // Take a snapshot of everything while holding the scheduler lock, but leave allocating
+    // and filling in the (possibly large) buffer until after we've let go of it.
+    Vector<ProcessStatisticsSnapshot> snapshots;
+    Vector<ThreadStatisticsRecord> thread_records;
+    u32 generation = 0;
+    {
+        ScopedSpinLock lock(g_scheduler_lock);
+        auto processes = Process::all_processes();
+        snapshots.ensure_capacity(processes.size() + 1);
+
+        auto snapshot_process = [&](Process& process) {
+            // Rather than have every place that changes a process bump its generation,
+            // notice changes to the identity here. It's cheap compared to sending it.
+            u32 identity_hash = process.statistics_identity_hash();
+            if (!process.m_statistics_generation || identity_hash != process.m_statistics_identity_hash) {
+                process.m_statistics_identity_hash = identity_hash;
+                process.m_statistics_generation = ++s_process_statistics_generation;
+            }
+
+            ProcessStatisticsSnapshot snapshot;
+            auto& record = snapshot.record;
+            memset(&record, 0, sizeof(record));
+            record.pid = process.pid();
+            record.nfds = process.number_of_open_file_descriptors();
+            if (params.fields & ProcessStatisticsIdentity && process.m_statistics_generation > params.since_generation)
+                record.fields |= ProcessStatisticsIdentity;
+            if (params.fields & ProcessStatisticsMemory) {
+                record.fields |= ProcessStatisticsMemory;
+                record.amount_virtual = process.amount_virtual();
+                record.amount_resident = process.amount_resident();
+                record.amount_dirty_private = process.amount_dirty_private();
+                record.amount_clean_inode = process.amount_clean_inode();
+                record.amount_shared = process.amount_shared();
+                record.amount_purgeable_volatile = process.amount_purgeable_volatile();
+                record.amount_purgeable_nonvolatile = process.amount_purgeable_nonvolatile();
+            }
+
+            if (record.fields & ProcessStatisticsIdentity) {
+                auto& identity = snapshot.identity;
+                memset(&identity, 0, sizeof(identity));
+                identity.pgid = process.tty() ? process.tty()->pgid() : 0;
+                identity.pgp = process.pgid();
+                identity.sid = process.sid();
+                identity.uid = process.uid();
+                identity.gid = process.gid();
+                identity.ppid = process.ppid();
+                identity.icon_id = process.icon_id();
+                copy_statistics_string(identity.name, sizeof(identity.name), process.name());
+                copy_statistics_string(identity.tty, sizeof(identity.tty), process.tty() ? process.tty()->tty_name() : "notty");
+                snapshot.promises = process.m_promises;
+                snapshot.veil_state = process.veil_state();
+            }
+
+            if (params.fields & ProcessStatisticsThreads) {
+                record.fields |= ProcessStatisticsThreads;
+                process.for_each_thread([&](const Thread& thread) {
+                    ThreadStatisticsRecord thread_record;
+                    memset(&thread_record, 0, sizeof(thread_record));
+                    thread_record.tid = thread.tid();
+                    thread_record.times_scheduled = thread.times_scheduled();
+                    thread_record.ticks = thread.ticks();
+                    thread_record.cpu = thread.cpu();
+                    thread_record.priority = thread.priority();
+                    thread_record.effective_priority = thread.effective_priority();
+                    thread_record.syscall_count = thread.syscall_count();
+                    thread_record.inode_faults = thread.inode_faults();
+                    thread_record.zero_faults = thread.zero_faults();
+                    thread_record.cow_faults = thread.cow_faults();
+                    thread_record.file_read_bytes = thread.file_read_bytes();
+                    thread_record.file_write_bytes = thread.file_write_bytes();
+                    thread_record.unix_socket_read_bytes = thread.unix_socket_read_bytes();
+                    thread_record.unix_socket_write_bytes = thread.unix_socket_write_bytes();
+                    thread_record.ipv4_socket_read_bytes = thread.ipv4_socket_read_bytes();
+                    thread_record.ipv4_socket_write_bytes = thread.ipv4_socket_write_bytes();
+                    copy_statistics_string(thread_record.state, sizeof(thread_record.state), thread.state_string());
+                    copy_statistics_string(thread_record.name, sizeof(thread_record.name), thread.name());
+                    thread_records.append(thread_record);
+                    ++record.thread_count;
+                    return IterationDecision::Continue;
+                });
+            }
+            snapshots.unchecked_append(move(snapshot));
+        };
+        snapshot_process(*Scheduler::colonel());
+        for (auto* process : processes)
+            snapshot_process(*process);
+        generation = s_process_statistics_generation.load();
+    }
+
+    size_t buffer_size = sizeof(ProcessStatisticsHeader) + snapshots.size() * sizeof(ProcessStatisticsRecord) + thread_records.size() * sizeof(ThreadStatisticsRecord);
+    for (auto& snapshot : snapshots) {
+        if (snapshot.record.fields & ProcessStatisticsIdentity)
+            buffer_size += sizeof(ProcessIdentityRecord);
+    }
+    auto maybe_buffer = KBuffer::try_create_with_size(buffer_size, Region::Access::Read | Region::Access::Write, "Process statistics");
+    if (!maybe_buffer.has_value())
+        return -ENOMEM;
+    auto& buffer = maybe_buffer.value();
+
+    u8* out = buffer.data();
+    auto write = [&](const void* data, size_t size) {
+        memcpy(out, data, size);
+        out += size;
+    };
+
+    ProcessStatisticsHeader header;
+    memset(&header, 0, sizeof(header));
+    header.version = PROCESS_STATISTICS_VERSION;
+    header.generation = generation;
+    header.total_size = buffer_size;
+    header.process_count = snapshots.size();
+    write(&header, sizeof(header));
+
+    size_t thread_index = 0;
+    for (auto& snapshot : snapshots) {
+        write(&snapshot.record, sizeof(snapshot.record));
+        if (snapshot.record.fields & ProcessStatisticsIdentity) {
+            auto& identity = snapshot.identity;
+            StringBuilder pledge_builder;
+#define __ENUMERATE_PLEDGE_PROMISE(promise)                 \
+    if (snapshot.promises & (1u << (u32)Pledge::promise)) { \
+        pledge_builder.append(#promise " ");                \
+    }
+            ENUMERATE_PLEDGE_PROMISES
+#undef __ENUMERATE_PLEDGE_PROMISE
+            copy_statistics_string(identity.pledge, sizeof(identity.pledge), pledge_builder.string_view());
+
+            switch (snapshot.veil_state) {
+            case VeilState::None:
+                copy_statistics_string(identity.veil, sizeof(identity.veil), "None");
+                break;
+            case VeilState::Dropped:
+                copy_statistics_string(identity.veil, sizeof(identity.veil), "Dropped");
+                break;
+            case VeilState::Locked:
+                copy_statistics_string(identity.veil, sizeof(identity.veil), "Locked");
+                break;
+            }
+            write(&identity, sizeof(identity));
+        }
+        write(thread_records.data() + thread_index, snapshot.record.thread_count * sizeof(ThreadStatisticsRecord));
+        thread_index += snapshot.record.thread_count;
+    }
+    ASSERT(out == buffer.data() + buffer_size);
+
+    // Like readlink(), copy what fits and return the full size, so callers can retry with a bigger buffer.
+    copy_to_user(params.buffer.data, buffer.data(), min(buffer.size(), params.buffer.size));
+    return buffer.size();
+}
+
+RefPtr<FutexQueue> Process::futex_queue(i32* userspace_address, bool create_if_missing)
+{
+    auto* region = region_containing({ VirtualAddress(userspace_address), sizeof(i32) });
+    if (!region)
+        return nullptr;
+    if (region->is_shared()) {
+        size_t offset_in_vmobject = region->offset_in_vmobject() + ((FlatPtr)userspace_address - region->vaddr().get());
+        if (!create_if_missing)
+            return FutexQueue::find_shared(region->vmobject(), offset_in_vmobject);
+        return FutexQueue::find_or_create_shared(region->vmobject(), offset_in_vmobject);
+    }
+    if (!create_if_missing)
+        return m_futex_queues.get((FlatPtr)userspace_address).value_or(nullptr);
     auto& queue = m_futex_queues.ensure((FlatPtr)userspace_address);
     if (!queue)
-        queue = make<WaitQueue>();
-    return *queue;
+        queue = FutexQueue::create();
+    return queue;
+}
+
+static Optional<i32> futex_wake_op_update(i32* userspace_address, u32 encoded_op)
+{
+    u32 op = (encoded_op >> 28) & 0x7;
+    if (op > FUTEX_OP_XOR)
+        return {};
+    i32 oparg = (i32)(encoded_op << 8) >> 20;
+    if ((encoded_op >> 28) & FUTEX_OP_OPARG_SHIFT) {
+        if (oparg < 0 || oparg > 31)
+            return {};
+        oparg = 1 << oparg;
+    }
+
+    SmapDisabler disabler;
+    auto& atomic = *reinterpret_cast<Atomic<i32>*>(userspace_address);
+    i32 old_value = atomic.load(AK::MemoryOrder::memory_order_relaxed);
+    for (;;) {
+        i32 new_value;
+        switch (op) {
+        case FUTEX_OP_SET:
+            new_value = oparg;
+            break;
+        case FUTEX_OP_ADD:
+            new_value = old_value + oparg;
+            break;
+        case FUTEX_OP_OR:
+            new_value = old_value | oparg;
+            break;
+        case FUTEX_OP_ANDN:
+            new_value = old_value & ~oparg;
+            break;
+        default:
+            new_value = old_value ^ oparg;
+            break;
+        }
+        if (atomic.compare_exchange_strong(old_value, new_value, AK::MemoryOrder::memory_order_acq_rel))
+            return old_value;
+    }
+}
+
+static Optional<bool> futex_wake_op_compare(i32 old_value, u32 encoded_op)
+{
+    i32 cmparg = (i32)(encoded_op << 20) >> 20;
+    switch ((encoded_op >> 24) & 0xf) {
+    case FUTEX_OP_CMP_EQ:
+        return old_value == cmparg;
+    case FUTEX_OP_CMP_NE:
+        return old_value != cmparg;
+    case FUTEX_OP_CMP_LT:
+        return old_value < cmparg;
+    case FUTEX_OP_CMP_LE:
+        return old_value <= cmparg;
+    case FUTEX_OP_CMP_GT:
+        return old_value > cmparg;
+    case FUTEX_OP_CMP_GE:
+        return old_value >= cmparg;
+    default:
+        return {};
+    }
 }
 
 int Process::sys$futex(const Syscall::SC_futex_params* user_params)
@@ -4867,22 +5659,31 @@ int Process::sys$futex(const Syscall::SC_futex_params* user_params)
 
     if (!validate_read_typed(userspace_address))
         return -EFAULT;
+    if ((FlatPtr)userspace_address & 3)
+        return -EINVAL;
 
     if (user_timeout && !validate_read_typed(user_timeout))
         return -EFAULT;
 
     switch (futex_op) {
     case FUTEX_WAIT: {
-        i32 user_value;
-        copy_from_user(&user_value, userspace_address);
-        if (user_value != value)
-            return -EAGAIN;
-
         timespec ts_abstimeout { 0, 0 };
         if (user_timeout && !validate_read_and_copy_typed(&ts_abstimeout, user_timeout))
             return -EFAULT;
 
-        WaitQueue& wait_queue = futex_queue(userspace_address);
+        // Get hold of the queue before looking at the value, so that a waker
+        // that changes the value after we've looked is sure to find it, and
+        // its wake stays pending on the queue until we're sleeping on it.
+        auto queue = futex_queue(userspace_address, true);
+        if (!queue)
+            return -EFAULT;
+
+        i32 user_value;
+        copy_from_user(&user_value, userspace_address);
+        if (user_value != value) {
+            FutexQueue::release(queue);
+            return -EAGAIN;
+        }
         timeval* optional_timeout = nullptr;
         timeval relative_timeout { 0, 0 };
         if (user_timeout) {
@@ -4890,23 +5691,94 @@ int Process::sys$futex(const Syscall::SC_futex_params* user_params)
             optional_timeout = &relative_timeout;
         }
 
+        auto& wait_queue = queue->wait_queue();
+        FutexQueue::start_waiting(*Thread::current(), move(queue));
+
         // FIXME: This is supposed to be interruptible by a signal, but right now WaitQueue cannot be interrupted.
         Thread::BlockResult result = Thread::current()->wait_on(wait_queue, "Futex", optional_timeout);
+
+        // FUTEX_REQUEUE may have moved us to another futex's queue while we slept.
+        queue = FutexQueue::stop_waiting(*Thread::current());
+        FutexQueue::release(queue);
         if (result == Thread::BlockResult::InterruptedByTimeout) {
             return -ETIMEDOUT;
         }
 
         break;
     }
-    case FUTEX_WAKE:
-        if (value == 0)
+    case FUTEX_WAKE: {
+        if (value <= 0)
             return 0;
-        if (value == 1) {
-            futex_queue(userspace_address).wake_one();
-        } else {
-            futex_queue(userspace_address).wake_n(value);
+        // Waiters create the queue before checking the value, so if there's
+        // no queue there's nobody we could possibly need to wake.
+        auto queue = futex_queue(userspace_address, false);
+        if (!queue)
+            return 0;
+        u32 woken_count = queue->wait_queue().wake_n(value);
+        FutexQueue::release(queue);
+        return woken_count;
+    }
+    case FUTEX_REQUEUE:
+    case FUTEX_CMP_REQUEUE: {
+        i32* userspace_address2 = params.userspace_address2;
+        if (!validate_read_typed(userspace_address2))
+            return -EFAULT;
+        if ((FlatPtr)userspace_address2 & 3)
+            return -EINVAL;
+        if (value < 0 || params.val2 < 0)
+            return -EINVAL;
+
+        if (futex_op == FUTEX_CMP_REQUEUE) {
+            i32 user_value;
+            copy_from_user(&user_value, userspace_address);
+            if (user_value != params.val3)
+                return -EAGAIN;
         }
-        break;
+
+        auto queue = futex_queue(userspace_address, false);
+        if (!queue)
+            return 0;
+        u32 woken_count = 0;
+        if (value > 0)
+            woken_count = queue->wait_queue().wake_n(value);
+        u32 requeued_count = 0;
+        if (params.val2 > 0 && !queue->wait_queue().is_empty()) {
+            auto target_queue = futex_queue(userspace_address2, true);
+            if (target_queue)
+                requeued_count = queue->requeue_to(*target_queue, params.val2);
+            FutexQueue::release(target_queue);
+        }
+        FutexQueue::release(queue);
+        return woken_count + requeued_count;
+    }
+    case FUTEX_WAKE_OP: {
+        i32* userspace_address2 = params.userspace_address2;
+        if (!validate_write_typed(userspace_address2))
+            return -EFAULT;
+        if ((FlatPtr)userspace_address2 & 3)
+            return -EINVAL;
+
+        u32 encoded_op = params.val3;
+        auto old_value = futex_wake_op_update(userspace_address2, encoded_op);
+        if (!old_value.has_value())
+            return -ENOSYS;
+        auto should_wake_second = futex_wake_op_compare(old_value.value(), encoded_op);
+        if (!should_wake_second.has_value())
+            return -ENOSYS;
+
+        auto queue = futex_queue(userspace_address, false);
+        auto second_queue = should_wake_second.value() ? futex_queue(userspace_address2, false) : nullptr;
+        u32 woken_count = 0;
+        if (queue && value > 0)
+            woken_count += queue->wait_queue().wake_n(value);
+        if (second_queue && params.val2 > 0)
+            woken_count += second_queue->wait_queue().wake_n(params.val2);
+        FutexQueue::release(queue);
+        FutexQueue::release(second_queue);
+        return woken_count;
+    }
+    default:
+        return -ENOSYS;
     }
 
     return 0;
@@ -5319,4 +6191,163 @@ long Process::sys$sysconf(int name)
         return -EINVAL;
     }
 }
+
+int Process::sys$epoll_create(int flags)
+{
+    REQUIRE_PROMISE(stdio);
+    if (flags & ~EPOLL_CLOEXEC)
+        return -EINVAL;
+
+    int fd = alloc_fd();
+    if (fd < 0)
+        return fd;
+
+    auto description = FileDescription::create(*EventPoll::create());
+    description->set_readable(true);
+    m_fds[fd].set(move(description), (flags & EPOLL_CLOEXEC) ? FD_CLOEXEC : 0);
+    return fd;
+}
+
+int Process::sys$epoll_ctl(const Syscall::SC_epoll_ctl_params* user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_epoll_ctl_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+
+    auto epoll_description = file_description(params.epoll_fd);
+    if (!epoll_description)
+        return -EBADF;
+    if (!epoll_description->file().is_event_poll())
+        return -EINVAL;
+    auto& event_poll = static_cast<EventPoll&>(epoll_description->file());
+
+    auto description = file_description(params.fd);
+    if (!description)
+        return -EBADF;
+
+    epoll_event event;
+    if (params.op != EPOLL_CTL_DEL) {
+        if (!validate_read_and_copy_typed(&event, params.event))
+            return -EFAULT;
+    }
+
+    switch (params.op) {
+    case EPOLL_CTL_ADD:
+        return event_poll.add(params.fd, *description, event);
+    case EPOLL_CTL_MOD:
+        return event_poll.modify(params.fd, event);
+    case EPOLL_CTL_DEL:
+        return event_poll.remove(params.fd);
+    default:
+        return -EINVAL;
+    }
+}
+
+int Process::sys$epoll_wait(const Syscall::SC_epoll_wait_params* user_params)
+{
+    REQUIRE_PROMISE(stdio);
+    Syscall::SC_epoll_wait_params params;
+    if (!validate_read_and_copy_typed(&params, user_params))
+        return -EFAULT;
+
+    if (params.max_events <= 0)
+        return -EINVAL;
+    if (!validate_write_typed(params.events, params.max_events))
+        return -EFAULT;
+
+    timespec timeout;
+    if (params.timeout && !validate_read_and_copy_typed(&timeout, params.timeout))
+        return -EFAULT;
+    u32 sigmask;
+    if (params.sigmask && !validate_read_and_copy_typed(&sigmask, params.sigmask))
+        return -EFAULT;
+
+    auto epoll_description = file_description(params.epoll_fd);
+    if (!epoll_description)
+        return -EBADF;
+    if (!epoll_description->file().is_event_poll())
+        return -EINVAL;
+    NonnullRefPtr<EventPoll> event_poll = static_cast<EventPoll&>(epoll_description->file());
+
+    timespec deadline {};
+    bool has_timeout = false;
+    bool should_block = !params.timeout;
+    if (params.timeout && (timeout.tv_sec || timeout.tv_nsec)) {
+        timespec ts_since_boot;
+        timeval_to_timespec(Scheduler::time_since_boot(), ts_since_boot);
+        timespec_add(ts_since_boot, timeout, deadline);
+        has_timeout = true;
+        should_block = true;
+    }
+
+    auto current_thread = Thread::current();
+    ScopedValueRollback scoped_sigmask(current_thread->m_signal_mask);
+    if (params.sigmask)
+        current_thread->m_signal_mask = sigmask;
+
+    for (;;) {
+        {
+            SmapDisabler disabler;
+            size_t event_count = event_poll->harvest(params.events, params.max_events);
+            if (event_count || !should_block)
+                return event_count;
+        }
+
+        if (has_timeout) {
+            timespec now;
+            timeval_to_timespec(Scheduler::time_since_boot(), now);
+            if (now.tv_sec > deadline.tv_sec || (now.tv_sec == deadline.tv_sec && now.tv_nsec >= deadline.tv_nsec))
+                return 0;
+        }
+
+        if (current_thread->block<Thread::EventPollBlocker>(*event_poll, deadline, has_timeout).was_interrupted())
+            return -EINTR;
+
+        // The process lock was dropped while we were blocked, so the output
+        // buffer may have been unmapped in the meantime.
+        if (!validate_write_typed(params.events, params.max_events))
+            return -EFAULT;
+    }
+}
+
+
+int Process::sys$io_ring_setup(u32 entries, size_t* user_mapping_size)
+{
+    REQUIRE_PROMISE(stdio);
+    if (!validate_write_typed(user_mapping_size))
+        return -EFAULT;
+
+    int fd = alloc_fd();
+    if (fd < 0)
+        return fd;
+
+    auto ring_or_error = IORing::create(entries);
+    if (ring_or_error.is_error())
+        return ring_or_error.error();
+    auto ring = ring_or_error.release_value();
+
+    size_t mapping_size = ring->mapping_size();
+    copy_to_user(user_mapping_size, &mapping_size);
+
+    auto description = FileDescription::create(*ring);
+    description->set_readable(true);
+    m_fds[fd].set(move(description), FD_CLOEXEC);
+    return fd;
+}
+
+int Process::sys$io_ring_enter(int fd, u32 to_submit, u32 min_complete)
+{
+    REQUIRE_PROMISE(stdio);
+    auto description = file_description(fd);
+    if (!description)
+        return -EBADF;
+    if (!description->file().is_io_ring())
+        return -EINVAL;
+    auto result = static_cast<IORing&>(description->file()).enter(*this, to_submit, min_complete);
+    if (result.is_error())
+        return result.error();
+    return result.value();
+}
+
 }
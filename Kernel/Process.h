@@ -154,6 +154,7 @@ public:
     const FixedArray<gid_t>& extra_gids() const { return m_extra_gids; }
     uid_t euid() const { return m_euid; }
     gid_t egid() const { return m_egid; }
+    Thread::AccessCredentials access_credentials() const;
     uid_t uid() const { return m_uid; }
     gid_t gid() const { return m_gid; }
     uid_t suid() const { return m_suid; }
@@ -186,6 +187,7 @@ public:
     int sys$beep();
     int sys$get_process_name(char* buffer, int buffer_size);
     int sys$watch_file(const char* path, size_t path_length);
+    int sys$watch_memory_pressure();
     int sys$dbgputch(u8);
     int sys$dbgputstr(const u8*, int length);
     int sys$dump_backtrace();
@@ -211,6 +213,12 @@ public:
     ssize_t sys$read(int fd, u8*, ssize_t);
     ssize_t sys$write(int fd, const u8*, ssize_t);
     ssize_t sys$writev(int fd, const struct iovec* iov, int iov_count);
+    ssize_t sys$readv(int fd, const struct iovec* iov, int iov_count);
+    ssize_t sys$pread(const Syscall::SC_pread_params*);
+    ssize_t sys$pwrite(const Syscall::SC_pwrite_params*);
+    ssize_t sys$preadv(const Syscall::SC_preadv_params*);
+    ssize_t sys$pwritev(const Syscall::SC_pwritev_params*);
+    ssize_t sys$sendfile(const Syscall::SC_sendfile_params*);
     int sys$fstat(int fd, stat*);
     int sys$stat(const Syscall::SC_stat_params*);
     int sys$lseek(int fd, off_t, int whence);
@@ -245,6 +253,7 @@ public:
     int sys$ptsname_r(int fd, char*, ssize_t);
     pid_t sys$fork(RegisterState&);
     int sys$execve(const Syscall::SC_execve_params*);
+    pid_t sys$posix_spawn(const Syscall::SC_posix_spawn_params*);
     int sys$dup(int oldfd);
     int sys$dup2(int oldfd, int newfd);
     int sys$sigaction(int signum, const sigaction* act, sigaction* old_act);
@@ -314,8 +323,9 @@ public:
     int sys$setkeymap(const Syscall::SC_setkeymap_params*);
     int sys$module_load(const char* path, size_t path_length);
     int sys$module_unload(const char* name, size_t name_length);
-    int sys$profiling_enable(pid_t);
+    int sys$profiling_enable(pid_t, u32 samples_per_second);
     int sys$profiling_disable(pid_t);
+    int sys$get_process_statistics(const Syscall::SC_get_process_statistics_params*);
     int sys$futex(const Syscall::SC_futex_params*);
     int sys$set_thread_boost(int tid, int amount);
     int sys$set_process_boost(pid_t, int amount);
@@ -328,6 +338,11 @@ public:
     int sys$sendfd(int sockfd, int fd);
     int sys$recvfd(int sockfd);
     long sys$sysconf(int name);
+    int sys$epoll_create(int flags);
+    int sys$epoll_ctl(const Syscall::SC_epoll_ctl_params*);
+    int sys$epoll_wait(const Syscall::SC_epoll_wait_params*);
+    int sys$io_ring_setup(u32 entries, size_t* mapping_size);
+    int sys$io_ring_enter(int fd, u32 to_submit, u32 min_complete);
 
     template<bool sockname, typename Params>
     int get_sock_or_peer_name(const Params&);
@@ -416,9 +431,11 @@ public:
     Region* allocate_region_with_vmobject(const Range&, NonnullRefPtr<VMObject>, size_t offset_in_vmobject, const String& name, int prot);
     Region* allocate_region(const Range&, const String& name, int prot = PROT_READ | PROT_WRITE, bool should_commit = true);
     bool deallocate_region(Region& region);
+    Range allocate_range(VirtualAddress, size_t, size_t alignment = PAGE_SIZE);
 
     Region& allocate_split_region(const Region& source_region, const Range&, size_t offset_in_vmobject);
     Vector<Region*, 2> split_region_around_range(const Region& source_region, const Range&);
+    KResult unmap_mmap_range(const Range&);
 
     bool is_being_inspected() const { return m_inspector_count; }
 
@@ -462,19 +479,29 @@ private:
     friend class MemoryManager;
     friend class Scheduler;
     friend class Region;
+    friend class IORing;
 
     Process(Thread*& first_thread, const String& name, uid_t, gid_t, pid_t ppid, RingLevel, RefPtr<Custody> cwd = nullptr, RefPtr<Custody> executable = nullptr, TTY* = nullptr, Process* fork_parent = nullptr);
     static pid_t allocate_pid();
 
-    Range allocate_range(VirtualAddress, size_t, size_t alignment = PAGE_SIZE);
-
     Region& add_region(NonnullOwnPtr<Region>);
 
+    bool copy_string_list_from_user(const Syscall::StringListArgument&, Vector<String>&);
+    KResult apply_spawn_file_action(Process& child, const Syscall::SC_posix_spawn_file_action&);
+
     void kill_threads_except_self();
     void kill_all_threads();
 
     int do_exec(NonnullRefPtr<FileDescription> main_program_description, Vector<String> arguments, Vector<String> environment, RefPtr<FileDescription> interpreter_description, Thread*& new_main_thread, u32& prev_flags);
     ssize_t do_write(FileDescription&, const u8*, int data_size);
+    ssize_t do_read(FileDescription&, u8*, ssize_t size);
+    int do_open(int dirfd, const char* user_path, size_t path_length, int options, u16 mode);
+
+    enum class IovecAccess {
+        Read,
+        Write,
+    };
+    KResult copy_iovecs_from_user(Vector<iovec, 32>&, const iovec*, int iov_count, IovecAccess);
 
     KResultOr<NonnullRefPtr<FileDescription>> find_elf_interpreter_for_executable(const String& path, char (&first_page)[PAGE_SIZE], int nread, size_t file_size);
     Vector<AuxiliaryValue> generate_auxiliary_vector() const;
@@ -576,11 +603,16 @@ private:
     VeilState m_veil_state { VeilState::None };
     Vector<UnveiledPath> m_unveiled_paths;
 
-    WaitQueue& futex_queue(i32*);
-    HashMap<u32, OwnPtr<WaitQueue>> m_futex_queues;
+    RefPtr<FutexQueue> futex_queue(i32*, bool create_if_missing);
+    HashMap<FlatPtr, RefPtr<FutexQueue>> m_futex_queues;
 
     OwnPtr<PerformanceEventBuffer> m_perf_event_buffer;
 
+    // See sys$get_process_statistics().
+    u32 statistics_identity_hash() const;
+    u32 m_statistics_identity_hash { 0 };
+    u32 m_statistics_generation { 0 };
+
     u32 m_inspector_count { 0 };
 
     // This member is used in the implementation of ptrace's PT_TRACEME flag.
@@ -698,19 +730,30 @@ inline void Process::for_each_in_pgrp(pid_t pgid, Callback callback)
     }
 }
 
+inline Thread::AccessCredentials Process::access_credentials() const
+{
+    auto* current_thread = Thread::current();
+    if (current_thread && &current_thread->process() == this && current_thread->access_credentials_override().has_value())
+        return current_thread->access_credentials_override().value();
+    return { m_euid, m_egid };
+}
+
 inline bool InodeMetadata::may_read(const Process& process) const
 {
-    return may_read(process.euid(), process.egid(), process.extra_gids());
+    auto credentials = process.access_credentials();
+    return may_read(credentials.euid, credentials.egid, process.extra_gids());
 }
 
 inline bool InodeMetadata::may_write(const Process& process) const
 {
-    return may_write(process.euid(), process.egid(), process.extra_gids());
+    auto credentials = process.access_credentials();
+    return may_write(credentials.euid, credentials.egid, process.extra_gids());
 }
 
 inline bool InodeMetadata::may_execute(const Process& process) const
 {
-    return may_execute(process.euid(), process.egid(), process.extra_gids());
+    auto credentials = process.access_credentials();
+    return may_execute(credentials.euid, credentials.egid, process.extra_gids());
 }
 
 inline int Thread::pid() const
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/HashFunctions.h>
+#include <Kernel/ProfileStackTable.h>
+#include <Kernel/StdLib.h>
+
+namespace Kernel {
+
+Optional<u32> ProfileStackTable::find(pid_t pid, const u32* frames, u32 frame_count, u32 hash) const
+{
+    auto candidates = m_ids_by_hash.get(hash);
+    if (!candidates.has_value())
+        return {};
+    for (u32 id : candidates.value()) {
+        auto* entry = &m_storage[m_offsets[id]];
+        if ((pid_t)entry[0] != pid || entry[1] != frame_count)
+            continue;
+        if (!memcmp(&entry[2], frames, frame_count * sizeof(u32)))
+            return id;
+    }
+    return {};
+}
+
+u32 ProfileStackTable::add(pid_t pid, const u32* frames, u32 frame_count, u32 hash)
+{
+    u32 id = m_next_id++;
+    // Beyond this, stacks are still written but no longer deduplicated.
+    if (m_storage.size() + frame_count + 2 > max_storage)
+        return id;
+    m_offsets.resize(id + 1);
+    m_offsets[id] = m_storage.size();
+    m_storage.append(pid);
+    m_storage.append(frame_count);
+    m_storage.append(frames, frame_count);
+    auto candidates = m_ids_by_hash.get(hash).value_or({});
+    candidates.append(id);
+    m_ids_by_hash.set(hash, move(candidates));
+    return id;
+}
+
+u32 ProfileStackTable::hash(pid_t pid, const u32* frames, u32 frame_count)
+{
+    u32 hash = int_hash(pid);
+    for (size_t i = 0; i < frame_count; ++i)
+        hash = pair_int_hash(hash, frames[i]);
+    return hash;
+}
+
+}
@@ -24,83 +24,313 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/Demangle.h>
-#include <AK/StringBuilder.h>
+#include <AK/HashMap.h>
+#include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/FileSystem/Custody.h>
 #include <Kernel/KBuffer.h>
-#include <Kernel/KSyms.h>
+#include <Kernel/KBufferBuilder.h>
 #include <Kernel/Process.h>
+#include <Kernel/ProfileStackTable.h>
 #include <Kernel/Profiling.h>
-#include <LibELF/Loader.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/Time/TimeManagement.h>
+#include <Kernel/VM/MemoryManager.h>
 
 namespace Kernel {
 
 namespace Profiling {
 
-static KBufferImpl* s_profiling_buffer;
-static size_t s_slot_count;
-static size_t s_next_slot_index;
-static u32 s_pid;
+// Each processor only ever writes to its own ring, from its timer interrupt,
+// so writers need no locking. Readers detect slots that were overwritten
+// while they were copying them, see for_each_sample().
+struct SampleRing {
+    KBufferImpl* buffer { nullptr };
+    size_t capacity { 0 };
+    Atomic<u32> written { 0 };
+    u32 ticks_until_next_sample { 0 };
 
-String& executable_path()
+    Sample& slot(u32 index) { return ((Sample*)buffer->data())[index % capacity]; }
+};
+
+static constexpr size_t ring_buffer_size = 4 * MB;
+
+static SampleRing* s_rings;
+static u32 s_ring_count;
+static Atomic<bool> s_active;
+static bool s_all_processes;
+static pid_t s_pid;
+static u32 s_samples_per_second = default_samples_per_second;
+static u32 s_ticks_per_sample = 1;
+
+static SpinLock<u8> s_executables_lock;
+
+static HashMap<pid_t, String>& executables()
 {
-    static String* path;
-    if (!path)
-        path = new String;
-    return *path;
+    static HashMap<pid_t, String>* map;
+    if (!map)
+        map = new HashMap<pid_t, String>;
+    return *map;
 }
 
-u32 pid()
+static void set_executable(Process& process)
 {
-    return s_pid;
+    String path;
+    if (process.executable())
+        path = process.executable()->absolute_path();
+    ScopedSpinLock lock(s_executables_lock);
+    executables().set(process.pid(), move(path));
 }
 
-void start(Process& process)
+pid_t pid()
 {
-    if (process.executable())
-        executable_path() = process.executable()->absolute_path().impl();
-    else
-        executable_path() = {};
-    s_pid = process.pid();
-
-    if (!s_profiling_buffer) {
-        s_profiling_buffer = RefPtr<KBufferImpl>(KBuffer::create_with_size(8 * MB).impl()).leak_ref();
-        s_profiling_buffer->region().commit();
-        s_slot_count = s_profiling_buffer->size() / sizeof(Sample);
-    }
+    return s_all_processes ? PROFILE_ALL_PROCESSES : s_pid;
+}
 
-    s_next_slot_index = 0;
+u32 samples_per_second()
+{
+    return s_samples_per_second;
 }
 
-static Sample& sample_slot(size_t index)
+bool is_profiling_all_processes()
 {
-    return ((Sample*)s_profiling_buffer->data())[index];
+    return s_active.load(AK::MemoryOrder::memory_order_relaxed) && s_all_processes;
 }
 
-Sample& next_sample_slot()
+void start(Process* process, u32 samples_per_second)
 {
-    auto& slot = sample_slot(s_next_slot_index++);
-    if (s_next_slot_index >= s_slot_count)
-        s_next_slot_index = 0;
-    return slot;
+    s_active.store(false, AK::MemoryOrder::memory_order_release);
+
+    if (!s_rings) {
+        s_ring_count = Processor::count();
+        s_rings = new SampleRing[s_ring_count];
+        for (u32 cpu = 0; cpu < s_ring_count; ++cpu) {
+            auto& ring = s_rings[cpu];
+            ring.buffer = RefPtr<KBufferImpl>(KBuffer::create_with_size(ring_buffer_size).impl()).leak_ref();
+            ring.buffer->region().commit();
+            ring.capacity = ring.buffer->size() / sizeof(Sample);
+        }
+    }
+
+    u32 ticks_per_second = TimeManagement::the().ticks_per_second();
+    if (!samples_per_second)
+        samples_per_second = default_samples_per_second;
+    s_samples_per_second = min(samples_per_second, ticks_per_second);
+    s_ticks_per_sample = ticks_per_second / s_samples_per_second;
+
+    for (u32 cpu = 0; cpu < s_ring_count; ++cpu) {
+        s_rings[cpu].written.store(0, AK::MemoryOrder::memory_order_relaxed);
+        s_rings[cpu].ticks_until_next_sample = 0;
+    }
+
+    {
+        ScopedSpinLock lock(s_executables_lock);
+        executables().clear();
+    }
+
+    s_all_processes = !process;
+    s_pid = process ? process->pid() : PROFILE_ALL_PROCESSES;
+    if (process) {
+        set_executable(*process);
+    } else {
+        ScopedSpinLock lock(g_processes_lock);
+        Process::for_each([&](Process& process) {
+            set_executable(process);
+            return IterationDecision::Continue;
+        });
+    }
+
+    s_active.store(true, AK::MemoryOrder::memory_order_release);
 }
 
 void stop()
 {
+    if (s_all_processes)
+        s_active.store(false, AK::MemoryOrder::memory_order_release);
 }
 
-void did_exec(const String& new_executable_path)
+void did_exec(Process& process, const String& new_executable_path)
 {
-    executable_path() = new_executable_path;
-    s_next_slot_index = 0;
+    if (!s_all_processes) {
+        // Profiling a single process starts over when it execs, as done by profile -c.
+        for (u32 cpu = 0; cpu < s_ring_count; ++cpu)
+            s_rings[cpu].written.store(0, AK::MemoryOrder::memory_order_relaxed);
+    }
+    ScopedSpinLock lock(s_executables_lock);
+    executables().set(process.pid(), new_executable_path);
 }
 
-void for_each_sample(Function<void(Sample&)> callback)
+static bool should_sample(Thread& thread)
 {
-    for (size_t i = 0; i < s_next_slot_index; ++i) {
-        auto& sample = sample_slot(i);
-        callback(sample);
+    if (!s_active.load(AK::MemoryOrder::memory_order_acquire))
+        return false;
+    if (s_all_processes)
+        return &thread != Processor::current().idle_thread();
+    return thread.process().is_profiling();
+}
+
+void timer_tick(Thread& thread, const RegisterState& regs)
+{
+    if (!should_sample(thread))
+        return;
+
+    u32 cpu = Processor::current().id();
+    if (cpu >= s_ring_count)
+        return;
+    auto& ring = s_rings[cpu];
+    if (ring.ticks_until_next_sample) {
+        --ring.ticks_until_next_sample;
+        return;
     }
+    ring.ticks_until_next_sample = s_ticks_per_sample - 1;
+
+    u32 index = ring.written.load(AK::MemoryOrder::memory_order_relaxed);
+    auto& sample = ring.slot(index);
+    sample.pid = thread.process().pid();
+    sample.tid = thread.tid();
+    sample.cpu = cpu;
+    sample.timestamp = g_uptime;
+
+    // This is Thread::raw_backtrace(), minus the allocation, which we can't
+    // afford in an interrupt handler on every processor. We are already in
+    // the paging scope of the interrupted thread's process.
+    SmapDisabler disabler;
+    auto& process = thread.process();
+    size_t frame_count = 0;
+    sample.frames[frame_count++] = regs.eip;
+    for (FlatPtr* stack_ptr = (FlatPtr*)regs.ebp; frame_count < max_stack_frame_count && process.validate_read_from_kernel(VirtualAddress(stack_ptr), sizeof(FlatPtr) * 2) && MM.can_read_without_faulting(process, VirtualAddress(stack_ptr), sizeof(FlatPtr) * 2); stack_ptr = (FlatPtr*)*stack_ptr)
+        sample.frames[frame_count++] = stack_ptr[1];
+    sample.frame_count = frame_count;
+
+    ring.written.store(index + 1, AK::MemoryOrder::memory_order_release);
+}
+
+void for_each_sample(Function<void(const Sample&)> callback)
+{
+    if (!s_rings)
+        return;
+
+    struct Cursor {
+        u32 next;
+        u32 end;
+    };
+    Vector<Cursor> cursors;
+    for (u32 cpu = 0; cpu < s_ring_count; ++cpu) {
+        auto& ring = s_rings[cpu];
+        u32 end = ring.written.load(AK::MemoryOrder::memory_order_acquire);
+        u32 begin = end > ring.capacity ? end - ring.capacity : 0;
+        cursors.append({ begin, end });
+    }
+
+    // Merge the rings by timestamp. There are only a handful of them.
+    auto sample = make<Sample>();
+    for (;;) {
+        Optional<u32> oldest_cpu;
+        u64 oldest_timestamp = 0;
+        for (u32 cpu = 0; cpu < s_ring_count; ++cpu) {
+            auto& cursor = cursors[cpu];
+            if (cursor.next == cursor.end)
+                continue;
+            u64 timestamp = s_rings[cpu].slot(cursor.next).timestamp;
+            if (!oldest_cpu.has_value() || timestamp < oldest_timestamp) {
+                oldest_cpu = cpu;
+                oldest_timestamp = timestamp;
+            }
+        }
+        if (!oldest_cpu.has_value())
+            break;
+
+        auto& ring = s_rings[oldest_cpu.value()];
+        u32 index = cursors[oldest_cpu.value()].next++;
+        memcpy(sample.ptr(), &ring.slot(index), sizeof(Sample));
+
+        // The writer may have lapped us while we were copying.
+        if (ring.written.load(AK::MemoryOrder::memory_order_acquire) - index >= ring.capacity)
+            continue;
+        if (sample->frame_count > max_stack_frame_count)
+            continue;
+        callback(*sample);
+    }
+}
+
+size_t max_perfcore_size()
+{
+    size_t sample_count = 0;
+    for (u32 cpu = 0; cpu < s_ring_count; ++cpu)
+        sample_count += s_rings[cpu].capacity;
+
+    size_t executables_size = 0;
+    {
+        ScopedSpinLock lock(s_executables_lock);
+        for (auto& it : executables())
+            executables_size += 2 + sizeof(ProfileStringRecord) + sizeof(ProfileProcessRecord) + it.value.length();
+    }
+
+    // Worst case, every sample has a stack of its own.
+    size_t max_sample_size = 2 + sizeof(ProfileSampleRecord) + sizeof(ProfileStackRecord) + max_stack_frame_count * sizeof(u32);
+    return sizeof(ProfileHeader) + executables_size + sample_count * max_sample_size;
+}
+
+// Assigns ids to distinct (pid, stack) pairs. The stacks themselves are kept
+// in one flat array of [pid, frame count, frames...] entries.
+void write_perfcore(KBufferBuilder& builder, bool mask_kernel_addresses)
+{
+    auto append_record = [&](ProfileRecordType type, const void* record, size_t size) {
+        builder.append((char)type);
+        builder.append((const char*)record, size);
+    };
+
+    ProfileHeader header;
+    header.magic = PROFILE_MAGIC;
+    header.version = PROFILE_VERSION;
+    header.pid = pid();
+    header.samples_per_second = s_samples_per_second;
+    builder.append((const char*)&header, sizeof(header));
+
+    HashMap<pid_t, String> executables_copy;
+    {
+        ScopedSpinLock lock(s_executables_lock);
+        executables_copy = executables();
+    }
+
+    HashMap<String, u32> string_ids;
+    for (auto& it : executables_copy) {
+        auto string_id = string_ids.get(it.value);
+        if (!string_id.has_value()) {
+            string_id = string_ids.size();
+            string_ids.set(it.value, string_id.value());
+            ProfileStringRecord string { (u32)it.value.length() };
+            append_record(ProfileRecordType::String, &string, sizeof(string));
+            builder.append(it.value);
+        }
+        ProfileProcessRecord process { it.key, string_id.value() };
+        append_record(ProfileRecordType::Process, &process, sizeof(process));
+    }
+
+    ProfileStackTable stacks;
+    for_each_sample([&](const Sample& original_sample) {
+        const Sample* sample = &original_sample;
+        Sample masked_sample;
+        if (mask_kernel_addresses) {
+            memcpy(&masked_sample, sample, sizeof(Sample));
+            for (size_t i = 0; i < masked_sample.frame_count; ++i) {
+                if (!is_user_address(VirtualAddress(masked_sample.frames[i])))
+                    masked_sample.frames[i] = 0xdeadc0de;
+            }
+            sample = &masked_sample;
+        }
+
+        u32 hash = ProfileStackTable::hash(sample->pid, sample->frames, sample->frame_count);
+        auto stack_id = stacks.find(sample->pid, sample->frames, sample->frame_count, hash);
+        if (!stack_id.has_value()) {
+            stack_id = stacks.add(sample->pid, sample->frames, sample->frame_count, hash);
+            ProfileStackRecord stack { sample->pid, sample->frame_count };
+            append_record(ProfileRecordType::Stack, &stack, sizeof(stack));
+            builder.append((const char*)sample->frames, sample->frame_count * sizeof(u32));
+        }
+
+        ProfileSampleRecord record { sample->tid, sample->cpu, stack_id.value(), sample->timestamp };
+        append_record(ProfileRecordType::Sample, &record, sizeof(record));
+    });
 }
 
 }
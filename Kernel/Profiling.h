@@ -29,30 +29,51 @@
 #include <AK/Function.h>
 #include <AK/String.h>
 #include <AK/Types.h>
+#include <Kernel/API/Profiling.h>
+#include <Kernel/UnixTypes.h>
 
 namespace Kernel {
 
+class KBufferBuilder;
 class Process;
+class Thread;
+struct RegisterState;
 
 namespace Profiling {
 
 constexpr size_t max_stack_frame_count = 50;
+constexpr u32 default_samples_per_second = 1000;
 
 struct Sample {
     i32 pid;
     i32 tid;
+    u32 cpu;
+    u32 frame_count;
     u64 timestamp;
     u32 frames[max_stack_frame_count];
 };
 
-extern u32 pid();
-extern String& executable_path();
+// The profiled pid, or PROFILE_ALL_PROCESSES.
+extern pid_t pid();
+extern u32 samples_per_second();
 
-Sample& next_sample_slot();
-void start(Process&);
+// Starts a new profile of one process, or of every thread in the system
+// (including kernel threads) if process is null. Samples are taken from the
+// timer interrupt of every processor, into a ring buffer per processor.
+void start(Process*, u32 samples_per_second);
 void stop();
-void did_exec(const String& new_executable_path);
-void for_each_sample(Function<void(Sample&)>);
+bool is_profiling_all_processes();
+void did_exec(Process&, const String& new_executable_path);
+
+// Called from every processor's timer interrupt.
+void timer_tick(Thread&, const RegisterState&);
+
+// Visits the samples of all processors in timestamp order.
+void for_each_sample(Function<void(const Sample&)>);
+
+// Writes the profile in the format described in Kernel/API/Profiling.h.
+size_t max_perfcore_size();
+void write_perfcore(KBufferBuilder&, bool mask_kernel_addresses);
 
 }
 
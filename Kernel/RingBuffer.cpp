@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/HashMap.h>
+#include <AK/StdLibExtras.h>
+#include <Kernel/Process.h>
+#include <Kernel/RingBuffer.h>
+
+namespace Kernel {
+
+static Lock& growth_charges_lock()
+{
+    static Lock* lock;
+    if (!lock)
+        lock = new Lock("RingBufferGrowth");
+    return *lock;
+}
+
+static HashMap<uid_t, size_t>& growth_charges()
+{
+    static HashMap<uid_t, size_t>* map;
+    if (!map)
+        map = new HashMap<uid_t, size_t>;
+    return *map;
+}
+
+static bool try_charge_growth(uid_t uid, size_t bytes)
+{
+    LOCKER(growth_charges_lock());
+    auto& charged = growth_charges().ensure(uid);
+    if (charged + bytes > RingBuffer::max_unprivileged_growth_per_user)
+        return false;
+    charged += bytes;
+    return true;
+}
+
+static void uncharge_growth(uid_t uid, size_t bytes)
+{
+    if (!bytes)
+        return;
+    LOCKER(growth_charges_lock());
+    auto it = growth_charges().find(uid);
+    ASSERT(it != growth_charges().end() && it->value >= bytes);
+    it->value -= bytes;
+    if (!it->value)
+        growth_charges().remove(it);
+}
+
+size_t RingBuffer::round_up_capacity(size_t capacity)
+{
+    capacity = min(max(capacity, min_capacity), max_capacity);
+    size_t rounded = min_capacity;
+    while (rounded < capacity)
+        rounded *= 2;
+    return rounded;
+}
+
+RingBuffer::RingBuffer(size_t capacity)
+    : m_storage(KBuffer::create_with_size(round_up_capacity(capacity), Region::Access::Read | Region::Access::Write, "RingBuffer"))
+    , m_capacity(round_up_capacity(capacity))
+{
+}
+
+RingBuffer::~RingBuffer()
+{
+    uncharge_growth(m_charged_uid, m_charged_bytes);
+}
+
+ssize_t RingBuffer::write(const u8* data, ssize_t size)
+{
+    if (!size)
+        return 0;
+    ASSERT(size > 0);
+    LOCKER(m_write_lock);
+    size_t write_offset = m_write_offset.load(AK::MemoryOrder::memory_order_relaxed);
+    size_t read_offset = m_read_offset.load(AK::MemoryOrder::memory_order_acquire);
+    size_t bytes_to_write = min(static_cast<size_t>(size), m_capacity - (write_offset - read_offset));
+    if (!bytes_to_write)
+        return 0;
+
+    size_t index = write_offset & (m_capacity - 1);
+    size_t first_chunk = min(bytes_to_write, m_capacity - index);
+    memcpy(m_storage.data() + index, data, first_chunk);
+    memcpy(m_storage.data(), data + first_chunk, bytes_to_write - first_chunk);
+
+    m_write_offset.store(write_offset + bytes_to_write, AK::MemoryOrder::memory_order_release);
+    return bytes_to_write;
+}
+
+ssize_t RingBuffer::read(u8* data, ssize_t size)
+{
+    if (!size)
+        return 0;
+    ASSERT(size > 0);
+    LOCKER(m_read_lock);
+    size_t read_offset = m_read_offset.load(AK::MemoryOrder::memory_order_relaxed);
+    size_t write_offset = m_write_offset.load(AK::MemoryOrder::memory_order_acquire);
+    size_t bytes_to_read = min(static_cast<size_t>(size), write_offset - read_offset);
+    if (!bytes_to_read)
+        return 0;
+
+    size_t index = read_offset & (m_capacity - 1);
+    size_t first_chunk = min(bytes_to_read, m_capacity - index);
+    memcpy(data, m_storage.data() + index, first_chunk);
+    memcpy(data + first_chunk, m_storage.data(), bytes_to_read - first_chunk);
+
+    m_read_offset.store(read_offset + bytes_to_read, AK::MemoryOrder::memory_order_release);
+    return bytes_to_read;
+}
+
+KResult RingBuffer::set_capacity(size_t capacity)
+{
+    capacity = round_up_capacity(capacity);
+    Locker read_locker(m_read_lock);
+    Locker write_locker(m_write_lock);
+    if (capacity == m_capacity)
+        return KSuccess;
+
+    size_t read_offset = m_read_offset.load(AK::MemoryOrder::memory_order_relaxed);
+    size_t used = m_write_offset.load(AK::MemoryOrder::memory_order_relaxed) - read_offset;
+    if (used > capacity)
+        return KResult(-EBUSY);
+
+    // Charge the caller for any growth before allocating, and only give back
+    // what was charged for the old buffer once the new one is in place.
+    auto& process = *Process::current();
+    uid_t uid = process.euid();
+    size_t growth = capacity > default_capacity && !process.is_superuser() ? capacity - default_capacity : 0;
+    size_t already_charged = m_charged_uid == uid ? m_charged_bytes : 0;
+    size_t extra_charge = growth > already_charged ? growth - already_charged : 0;
+    if (extra_charge && !try_charge_growth(uid, extra_charge))
+        return KResult(-EPERM);
+
+    auto maybe_storage = KBuffer::try_create_with_size(capacity, Region::Access::Read | Region::Access::Write, "RingBuffer");
+    if (!maybe_storage.has_value()) {
+        uncharge_growth(uid, extra_charge);
+        return KResult(-ENOMEM);
+    }
+    auto& storage = maybe_storage.value();
+
+    if (already_charged) {
+        uncharge_growth(uid, already_charged + extra_charge - growth);
+    } else {
+        uncharge_growth(m_charged_uid, m_charged_bytes);
+    }
+    m_charged_uid = uid;
+    m_charged_bytes = growth;
+
+    size_t index = read_offset & (m_capacity - 1);
+    size_t first_chunk = min(used, m_capacity - index);
+    memcpy(storage.data(), m_storage.data() + index, first_chunk);
+    memcpy(storage.data() + first_chunk, m_storage.data(), used - first_chunk);
+
+    m_storage = move(storage);
+    m_capacity = capacity;
+    m_read_offset.store(0, AK::MemoryOrder::memory_order_relaxed);
+    m_write_offset.store(used, AK::MemoryOrder::memory_order_release);
+    return KSuccess;
+}
+
+}
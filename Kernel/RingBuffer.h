@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Types.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/KResult.h>
+#include <Kernel/Lock.h>
+#include <Kernel/UnixTypes.h>
+
+namespace Kernel {
+
+// A byte ring buffer for pipes and local sockets.
+//
+// The read and write offsets only ever grow, and each is only advanced by its
+// own side, so a reader and a writer never wait for each other. Concurrent
+// writers (or readers) on the same buffer are still serialized among
+// themselves, since a pipe may have several of them.
+class RingBuffer {
+public:
+    static constexpr size_t default_capacity = 64 * KB;
+    static constexpr size_t min_capacity = PAGE_SIZE;
+    static constexpr size_t max_capacity = 1 * MB;
+
+    // How far all the buffers enlarged by one unprivileged user may grow past
+    // default_capacity in total, like Linux's pipe-user-pages-soft.
+    static constexpr size_t max_unprivileged_growth_per_user = 4 * MB;
+
+    explicit RingBuffer(size_t capacity = default_capacity);
+    ~RingBuffer();
+
+    ssize_t write(const u8*, ssize_t);
+    ssize_t read(u8*, ssize_t);
+
+    bool is_empty() const { return used_bytes() == 0; }
+    size_t space_for_writing() const { return m_capacity - used_bytes(); }
+    size_t capacity() const { return m_capacity; }
+
+    // Rounded up to a power of two. Fails with EBUSY if the data currently in
+    // the buffer wouldn't fit, ENOMEM if there's no memory for the new buffer,
+    // and EPERM if an unprivileged caller would grow past their allowance.
+    KResult set_capacity(size_t);
+
+private:
+    size_t used_bytes() const { return m_write_offset.load(AK::MemoryOrder::memory_order_acquire) - m_read_offset.load(AK::MemoryOrder::memory_order_acquire); }
+    static size_t round_up_capacity(size_t);
+
+    KBuffer m_storage;
+    size_t m_capacity { 0 };
+    Atomic<size_t> m_read_offset { 0 };
+    Atomic<size_t> m_write_offset { 0 };
+
+    // Growth past default_capacity counted against an unprivileged user's allowance.
+    uid_t m_charged_uid { 0 };
+    size_t m_charged_bytes { 0 };
+    Lock m_read_lock { "RingBuffer read" };
+    Lock m_write_lock { "RingBuffer write" };
+};
+
+}
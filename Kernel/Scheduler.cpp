@@ -26,6 +26,7 @@
 
 #include <AK/QuickSort.h>
 #include <AK/TemporaryChange.h>
+#include <Kernel/FileSystem/EventPoll.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/Net/Socket.h>
 #include <Kernel/Process.h>
@@ -234,6 +235,24 @@ bool Thread::SelectBlocker::should_unblock(Thread& thread, time_t now_sec, long
     return false;
 }
 
+Thread::EventPollBlocker::EventPollBlocker(const EventPoll& event_poll, const timespec& deadline, bool has_timeout)
+    : m_event_poll(event_poll)
+    , m_deadline(deadline)
+    , m_has_timeout(has_timeout)
+{
+}
+
+bool Thread::EventPollBlocker::should_unblock(Thread&, time_t now_sec, long now_usec)
+{
+    if (m_has_timeout) {
+        if (now_sec > m_deadline.tv_sec || (now_sec == m_deadline.tv_sec && now_usec * 1000 >= m_deadline.tv_nsec))
+            return true;
+    }
+    // Files push their entries onto the ready list, so this doesn't depend on
+    // how many file descriptors are being watched.
+    return m_event_poll->has_ready_entries();
+}
+
 Thread::WaitBlocker::WaitBlocker(int wait_options, pid_t& waitee_pid)
     : m_wait_options(wait_options)
     , m_waitee_pid(waitee_pid)
@@ -610,27 +629,19 @@ void Scheduler::timer_tick(const RegisterState& regs)
 {
     ASSERT_INTERRUPTS_DISABLED();
     ASSERT(Processor::current().in_irq());
-if (Processor::current().id() > 0) return;
     auto current_thread = Processor::current().current_thread();
     if (!current_thread)
         return;
 
+    // Every processor samples the thread it interrupted.
+    Profiling::timer_tick(*current_thread, regs);
+
+if (Processor::current().id() > 0) return;
+
     ++g_uptime;
 
     g_timeofday = TimeManagement::now_as_timeval();
 
-    if (current_thread->process().is_profiling()) {
-        SmapDisabler disabler;
-        auto backtrace = current_thread->raw_backtrace(regs.ebp, regs.eip);
-        auto& sample = Profiling::next_sample_slot();
-        sample.pid = current_thread->process().pid();
-        sample.tid = current_thread->tid();
-        sample.timestamp = g_uptime;
-        for (size_t i = 0; i < min(backtrace.size(), Profiling::max_stack_frame_count); ++i) {
-            sample.frames[i] = backtrace[i];
-        }
-    }
-
     TimerQueue::the().fire();
 
     if (current_thread->tick())
@@ -25,6 +25,7 @@
  */
 
 #include <AK/Assertions.h>
+#include <AK/LogStream.h>
 #include <AK/String.h>
 #include <AK/Types.h>
 #include <Kernel/Arch/i386/CPU.h>
@@ -57,31 +58,55 @@ void copy_from_user(void* dest_ptr, const void* src_ptr, size_t n)
     memcpy(dest_ptr, src_ptr, n);
 }
 
+// Below this size, the startup cost of the fast string microcode outweighs its benefits.
+static constexpr size_t erms_threshold = 128;
+
 void* memcpy(void* dest_ptr, const void* src_ptr, size_t n)
 {
     size_t dest = (size_t)dest_ptr;
     size_t src = (size_t)src_ptr;
-    // FIXME: Support starting at an unaligned address.
-    if (!(dest & 0x3) && !(src & 0x3) && n >= 12) {
+
+    // With ERMS, "rep movsb" handles misaligned heads and tails internally
+    // and moves full cache lines at a time, so there's nothing to gain from doing it by hand.
+    if (n >= erms_threshold && Kernel::g_cpu_supports_erms) {
+        asm volatile(
+            "rep movsb\n"
+            : "+S"(src), "+D"(dest), "+c"(n)
+            :
+            : "memory");
+        return dest_ptr;
+    }
+
+    if (n >= 12) {
+        // Align the destination; misaligned stores are more expensive than misaligned loads.
+        size_t head = (0 - dest) & 0x3;
+        n -= head;
+        asm volatile(
+            "rep movsb\n"
+            : "+S"(src), "+D"(dest), "+c"(head)
+            :
+            : "memory");
         size_t size_ts = n / sizeof(size_t);
         asm volatile(
             "rep movsl\n"
-            : "=S"(src), "=D"(dest)
-            : "S"(src), "D"(dest), "c"(size_ts)
+            : "+S"(src), "+D"(dest), "+c"(size_ts)
+            :
             : "memory");
-        n -= size_ts * sizeof(size_t);
+        n &= sizeof(size_t) - 1;
         if (n == 0)
             return dest_ptr;
     }
     asm volatile(
-        "rep movsb\n" ::"S"(src), "D"(dest), "c"(n)
+        "rep movsb\n"
+        : "+S"(src), "+D"(dest), "+c"(n)
+        :
         : "memory");
     return dest_ptr;
 }
 
 void* memmove(void* dest, const void* src, size_t n)
 {
-    if (dest < src)
+    if (dest < src || (const u8*)dest >= (const u8*)src + n)
         return memcpy(dest, src, n);
 
     u8* pd = (u8*)dest;
@@ -120,25 +145,41 @@ void memset_user(void* dest_ptr, int c, size_t n)
 void* memset(void* dest_ptr, int c, size_t n)
 {
     size_t dest = (size_t)dest_ptr;
-    // FIXME: Support starting at an unaligned address.
-    if (!(dest & 0x3) && n >= 12) {
+
+    if (n >= erms_threshold && Kernel::g_cpu_supports_erms) {
+        asm volatile(
+            "rep stosb\n"
+            : "+D"(dest), "+c"(n)
+            : "a"(c)
+            : "memory");
+        return dest_ptr;
+    }
+
+    if (n >= 12) {
+        size_t head = (0 - dest) & 0x3;
+        n -= head;
+        asm volatile(
+            "rep stosb\n"
+            : "+D"(dest), "+c"(head)
+            : "a"(c)
+            : "memory");
         size_t size_ts = n / sizeof(size_t);
         size_t expanded_c = (u8)c;
         expanded_c |= expanded_c << 8;
         expanded_c |= expanded_c << 16;
         asm volatile(
             "rep stosl\n"
-            : "=D"(dest)
-            : "D"(dest), "c"(size_ts), "a"(expanded_c)
+            : "+D"(dest), "+c"(size_ts)
+            : "a"(expanded_c)
             : "memory");
-        n -= size_ts * sizeof(size_t);
+        n &= sizeof(size_t) - 1;
         if (n == 0)
             return dest_ptr;
     }
     asm volatile(
         "rep stosb\n"
-        : "=D"(dest), "=c"(n)
-        : "0"(dest), "1"(n), "a"(c)
+        : "+D"(dest), "+c"(n)
+        : "a"(c)
         : "memory");
     return dest_ptr;
 }
@@ -254,3 +295,124 @@ void free(void* p)
     ASSERT_NOT_REACHED();
 }
 }
+
+namespace Kernel {
+
+static constexpr size_t self_test_guard_size = 16;
+static constexpr size_t self_test_buffer_size = 64 * KB + 2 * self_test_guard_size;
+
+static bool verify_guards(const u8* buffer, size_t offset, size_t n)
+{
+    for (size_t i = 0; i < self_test_guard_size + offset; ++i) {
+        if (buffer[i] != 0xa5)
+            return false;
+    }
+    for (size_t i = self_test_guard_size + offset + n; i < self_test_buffer_size; ++i) {
+        if (buffer[i] != 0xa5)
+            return false;
+    }
+    return true;
+}
+
+static bool self_test_memcpy(u8* src, u8* dest, size_t n, size_t src_offset, size_t dest_offset)
+{
+    for (size_t i = 0; i < self_test_buffer_size; ++i) {
+        src[i] = (u8)(i * 7 + 3);
+        dest[i] = 0xa5;
+    }
+    memcpy(dest + self_test_guard_size + dest_offset, src + self_test_guard_size + src_offset, n);
+    if (memcmp(dest + self_test_guard_size + dest_offset, src + self_test_guard_size + src_offset, n) != 0)
+        return false;
+    return verify_guards(dest, dest_offset, n);
+}
+
+static bool self_test_memset(u8* dest, size_t n, size_t dest_offset)
+{
+    for (size_t i = 0; i < self_test_buffer_size; ++i)
+        dest[i] = 0xa5;
+    memset(dest + self_test_guard_size + dest_offset, 0x3c, n);
+    for (size_t i = 0; i < n; ++i) {
+        if (dest[self_test_guard_size + dest_offset + i] != 0x3c)
+            return false;
+    }
+    return verify_guards(dest, dest_offset, n);
+}
+
+template<typename Callback>
+static void benchmark(const char* name, size_t n, size_t src_offset, size_t dest_offset, Callback operation)
+{
+    static constexpr size_t iterations = 64;
+    // Warm up the caches and TLB first so we measure the copy loop rather than the first touch.
+    operation(n, src_offset, dest_offset);
+    u64 start = read_tsc();
+    for (size_t i = 0; i < iterations; ++i)
+        operation(n, src_offset, dest_offset);
+    u64 cycles = max(read_tsc() - start, (u64)1);
+    u64 centibytes_per_cycle = (u64)n * iterations * 100 / cycles;
+    klog() << "StringOperationsSelfTest: " << name << " " << n << " bytes (src+" << src_offset << ", dest+" << dest_offset << "): "
+           << (u32)(centibytes_per_cycle / 100) << "." << ((centibytes_per_cycle % 100) < 10 ? "0" : "") << (u32)(centibytes_per_cycle % 100) << " bytes/cycle";
+}
+
+void run_string_operations_self_test()
+{
+    auto* src = (u8*)kmalloc(self_test_buffer_size);
+    auto* dest = (u8*)kmalloc(self_test_buffer_size);
+
+    static const size_t sizes[] = { 0, 1, 2, 3, 4, 5, 7, 8, 11, 12, 13, 15, 16, 31, 32, 33, 63, 64, 65, 127, 128, 129, 255, 256, 1023, 1024, 4095, 4096, 4099, 65536 - 8 };
+    size_t failures = 0;
+    for (size_t n : sizes) {
+        for (size_t src_offset = 0; src_offset < 8; ++src_offset) {
+            for (size_t dest_offset = 0; dest_offset < 8; ++dest_offset) {
+                if (!self_test_memcpy(src, dest, n, src_offset, dest_offset)) {
+                    klog() << "StringOperationsSelfTest: memcpy of " << n << " bytes (src+" << src_offset << ", dest+" << dest_offset << ") FAILED";
+                    ++failures;
+                }
+            }
+            if (!self_test_memset(dest, n, src_offset)) {
+                klog() << "StringOperationsSelfTest: memset of " << n << " bytes (dest+" << src_offset << ") FAILED";
+                ++failures;
+            }
+        }
+    }
+
+    // Overlapping moves in both directions, on ranges that don't touch each other.
+    for (size_t shift = 1; shift < 9; ++shift) {
+        for (size_t i = 0; i < 512; ++i)
+            src[i] = (u8)i;
+        memmove(src + shift, src, 128);
+        memmove(src + 256, src + 256 + shift, 64);
+        bool ok = true;
+        for (size_t i = 0; i < 128; ++i)
+            ok &= src[i + shift] == (u8)i;
+        for (size_t i = 0; i < 64; ++i)
+            ok &= src[256 + i] == (u8)(256 + shift + i);
+        if (!ok) {
+            klog() << "StringOperationsSelfTest: overlapping memmove by " << shift << " bytes FAILED";
+            ++failures;
+        }
+    }
+
+    klog() << "StringOperationsSelfTest: " << failures << " failures, ERMS " << (g_cpu_supports_erms ? "enabled" : "disabled");
+
+    if (Processor::current().has_feature(CPUFeature::TSC)) {
+        auto do_memcpy = [&](size_t n, size_t src_offset, size_t dest_offset) {
+            memcpy(dest + dest_offset, src + src_offset, n);
+        };
+        auto do_memset = [&](size_t n, size_t, size_t dest_offset) {
+            memset(dest + dest_offset, 0, n);
+        };
+        static const size_t benchmark_sizes[] = { 16, 64, 256, 1024, 4096, 16384, 65536 };
+        static const size_t benchmark_offsets[][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 3, 1 } };
+        for (size_t n : benchmark_sizes) {
+            for (auto& offsets : benchmark_offsets)
+                benchmark("memcpy", n, offsets[0], offsets[1], do_memcpy);
+            benchmark("memset", n, 0, 0, do_memset);
+            benchmark("memset", n, 0, 1, do_memset);
+        }
+    }
+
+    kfree(src);
+    kfree(dest);
+}
+
+}
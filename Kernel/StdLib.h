@@ -58,6 +58,10 @@ inline u16 ntohs(u16 w) { return (w & 0xff) << 8 | ((w >> 8) & 0xff); }
 inline u16 htons(u16 w) { return (w & 0xff) << 8 | ((w >> 8) & 0xff); }
 }
 
+namespace Kernel {
+void run_string_operations_self_test();
+}
+
 template<typename T>
 inline void copy_from_user(T* dest, const T* src)
 {
@@ -24,7 +24,10 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Atomic.h>
 #include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/CommandLine.h>
+#include <Kernel/Net/LoopbackAdapter.h>
 #include <Kernel/Process.h>
 #include <Kernel/Random.h>
 #include <Kernel/API/Syscall.h>
@@ -64,14 +67,182 @@ asm(
     "    movl %ebx, 0(%esp) \n" // push pointer to TrapFrame
     "    jmp common_trap_exit \n");
 
+// The userspace half of the SYSENTER path. This is copied to a page that
+// userspace can execute but not write, and LibC calls into it instead of
+// using `int 0x82` when the kernel advertises it with AT_SYSINFO.
+//
+// SYSENTER doesn't save where it came from, so the stub sets up a normal
+// stack frame, hands the kernel its frame pointer in %ebp, and the kernel
+// always returns to the `popfl`.
+//
+// SYSENTER also doesn't clear the trap flag, so a single-stepped process
+// would take a debug exception on the first kernel instruction. The stub
+// clears it on the way in and restores it on the way out.
+//
+// The stack the kernel returns to is: saved flags, saved %ebp, and the
+// return address into whoever called the stub (see fast_syscall_caller_offset).
+extern "C" void asm_fast_syscall_stub();
+extern "C" void asm_fast_syscall_stub_return();
+extern "C" void asm_fast_syscall_stub_end();
+
+asm(
+    ".globl asm_fast_syscall_stub\n"
+    "asm_fast_syscall_stub:\n"
+    "    pushl %ebp\n"
+    "    movl %esp, %ebp\n"
+    "    pushfl\n"
+    "    pushfl\n"
+    "    andl $~0x100, (%esp)\n"
+    "    popfl\n"
+    "    sysenter\n"
+    ".globl asm_fast_syscall_stub_return\n"
+    "asm_fast_syscall_stub_return:\n"
+    "    popfl\n"
+    "    popl %ebp\n"
+    "    ret\n"
+    ".globl asm_fast_syscall_stub_end\n"
+    "asm_fast_syscall_stub_end:\n");
+
+extern "C" void fast_syscall_asm_entry();
+extern "C" FlatPtr fast_syscall_return_address;
+static constexpr size_t fast_syscall_caller_offset = 2 * sizeof(FlatPtr);
+
+// SYSENTER puts us on top of the current thread's kernel stack with
+// interrupts disabled (see enter_thread_context()). Build the same frame
+// that `int 0x82` would have, so the rest of the kernel can't tell the
+// difference. On the way out, we use SYSEXIT unless the thread is being
+// single-stepped, since that needs the trap flag restored by IRET.
+asm(
+    ".globl fast_syscall_asm_entry\n"
+    "fast_syscall_asm_entry:\n"
+    "    pushl $" __STRINGIFY(GDT_SELECTOR_DATA3 | 3) "\n" // userspace_ss
+    "    pushl %ebp\n"
+    "    subl $4, (%esp)\n" // userspace_esp, just below the stub's frame
+    "    pushfl\n"
+    "    orl $0x200, (%esp)\n" // userspace always runs with interrupts enabled
+    "    pushl $" __STRINGIFY(GDT_SELECTOR_CODE3 | 3) "\n"
+    "    pushl fast_syscall_return_address\n"
+    "    pushl $0x0\n"
+    "    pusha\n"
+    "    pushl %ds\n"
+    "    pushl %es\n"
+    "    pushl %fs\n"
+    "    pushl %gs\n"
+    "    pushl %ss\n"
+    "    mov $" __STRINGIFY(GDT_SELECTOR_DATA0) ", %ax\n"
+    "    mov %ax, %ds\n"
+    "    mov %ax, %es\n"
+    "    mov $" __STRINGIFY(GDT_SELECTOR_PROC) ", %ax\n"
+    "    mov %ax, %fs\n"
+    "    cld\n"
+    "    xor %esi, %esi\n"
+    "    xor %edi, %edi\n"
+    "    pushl %esp \n" // set TrapFrame::regs
+    "    subl $" __STRINGIFY(TRAP_FRAME_SIZE - 4) ", %esp \n"
+    "    movl %esp, %ebx \n"
+    "    pushl %ebx \n" // push pointer to TrapFrame
+    "    call enter_trap_no_irq \n"
+    "    sti \n"
+    "    movl %ebx, 0(%esp) \n" // push pointer to TrapFrame
+    "    call syscall_handler \n"
+    "    movl %ebx, 0(%esp) \n" // push pointer to TrapFrame
+    "    call exit_trap \n"
+    "    addl $" __STRINGIFY(TRAP_FRAME_SIZE + 4) ", %esp\n" // pop TrapFrame and pointer to it
+    "    testl $0x100, 64(%esp)\n" // RegisterState::eflags & TF
+    "    jnz interrupt_common_asm_exit\n"
+    "    addl $4, %esp\n" // pop %ss
+    "    popl %gs\n"
+    "    popl %fs\n"
+    "    popl %es\n"
+    "    popl %ds\n"
+    "    popa\n"
+    "    addl $0x4, %esp\n" // skip exception_code, isr_number
+    "    movl 0(%esp), %edx\n" // eip
+    "    movl 12(%esp), %ecx\n" // userspace_esp
+    "    addl $8, %esp\n"
+    "    andl $~0x200, (%esp)\n" // keep interrupts off until the sti right before sysexit
+    "    popfl\n"
+    "    addl $8, %esp\n"
+    "    sti\n"
+    "    sysexit\n");
+
+FlatPtr fast_syscall_return_address;
+
 namespace Syscall {
 
 static int handle(RegisterState&, u32 function, u32 arg1, u32 arg2, u32 arg3);
 
+static FlatPtr s_fast_syscall_entry;
+
+struct AtomicStatistics {
+    Atomic<u32> call_count;
+    Atomic<u64> total_cycles;
+    Atomic<u32> latency_histogram[latency_histogram_bucket_count];
+};
+
+static AtomicStatistics s_statistics[Function::__Count];
+
+static void initialize_fast_syscall_stub()
+{
+    // NOTE: We leak this region.
+    auto* region = MM.allocate_user_accessible_kernel_region(PAGE_SIZE, "Fast syscall stub", Region::Access::Read | Region::Access::Write | Region::Access::Execute, false).leak_ptr();
+
+    u8* stub = (u8*)asm_fast_syscall_stub;
+    u8* stub_end = (u8*)asm_fast_syscall_stub_end;
+    {
+        SmapDisabler disabler;
+        memcpy(region->vaddr().as_ptr(), stub, stub_end - stub);
+    }
+
+    region->set_writable(false);
+    region->remap();
+
+    s_fast_syscall_entry = region->vaddr().get();
+    fast_syscall_return_address = s_fast_syscall_entry + ((u8*)asm_fast_syscall_stub_return - stub);
+}
+
 void initialize()
 {
     register_user_callable_interrupt_handler(syscall_vector, syscall_asm_entry);
     klog() << "Syscall: int 0x82 handler installed";
+
+    if (Processor::current().has_feature(CPUFeature::SEP) && !kernel_command_line().contains("nosysenter")) {
+        initialize_fast_syscall_stub();
+        klog() << "Syscall: sysenter fast path enabled";
+    }
+}
+
+FlatPtr fast_syscall_entry()
+{
+    return s_fast_syscall_entry;
+}
+
+Statistics statistics(Function function)
+{
+    ASSERT(function < Function::__Count);
+    auto& atomic_statistics = s_statistics[function];
+    Statistics statistics;
+    statistics.call_count = atomic_statistics.call_count.load(AK::MemoryOrder::memory_order_relaxed);
+    statistics.total_cycles = atomic_statistics.total_cycles.load(AK::MemoryOrder::memory_order_relaxed);
+    for (size_t i = 0; i < latency_histogram_bucket_count; ++i)
+        statistics.latency_histogram[i] = atomic_statistics.latency_histogram[i].load(AK::MemoryOrder::memory_order_relaxed);
+    return statistics;
+}
+
+static void record_statistics(u32 function, u64 cycles)
+{
+    if (function >= Function::__Count)
+        return;
+    auto& statistics = s_statistics[function];
+    statistics.call_count.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+    statistics.total_cycles.fetch_add(cycles, AK::MemoryOrder::memory_order_relaxed);
+
+    // Bucket N counts calls that took less than 2^(N + 8) cycles,
+    // and the last bucket counts everything slower than that.
+    size_t bucket = 0;
+    for (u64 limit = 256; cycles >= limit && bucket < latency_histogram_bucket_count - 1; limit <<= 1)
+        ++bucket;
+    statistics.latency_histogram[bucket].fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
 }
 
 #pragma GCC diagnostic ignored "-Wcast-function-type"
@@ -148,15 +319,27 @@ void syscall_handler(TrapFrame* trap)
         ASSERT_NOT_REACHED();
     }
 
-    auto* calling_region = MM.region_from_vaddr(process, VirtualAddress(regs.eip));
+    // Everyone shares the SYSENTER stub, so what matters is who called it.
+    FlatPtr calling_eip = regs.eip;
+    if (calling_eip == fast_syscall_return_address) {
+        auto* caller = (const FlatPtr*)(regs.userspace_esp + fast_syscall_caller_offset);
+        if (!process.validate_read_typed(caller)) {
+            dbg() << "Fast syscall with invalid stack at " << String::format("%p", regs.userspace_esp);
+            handle_crash(regs, "Bad stack on syscall entry", SIGSTKFLT);
+            ASSERT_NOT_REACHED();
+        }
+        copy_from_user(&calling_eip, caller);
+    }
+
+    auto* calling_region = MM.region_from_vaddr(process, VirtualAddress(calling_eip));
     if (!calling_region) {
-        dbg() << "Syscall from " << String::format("%p", regs.eip) << " which has no region";
+        dbg() << "Syscall from " << String::format("%p", calling_eip) << " which has no region";
         handle_crash(regs, "Syscall from unknown region", SIGSEGV);
         ASSERT_NOT_REACHED();
     }
 
     if (calling_region->is_writable()) {
-        dbg() << "Syscall from writable memory at " << String::format("%p", regs.eip);
+        dbg() << "Syscall from writable memory at " << String::format("%p", calling_eip);
         handle_crash(regs, "Syscall from writable memory", SIGSEGV);
         ASSERT_NOT_REACHED();
     }
@@ -166,7 +349,15 @@ void syscall_handler(TrapFrame* trap)
     u32 arg1 = regs.edx;
     u32 arg2 = regs.ecx;
     u32 arg3 = regs.ebx;
+    bool should_record_statistics = Processor::current().has_feature(CPUFeature::TSC);
+    u64 start_cycles = should_record_statistics ? read_tsc() : 0;
     regs.eax = (u32)Syscall::handle(regs, function, arg1, arg2, arg3);
+    if (should_record_statistics) {
+        // We may have been migrated to a processor whose TSC is behind.
+        u64 end_cycles = read_tsc();
+        if (end_cycles >= start_cycles)
+            Syscall::record_statistics(function, end_cycles - start_cycles);
+    }
 
     if (current_thread->tracer() && current_thread->tracer()->is_tracing_syscalls()) {
         current_thread->tracer()->set_trace_syscalls(false);
@@ -175,6 +366,13 @@ void syscall_handler(TrapFrame* trap)
 
     process.big_lock().unlock();
 
+    // Packets sent over the loopback adapter during this syscall are handed to
+    // the receiving sockets here, once no socket or process locks are held.
+    if (current_thread->has_undelivered_loopback_packets()) {
+        LoopbackAdapter::the().deliver_queued_ipv4_packets();
+        current_thread->set_has_undelivered_loopback_packets(false);
+    }
+
     // Check if we're supposed to return to userspace or just die.
     current_thread->die_if_needed();
 
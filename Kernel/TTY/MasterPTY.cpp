@@ -94,8 +94,10 @@ void MasterPTY::notify_slave_closed(Badge<SlavePTY>)
 #endif
     // +1 ref for my MasterPTY::m_slave
     // +1 ref for FileDescription::m_device
-    if (m_slave->ref_count() == 2)
+    if (m_slave->ref_count() == 2) {
         m_slave = nullptr;
+        did_change_readiness();
+    }
 }
 
 ssize_t MasterPTY::on_slave_write(const u8* data, ssize_t size)
@@ -103,6 +105,7 @@ ssize_t MasterPTY::on_slave_write(const u8* data, ssize_t size)
     if (m_closed)
         return -EIO;
     m_buffer.write(data, size);
+    did_change_readiness();
     return size;
 }
 
@@ -122,6 +125,7 @@ KResult MasterPTY::close()
         m_closed = true;
 
         m_slave->hang_up();
+        m_slave->did_change_readiness();
     }
 
     return KSuccess;
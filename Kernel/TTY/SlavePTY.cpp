@@ -89,6 +89,11 @@ bool SlavePTY::can_read(const FileDescription& description, size_t offset) const
     return TTY::can_read(description, offset);
 }
 
+bool SlavePTY::is_hung_up(const FileDescription&) const
+{
+    return m_master->is_closed();
+}
+
 ssize_t SlavePTY::read(FileDescription& description, size_t offset, u8* buffer, ssize_t size)
 {
     if (m_master->is_closed())
@@ -162,6 +162,7 @@ void TTY::emit(u8 ch)
             //We use '\0' to delimit the end
             //of a line.
             m_input_buffer.enqueue('\0');
+            did_change_readiness();
             return;
         }
         if (is_kill(ch)) {
@@ -182,6 +183,7 @@ void TTY::emit(u8 ch)
     }
     m_input_buffer.enqueue(ch);
     echo(ch);
+    did_change_readiness();
 }
 
 bool TTY::can_do_backspace() const
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/NonnullRefPtrVector.h>
+#include <Kernel/Process.h>
+#include <Kernel/Tasks/SwapTask.h>
+#include <Kernel/Time/TimeManagement.h>
+#include <Kernel/VM/AnonymousVMObject.h>
+#include <Kernel/VM/MemoryManager.h>
+
+//#define SWAP_DEBUG
+
+namespace Kernel {
+
+static void swap_out_cold_pages()
+{
+    NonnullRefPtrVector<AnonymousVMObject> vmobjects;
+    {
+        ScopedSpinLock lock(s_mm_lock);
+        MM.for_each_vmobject_of_type<AnonymousVMObject>([&](auto& vmobject) {
+            if (vmobject.is_swappable())
+                vmobjects.append(vmobject);
+            return IterationDecision::Continue;
+        });
+    }
+
+    size_t swapped_out_count = 0;
+    for (auto& vmobject : vmobjects) {
+        if (MM.memory_pressure() == MemoryManager::MemoryPressure::Normal)
+            break;
+        swapped_out_count += vmobject.swap_out_cold_pages();
+    }
+
+#ifdef SWAP_DEBUG
+    dbg() << "SwapTask: Swapped out " << swapped_out_count << " pages, " << CompressedSwap::the().stored_page_count() << " pages stored in " << CompressedSwap::the().storage_page_count();
+#else
+    (void)swapped_out_count;
+#endif
+}
+
+void SwapTask::spawn()
+{
+    Thread* swap_thread = nullptr;
+    Process::create_kernel_process(swap_thread, "SwapTask", [] {
+        Thread::current()->set_priority(THREAD_PRIORITY_LOW);
+        for (;;) {
+            Thread::current()->sleep(1 * TimeManagement::the().ticks_per_second());
+            // Every pass clears the access bits of the pages it looks at, so whatever
+            // is still untouched on the next pass hasn't been used for a second.
+            if (MM.memory_pressure() != MemoryManager::MemoryPressure::Normal)
+                swap_out_cold_pages();
+        }
+    });
+}
+
+}
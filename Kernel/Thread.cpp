@@ -28,7 +28,9 @@
 #include <AK/StringBuilder.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/FutexQueue.h>
 #include <Kernel/KSyms.h>
+#include <Kernel/Net/LoopbackAdapter.h>
 #include <Kernel/Process.h>
 #include <Kernel/Profiling.h>
 #include <Kernel/Scheduler.h>
@@ -220,6 +222,14 @@ void Thread::relock_process(bool did_unlock)
         process().big_lock().lock();
 }
 
+void Thread::hand_off_undelivered_loopback_packets()
+{
+    // We're about to block before reaching the end of the syscall, where we would
+    // have delivered these ourselves. The receiver may be what we're waiting for.
+    m_has_undelivered_loopback_packets = false;
+    LoopbackAdapter::the().hand_off_queued_ipv4_packets();
+}
+
 u64 Thread::sleep(u32 ticks)
 {
     ASSERT(state() == Thread::Running);
@@ -289,6 +299,10 @@ void Thread::finalize()
         m_joiner = nullptr;
     }
 
+    // If we died in FUTEX_WAIT, don't leave our queue behind in the shared futex table.
+    auto futex_queue = FutexQueue::stop_waiting(*this);
+    FutexQueue::release(futex_queue);
+
     if (m_dump_backtrace_on_finalization)
         dbg() << backtrace_impl();
 }
@@ -879,6 +893,9 @@ Thread::BlockResult Thread::wait_on(WaitQueue& queue, const char* reason, timeva
     TimerId timer_id {};
     bool did_unlock;
 
+    if (m_has_undelivered_loopback_packets)
+        hand_off_undelivered_loopback_packets();
+
     {
         ScopedCritical critical;
         // We need to be in a critical section *and* then also acquire the
@@ -236,6 +236,18 @@ public:
         const FDVector& m_select_exceptional_fds;
     };
 
+    class EventPollBlocker final : public Blocker {
+    public:
+        EventPollBlocker(const EventPoll&, const timespec& deadline, bool has_timeout);
+        virtual bool should_unblock(Thread&, time_t, long) override;
+        virtual const char* state_string() const override { return "EventPolling"; }
+
+    private:
+        NonnullRefPtr<EventPoll> m_event_poll;
+        timespec m_deadline;
+        bool m_has_timeout { false };
+    };
+
     class WaitBlocker final : public Blocker {
     public:
         WaitBlocker(int wait_options, pid_t& waitee_pid);
@@ -279,6 +291,11 @@ public:
 
     bool in_kernel() const { return (m_tss.cs & 0x03) == 0; }
 
+    // Set while this thread has loopback packets queued that it will deliver
+    // itself on its way out of the current syscall (see LoopbackAdapter::send_ipv4()).
+    bool has_undelivered_loopback_packets() const { return m_has_undelivered_loopback_packets; }
+    void set_has_undelivered_loopback_packets(bool value) { m_has_undelivered_loopback_packets = value; }
+
     u32 cpu() const { return m_cpu.load(AK::MemoryOrder::memory_order_consume); }
     void set_cpu(u32 cpu) { m_cpu.store(cpu, AK::MemoryOrder::memory_order_release); }
     u32 affinity() const { return m_cpu_affinity; }
@@ -345,6 +362,9 @@ public:
         ASSERT(state() == Thread::Running);
         ASSERT(m_blocker == nullptr);
 
+        if (m_has_undelivered_loopback_packets)
+            hand_off_undelivered_loopback_packets();
+
         T t(forward<Args>(args)...);
         m_blocker = &t;
         set_state(Thread::Blocked);
@@ -426,6 +446,16 @@ public:
     unsigned cow_faults() const { return m_cow_faults; }
     void did_cow_fault() { ++m_cow_faults; }
 
+    // Number of Locks this thread holds in shared mode. Such a thread may be
+    // relocking one of them, so it must not be made to wait for queued writers.
+    bool holds_shared_locks() const { return m_shared_lock_count; }
+    void did_lock_shared() { ++m_shared_lock_count; }
+    void did_unlock_shared()
+    {
+        if (m_shared_lock_count)
+            --m_shared_lock_count;
+    }
+
     unsigned file_read_bytes() const { return m_file_read_bytes; }
     unsigned file_write_bytes() const { return m_file_write_bytes; }
 
@@ -504,6 +534,21 @@ public:
     void stop_tracing();
     void tracer_trap(const RegisterState&);
 
+    // The futex queue this thread is sleeping on, see FutexQueue::start_waiting().
+    RefPtr<FutexQueue>& futex_queue() { return m_futex_queue; }
+
+    TLBFlushBatch* tlb_flush_batch() { return m_tlb_flush_batch; }
+    void set_tlb_flush_batch(TLBFlushBatch* batch) { m_tlb_flush_batch = batch; }
+
+    // While set, permission checks made by this thread use these ids instead of the
+    // process's effective ones. posix_spawn() uses this to act on behalf of the child.
+    struct AccessCredentials {
+        uid_t euid;
+        gid_t egid;
+    };
+    const Optional<AccessCredentials>& access_credentials_override() const { return m_access_credentials_override; }
+    void set_access_credentials_override(Optional<AccessCredentials> credentials) { m_access_credentials_override = credentials; }
+
 private:
     IntrusiveListNode m_runnable_list_node;
     IntrusiveListNode m_wait_queue_node;
@@ -513,6 +558,7 @@ private:
     friend class WaitQueue;
     bool unlock_process_if_locked();
     void relock_process(bool did_unlock);
+    void hand_off_undelivered_loopback_packets();
     String backtrace_impl();
     void reset_fpu_state();
 
@@ -546,6 +592,8 @@ private:
     unsigned m_zero_faults { 0 };
     unsigned m_cow_faults { 0 };
 
+    unsigned m_shared_lock_count { 0 };
+
     unsigned m_file_read_bytes { 0 };
     unsigned m_file_write_bytes { 0 };
 
@@ -567,9 +615,14 @@ private:
 
     bool m_dump_backtrace_on_finalization { false };
     bool m_should_die { false };
+    bool m_has_undelivered_loopback_packets { false };
     bool m_initialized { false };
 
     OwnPtr<ThreadTracer> m_tracer;
+    Optional<AccessCredentials> m_access_credentials_override;
+    RefPtr<FutexQueue> m_futex_queue;
+
+    TLBFlushBatch* m_tlb_flush_batch { nullptr };
 
     void yield_without_holding_big_lock();
 };
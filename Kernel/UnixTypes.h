@@ -107,11 +107,41 @@ enum {
 #define F_GETFL 3
 #define F_SETFL 4
 #define F_ISTTY 5
+#define F_GETPIPE_SZ 8
+#define F_SETPIPE_SZ 9
 
 #define FD_CLOEXEC 1
 
 #define FUTEX_WAIT 1
 #define FUTEX_WAKE 2
+#define FUTEX_REQUEUE 3
+#define FUTEX_CMP_REQUEUE 4
+#define FUTEX_WAKE_OP 5
+
+#define FUTEX_OP_SET 0
+#define FUTEX_OP_ADD 1
+#define FUTEX_OP_OR 2
+#define FUTEX_OP_ANDN 3
+#define FUTEX_OP_XOR 4
+#define FUTEX_OP_OPARG_SHIFT 8
+
+#define FUTEX_OP_CMP_EQ 0
+#define FUTEX_OP_CMP_NE 1
+#define FUTEX_OP_CMP_LT 2
+#define FUTEX_OP_CMP_LE 3
+#define FUTEX_OP_CMP_GT 4
+#define FUTEX_OP_CMP_GE 5
+
+#define FUTEX_OP(op, oparg, cmp, cmparg) \
+    ((((op)&0xf) << 28) | (((cmp)&0xf) << 24) | (((oparg)&0xfff) << 12) | ((cmparg)&0xfff))
+
+#define POSIX_SPAWN_RESETIDS (1 << 0)
+#define POSIX_SPAWN_SETPGROUP (1 << 1)
+#define POSIX_SPAWN_SETSCHEDPARAM (1 << 2)
+#define POSIX_SPAWN_SETSCHEDULER (1 << 3)
+#define POSIX_SPAWN_SETSIGDEF (1 << 4)
+#define POSIX_SPAWN_SETSIGMASK (1 << 5)
+#define POSIX_SPAWN_SETSID (1 << 6)
 
 #define S_IFMT 0170000
 #define S_IFDIR 0040000
@@ -430,6 +460,32 @@ struct pollfd {
     short revents;
 };
 
+#define EPOLLIN (1u << 0)
+#define EPOLLPRI (1u << 1)
+#define EPOLLOUT (1u << 2)
+#define EPOLLERR (1u << 3)
+#define EPOLLHUP (1u << 4)
+#define EPOLLONESHOT (1u << 30)
+#define EPOLLET (1u << 31)
+
+#define EPOLL_CTL_ADD 1
+#define EPOLL_CTL_DEL 2
+#define EPOLL_CTL_MOD 3
+
+#define EPOLL_CLOEXEC 02000000
+
+typedef union epoll_data {
+    void* ptr;
+    int fd;
+    uint32_t u32;
+    uint64_t u64;
+} epoll_data_t;
+
+struct epoll_event {
+    uint32_t events;
+    epoll_data_t data;
+};
+
 #define AF_MASK 0xff
 #define AF_UNSPEC 0
 #define AF_LOCAL 1
@@ -460,6 +516,8 @@ struct pollfd {
 #define SO_REUSEADDR 6
 #define SO_BINDTODEVICE 7
 #define SO_KEEPALIVE 9
+#define SO_SNDBUF 10
+#define SO_RCVBUF 11
 
 #define IPPROTO_IP 0
 #define IPPROTO_ICMP 1
@@ -598,6 +656,10 @@ struct rtentry {
 #define PURGE_ALL_VOLATILE 0x1
 #define PURGE_ALL_CLEAN_INODE 0x2
 
+#define MEMORY_PRESSURE_NORMAL 0
+#define MEMORY_PRESSURE_LOW 1
+#define MEMORY_PRESSURE_CRITICAL 2
+
 #define PT_TRACE_ME 1
 #define PT_ATTACH 2
 #define PT_CONTINUE 3
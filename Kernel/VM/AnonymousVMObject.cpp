@@ -24,9 +24,11 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/ScopeGuard.h>
 #include <Kernel/VM/AnonymousVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/PhysicalPage.h>
+#include <Kernel/VM/Region.h>
 
 namespace Kernel {
 
@@ -70,7 +72,15 @@ AnonymousVMObject::AnonymousVMObject(PhysicalAddress paddr, size_t size)
 
 AnonymousVMObject::AnonymousVMObject(const AnonymousVMObject& other)
     : VMObject(other)
+    , m_swappable(other.m_swappable)
 {
+    // Swapped out pages are shared until someone faults them back in,
+    // at which point they get their own copy.
+    ScopedSpinLock lock(s_mm_lock);
+    for (auto& it : other.m_swapped_pages) {
+        if (!m_physical_pages[it.key])
+            m_swapped_pages.set(it.key, it.value);
+    }
 }
 
 AnonymousVMObject::~AnonymousVMObject()
@@ -82,4 +92,75 @@ NonnullRefPtr<VMObject> AnonymousVMObject::clone()
     return adopt(*new AnonymousVMObject(*this));
 }
 
+size_t AnonymousVMObject::swap_out_cold_pages()
+{
+    ASSERT(m_swappable);
+
+    // Compressing pages is slow enough that we don't want to keep interrupts
+    // disabled for a whole VMObject at a time.
+    constexpr size_t pages_per_batch = 32;
+
+    size_t swapped_out_count = 0;
+    for (size_t batch_start = 0; batch_start < page_count(); batch_start += pages_per_batch) {
+        ScopedSpinLock lock(s_mm_lock);
+        // Page faults take the paging lock while holding the MM lock, so we
+        // can't wait for it here. If someone is paging this object in right
+        // now, it's not cold anyway.
+        if (!m_paging_lock.try_lock())
+            break;
+        ScopeGuard unlock_paging_lock([&] { m_paging_lock.unlock(); });
+
+        Vector<Region*, 4> regions;
+        for_each_region([&](auto& region) {
+            regions.append(&region);
+        });
+
+        size_t batch_end = min(batch_start + pages_per_batch, page_count());
+        for (size_t i = batch_start; i < batch_end; ++i) {
+            auto& page_slot = m_physical_pages[i];
+            // Pages shared with anyone else (like a forked process) aren't ours to take away.
+            if (!page_slot || page_slot->is_shared_zero_page() || page_slot->ref_count() != 1)
+                continue;
+
+            bool was_accessed = false;
+            for (auto* region : regions) {
+                if (i < region->first_page_index() || i > region->last_page_index())
+                    continue;
+                if (region->test_and_clear_accessed(i - region->first_page_index()))
+                    was_accessed = true;
+            }
+            if (was_accessed)
+                continue;
+
+            // Take the page away from everyone before compressing it, so that nobody
+            // can write to it behind our back.
+            auto page = move(page_slot);
+            for (auto* region : regions) {
+                if (i >= region->first_page_index() && i <= region->last_page_index())
+                    region->unmap_page(i - region->first_page_index());
+            }
+
+            auto compressed_page = CompressedSwap::the().store(*page);
+            if (!compressed_page) {
+                // It gets mapped back in on the next access.
+                page_slot = move(page);
+                continue;
+            }
+            m_swapped_pages.set(i, compressed_page.release_nonnull());
+            ++swapped_out_count;
+        }
+    }
+    return swapped_out_count;
+}
+
+void AnonymousVMObject::swap_in_page(Badge<Region>, size_t page_index, PhysicalPage& page)
+{
+    ASSERT(m_paging_lock.is_locked());
+    ScopedSpinLock lock(s_mm_lock);
+    auto it = m_swapped_pages.find(page_index);
+    ASSERT(it != m_swapped_pages.end());
+    CompressedSwap::the().load(*it->value, page);
+    m_swapped_pages.remove(it);
+}
+
 }
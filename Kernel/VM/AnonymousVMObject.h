@@ -26,6 +26,9 @@
 
 #pragma once
 
+#include <AK/Badge.h>
+#include <AK/HashMap.h>
+#include <Kernel/VM/CompressedSwap.h>
 #include <Kernel/VM/VMObject.h>
 #include <Kernel/PhysicalAddress.h>
 
@@ -40,6 +43,18 @@ public:
     static NonnullRefPtr<AnonymousVMObject> create_with_physical_page(PhysicalPage&);
     virtual NonnullRefPtr<VMObject> clone() override;
 
+    // Only memory that nothing but userspace looks at may be swapped out,
+    // since the kernel expects its own pages to stay put.
+    bool is_swappable() const { return m_swappable; }
+    void set_swappable(bool b) { m_swappable = b; }
+
+    // Compresses the pages that haven't been accessed through any mapping since
+    // the last call into the compressed swap, and returns how many it stored.
+    size_t swap_out_cold_pages();
+    bool is_page_swapped_out(size_t page_index) const { return m_swapped_pages.contains(page_index); }
+    void swap_in_page(Badge<Region>, size_t page_index, PhysicalPage&);
+    size_t swapped_page_count() const { return m_swapped_pages.size(); }
+
 protected:
     explicit AnonymousVMObject(size_t);
     explicit AnonymousVMObject(const AnonymousVMObject&);
@@ -54,6 +69,9 @@ private:
     AnonymousVMObject(AnonymousVMObject&&) = delete;
 
     virtual bool is_anonymous() const override { return true; }
+
+    bool m_swappable { false };
+    HashMap<size_t, NonnullRefPtr<CompressedPage>> m_swapped_pages;
 };
 
 template<>
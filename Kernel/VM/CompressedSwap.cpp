@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Memory.h>
+#include <Kernel/StdLib.h>
+#include <Kernel/VM/CompressedSwap.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <Kernel/VM/PhysicalPage.h>
+
+namespace Kernel {
+
+// The compressed format is a sequence of LZ4-style sequences: a token byte with
+// the literal count in the high nibble and the match length (minus 4) in the low
+// nibble, either of which is continued in 255-bytes when it's 15. The token is
+// followed by the literals, a 16-bit little endian match offset and the match
+// length continuation. The last sequence only has literals.
+
+static constexpr size_t min_match_length = 4;
+static constexpr size_t last_literals = 5;
+
+static inline u32 read_u32(const u8* p)
+{
+    u32 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline u32 hash_sequence(u32 sequence)
+{
+    return (sequence * 2654435761u) >> 20;
+}
+
+CompressedSwap& CompressedSwap::the()
+{
+    static CompressedSwap* s_the;
+    if (!s_the)
+        s_the = new CompressedSwap;
+    return *s_the;
+}
+
+CompressedSwap::CompressedSwap()
+{
+}
+
+size_t CompressedSwap::compress(const u8* in, size_t in_size, u8* out, size_t max_out_size)
+{
+    static_assert(hash_table_size == 1 << 12);
+    ASSERT(in_size <= PAGE_SIZE);
+    memset(m_hash_table, 0, sizeof(m_hash_table));
+
+    size_t out_size = 0;
+    auto emit_length = [&](size_t length) {
+        for (; length >= 255; length -= 255) {
+            if (out_size >= max_out_size)
+                return false;
+            out[out_size++] = 255;
+        }
+        if (out_size >= max_out_size)
+            return false;
+        out[out_size++] = length;
+        return true;
+    };
+
+    auto emit_sequence = [&](const u8* literals, size_t literal_length, size_t offset, size_t match_length) {
+        if (out_size >= max_out_size)
+            return false;
+        size_t match_nibble = match_length ? match_length - min_match_length : 0;
+        out[out_size++] = (min(literal_length, (size_t)15) << 4) | min(match_nibble, (size_t)15);
+        if (literal_length >= 15 && !emit_length(literal_length - 15))
+            return false;
+        if (literal_length > max_out_size - out_size)
+            return false;
+        memcpy(out + out_size, literals, literal_length);
+        out_size += literal_length;
+        if (!match_length)
+            return true;
+        if (max_out_size - out_size < 2)
+            return false;
+        out[out_size++] = offset & 0xff;
+        out[out_size++] = offset >> 8;
+        if (match_nibble >= 15 && !emit_length(match_nibble - 15))
+            return false;
+        return true;
+    };
+
+    size_t anchor = 0;
+    size_t position = 0;
+    size_t match_limit = in_size > last_literals ? in_size - last_literals : 0;
+    while (position + min_match_length <= match_limit) {
+        u32 sequence = read_u32(in + position);
+        auto& entry = m_hash_table[hash_sequence(sequence)];
+        size_t candidate = entry;
+        entry = position;
+        if (candidate >= position || read_u32(in + candidate) != sequence) {
+            ++position;
+            continue;
+        }
+        size_t match_length = min_match_length;
+        while (position + match_length < match_limit && in[candidate + match_length] == in[position + match_length])
+            ++match_length;
+        if (!emit_sequence(in + anchor, position - anchor, position - candidate, match_length))
+            return 0;
+        position += match_length;
+        anchor = position;
+    }
+    if (!emit_sequence(in + anchor, in_size - anchor, 0, 0))
+        return 0;
+    return out_size;
+}
+
+bool CompressedSwap::decompress(const u8* in, size_t in_size, u8* out, size_t out_size)
+{
+    size_t in_position = 0;
+    size_t out_position = 0;
+
+    auto read_length = [&](size_t& length) {
+        u8 byte;
+        do {
+            if (in_position >= in_size)
+                return false;
+            byte = in[in_position++];
+            length += byte;
+        } while (byte == 255);
+        return true;
+    };
+
+    while (in_position < in_size) {
+        u8 token = in[in_position++];
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !read_length(literal_length))
+            return false;
+        if (literal_length > in_size - in_position || literal_length > out_size - out_position)
+            return false;
+        memcpy(out + out_position, in + in_position, literal_length);
+        in_position += literal_length;
+        out_position += literal_length;
+        if (in_position == in_size)
+            break;
+
+        if (in_size - in_position < 2)
+            return false;
+        size_t offset = in[in_position] | (in[in_position + 1] << 8);
+        in_position += 2;
+        if (!offset || offset > out_position)
+            return false;
+        size_t match_length = token & 0xf;
+        if (match_length == 15 && !read_length(match_length))
+            return false;
+        match_length += min_match_length;
+        if (match_length > out_size - out_position)
+            return false;
+        // Matches may overlap what they produce, so this has to go byte by byte.
+        for (size_t i = 0; i < match_length; ++i, ++out_position)
+            out[out_position] = out[out_position - offset];
+    }
+    return out_position == out_size;
+}
+
+RefPtr<CompressedPage> CompressedSwap::store(PhysicalPage& page)
+{
+    ScopedSpinLock lock(s_mm_lock);
+
+    u8* source = MM.quickmap_page(page);
+    size_t compressed_size = compress(source, PAGE_SIZE, m_compression_buffer, max_compressed_size);
+    MM.unquickmap_page();
+    if (!compressed_size)
+        return nullptr;
+
+    StoragePage* storage = nullptr;
+    for (size_t i = ceil_div(compressed_size, chunk_size); i < chunk_count && !storage; ++i) {
+        if (!m_unbuddied[i].is_empty())
+            storage = m_unbuddied[i].head();
+    }
+
+    if (storage) {
+        m_unbuddied[storage->free_space() / chunk_size].remove(storage);
+        storage->is_unbuddied = false;
+    } else {
+        auto physical_page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No);
+        if (!physical_page)
+            return nullptr;
+        storage = new StoragePage(physical_page.release_nonnull());
+        ++m_storage_page_count;
+    }
+
+    ASSERT(storage->free_space() >= compressed_size);
+    bool is_last = storage->first_size != 0;
+    if (is_last)
+        storage->last_size = compressed_size;
+    else
+        storage->first_size = compressed_size;
+    auto compressed_page = adopt(*new CompressedPage(*storage, is_last, compressed_size));
+
+    u8* destination = MM.quickmap_page(storage->physical_page);
+    memcpy(destination + compressed_page->offset_in_storage(), m_compression_buffer, compressed_size);
+    MM.unquickmap_page();
+
+    if (!storage->first_size || !storage->last_size)
+        make_unbuddied(*storage);
+    ++m_stored_page_count;
+    return compressed_page;
+}
+
+void CompressedSwap::load(const CompressedPage& compressed_page, PhysicalPage& page)
+{
+    ScopedSpinLock lock(s_mm_lock);
+
+    // We can only quickmap one page at a time, so bounce the compressed data.
+    const u8* source = MM.quickmap_page(compressed_page.m_storage.physical_page);
+    memcpy(m_compression_buffer, source + compressed_page.offset_in_storage(), compressed_page.size());
+    MM.unquickmap_page();
+
+    u8* destination = MM.quickmap_page(page);
+    bool success = decompress(m_compression_buffer, compressed_page.size(), destination, PAGE_SIZE);
+    MM.unquickmap_page();
+    ASSERT(success);
+}
+
+void CompressedSwap::make_unbuddied(StoragePage& storage)
+{
+    ASSERT(!storage.is_unbuddied);
+    m_unbuddied[storage.free_space() / chunk_size].append(&storage);
+    storage.is_unbuddied = true;
+}
+
+void CompressedSwap::release(Badge<CompressedPage>, StoragePage& storage, bool is_last)
+{
+    ScopedSpinLock lock(s_mm_lock);
+    if (storage.is_unbuddied) {
+        m_unbuddied[storage.free_space() / chunk_size].remove(&storage);
+        storage.is_unbuddied = false;
+    }
+    if (is_last)
+        storage.last_size = 0;
+    else
+        storage.first_size = 0;
+    --m_stored_page_count;
+
+    if (storage.first_size || storage.last_size) {
+        make_unbuddied(storage);
+        return;
+    }
+    delete &storage;
+    --m_storage_page_count;
+}
+
+CompressedPage::~CompressedPage()
+{
+    CompressedSwap::the().release({}, m_storage, m_is_last);
+}
+
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Badge.h>
+#include <AK/InlineLinkedList.h>
+#include <AK/RefCounted.h>
+#include <AK/RefPtr.h>
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/Forward.h>
+
+namespace Kernel {
+
+class CompressedPage;
+
+// A RAM-backed swap area for cold anonymous pages.
+// Pages are compressed with a small LZ77 compressor and stored two to a physical
+// page, one packed against each end ("zbud"). That caps the savings at 2x, but
+// it means a stored page never has to be moved around to make room for another.
+class CompressedSwap {
+    AK_MAKE_ETERNAL
+    friend class CompressedPage;
+
+public:
+    static CompressedSwap& the();
+
+    // Returns null if the page doesn't compress well enough to be worth storing,
+    // or if there's no memory left to store it in.
+    RefPtr<CompressedPage> store(PhysicalPage&);
+    void load(const CompressedPage&, PhysicalPage&);
+
+    size_t stored_page_count() const { return m_stored_page_count; }
+    size_t storage_page_count() const { return m_storage_page_count; }
+
+private:
+    CompressedSwap();
+
+    size_t compress(const u8* in, size_t in_size, u8* out, size_t max_out_size);
+    static bool decompress(const u8* in, size_t in_size, u8* out, size_t out_size);
+
+    static constexpr size_t chunk_size = 64;
+    static constexpr size_t chunk_count = PAGE_SIZE / chunk_size;
+    static constexpr size_t max_compressed_size = PAGE_SIZE - PAGE_SIZE / 4;
+    static constexpr size_t hash_table_size = 4096;
+
+    struct StoragePage : public InlineLinkedListNode<StoragePage> {
+        explicit StoragePage(NonnullRefPtr<PhysicalPage>&& page)
+            : physical_page(move(page))
+        {
+        }
+
+        size_t free_space() const { return PAGE_SIZE - first_size - last_size; }
+
+        NonnullRefPtr<PhysicalPage> physical_page;
+        u16 first_size { 0 };
+        u16 last_size { 0 };
+        bool is_unbuddied { false };
+
+        // For InlineLinkedList
+        StoragePage* m_prev { nullptr };
+        StoragePage* m_next { nullptr };
+    };
+
+    void release(Badge<CompressedPage>, StoragePage&, bool is_last);
+    void make_unbuddied(StoragePage&);
+
+    // Storage pages holding a single compressed page, by how many chunks they have free.
+    InlineLinkedList<StoragePage> m_unbuddied[chunk_count];
+
+    size_t m_stored_page_count { 0 };
+    size_t m_storage_page_count { 0 };
+
+    u8 m_compression_buffer[PAGE_SIZE];
+    u16 m_hash_table[hash_table_size];
+};
+
+class CompressedPage : public RefCounted<CompressedPage> {
+    friend class CompressedSwap;
+
+public:
+    ~CompressedPage();
+
+    size_t size() const { return m_size; }
+
+private:
+    CompressedPage(CompressedSwap::StoragePage& storage, bool is_last, u16 size)
+        : m_storage(storage)
+        , m_is_last(is_last)
+        , m_size(size)
+    {
+    }
+
+    size_t offset_in_storage() const { return m_is_last ? PAGE_SIZE - m_size : 0; }
+
+    CompressedSwap::StoragePage& m_storage;
+    bool m_is_last { false };
+    u16 m_size { 0 };
+};
+
+}
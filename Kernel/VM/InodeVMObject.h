@@ -47,6 +47,10 @@ public:
 
     int release_all_clean_pages();
 
+    // A private mapping that writes to a page has its own copy, which can't be
+    // dropped and read back in from the inode later.
+    void set_page_dirty(size_t page_index) { m_dirty_pages.set(page_index, true); }
+
     u32 writable_mappings() const;
     u32 executable_mappings() const;
 
@@ -35,6 +35,7 @@
 #include <Kernel/VM/AnonymousVMObject.h>
 #include <Kernel/VM/ContiguousVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
+#include <Kernel/VM/MemoryPressureWatcher.h>
 #include <Kernel/VM/PageDirectory.h>
 #include <Kernel/VM/PhysicalRegion.h>
 #include <Kernel/VM/PurgeableVMObject.h>
@@ -163,7 +164,7 @@ void MemoryManager::parse_memory_map()
     ASSERT(m_user_physical_pages > 0);
 }
 
-const PageTableEntry* MemoryManager::pte(const PageDirectory& page_directory, VirtualAddress vaddr)
+PageTableEntry* MemoryManager::pte(PageDirectory& page_directory, VirtualAddress vaddr)
 {
     ASSERT_INTERRUPTS_DISABLED();
     ASSERT(s_mm_lock.own_lock());
@@ -171,9 +172,9 @@ const PageTableEntry* MemoryManager::pte(const PageDirectory& page_directory, Vi
     u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
     u32 page_table_index = (vaddr.get() >> 12) & 0x1ff;
 
-    auto* pd = quickmap_pd(const_cast<PageDirectory&>(page_directory), page_directory_table_index);
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     const PageDirectoryEntry& pde = pd[page_directory_index];
-    if (!pde.is_present())
+    if (!pde.is_present() || pde.is_huge())
         return nullptr;
 
     return &quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()))[page_table_index];
@@ -189,6 +190,8 @@ PageTableEntry& MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     PageDirectoryEntry& pde = pd[page_directory_index];
+    // NOTE: A large page has no page table to hand out. Its owner must unmap it before mapping 4 KiB pages in its place.
+    ASSERT(!pde.is_present() || !pde.is_huge());
     if (!pde.is_present()) {
 #ifdef MM_DEBUG
         dbg() << "MM: PDE " << page_directory_index << " not present (requested for " << vaddr << "), allocating";
@@ -202,12 +205,59 @@ PageTableEntry& MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
         pde.set_present(true);
         pde.set_writable(true);
         pde.set_global(&page_directory == m_kernel_page_directory.ptr());
-        page_directory.m_physical_pages.set(page_directory_index, move(page_table));
+        page_directory.m_physical_pages.set(vaddr.get() >> 21, move(page_table));
     }
 
     return quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()))[page_table_index];
 }
 
+PageDirectoryEntry& MemoryManager::page_directory_entry(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    ASSERT(s_mm_lock.own_lock());
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x3;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+    return quickmap_pd(page_directory, page_directory_table_index)[page_directory_index];
+}
+
+void MemoryManager::map_large_page(PageDirectory& page_directory, VirtualAddress vaddr, PhysicalAddress paddr, bool writable, bool user_allowed, bool executable, bool cacheable)
+{
+    ASSERT(!(vaddr.get() % LARGE_PAGE_SIZE));
+    ASSERT(!(paddr.get() % LARGE_PAGE_SIZE));
+    auto& pde = page_directory_entry(page_directory, vaddr);
+    // Any page table we previously allocated for this range is superseded by the large page.
+    if (pde.is_present() && !pde.is_huge())
+        page_directory.m_physical_pages.remove(vaddr.get() >> 21);
+    if (!pde.is_present() || !pde.is_huge())
+        ++m_large_pages_mapped;
+    pde.clear();
+    pde.set_large_page_base(paddr.get());
+    pde.set_huge(true);
+    pde.set_present(true);
+    pde.set_writable(writable);
+    pde.set_user_allowed(user_allowed);
+    pde.set_cache_disabled(!cacheable);
+    pde.set_global(&page_directory == m_kernel_page_directory.ptr());
+    if (Processor::current().has_feature(CPUFeature::NX))
+        pde.set_execute_disabled(!executable);
+#ifdef MM_DEBUG
+    dbg() << "MM: >> large page map (PD=" << page_directory.cr3() << ", PDE=" << (void*)pde.raw() << ") " << vaddr << " => " << paddr;
+#endif
+}
+
+bool MemoryManager::unmap_large_page(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    if (vaddr.get() % LARGE_PAGE_SIZE)
+        return false;
+    auto& pde = page_directory_entry(page_directory, vaddr);
+    if (!pde.is_present() || !pde.is_huge())
+        return false;
+    pde.clear();
+    ASSERT(m_large_pages_mapped);
+    --m_large_pages_mapped;
+    return true;
+}
+
 void MemoryManager::initialize(u32 cpu)
 {
     auto mm_data = new MemoryManagerData;
@@ -298,13 +348,17 @@ OwnPtr<Region> MemoryManager::allocate_contiguous_kernel_region(size_t size, con
 {
     ASSERT(!(size % PAGE_SIZE));
     ScopedSpinLock lock(s_mm_lock);
-    auto range = kernel_page_directory().range_allocator().allocate_anywhere(size);
+    auto range = kernel_page_directory().range_allocator().allocate_anywhere(size, size >= LARGE_PAGE_SIZE ? LARGE_PAGE_SIZE : PAGE_SIZE);
     if (!range.is_valid())
         return nullptr;
     auto vmobject = ContiguousVMObject::create_with_size(size);
     auto region = allocate_kernel_region_with_vmobject(range, vmobject, name, access, user_accessible, cacheable);
     if (!region)
         return nullptr;
+    if (size >= LARGE_PAGE_SIZE) {
+        region->set_large_pages(true);
+        region->remap();
+    }
     return region;
 }
 
@@ -328,13 +382,19 @@ OwnPtr<Region> MemoryManager::allocate_kernel_region(PhysicalAddress paddr, size
 {
     ASSERT(!(size % PAGE_SIZE));
     ScopedSpinLock lock(s_mm_lock);
-    auto range = kernel_page_directory().range_allocator().allocate_anywhere(size);
+    bool use_large_pages = size >= LARGE_PAGE_SIZE && !(paddr.get() % LARGE_PAGE_SIZE);
+    auto range = kernel_page_directory().range_allocator().allocate_anywhere(size, use_large_pages ? LARGE_PAGE_SIZE : PAGE_SIZE);
     if (!range.is_valid())
         return nullptr;
     auto vmobject = AnonymousVMObject::create_for_physical_range(paddr, size);
     if (!vmobject)
         return nullptr;
-    return allocate_kernel_region_with_vmobject(range, *vmobject, name, access, user_accessible, cacheable);
+    auto region = allocate_kernel_region_with_vmobject(range, *vmobject, name, access, user_accessible, cacheable);
+    if (region && use_large_pages) {
+        region->set_large_pages(true);
+        region->remap();
+    }
+    return region;
 }
 
 OwnPtr<Region> MemoryManager::allocate_kernel_region_identity(PhysicalAddress paddr, size_t size, const StringView& name, u8 access, bool user_accessible, bool cacheable)
@@ -389,6 +449,7 @@ void MemoryManager::deallocate_user_physical_page(PhysicalPage&& page)
 
         region.return_page(move(page));
         --m_user_physical_pages_used;
+        update_memory_pressure();
 
         return;
     }
@@ -409,6 +470,79 @@ RefPtr<PhysicalPage> MemoryManager::find_free_user_physical_page()
     return page;
 }
 
+int MemoryManager::purge_volatile_vmobjects(unsigned target_free_pages)
+{
+    ASSERT(s_mm_lock.is_locked());
+
+    // Purge the volatile objects that were least recently used first, since those
+    // are the least likely to be wanted back soon.
+    int purged_page_count = 0;
+    bool have_previous = false;
+    u32 previous_last_used = 0;
+    while (m_user_physical_pages - m_user_physical_pages_used < target_free_pages) {
+        PurgeableVMObject* oldest = nullptr;
+        for_each_vmobject_of_type<PurgeableVMObject>([&](auto& vmobject) {
+            if (!vmobject.is_volatile() || vmobject.was_purged())
+                return IterationDecision::Continue;
+            if (have_previous && vmobject.last_used() <= previous_last_used)
+                return IterationDecision::Continue;
+            if (!oldest || vmobject.last_used() < oldest->last_used())
+                oldest = &vmobject;
+            return IterationDecision::Continue;
+        });
+        if (!oldest)
+            break;
+        have_previous = true;
+        previous_last_used = oldest->last_used();
+        purged_page_count += oldest->purge_with_interrupts_disabled({});
+    }
+    return purged_page_count;
+}
+
+bool MemoryManager::update_memory_pressure()
+{
+    ASSERT(s_mm_lock.is_locked());
+    unsigned free_pages = m_user_physical_pages - m_user_physical_pages_used;
+
+    auto pressure_for = [&](unsigned free_pages) {
+        if (free_pages < critical_memory_watermark())
+            return MemoryPressure::Critical;
+        if (free_pages < low_memory_watermark())
+            return MemoryPressure::Low;
+        return MemoryPressure::Normal;
+    };
+
+    auto pressure = pressure_for(free_pages);
+    if (pressure < m_memory_pressure) {
+        // Require some slack before lowering the level again, so that we don't
+        // wake up every watcher each time a single page comes and goes.
+        unsigned hysteresis = m_user_physical_pages / 64;
+        pressure = max(pressure, min(m_memory_pressure, pressure_for(free_pages > hysteresis ? free_pages - hysteresis : 0)));
+    }
+    if (pressure == m_memory_pressure)
+        return false;
+
+#ifdef MM_DEBUG
+    dbg() << "MM: Memory pressure changed from " << (u32)m_memory_pressure << " to " << (u32)pressure << ", " << free_pages << " free user pages";
+#endif
+    m_memory_pressure = pressure;
+    for (auto& watcher : m_memory_pressure_watchers)
+        watcher.notify_memory_pressure_changed({});
+    return true;
+}
+
+void MemoryManager::register_memory_pressure_watcher(Badge<MemoryPressureWatcher>, MemoryPressureWatcher& watcher)
+{
+    ScopedSpinLock lock(s_mm_lock);
+    m_memory_pressure_watchers.append(&watcher);
+}
+
+void MemoryManager::unregister_memory_pressure_watcher(Badge<MemoryPressureWatcher>, MemoryPressureWatcher& watcher)
+{
+    ScopedSpinLock lock(s_mm_lock);
+    m_memory_pressure_watchers.remove(&watcher);
+}
+
 RefPtr<PhysicalPage> MemoryManager::allocate_user_physical_page(ShouldZeroFill should_zero_fill)
 {
     ScopedSpinLock lock(s_mm_lock);
@@ -417,16 +551,12 @@ RefPtr<PhysicalPage> MemoryManager::allocate_user_physical_page(ShouldZeroFill s
     if (!page) {
         // We didn't have a single free physical page. Let's try to free something up!
         // First, we look for a purgeable VMObject in the volatile state.
-        for_each_vmobject_of_type<PurgeableVMObject>([&](auto& vmobject) {
-            int purged_page_count = vmobject.purge_with_interrupts_disabled({});
-            if (purged_page_count) {
-                klog() << "MM: Purge saved the day! Purged " << purged_page_count << " pages from PurgeableVMObject{" << &vmobject << "}";
-                page = find_free_user_physical_page();
-                ASSERT(page);
-                return IterationDecision::Break;
-            }
-            return IterationDecision::Continue;
-        });
+        int purged_page_count = purge_volatile_vmobjects(1);
+        if (purged_page_count) {
+            klog() << "MM: Purge saved the day! Purged " << purged_page_count << " pages from volatile PurgeableVMObjects";
+            page = find_free_user_physical_page();
+            ASSERT(page);
+        }
 
         if (!page) {
             klog() << "MM: no user physical pages available";
@@ -445,6 +575,12 @@ RefPtr<PhysicalPage> MemoryManager::allocate_user_physical_page(ShouldZeroFill s
     }
 
     ++m_user_physical_pages_used;
+
+    // Don't wait until we've run out completely. Userspace has been told about
+    // the pressure by now, but volatile memory is fair game right away.
+    if (update_memory_pressure() && m_memory_pressure == MemoryPressure::Critical)
+        purge_volatile_vmobjects(low_memory_watermark());
+
     return page;
 }
 
@@ -543,12 +679,56 @@ void MemoryManager::flush_tlb_local(VirtualAddress vaddr, size_t page_count)
     Processor::flush_tlb_local(vaddr, page_count);
 }
 
-void MemoryManager::flush_tlb(VirtualAddress vaddr, size_t page_count)
+void MemoryManager::flush_tlb(const PageDirectory* page_directory, VirtualAddress vaddr, size_t page_count)
 {
 #ifdef MM_DEBUG
     dbg() << "MM: Flush " << page_count << " pages at " << vaddr;
 #endif
-    Processor::flush_tlb(vaddr, page_count);
+    auto* current_thread = Thread::current();
+    if (page_directory && current_thread) {
+        auto* batch = current_thread->tlb_flush_batch();
+        if (batch && &batch->page_directory() == page_directory) {
+            Processor::flush_tlb_local(vaddr, page_count);
+            batch->add(vaddr, page_count);
+            return;
+        }
+    }
+    Processor::flush_tlb(page_directory, vaddr, page_count);
+}
+
+TLBFlushBatch::TLBFlushBatch(PageDirectory& page_directory)
+    : m_page_directory(page_directory)
+{
+    auto* current_thread = Thread::current();
+    ASSERT(current_thread);
+    m_previous_batch = current_thread->tlb_flush_batch();
+    current_thread->set_tlb_flush_batch(this);
+}
+
+TLBFlushBatch::~TLBFlushBatch()
+{
+    Thread::current()->set_tlb_flush_batch(m_previous_batch);
+    if (m_end <= m_start)
+        return;
+    // Every flush was already done locally as it was added, but we may have
+    // migrated since. Switching between threads of the same process doesn't
+    // reload CR3, so the processor we're on now may still have stale entries.
+    // Stay put so that the local flush and the broadcast cover every processor.
+    ScopedCritical critical;
+    Processor::flush_tlb(&m_page_directory, m_start, (m_end.get() - m_start.get()) / PAGE_SIZE);
+}
+
+void TLBFlushBatch::add(VirtualAddress vaddr, size_t page_count)
+{
+    auto end = vaddr.offset(page_count * PAGE_SIZE);
+    if (m_end <= m_start) {
+        m_start = vaddr;
+        m_end = end;
+    } else {
+        m_start = min(m_start, vaddr);
+        m_end = max(m_end, end);
+    }
+    Processor::did_batch_tlb_flush();
 }
 
 extern "C" PageTableEntry boot_pd3_pt1023[1024];
@@ -687,7 +867,10 @@ bool MemoryManager::can_read_without_faulting(const Process& process, VirtualAdd
     // FIXME: Use the size argument!
     UNUSED_PARAM(size);
     ScopedSpinLock lock(s_mm_lock);
-    auto* pte = const_cast<MemoryManager*>(this)->pte(process.page_directory(), vaddr);
+    auto& page_directory = const_cast<PageDirectory&>(process.page_directory());
+    if (const_cast<MemoryManager*>(this)->page_directory_entry(page_directory, vaddr).is_huge())
+        return true;
+    auto* pte = const_cast<MemoryManager*>(this)->pte(page_directory, vaddr);
     if (!pte)
         return false;
     return pte->is_present();
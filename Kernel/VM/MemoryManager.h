@@ -26,12 +26,15 @@
 
 #pragma once
 
+#include <AK/Badge.h>
 #include <AK/HashTable.h>
+#include <AK/InlineLinkedList.h>
 #include <AK/NonnullRefPtrVector.h>
 #include <AK/String.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Forward.h>
 #include <Kernel/SpinLock.h>
+#include <Kernel/UnixTypes.h>
 #include <Kernel/VM/PhysicalPage.h>
 #include <Kernel/VM/Region.h>
 #include <Kernel/VM/VMObject.h>
@@ -81,6 +84,9 @@ class MemoryManager {
     friend class PhysicalRegion;
     friend class Region;
     friend class VMObject;
+    friend class TLBFlushBatch;
+    friend class TmpFSInode;
+    friend class CompressedSwap;
     friend Optional<KBuffer> procfs$mm(InodeIdentifier);
     friend Optional<KBuffer> procfs$memstat(InodeIdentifier);
 
@@ -129,6 +135,18 @@ public:
     unsigned user_physical_pages_used() const { return m_user_physical_pages_used; }
     unsigned super_physical_pages() const { return m_super_physical_pages; }
     unsigned super_physical_pages_used() const { return m_super_physical_pages_used; }
+    unsigned large_pages_mapped() const { return m_large_pages_mapped; }
+
+    enum class MemoryPressure : u32 {
+        Normal = MEMORY_PRESSURE_NORMAL,
+        Low = MEMORY_PRESSURE_LOW,
+        Critical = MEMORY_PRESSURE_CRITICAL,
+    };
+
+    MemoryPressure memory_pressure() const { return m_memory_pressure; }
+
+    void register_memory_pressure_watcher(Badge<MemoryPressureWatcher>, MemoryPressureWatcher&);
+    void unregister_memory_pressure_watcher(Badge<MemoryPressureWatcher>, MemoryPressureWatcher&);
 
     template<typename Callback>
     static void for_each_vmobject(Callback callback)
@@ -179,7 +197,7 @@ private:
     void protect_kernel_image();
     void parse_memory_map();
     static void flush_tlb_local(VirtualAddress, size_t page_count = 1);
-    static void flush_tlb(VirtualAddress, size_t page_count = 1);
+    static void flush_tlb(const PageDirectory*, VirtualAddress, size_t page_count = 1);
 
     static Region* user_region_from_vaddr(Process&, VirtualAddress);
     static Region* kernel_region_from_vaddr(VirtualAddress);
@@ -187,14 +205,24 @@ private:
     static Region* region_from_vaddr(VirtualAddress);
 
     RefPtr<PhysicalPage> find_free_user_physical_page();
+    int purge_volatile_vmobjects(unsigned target_free_pages);
+
+    // Free user page counts below which we consider memory to be tight.
+    unsigned low_memory_watermark() const { return m_user_physical_pages / 8; }
+    unsigned critical_memory_watermark() const { return m_user_physical_pages / 32; }
+    bool update_memory_pressure();
     u8* quickmap_page(PhysicalPage&);
     void unquickmap_page();
 
     PageDirectoryEntry* quickmap_pd(PageDirectory&, size_t pdpt_index);
     PageTableEntry* quickmap_pt(PhysicalAddress);
 
-    const PageTableEntry* pte(const PageDirectory&, VirtualAddress);
+    PageTableEntry* pte(PageDirectory&, VirtualAddress);
     PageTableEntry& ensure_pte(PageDirectory&, VirtualAddress);
+    PageDirectoryEntry& page_directory_entry(PageDirectory&, VirtualAddress);
+
+    void map_large_page(PageDirectory&, VirtualAddress, PhysicalAddress, bool writable, bool user_allowed, bool executable, bool cacheable);
+    bool unmap_large_page(PageDirectory&, VirtualAddress);
 
     RefPtr<PageDirectory> m_kernel_page_directory;
     RefPtr<PhysicalPage> m_low_page_table;
@@ -205,6 +233,10 @@ private:
     unsigned m_user_physical_pages_used { 0 };
     unsigned m_super_physical_pages { 0 };
     unsigned m_super_physical_pages_used { 0 };
+    unsigned m_large_pages_mapped { 0 };
+
+    MemoryPressure m_memory_pressure { MemoryPressure::Normal };
+    InlineLinkedList<MemoryPressureWatcher> m_memory_pressure_watchers;
 
     NonnullRefPtrVector<PhysicalRegion> m_user_physical_regions;
     NonnullRefPtrVector<PhysicalRegion> m_super_physical_regions;
@@ -217,6 +249,30 @@ private:
     RefPtr<PhysicalPage> m_low_pseudo_identity_mapping_pages[4];
 };
 
+// Collects the TLB invalidations that a multi-region operation (like fork or
+// splitting a region) makes in one address space, so that other processors
+// get interrupted once at the end instead of once per region. The current
+// processor is still flushed immediately.
+// NOTE: Pages must not be freed while a batch is open, since other processors
+//       may still be using stale translations to them.
+class TLBFlushBatch {
+    AK_MAKE_NONCOPYABLE(TLBFlushBatch);
+    AK_MAKE_NONMOVABLE(TLBFlushBatch);
+
+public:
+    explicit TLBFlushBatch(PageDirectory&);
+    ~TLBFlushBatch();
+
+    const PageDirectory& page_directory() const { return m_page_directory; }
+    void add(VirtualAddress, size_t page_count);
+
+private:
+    PageDirectory& m_page_directory;
+    TLBFlushBatch* m_previous_batch { nullptr };
+    VirtualAddress m_start;
+    VirtualAddress m_end;
+};
+
 template<typename Callback>
 void VMObject::for_each_region(Callback callback)
 {
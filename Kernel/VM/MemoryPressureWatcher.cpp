@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/Memory.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <Kernel/VM/MemoryPressureWatcher.h>
+#include <LibC/errno_numbers.h>
+
+namespace Kernel {
+
+NonnullRefPtr<MemoryPressureWatcher> MemoryPressureWatcher::create()
+{
+    return adopt(*new MemoryPressureWatcher);
+}
+
+MemoryPressureWatcher::MemoryPressureWatcher()
+{
+    MM.register_memory_pressure_watcher({}, *this);
+}
+
+MemoryPressureWatcher::~MemoryPressureWatcher()
+{
+    MM.unregister_memory_pressure_watcher({}, *this);
+}
+
+bool MemoryPressureWatcher::can_read(const FileDescription&, size_t) const
+{
+    return m_pending.load(AK::MemoryOrder::memory_order_acquire);
+}
+
+bool MemoryPressureWatcher::can_write(const FileDescription&, size_t) const
+{
+    return true;
+}
+
+ssize_t MemoryPressureWatcher::read(FileDescription&, size_t, u8* buffer, ssize_t buffer_size)
+{
+    if (buffer_size < (ssize_t)sizeof(u32))
+        return -EINVAL;
+    // Clear the flag before sampling the level, so that a change racing with us
+    // makes us readable again instead of getting lost.
+    m_pending.store(false, AK::MemoryOrder::memory_order_release);
+    u32 pressure = (u32)MM.memory_pressure();
+    memcpy(buffer, &pressure, sizeof(pressure));
+    return sizeof(pressure);
+}
+
+ssize_t MemoryPressureWatcher::write(FileDescription&, size_t, const u8*, ssize_t)
+{
+    return -EIO;
+}
+
+String MemoryPressureWatcher::absolute_path(const FileDescription&) const
+{
+    return "MemoryPressureWatcher";
+}
+
+void MemoryPressureWatcher::notify_memory_pressure_changed(Badge<MemoryManager>)
+{
+    m_pending.store(true, AK::MemoryOrder::memory_order_release);
+    did_change_readiness();
+}
+
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2020, The SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Badge.h>
+#include <AK/InlineLinkedList.h>
+#include <Kernel/FileSystem/File.h>
+
+namespace Kernel {
+
+// Readable whenever MM's memory pressure level has changed since the last read,
+// which returns the current level as a u32 (one of the MEMORY_PRESSURE_* values).
+class MemoryPressureWatcher final : public File
+    , public InlineLinkedListNode<MemoryPressureWatcher> {
+    friend class InlineLinkedListNode<MemoryPressureWatcher>;
+
+public:
+    static NonnullRefPtr<MemoryPressureWatcher> create();
+    virtual ~MemoryPressureWatcher() override;
+
+    virtual bool can_read(const FileDescription&, size_t) const override;
+    virtual bool can_write(const FileDescription&, size_t) const override;
+    virtual ssize_t read(FileDescription&, size_t, u8*, ssize_t) override;
+    virtual ssize_t write(FileDescription&, size_t, const u8*, ssize_t) override;
+    virtual String absolute_path(const FileDescription&) const override;
+    virtual const char* class_name() const override { return "MemoryPressureWatcher"; };
+
+    void notify_memory_pressure_changed(Badge<MemoryManager>);
+
+private:
+    MemoryPressureWatcher();
+
+    // Start out pending, so that new watchers learn the current level right away.
+    Atomic<bool> m_pending { true };
+
+    // For InlineLinkedList
+    MemoryPressureWatcher* m_prev { nullptr };
+    MemoryPressureWatcher* m_next { nullptr };
+};
+
+}
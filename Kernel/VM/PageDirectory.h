@@ -66,6 +66,7 @@ private:
     RangeAllocator m_identity_range_allocator;
     RefPtr<PhysicalPage> m_directory_table;
     RefPtr<PhysicalPage> m_directory_pages[4];
+    // Page tables, keyed by the 2 MiB chunk of address space they map (vaddr >> 21).
     HashMap<unsigned, RefPtr<PhysicalPage>> m_physical_pages;
 };
 
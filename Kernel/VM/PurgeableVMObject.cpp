@@ -24,12 +24,15 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/Atomic.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/PhysicalPage.h>
 #include <Kernel/VM/PurgeableVMObject.h>
 
 namespace Kernel {
 
+static Atomic<u32> s_last_used_clock;
+
 NonnullRefPtr<PurgeableVMObject> PurgeableVMObject::create_with_size(size_t size)
 {
     return adopt(*new PurgeableVMObject(size));
@@ -54,6 +57,12 @@ NonnullRefPtr<VMObject> PurgeableVMObject::clone()
     return adopt(*new PurgeableVMObject(*this));
 }
 
+void PurgeableVMObject::set_volatile(bool b)
+{
+    m_volatile = b;
+    m_last_used = s_last_used_clock.fetch_add(1, AK::MemoryOrder::memory_order_relaxed) + 1;
+}
+
 int PurgeableVMObject::purge()
 {
     LOCKER(m_paging_lock);
@@ -44,7 +44,11 @@ public:
     void set_was_purged(bool b) { m_was_purged = b; }
 
     bool is_volatile() const { return m_volatile; }
-    void set_volatile(bool b) { m_volatile = b; }
+    void set_volatile(bool);
+
+    // A logical timestamp of the last time userspace changed our volatility,
+    // which is the last time we know the contents were in use.
+    u32 last_used() const { return m_last_used; }
 
 private:
     explicit PurgeableVMObject(size_t);
@@ -62,6 +66,7 @@ private:
 
     bool m_was_purged { false };
     bool m_volatile { false };
+    u32 m_last_used { 0 };
 };
 
 template<>
@@ -92,6 +92,7 @@ NonnullOwnPtr<Region> Region::clone()
         auto region = Region::create_user_accessible(m_range, m_vmobject, m_offset_in_vmobject, m_name, m_access);
         region->set_mmap(m_mmap);
         region->set_shared(m_shared);
+        region->set_large_pages(m_large_pages);
         return region;
     }
 
@@ -103,7 +104,10 @@ NonnullOwnPtr<Region> Region::clone()
 #endif
     // Set up a COW region. The parent (this) region becomes COW as well!
     ensure_cow_map().fill(true);
-    remap();
+    if (m_large_pages)
+        remap();
+    else
+        write_protect_mapped_pages();
     auto clone_region = Region::create_user_accessible(m_range, m_vmobject->clone(), m_offset_in_vmobject, m_name, m_access);
     clone_region->ensure_cow_map();
     if (m_stack) {
@@ -126,11 +130,11 @@ bool Region::commit()
         if (!commit(i)) {
             // Flush what we did commit
             if (i > 0)
-                MM.flush_tlb(vaddr(), i + 1);
+                MM.flush_tlb(m_page_directory.ptr(), vaddr(), i + 1);
             return false;
         }
     }
-    MM.flush_tlb(vaddr(), page_count());
+    MM.flush_tlb(m_page_directory.ptr(), vaddr(), page_count());
     return true;
 }
 
@@ -228,9 +232,45 @@ Bitmap& Region::ensure_cow_map() const
     return *m_cow_map;
 }
 
+bool Region::map_large_page_if_possible(size_t page_index)
+{
+    constexpr size_t pages_per_large_page = LARGE_PAGE_SIZE / PAGE_SIZE;
+    auto page_vaddr = vaddr_from_page_index(page_index);
+    ASSERT(!(page_vaddr.get() % LARGE_PAGE_SIZE));
+    ASSERT(page_index + pages_per_large_page <= page_count());
+
+    bool eligible = is_readable() || is_writable();
+    auto* first_page = physical_page(page_index);
+    if (!first_page || first_page->paddr().get() % LARGE_PAGE_SIZE)
+        eligible = false;
+    for (size_t i = 0; eligible && i < pages_per_large_page; ++i) {
+        auto* page = physical_page(page_index + i);
+        if (!page || page->paddr() != first_page->paddr().offset(i * PAGE_SIZE) || should_cow(page_index + i))
+            eligible = false;
+    }
+
+    if (!eligible) {
+        MM.unmap_large_page(*m_page_directory, page_vaddr);
+        return false;
+    }
+
+    MM.map_large_page(*m_page_directory, page_vaddr, first_page->paddr(), is_writable(), is_user_accessible(), is_executable(), m_cacheable);
+    return true;
+}
+
 void Region::map_individual_page_impl(size_t page_index)
 {
     auto page_vaddr = vaddr_from_page_index(page_index);
+    if (m_large_pages) {
+        // A page-granular change inside a large page splits it back into individual pages.
+        auto large_page_vaddr = VirtualAddress(page_vaddr.get() & ~(LARGE_PAGE_SIZE - 1));
+        if (MM.unmap_large_page(*m_page_directory, large_page_vaddr)) {
+            auto first_page_index = page_index_from_address(large_page_vaddr);
+            for (size_t i = 0; i < LARGE_PAGE_SIZE / PAGE_SIZE; ++i)
+                map_individual_page_impl(first_page_index + i);
+            return;
+        }
+    }
     auto& pte = MM.ensure_pte(*m_page_directory, page_vaddr);
     auto* page = physical_page(page_index);
     if (!page || (!is_readable() && !is_writable())) {
@@ -259,23 +299,100 @@ void Region::remap_page(size_t page_index, bool with_flush)
     ASSERT(physical_page(page_index));
     map_individual_page_impl(page_index);
     if (with_flush)
-        MM.flush_tlb(vaddr_from_page_index(page_index));
+        MM.flush_tlb(m_page_directory.ptr(), vaddr_from_page_index(page_index));
+}
+
+bool Region::test_and_clear_accessed(size_t page_index)
+{
+    ASSERT(s_mm_lock.own_lock());
+    if (!m_page_directory)
+        return false;
+    // Large pages only tell us about 2 MiB at a time (we use PAE), so consider them all hot.
+    if (m_large_pages)
+        return true;
+    auto* pte = MM.pte(*m_page_directory, vaddr_from_page_index(page_index));
+    if (!pte || !pte->is_present() || !pte->is_accessed())
+        return false;
+    // NOTE: We don't flush the TLB here. A stale entry may keep the CPU from setting
+    //       the bit again, but that only makes the page look colder than it is.
+    pte->set_accessed(false);
+    return true;
+}
+
+void Region::unmap_page(size_t page_index)
+{
+    ScopedSpinLock lock(s_mm_lock);
+    ASSERT(!physical_page(page_index));
+    ASSERT(!m_large_pages);
+    if (!m_page_directory)
+        return;
+    auto* pte = MM.pte(*m_page_directory, vaddr_from_page_index(page_index));
+    if (!pte)
+        return;
+    pte->clear();
+    MM.flush_tlb(m_page_directory.ptr(), vaddr_from_page_index(page_index));
+}
+
+size_t Region::page_count_to_next_page_table(size_t page_index) const
+{
+    auto vaddr = vaddr_from_page_index(page_index);
+    return (LARGE_PAGE_SIZE - (vaddr.get() % LARGE_PAGE_SIZE)) / PAGE_SIZE;
+}
+
+void Region::write_protect_mapped_pages()
+{
+    ScopedSpinLock lock(s_mm_lock);
+    ASSERT(m_page_directory);
+    if (!is_writable())
+        return;
+    // Pages that were never faulted in have nothing to protect, they pick up the COW state when they are.
+    for (size_t i = 0; i < page_count();) {
+        auto* pte = MM.pte(*m_page_directory, vaddr_from_page_index(i));
+        if (!pte) {
+            i += page_count_to_next_page_table(i);
+            continue;
+        }
+        if (pte->is_present())
+            pte->set_writable(false);
+        ++i;
+    }
+    MM.flush_tlb(m_page_directory.ptr(), vaddr(), page_count());
+}
+
+void Region::map_on_demand(PageDirectory& page_directory)
+{
+    ScopedSpinLock lock(s_mm_lock);
+    if (m_large_pages) {
+        map(page_directory);
+        return;
+    }
+    set_page_directory(page_directory);
 }
 
 void Region::unmap(ShouldDeallocateVirtualMemoryRange deallocate_range)
 {
     ScopedSpinLock lock(s_mm_lock);
     ASSERT(m_page_directory);
-    for (size_t i = 0; i < page_count(); ++i) {
+    for (size_t i = 0; i < page_count();) {
         auto vaddr = vaddr_from_page_index(i);
-        auto& pte = MM.ensure_pte(*m_page_directory, vaddr);
-        pte.clear();
+        if (m_large_pages && MM.unmap_large_page(*m_page_directory, vaddr)) {
+            i += LARGE_PAGE_SIZE / PAGE_SIZE;
+            continue;
+        }
+        auto* pte = MM.pte(*m_page_directory, vaddr);
+        if (!pte) {
+            // Nothing was ever mapped through this page table, don't allocate one just to clear it.
+            i += page_count_to_next_page_table(i);
+            continue;
+        }
+        pte->clear();
 #ifdef MM_DEBUG
         auto* page = physical_page(i);
         dbg() << "MM: >> Unmapped " << vaddr << " => P" << String::format("%p", page ? page->paddr().get() : 0) << " <<";
 #endif
+        ++i;
     }
-    MM.flush_tlb(vaddr(), page_count());
+    MM.flush_tlb(m_page_directory.ptr(), vaddr(), page_count());
     if (deallocate_range == ShouldDeallocateVirtualMemoryRange::Yes) {
         if (m_page_directory->range_allocator().contains(range()))
             m_page_directory->range_allocator().deallocate(range());
@@ -299,9 +416,17 @@ void Region::map(PageDirectory& page_directory)
 #ifdef MM_DEBUG
     dbg() << "MM: Region::map() will map VMO pages " << first_page_index() << " - " << last_page_index() << " (VMO page count: " << vmobject().page_count() << ")";
 #endif
-    for (size_t page_index = 0; page_index < page_count(); ++page_index)
+    for (size_t page_index = 0; page_index < page_count();) {
+        auto page_vaddr = vaddr_from_page_index(page_index);
+        bool large_page_fits = !(page_vaddr.get() % LARGE_PAGE_SIZE) && page_index + LARGE_PAGE_SIZE / PAGE_SIZE <= page_count();
+        if (m_large_pages && large_page_fits && map_large_page_if_possible(page_index)) {
+            page_index += LARGE_PAGE_SIZE / PAGE_SIZE;
+            continue;
+        }
         map_individual_page_impl(page_index);
-    MM.flush_tlb(vaddr(), page_count());
+        ++page_index;
+    }
+    MM.flush_tlb(m_page_directory.ptr(), vaddr(), page_count());
 }
 
 void Region::remap()
@@ -322,12 +447,27 @@ PageFaultResponse Region::handle_fault(const PageFault& fault)
             dbg() << "NP(non-writable) write fault in Region{" << this << "}[" << page_index_in_region << "] at " << fault.vaddr();
             return PageFaultResponse::ShouldCrash;
         }
+        if (!vmobject().is_inode() && physical_page(page_index_in_region)) {
+            // Regions cloned by fork() are mapped on first access. A write to a COW page
+            // will fault again as a protection violation and get its own copy then.
+#ifdef PAGE_FAULT_DEBUG
+            dbg() << "NP(deferred) fault in Region{" << this << "}[" << page_index_in_region << "]";
+#endif
+            remap_page(page_index_in_region);
+            return PageFaultResponse::Continue;
+        }
         if (vmobject().is_inode()) {
 #ifdef PAGE_FAULT_DEBUG
             dbg() << "NP(inode) fault in Region{" << this << "}[" << page_index_in_region << "]";
 #endif
             return handle_inode_fault(page_index_in_region);
         }
+        if (vmobject().is_anonymous() && static_cast<AnonymousVMObject&>(vmobject()).is_page_swapped_out(first_page_index() + page_index_in_region)) {
+#ifdef PAGE_FAULT_DEBUG
+            dbg() << "NP(swap) fault in Region{" << this << "}[" << page_index_in_region << "]";
+#endif
+            return handle_swap_fault(page_index_in_region);
+        }
 #ifdef MAP_SHARED_ZERO_PAGE_LAZILY
         if (fault.is_read()) {
             physical_page_slot(page_index_in_region) = MM.shared_zero_page();
@@ -394,14 +534,52 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region)
     return PageFaultResponse::Continue;
 }
 
+PageFaultResponse Region::handle_swap_fault(size_t page_index_in_region)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    auto& vmobject = static_cast<AnonymousVMObject&>(this->vmobject());
+
+    sti();
+    LOCKER(vmobject.m_paging_lock);
+    cli();
+
+    auto& page_slot = physical_page_slot(page_index_in_region);
+    if (!page_slot.is_null()) {
+#ifdef PAGE_FAULT_DEBUG
+        dbg() << "MM: swap_page() but page already present. Fine with me!";
+#endif
+        remap_page(page_index_in_region);
+        return PageFaultResponse::Continue;
+    }
+
+    auto page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No);
+    if (page.is_null()) {
+        klog() << "MM: handle_swap_fault was unable to allocate a physical page";
+        return PageFaultResponse::OutOfMemory;
+    }
+
+    vmobject.swap_in_page({}, first_page_index() + page_index_in_region, *page);
+    page_slot = move(page);
+    // Whatever we may have shared this page with before, this copy is ours alone now.
+    if (!m_shared && m_cow_map)
+        set_should_cow(page_index_in_region, false);
+    remap_page(page_index_in_region);
+    return PageFaultResponse::Continue;
+}
+
 PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
 {
     ASSERT_INTERRUPTS_DISABLED();
     auto& page_slot = physical_page_slot(page_index_in_region);
+    auto mark_page_dirty_if_inode_backed = [&] {
+        if (vmobject().is_inode())
+            static_cast<InodeVMObject&>(vmobject()).set_page_dirty(first_page_index() + page_index_in_region);
+    };
     if (page_slot->ref_count() == 1) {
 #ifdef PAGE_FAULT_DEBUG
         dbg() << "    >> It's a COW page but nobody is sharing it anymore. Remap r/w";
 #endif
+        mark_page_dirty_if_inode_backed();
         set_should_cow(page_index_in_region, false);
         remap_page(page_index_in_region);
         return PageFaultResponse::Continue;
@@ -428,11 +606,46 @@ PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
     copy_from_user(dest_ptr, src_ptr, PAGE_SIZE);
     page_slot = move(page);
     MM.unquickmap_page();
+    mark_page_dirty_if_inode_backed();
     set_should_cow(page_index_in_region, false);
     remap_page(page_index_in_region);
     return PageFaultResponse::Continue;
 }
 
+PageFaultResponse Region::page_in_from_inode(Inode& inode, size_t page_index_in_vmobject, RefPtr<PhysicalPage>& physical_page_entry)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    auto current_thread = Thread::current();
+    if (current_thread)
+        current_thread->did_inode_fault();
+
+#ifdef MM_DEBUG
+    dbg() << "MM: page_in_from_inode ready to read from inode";
+#endif
+    sti();
+    u8 page_buffer[PAGE_SIZE];
+    auto nread = inode.read_bytes(page_index_in_vmobject * PAGE_SIZE, PAGE_SIZE, page_buffer, nullptr);
+    if (nread < 0) {
+        klog() << "MM: handle_inode_fault had error (" << nread << ") while reading!";
+        return PageFaultResponse::ShouldCrash;
+    }
+    if (nread < PAGE_SIZE) {
+        // If we read less than a page, zero out the rest to avoid leaking uninitialized data.
+        memset(page_buffer + nread, 0, PAGE_SIZE - nread);
+    }
+    cli();
+    physical_page_entry = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No);
+    if (physical_page_entry.is_null()) {
+        klog() << "MM: handle_inode_fault was unable to allocate a physical page";
+        return PageFaultResponse::OutOfMemory;
+    }
+
+    u8* dest_ptr = MM.quickmap_page(*physical_page_entry);
+    memcpy(dest_ptr, page_buffer, PAGE_SIZE);
+    MM.unquickmap_page();
+    return PageFaultResponse::Continue;
+}
+
 PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
 {
     ASSERT_INTERRUPTS_DISABLED();
@@ -443,7 +656,8 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
     cli();
 
     auto& inode_vmobject = static_cast<InodeVMObject&>(vmobject());
-    auto& vmobject_physical_page_entry = inode_vmobject.physical_pages()[first_page_index() + page_index_in_region];
+    auto page_index_in_vmobject = first_page_index() + page_index_in_region;
+    auto& vmobject_physical_page_entry = inode_vmobject.physical_pages()[page_index_in_vmobject];
 
 #ifdef PAGE_FAULT_DEBUG
     dbg() << "Inode fault in " << name() << " page index: " << page_index_in_region;
@@ -457,36 +671,53 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
         return PageFaultResponse::Continue;
     }
 
-    auto current_thread = Thread::current();
-    if (current_thread)
-        current_thread->did_inode_fault();
+    auto& inode = inode_vmobject.inode();
 
-#ifdef MM_DEBUG
-    dbg() << "MM: page_in_from_inode ready to read from inode";
-#endif
     sti();
-    u8 page_buffer[PAGE_SIZE];
-    auto& inode = inode_vmobject.inode();
-    auto nread = inode.read_bytes((first_page_index() + page_index_in_region) * PAGE_SIZE, PAGE_SIZE, page_buffer, nullptr);
-    if (nread < 0) {
-        klog() << "MM: handle_inode_fault had error (" << nread << ") while reading!";
-        return PageFaultResponse::ShouldCrash;
-    }
-    if (nread < PAGE_SIZE) {
-        // If we read less than a page, zero out the rest to avoid leaking uninitialized data.
-        memset(page_buffer + nread, 0, PAGE_SIZE - nread);
-    }
+    auto inode_page_or_error = inode.physical_page_for_mapping(page_index_in_vmobject);
     cli();
-    vmobject_physical_page_entry = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No);
-    if (vmobject_physical_page_entry.is_null()) {
-        klog() << "MM: handle_inode_fault was unable to allocate a physical page";
+    if (inode_page_or_error.is_error()) {
+        klog() << "MM: handle_inode_fault was unable to get a page from the inode (" << inode_page_or_error.error() << ")";
         return PageFaultResponse::OutOfMemory;
     }
+    auto inode_page = inode_page_or_error.value();
+    if (inode_page) {
+        // The page is the file's own storage. Shared mappings write straight through to it,
+        // private ones get a copy once they write.
+        vmobject_physical_page_entry = move(inode_page);
+        if (inode_vmobject.is_private_inode())
+            set_should_cow(page_index_in_region, true);
+        remap_page(page_index_in_region);
+        return PageFaultResponse::Continue;
+    }
 
-    u8* dest_ptr = MM.quickmap_page(*vmobject_physical_page_entry);
-    memcpy(dest_ptr, page_buffer, PAGE_SIZE);
-    MM.unquickmap_page();
+    // A private mapping borrows clean pages from the inode's page cache if it has one,
+    // and only gets a page of its own once it writes to it.
+    RefPtr<SharedInodeVMObject> shared_vmobject = inode.shared_vmobject();
+    if (!m_shared && inode_vmobject.is_private_inode() && shared_vmobject && page_index_in_vmobject < shared_vmobject->page_count()) {
+        sti();
+        LOCKER(shared_vmobject->m_paging_lock);
+        cli();
+        auto& shared_physical_page_entry = shared_vmobject->physical_pages()[page_index_in_vmobject];
+        if (shared_physical_page_entry.is_null()) {
+            auto response = page_in_from_inode(inode, page_index_in_vmobject, shared_physical_page_entry);
+            if (response != PageFaultResponse::Continue)
+                return response;
+        }
+        vmobject_physical_page_entry = shared_physical_page_entry;
+        set_should_cow(page_index_in_region, true);
+        remap_page(page_index_in_region);
+        return PageFaultResponse::Continue;
+    }
+
+    auto response = page_in_from_inode(inode, page_index_in_vmobject, vmobject_physical_page_entry);
+    if (response != PageFaultResponse::Continue)
+        return response;
 
+    // Even a page nobody else has must not be written to before it's marked dirty,
+    // or purging clean pages would throw away the private changes.
+    if (inode_vmobject.is_private_inode())
+        set_should_cow(page_index_in_region, true);
     remap_page(page_index_in_region);
     return PageFaultResponse::Continue;
 }
@@ -99,6 +99,9 @@ public:
     bool is_kernel() const { return m_kernel || vaddr().get() >= 0xc0000000; }
     void set_kernel(bool kernel) { m_kernel = kernel; }
 
+    bool is_using_large_pages() const { return m_large_pages; }
+    void set_large_pages(bool large_pages) { m_large_pages = large_pages; }
+
     PageFaultResponse handle_fault(const PageFault&);
 
     NonnullOwnPtr<Region> clone();
@@ -172,6 +175,7 @@ public:
 
     void set_page_directory(PageDirectory&);
     void map(PageDirectory&);
+    void map_on_demand(PageDirectory&);
     enum class ShouldDeallocateVirtualMemoryRange {
         No,
         Yes,
@@ -180,6 +184,10 @@ public:
 
     void remap();
 
+    // Used by the compressed swap to find and evict cold pages.
+    bool test_and_clear_accessed(size_t page_index);
+    void unmap_page(size_t page_index);
+
     // For InlineLinkedListNode
     Region* m_next { nullptr };
     Region* m_prev { nullptr };
@@ -205,9 +213,14 @@ private:
 
     PageFaultResponse handle_cow_fault(size_t page_index);
     PageFaultResponse handle_inode_fault(size_t page_index);
+    static PageFaultResponse page_in_from_inode(Inode&, size_t page_index_in_vmobject, RefPtr<PhysicalPage>&);
     PageFaultResponse handle_zero_fault(size_t page_index);
+    PageFaultResponse handle_swap_fault(size_t page_index);
 
     void map_individual_page_impl(size_t page_index);
+    void write_protect_mapped_pages();
+    size_t page_count_to_next_page_table(size_t page_index) const;
+    bool map_large_page_if_possible(size_t page_index);
 
     RefPtr<PageDirectory> m_page_directory;
     Range m_range;
@@ -222,6 +235,7 @@ private:
     bool m_stack : 1 { false };
     bool m_mmap : 1 { false };
     bool m_kernel : 1 { false };
+    bool m_large_pages : 1 { false };
     mutable OwnPtr<Bitmap> m_cow_map;
 };
 
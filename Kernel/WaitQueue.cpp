@@ -81,7 +81,7 @@ void WaitQueue::wake_one(Atomic<bool>* lock)
     Scheduler::yield();
 }
 
-void WaitQueue::wake_n(u32 wake_count)
+u32 WaitQueue::wake_n(u32 wake_count)
 {
     ScopedSpinLock queue_lock(m_lock);
     if (m_threads.is_empty()) {
@@ -90,13 +90,14 @@ void WaitQueue::wake_n(u32 wake_count)
 #ifdef WAITQUEUE_DEBUG
         dbg() << "WaitQueue " << VirtualAddress(this) << ": wake_n: nobody to wake, mark as pending";
 #endif
-        return;
+        return 0;
     }
 
 #ifdef WAITQUEUE_DEBUG
     dbg() << "WaitQueue " << VirtualAddress(this) << ": wake_n: " << wake_count;
 #endif
-    for (u32 i = 0; i < wake_count; ++i) {
+    u32 woken_count = 0;
+    for (; woken_count < wake_count; ++woken_count) {
         Thread* thread = m_threads.take_first();
         if (!thread)
             break;
@@ -107,6 +108,7 @@ void WaitQueue::wake_n(u32 wake_count)
     }
     m_wake_requested = false;
     Scheduler::yield();
+    return woken_count;
 }
 
 void WaitQueue::wake_all()
@@ -134,6 +136,44 @@ void WaitQueue::wake_all()
     Scheduler::yield();
 }
 
+u32 WaitQueue::move_to(WaitQueue& other, u32 move_count, const Function<void(Thread&)>& did_move)
+{
+    if (&other == this)
+        return 0;
+    // Always take the two locks in the same order, so that a concurrent
+    // move in the opposite direction can't deadlock against us.
+    auto& first_lock = this < &other ? m_lock : other.m_lock;
+    auto& second_lock = this < &other ? other.m_lock : m_lock;
+    ScopedSpinLock first_queue_lock(first_lock);
+    ScopedSpinLock second_queue_lock(second_lock);
+    u32 moved_count = 0;
+    for (; moved_count < move_count; ++moved_count) {
+        Thread* thread = m_threads.take_first();
+        if (!thread)
+            break;
+#ifdef WAITQUEUE_DEBUG
+        dbg() << "WaitQueue " << VirtualAddress(this) << ": move_to: move thread " << *thread << " to " << VirtualAddress(&other);
+#endif
+        other.m_threads.append(*thread);
+        if (did_move)
+            did_move(*thread);
+    }
+    return moved_count;
+}
+
+void WaitQueue::dequeue(Thread& thread)
+{
+    ScopedSpinLock queue_lock(m_lock);
+    if (m_threads.contains(thread))
+        m_threads.remove(thread);
+}
+
+bool WaitQueue::is_empty()
+{
+    ScopedSpinLock queue_lock(m_lock);
+    return m_threads.is_empty();
+}
+
 void WaitQueue::clear()
 {
     ScopedSpinLock queue_lock(m_lock);
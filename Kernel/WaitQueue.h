@@ -40,10 +40,17 @@ public:
 
     bool enqueue(Thread&);
     void wake_one(Atomic<bool>* lock = nullptr);
-    void wake_n(u32 wake_count);
+    u32 wake_n(u32 wake_count);
     void wake_all();
     void clear();
 
+    // Moves up to move_count sleeping threads to the other queue without waking them.
+    // did_move is called for each of them while both queues are still locked.
+    u32 move_to(WaitQueue&, u32 move_count, const Function<void(Thread&)>& did_move);
+    // Takes a thread that stopped waiting on its own (e.g. it timed out) off the queue.
+    void dequeue(Thread&);
+    bool is_empty();
+
 private:
     typedef IntrusiveList<Thread, &Thread::m_wait_queue_node> ThreadList;
     ThreadList m_threads;
@@ -49,6 +49,7 @@
 #include <Kernel/Devices/VMWareBackdoor.h>
 #include <Kernel/Devices/ZeroDevice.h>
 #include <Kernel/FileSystem/Ext2FileSystem.h>
+#include <Kernel/FileSystem/IORing.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
 #include <Kernel/Heap/SlabAllocator.h>
 #include <Kernel/Heap/kmalloc.h>
@@ -70,6 +71,7 @@
 #include <Kernel/TTY/PTYMultiplexer.h>
 #include <Kernel/TTY/VirtualConsole.h>
 #include <Kernel/Tasks/FinalizerTask.h>
+#include <Kernel/Tasks/SwapTask.h>
 #include <Kernel/Tasks/SyncTask.h>
 #include <Kernel/Time/TimeManagement.h>
 #include <Kernel/VM/MemoryManager.h>
@@ -202,6 +204,10 @@ void init_stage2()
 
     SyncTask::spawn();
     FinalizerTask::spawn();
+    SwapTask::spawn();
+
+    if (kernel_command_line().contains("string_self_test"))
+        run_string_operations_self_test();
 
     PCI::initialize();
 
@@ -237,6 +243,7 @@ void init_stage2()
     LoopbackAdapter::the();
 
     Syscall::initialize();
+    IORing::initialize();
 
     new ZeroDevice;
     new FullDevice;
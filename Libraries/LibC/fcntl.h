@@ -37,6 +37,8 @@ __BEGIN_DECLS
 #define F_GETFL 3
 #define F_SETFL 4
 #define F_ISTTY 5
+#define F_GETPIPE_SZ 8
+#define F_SETPIPE_SZ 9
 
 #define FD_CLOEXEC 1
 
@@ -92,6 +94,8 @@ int openat(int dirfd, const char* path, int options, ...);
 int openat_with_path_length(int dirfd, const char* path, size_t path_length, int options, mode_t);
 
 int fcntl(int fd, int cmd, ...);
+
+// See Kernel/API/InodeWatcherEvent.h for what reading the returned fd yields.
 int watch_file(const char* path, size_t path_length);
 
 #define F_RDLCK 0
@@ -25,6 +25,7 @@
  */
 
 #include <AK/Types.h>
+#include <LibELF/AuxiliaryVector.h>
 #include <assert.h>
 
 extern "C" {
@@ -33,8 +34,35 @@ __thread int errno;
 char** environ;
 bool __environ_is_malloced;
 
+// The default way into the kernel, used unless it offers us a faster one.
+void __syscall_int_entry();
+asm(
+    ".globl __syscall_int_entry\n"
+    "__syscall_int_entry:\n"
+    "    int $0x82\n"
+    "    ret\n");
+
+FlatPtr __syscall_entry = (FlatPtr)__syscall_int_entry;
+
+static void __auxv_init()
+{
+    if (!environ)
+        return;
+
+    // The auxiliary vector follows the environment on the initial stack.
+    char** env = environ;
+    while (*env)
+        ++env;
+    for (auto* auxvp = (auxv_t*)(env + 1); auxvp->a_type != AT_NULL; ++auxvp) {
+        if (auxvp->a_type == AT_SYSINFO)
+            __syscall_entry = (FlatPtr)auxvp->a_un.a_ptr;
+    }
+}
+
 void __libc_init()
 {
+    __auxv_init();
+
     void __malloc_init();
     __malloc_init();
 
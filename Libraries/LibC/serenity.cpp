@@ -44,7 +44,12 @@ int module_unload(const char* name, size_t name_length)
 
 int profiling_enable(pid_t pid)
 {
-    int rc = syscall(SC_profiling_enable, pid);
+    return profiling_enable_with_frequency(pid, 0);
+}
+
+int profiling_enable_with_frequency(pid_t pid, unsigned samples_per_second)
+{
+    int rc = syscall(SC_profiling_enable, pid, samples_per_second);
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
@@ -66,9 +71,13 @@ int set_process_boost(int tid, int amount)
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
-int futex(int32_t* userspace_address, int futex_op, int32_t value, const struct timespec* timeout)
+int futex(int32_t* userspace_address, int futex_op, int32_t value, const struct timespec* timeout, int32_t* userspace_address2, int32_t value3)
 {
-    Syscall::SC_futex_params params { userspace_address, futex_op, value, timeout };
+    Syscall::SC_futex_params params { userspace_address, futex_op, value, timeout, userspace_address2, 0, value3 };
+    if (futex_op == FUTEX_REQUEUE || futex_op == FUTEX_CMP_REQUEUE || futex_op == FUTEX_WAKE_OP) {
+        params.timeout = nullptr;
+        params.val2 = (int32_t)(uintptr_t)timeout;
+    }
     int rc = syscall(SC_futex, &params);
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
@@ -79,6 +88,12 @@ int purge(int mode)
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
+int watch_memory_pressure()
+{
+    int rc = syscall(SC_watch_memory_pressure);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
 int perf_event(int type, uintptr_t arg1, FlatPtr arg2)
 {
     int rc = syscall(SC_perf_event, type, arg1, arg2);
@@ -131,4 +146,23 @@ int get_stack_bounds(uintptr_t* user_stack_base, size_t* user_stack_size)
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
+int io_ring_setup(unsigned entries, size_t* mapping_size)
+{
+    int rc = syscall(SC_io_ring_setup, entries, mapping_size);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int io_ring_enter(int fd, unsigned to_submit, unsigned min_complete)
+{
+    int rc = syscall(SC_io_ring_enter, fd, to_submit, min_complete);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int get_process_statistics(unsigned since_generation, unsigned fields, void* buffer, size_t buffer_size)
+{
+    Syscall::SC_get_process_statistics_params params { since_generation, fields, { buffer, buffer_size } };
+    int rc = syscall(SC_get_process_statistics, &params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
 }
@@ -41,7 +41,11 @@ int shbuf_seal(int shbuf_id);
 int module_load(const char* path, size_t path_length);
 int module_unload(const char* name, size_t name_length);
 
+// Passed as the pid to profile every thread in the system. Requires root.
+#define PROFILE_ALL_PROCESSES -1
+
 int profiling_enable(pid_t);
+int profiling_enable_with_frequency(pid_t, unsigned samples_per_second);
 int profiling_disable(pid_t);
 
 #define THREAD_PRIORITY_MIN 1
@@ -55,14 +59,44 @@ int set_process_boost(pid_t, int amount);
 
 #define FUTEX_WAIT 1
 #define FUTEX_WAKE 2
-
-int futex(int32_t* userspace_address, int futex_op, int32_t value, const struct timespec* timeout);
+#define FUTEX_REQUEUE 3
+#define FUTEX_CMP_REQUEUE 4
+#define FUTEX_WAKE_OP 5
+
+#define FUTEX_OP_SET 0
+#define FUTEX_OP_ADD 1
+#define FUTEX_OP_OR 2
+#define FUTEX_OP_ANDN 3
+#define FUTEX_OP_XOR 4
+#define FUTEX_OP_OPARG_SHIFT 8
+
+#define FUTEX_OP_CMP_EQ 0
+#define FUTEX_OP_CMP_NE 1
+#define FUTEX_OP_CMP_LT 2
+#define FUTEX_OP_CMP_LE 3
+#define FUTEX_OP_CMP_GT 4
+#define FUTEX_OP_CMP_GE 5
+
+#define FUTEX_OP(op, oparg, cmp, cmparg) \
+    ((((op)&0xf) << 28) | (((cmp)&0xf) << 24) | (((oparg)&0xfff) << 12) | ((cmparg)&0xfff))
+
+// For FUTEX_REQUEUE, FUTEX_CMP_REQUEUE and FUTEX_WAKE_OP, the timeout argument carries
+// the second count instead, as on other systems.
+int futex(int32_t* userspace_address, int futex_op, int32_t value, const struct timespec* timeout, int32_t* userspace_address2, int32_t value3);
 
 #define PURGE_ALL_VOLATILE 0x1
 #define PURGE_ALL_CLEAN_INODE 0x2
 
 int purge(int mode);
 
+#define MEMORY_PRESSURE_NORMAL 0
+#define MEMORY_PRESSURE_LOW 1
+#define MEMORY_PRESSURE_CRITICAL 2
+
+// Returns a file descriptor that becomes readable whenever the system's memory
+// pressure level changes. Reading it yields the current level as an unsigned int.
+int watch_memory_pressure();
+
 #define PERF_EVENT_MALLOC 1
 #define PERF_EVENT_FREE 2
 
@@ -70,6 +104,14 @@ int perf_event(int type, uintptr_t arg1, uintptr_t arg2);
 
 int get_stack_bounds(uintptr_t* user_stack_base, size_t* user_stack_size);
 
+// See Kernel/API/IORing.h for the layout of the mapping.
+int io_ring_setup(unsigned entries, size_t* mapping_size);
+int io_ring_enter(int fd, unsigned to_submit, unsigned min_complete);
+
+// See Kernel/API/ProcessStatistics.h for the layout of the buffer.
+// Returns the full size of the statistics, which may be larger than buffer_size.
+int get_process_statistics(unsigned since_generation, unsigned fields, void* buffer, size_t buffer_size);
+
 ALWAYS_INLINE void send_secret_data_to_userspace_emulator(uintptr_t data1, uintptr_t data2, uintptr_t data3)
 {
     asm volatile(
@@ -34,153 +34,125 @@
 
 #include <spawn.h>
 
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <Kernel/API/Syscall.h>
+#include <errno.h>
 #include <fcntl.h>
-#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
-#include <sys/stat.h>
 #include <sys/types.h>
-#include <AK/Function.h>
-#include <AK/Vector.h>
 
 struct posix_spawn_file_actions_state {
-    Vector<Function<int()>, 4> actions;
+    Vector<Syscall::SC_posix_spawn_file_action, 4> actions;
+    // Keeps the paths handed to us alive, the actions point into them.
+    Vector<String, 4> paths;
 };
 
 extern "C" {
 
-[[noreturn]] static void posix_spawn_child(const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[], int (*exec)(const char*, char* const[], char* const[]))
+static int posix_spawn_with_path(pid_t* out_pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[])
 {
+    auto copy_strings = [](char* const list[], Vector<Syscall::StringArgument, 16>& output) {
+        for (size_t i = 0; list && list[i]; ++i)
+            output.append({ list[i], strlen(list[i]) });
+    };
+
+    Vector<Syscall::StringArgument, 16> arguments;
+    Vector<Syscall::StringArgument, 16> environment;
+    copy_strings(argv, arguments);
+    copy_strings(envp, environment);
+
+    Syscall::SC_posix_spawn_params params {};
+    params.path = { path, strlen(path) };
+    params.arguments = { arguments.data(), arguments.size() };
+    params.environment = { environment.data(), environment.size() };
+    if (file_actions) {
+        params.file_actions = file_actions->state->actions.data();
+        params.file_action_count = file_actions->state->actions.size();
+    }
     if (attr) {
-        short flags = attr->flags;
-        if (flags & POSIX_SPAWN_RESETIDS) {
-            if (seteuid(getuid()) < 0) {
-                perror("posix_spawn seteuid");
-                _exit(127);
-            }
-            if (setegid(getgid()) < 0) {
-                perror("posix_spawn setegid");
-                _exit(127);
-            }
-        }
-        if (flags & POSIX_SPAWN_SETPGROUP) {
-            if (setpgid(0, attr->pgroup) < 0) {
-                perror("posix_spawn setpgid");
-                _exit(127);
-            }
-        }
-        if (flags & POSIX_SPAWN_SETSCHEDPARAM) {
-            if (sched_setparam(0, &attr->schedparam) < 0) {
-                perror("posix_spawn sched_setparam");
-                _exit(127);
-            }
-        }
-        if (flags & POSIX_SPAWN_SETSIGDEF) {
-            struct sigaction default_action;
-            default_action.sa_flags = 0;
-            sigemptyset(&default_action.sa_mask);
-            default_action.sa_handler = SIG_DFL;
-
-            sigset_t sigdefault = attr->sigdefault;
-            for (int i = 0; i < NSIG; ++i) {
-                if (sigismember(&sigdefault, i) && sigaction(i, &default_action, nullptr) < 0) {
-                    perror("posix_spawn sigaction");
-                    _exit(127);
-                }
-            }
-        }
-        if (flags & POSIX_SPAWN_SETSIGMASK) {
-            if (sigprocmask(SIG_SETMASK, &attr->sigmask, nullptr) < 0) {
-                perror("posix_spawn sigprocmask");
-                _exit(127);
-            }
-        }
-        if (flags & POSIX_SPAWN_SETSID) {
-            if (setsid() < 0) {
-                perror("posix_spawn setsid");
-                _exit(127);
-            }
-        }
-
         // FIXME: POSIX_SPAWN_SETSCHEDULER
+        params.flags = attr->flags;
+        params.pgroup = attr->pgroup;
+        params.sched_priority = attr->schedparam.sched_priority;
+        params.sigmask = attr->sigmask;
     }
 
-    if (file_actions) {
-        for (const auto& action : file_actions->state->actions) {
-            if (action() < 0) {
-                perror("posix_spawn file action");
-                _exit(127);
-            }
-        }
-    }
-
-    exec(path, argv, envp);
-    perror("posix_spawn exec");
-    _exit(127);
+    int rc = syscall(SC_posix_spawn, &params);
+    if (rc < 0)
+        return -rc;
+    if (out_pid)
+        *out_pid = rc;
+    return 0;
 }
 
 int posix_spawn(pid_t* out_pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[])
 {
-    pid_t child_pid = fork();
-    if (child_pid < 0)
-        return errno;
-
-    if (child_pid != 0) {
-        *out_pid = child_pid;
-        return 0;
-    }
-
-    posix_spawn_child(path, file_actions, attr, argv, envp, execve);
+    return posix_spawn_with_path(out_pid, path, file_actions, attr, argv, envp);
 }
 
 int posix_spawnp(pid_t* out_pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[])
 {
-    pid_t child_pid = fork();
-    if (child_pid < 0)
-        return errno;
-
-    if (child_pid != 0) {
-        *out_pid = child_pid;
-        return 0;
+    if (strchr(path, '/'))
+        return posix_spawn_with_path(out_pid, path, file_actions, attr, argv, envp);
+
+    String search_path = getenv("PATH");
+    if (search_path.is_empty())
+        search_path = "/bin:/usr/bin";
+    for (auto& part : search_path.split(':')) {
+        auto candidate = String::format("%s/%s", part.characters(), path);
+        int rc = posix_spawn_with_path(out_pid, candidate.characters(), file_actions, attr, argv, envp);
+        if (rc != ENOENT)
+            return rc;
     }
+    return ENOENT;
+}
 
-    posix_spawn_child(path, file_actions, attr, argv, envp, execvpe);
+static void append_file_action(posix_spawn_file_actions_t* actions, Syscall::SpawnFileActionType type, int fd, int new_fd = -1, const char* path = nullptr, int options = 0, mode_t mode = 0)
+{
+    Syscall::SC_posix_spawn_file_action action {};
+    action.type = type;
+    action.fd = fd;
+    action.new_fd = new_fd;
+    action.options = options;
+    action.mode = mode;
+    if (path) {
+        actions->state->paths.append(path);
+        auto& stored_path = actions->state->paths.last();
+        action.path = { stored_path.characters(), stored_path.length() };
+    }
+    actions->state->actions.append(action);
 }
 
 int posix_spawn_file_actions_addchdir(posix_spawn_file_actions_t* actions, const char* path)
 {
-    actions->state->actions.append([path]() { return chdir(path); });
+    append_file_action(actions, Syscall::SpawnFileActionType::Chdir, -1, -1, path);
     return 0;
 }
 
 int posix_spawn_file_actions_addfchdir(posix_spawn_file_actions_t* actions, int fd)
 {
-    actions->state->actions.append([fd]() { return fchdir(fd); });
+    append_file_action(actions, Syscall::SpawnFileActionType::Fchdir, fd);
     return 0;
 }
 
 int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t* actions, int fd)
 {
-    actions->state->actions.append([fd]() { return close(fd); });
+    append_file_action(actions, Syscall::SpawnFileActionType::Close, fd);
     return 0;
 }
 
 int posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t* actions, int old_fd, int new_fd)
 {
-    actions->state->actions.append([old_fd, new_fd]() { return dup2(old_fd, new_fd); });
+    append_file_action(actions, Syscall::SpawnFileActionType::Dup2, old_fd, new_fd);
     return 0;
 }
 
 int posix_spawn_file_actions_addopen(posix_spawn_file_actions_t* actions, int want_fd, const char* path, int flags, mode_t mode)
 {
-    actions->state->actions.append([want_fd, path, flags, mode]() {
-        int opened_fd = open(path, flags, mode);
-        if (opened_fd < 0 || opened_fd == want_fd)
-            return opened_fd;
-        if (int rc = dup2(opened_fd, want_fd); rc < 0)
-            return rc;
-        return close(opened_fd);
-    });
+    append_file_action(actions, Syscall::SpawnFileActionType::Open, want_fd, -1, path, flags, mode);
     return 0;
 }
 
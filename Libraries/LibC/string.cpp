@@ -422,6 +422,7 @@ const char* const sys_errlist[] = {
     "No such thread",
     "Protocol error",
     "Not supported",
+    "Operation canceled",
     "The highest errno +1 :^)",
 };
 
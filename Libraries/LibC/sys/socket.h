@@ -85,6 +85,8 @@ struct ucred {
 #define SO_REUSEADDR 6
 #define SO_BINDTODEVICE 7
 #define SO_KEEPALIVE 9
+#define SO_SNDBUF 10
+#define SO_RCVBUF 11
 
 int socket(int domain, int type, int protocol);
 int bind(int sockfd, const struct sockaddr* addr, socklen_t);
@@ -24,88 +24,137 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <AK/JsonArray.h>
-#include <AK/JsonObject.h>
-#include <AK/JsonValue.h>
-#include <LibCore/File.h>
+#include <AK/ByteBuffer.h>
+#include <Kernel/API/ProcessStatistics.h>
 #include <LibCore/ProcessStatisticsReader.h>
 #include <pwd.h>
+#include <serenity.h>
 #include <stdio.h>
+#include <string.h>
 
 namespace Core {
 
 HashMap<uid_t, String> ProcessStatisticsReader::s_usernames;
+HashMap<pid_t, Core::ProcessStatistics> ProcessStatisticsReader::s_previous_statistics;
+u32 ProcessStatisticsReader::s_generation;
 
 HashMap<pid_t, Core::ProcessStatistics> ProcessStatisticsReader::get_all()
 {
-    auto file = Core::File::construct("/proc/all");
-    if (!file->open(Core::IODevice::ReadOnly)) {
-        fprintf(stderr, "ProcessStatisticsReader: Failed to open /proc/all: %s\n", file->error_string());
-        return {};
+    static ByteBuffer buffer;
+    if (buffer.is_empty())
+        buffer = ByteBuffer::create_uninitialized(64 * KB);
+
+    size_t size;
+    for (;;) {
+        int rc = get_process_statistics(s_generation, ProcessStatisticsAll, buffer.data(), buffer.size());
+        if (rc < 0) {
+            perror("ProcessStatisticsReader: get_process_statistics");
+            return {};
+        }
+        size = rc;
+        if (size <= buffer.size())
+            break;
+        buffer = ByteBuffer::create_uninitialized(size + size / 4);
     }
 
+    size_t offset = 0;
+    auto read = [&](auto& value) {
+        ASSERT(offset + sizeof(value) <= size);
+        memcpy(&value, buffer.data() + offset, sizeof(value));
+        offset += sizeof(value);
+    };
+
+    ProcessStatisticsHeader header;
+    read(header);
+    ASSERT(header.version == PROCESS_STATISTICS_VERSION);
+
     HashMap<pid_t, Core::ProcessStatistics> map;
 
-    auto file_contents = file->read_all();
-    auto json = JsonValue::from_string(file_contents);
-    ASSERT(json.has_value());
-    json.value().as_array().for_each([&](auto& value) {
-        const JsonObject& process_object = value.as_object();
+    for (u32 i = 0; i < header.process_count; ++i) {
+        ProcessStatisticsRecord record;
+        read(record);
+
         Core::ProcessStatistics process;
+        process.pid = record.pid;
+        process.nfds = record.nfds;
 
-        // kernel data first
-        process.pid = process_object.get("pid").to_u32();
-        process.pgid = process_object.get("pgid").to_u32();
-        process.pgp = process_object.get("pgp").to_u32();
-        process.sid = process_object.get("sid").to_u32();
-        process.uid = process_object.get("uid").to_u32();
-        process.gid = process_object.get("gid").to_u32();
-        process.ppid = process_object.get("ppid").to_u32();
-        process.nfds = process_object.get("nfds").to_u32();
-        process.name = process_object.get("name").to_string();
-        process.tty = process_object.get("tty").to_string();
-        process.pledge = process_object.get("pledge").to_string();
-        process.veil = process_object.get("veil").to_string();
-        process.amount_virtual = process_object.get("amount_virtual").to_u32();
-        process.amount_resident = process_object.get("amount_resident").to_u32();
-        process.amount_shared = process_object.get("amount_shared").to_u32();
-        process.amount_dirty_private = process_object.get("amount_dirty_private").to_u32();
-        process.amount_clean_inode = process_object.get("amount_clean_inode").to_u32();
-        process.amount_purgeable_volatile = process_object.get("amount_purgeable_volatile").to_u32();
-        process.amount_purgeable_nonvolatile = process_object.get("amount_purgeable_nonvolatile").to_u32();
-        process.icon_id = process_object.get("icon_id").to_int();
-
-        auto& thread_array = process_object.get_ptr("threads")->as_array();
-        process.threads.ensure_capacity(thread_array.size());
-        thread_array.for_each([&](auto& value) {
-            auto& thread_object = value.as_object();
+        if (record.fields & ProcessStatisticsIdentity) {
+            ProcessIdentityRecord identity;
+            read(identity);
+            process.pgid = identity.pgid;
+            process.pgp = identity.pgp;
+            process.sid = identity.sid;
+            process.uid = identity.uid;
+            process.gid = identity.gid;
+            process.ppid = identity.ppid;
+            process.icon_id = identity.icon_id;
+            process.name = identity.name;
+            process.tty = identity.tty;
+            process.pledge = identity.pledge;
+            process.veil = identity.veil;
+            process.username = username_from_uid(process.uid);
+        } else {
+            // The kernel only sends the identity if it changed since our last read.
+            auto it = s_previous_statistics.find(record.pid);
+            if (it == s_previous_statistics.end()) {
+                s_generation = 0;
+                s_previous_statistics.clear();
+                return get_all();
+            }
+            auto& previous = it->value;
+            process.pgid = previous.pgid;
+            process.pgp = previous.pgp;
+            process.sid = previous.sid;
+            process.uid = previous.uid;
+            process.gid = previous.gid;
+            process.ppid = previous.ppid;
+            process.icon_id = previous.icon_id;
+            process.name = previous.name;
+            process.tty = previous.tty;
+            process.pledge = previous.pledge;
+            process.veil = previous.veil;
+            process.username = previous.username;
+        }
+
+        process.amount_virtual = record.amount_virtual;
+        process.amount_resident = record.amount_resident;
+        process.amount_shared = record.amount_shared;
+        process.amount_dirty_private = record.amount_dirty_private;
+        process.amount_clean_inode = record.amount_clean_inode;
+        process.amount_purgeable_volatile = record.amount_purgeable_volatile;
+        process.amount_purgeable_nonvolatile = record.amount_purgeable_nonvolatile;
+
+        process.threads.ensure_capacity(record.thread_count);
+        for (u32 j = 0; j < record.thread_count; ++j) {
+            ThreadStatisticsRecord thread_record;
+            read(thread_record);
             Core::ThreadStatistics thread;
-            thread.tid = thread_object.get("tid").to_u32();
-            thread.times_scheduled = thread_object.get("times_scheduled").to_u32();
-            thread.name = thread_object.get("name").to_string();
-            thread.state = thread_object.get("state").to_string();
-            thread.ticks = thread_object.get("ticks").to_u32();
-            thread.cpu = thread_object.get("cpu").to_u32();
-            thread.priority = thread_object.get("priority").to_u32();
-            thread.effective_priority = thread_object.get("effective_priority").to_u32();
-            thread.syscall_count = thread_object.get("syscall_count").to_u32();
-            thread.inode_faults = thread_object.get("inode_faults").to_u32();
-            thread.zero_faults = thread_object.get("zero_faults").to_u32();
-            thread.cow_faults = thread_object.get("cow_faults").to_u32();
-            thread.unix_socket_read_bytes = thread_object.get("unix_socket_read_bytes").to_u32();
-            thread.unix_socket_write_bytes = thread_object.get("unix_socket_write_bytes").to_u32();
-            thread.ipv4_socket_read_bytes = thread_object.get("ipv4_socket_read_bytes").to_u32();
-            thread.ipv4_socket_write_bytes = thread_object.get("ipv4_socket_write_bytes").to_u32();
-            thread.file_read_bytes = thread_object.get("file_read_bytes").to_u32();
-            thread.file_write_bytes = thread_object.get("file_write_bytes").to_u32();
+            thread.tid = thread_record.tid;
+            thread.times_scheduled = thread_record.times_scheduled;
+            thread.name = thread_record.name;
+            thread.state = thread_record.state;
+            thread.ticks = thread_record.ticks;
+            thread.cpu = thread_record.cpu;
+            thread.priority = thread_record.priority;
+            thread.effective_priority = thread_record.effective_priority;
+            thread.syscall_count = thread_record.syscall_count;
+            thread.inode_faults = thread_record.inode_faults;
+            thread.zero_faults = thread_record.zero_faults;
+            thread.cow_faults = thread_record.cow_faults;
+            thread.unix_socket_read_bytes = thread_record.unix_socket_read_bytes;
+            thread.unix_socket_write_bytes = thread_record.unix_socket_write_bytes;
+            thread.ipv4_socket_read_bytes = thread_record.ipv4_socket_read_bytes;
+            thread.ipv4_socket_write_bytes = thread_record.ipv4_socket_write_bytes;
+            thread.file_read_bytes = thread_record.file_read_bytes;
+            thread.file_write_bytes = thread_record.file_write_bytes;
             process.threads.append(move(thread));
-        });
+        }
 
-        // and synthetic data last
-        process.username = username_from_uid(process.uid);
-        map.set(process.pid, process);
-    });
+        map.set(process.pid, move(process));
+    }
 
+    s_generation = header.generation;
+    s_previous_statistics = map;
     return map;
 }
 
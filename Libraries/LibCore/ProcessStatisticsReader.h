@@ -54,7 +54,7 @@ struct ThreadStatistics {
 };
 
 struct ProcessStatistics {
-    // Keep this in sync with /proc/all.
+    // Keep this in sync with Kernel/API/ProcessStatistics.h.
     // From the kernel side:
     pid_t pid;
     unsigned pgid;
@@ -90,6 +90,8 @@ public:
 private:
     static String username_from_uid(uid_t);
     static HashMap<uid_t, String> s_usernames;
+    static HashMap<pid_t, Core::ProcessStatistics> s_previous_statistics;
+    static u32 s_generation;
 };
 
 }
@@ -60,6 +60,7 @@ typedef struct
 #define AT_RANDOM 25        /* a_ptr points to 16 securely generated random bytes */
 #define AT_HWCAP2 26        /* a_val holds extended hw feature mask. Currently 0 */
 #define AT_EXECFN 31        /* a_ptr points to file name of executed program */
+#define AT_SYSINFO 32       /* a_ptr points to the fast system call entry point */
 
 #ifdef __cplusplus
 #    include <AK/String.h>
@@ -89,7 +90,8 @@ struct AuxiliaryValue {
         BasePlatform = AT_BASE_PLATFORM,
         Random = AT_RANDOM,
         HwCap2 = AT_HWCAP2,
-        ExecFilename = AT_EXECFN
+        ExecFilename = AT_EXECFN,
+        SysInfo = AT_SYSINFO
     };
 
     AuxiliaryValue(Type type, long val)
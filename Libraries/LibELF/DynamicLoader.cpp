@@ -24,16 +24,21 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/ByteBuffer.h>
 #include <AK/StringBuilder.h>
 #include <LibELF/DynamicLoader.h>
 #include <LibELF/Validation.h>
 
 #include <assert.h>
 #include <dlfcn.h>
+#include <fcntl.h>
+#include <limits.h>
 #include <mman.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #define DYNAMIC_LOAD_DEBUG
 //#define DYNAMIC_LOAD_VERBOSE
@@ -50,6 +55,9 @@ namespace ELF {
 
 static bool s_always_bind_now = false;
 
+static const u32 s_prelink_magic = 0x4b4c5250; // "PRLK"
+static const u32 s_prelink_version = 1;
+
 NonnullRefPtr<DynamicLoader> DynamicLoader::construct(const char* filename, int fd, size_t size)
 {
     return adopt(*new DynamicLoader(filename, fd, size));
@@ -85,6 +93,8 @@ DynamicLoader::~DynamicLoader()
 {
     if (MAP_FAILED != m_file_mapping)
         munmap(m_file_mapping, m_file_size);
+    if (m_prelink_fd >= 0)
+        close(m_prelink_fd);
 }
 
 void* DynamicLoader::symbol_for_name(const char* name)
@@ -111,17 +121,135 @@ bool DynamicLoader::load_from_image(unsigned flags)
     m_image->dump();
 #endif
 
-    load_program_headers(elf_image);
+    VirtualAddress preferred_base;
+    if (open_prelinked_image())
+        preferred_base = VirtualAddress(m_prelink_header.base_address);
+
+    bool loaded = load_program_headers(elf_image, preferred_base);
+
+    if (m_prelink_fd >= 0) {
+        close(m_prelink_fd);
+        m_prelink_fd = -1;
+    }
 
     // Don't need this private mapping anymore
     munmap(m_file_mapping, m_file_size);
     m_file_mapping = MAP_FAILED;
 
+    if (!loaded)
+        return false;
+
     m_dynamic_object = AK::make<DynamicObject>(m_text_segment_load_address, m_dynamic_section_address);
 
     return load_stage_2(flags);
 }
 
+bool DynamicLoader::prelink(VirtualAddress base_address, const char* prelink_path)
+{
+    Image elf_image((u8*)m_file_mapping, m_file_size);
+
+    m_valid = elf_image.is_valid() && elf_image.is_dynamic();
+    if (!m_valid)
+        return false;
+
+    if (!load_program_headers(elf_image, base_address))
+        return false;
+
+    if (m_text_segment_load_address != base_address) {
+        dbgprintf("DynamicLoader: Could not map %s at %p for prelinking\n", m_filename.characters(), base_address.as_ptr());
+        return false;
+    }
+
+    m_dynamic_object = AK::make<DynamicObject>(m_text_segment_load_address, m_dynamic_section_address);
+
+    // Text relocations would have to be stored as well, and would defeat sharing the text in the first place.
+    if (m_dynamic_object->has_text_relocations() || !m_data_pages_size)
+        return false;
+
+    do_relocations();
+
+    struct stat image_stat;
+    if (fstat(m_image_fd, &image_stat) < 0)
+        return false;
+
+    // The header gets a page to itself so that the relocated pages can be mapped straight from the file.
+    auto header_page = ByteBuffer::create_zeroed(PAGE_SIZE);
+    auto& header = *(PrelinkHeader*)header_page.data();
+    header.magic = s_prelink_magic;
+    header.version = s_prelink_version;
+    header.image_size = image_stat.st_size;
+    header.image_mtime = image_stat.st_mtime;
+    header.image_inode = image_stat.st_ino;
+    header.base_address = base_address.get();
+    header.data_offset = PAGE_SIZE;
+    header.data_size = m_data_pages_size;
+
+    int fd = open(prelink_path, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    if (fd < 0)
+        return false;
+
+    auto write_all = [fd](const u8* data, size_t size) {
+        while (size) {
+            ssize_t nwritten = write(fd, data, size);
+            if (nwritten <= 0)
+                return false;
+            data += nwritten;
+            size -= nwritten;
+        }
+        return true;
+    };
+
+    bool success = write_all(header_page.data(), header_page.size()) && write_all(m_data_pages_address.as_ptr(), m_data_pages_size);
+    if (close(fd) < 0)
+        success = false;
+    if (!success)
+        unlink(prelink_path);
+    return success;
+}
+
+bool DynamicLoader::open_prelinked_image()
+{
+    struct stat image_stat;
+    if (fstat(m_image_fd, &image_stat) < 0)
+        return false;
+
+    int fd = open(prelink_path_for(m_filename).characters(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    // A prelink image is only good for the exact file it was made from.
+    PrelinkHeader header;
+    if (read(fd, &header, sizeof(header)) != sizeof(header)
+        || header.magic != s_prelink_magic
+        || header.version != s_prelink_version
+        || header.image_size != (u32)image_stat.st_size
+        || header.image_mtime != (u32)image_stat.st_mtime
+        || header.image_inode != (u32)image_stat.st_ino) {
+        close(fd);
+        return false;
+    }
+
+    m_prelink_fd = fd;
+    m_prelink_header = header;
+    return true;
+}
+
+bool DynamicLoader::image_has_text_relocations(const ProgramHeaderRegion& dynamic_region) const
+{
+    if (dynamic_region.offset() + dynamic_region.size_in_image() > m_file_size)
+        return true;
+
+    auto* entry = (const Elf32_Dyn*)((const u8*)m_file_mapping + dynamic_region.offset());
+    auto* end = entry + dynamic_region.size_in_image() / sizeof(Elf32_Dyn);
+    for (; entry != end && entry->d_tag != DT_NULL; ++entry) {
+        if (entry->d_tag == DT_TEXTREL)
+            return true;
+        if (entry->d_tag == DT_FLAGS && (entry->d_un.d_val & DF_TEXTREL))
+            return true;
+    }
+    return false;
+}
+
 bool DynamicLoader::load_stage_2(unsigned flags)
 {
     ASSERT(flags & RTLD_GLOBAL);
@@ -140,7 +268,13 @@ bool DynamicLoader::load_stage_2(unsigned flags)
         }
     }
 
-    do_relocations();
+    if (m_is_prelinked) {
+#ifdef DYNAMIC_LOAD_DEBUG
+        dbgprintf("Using prelinked relocations for %s\n", m_filename.characters());
+#endif
+    } else {
+        do_relocations();
+    }
     setup_plt_trampoline();
 
     // Clean up our setting of .text to PROT_READ | PROT_WRITE
@@ -159,20 +293,22 @@ bool DynamicLoader::load_stage_2(unsigned flags)
     return true;
 }
 
-void DynamicLoader::load_program_headers(const Image& elf_image)
+bool DynamicLoader::load_program_headers(const Image& elf_image, VirtualAddress preferred_base)
 {
     Vector<ProgramHeaderRegion> program_headers;
 
     ProgramHeaderRegion* text_region_ptr = nullptr;
     ProgramHeaderRegion* data_region_ptr = nullptr;
     ProgramHeaderRegion* tls_region_ptr = nullptr;
-    VirtualAddress dynamic_region_desired_vaddr;
+    ProgramHeaderRegion* dynamic_region_ptr = nullptr;
 
     elf_image.for_each_program_header([&](const Image::ProgramHeader& program_header) {
         ProgramHeaderRegion new_region;
         new_region.set_program_header(program_header.raw_header());
         program_headers.append(move(new_region));
-        auto& region = program_headers.last();
+    });
+
+    for (auto& region : program_headers) {
         if (region.is_tls_template())
             tls_region_ptr = &region;
         else if (region.is_load()) {
@@ -181,30 +317,89 @@ void DynamicLoader::load_program_headers(const Image& elf_image)
             else
                 data_region_ptr = &region;
         } else if (region.is_dynamic()) {
-            dynamic_region_desired_vaddr = region.desired_load_address();
+            dynamic_region_ptr = &region;
         }
-    });
+    }
 
     ASSERT(text_region_ptr && data_region_ptr);
 
+    // Reserve address space for the whole image first, so that .data and .bss are guaranteed
+    // to fit behind .text. Each segment is then mapped over its part of the reservation.
+    size_t image_span = ALIGN_ROUND_UP(data_region_ptr->desired_load_address().get() + data_region_ptr->size_in_memory(), PAGE_SIZE);
+    void* image_begin = mmap_with_name(preferred_base.as_ptr(), image_span, PROT_NONE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0, String::format("ELF image: %s", m_filename.characters()).characters());
+    if (MAP_FAILED == image_begin) {
+        perror("mmap ELF image");
+        return false;
+    }
+
     // Process regions in order: .text, .data, .tls
+    // Position-independent text is never written to, so map it shared. Every process that loads
+    // this library then runs it from the same physical pages in the inode's page cache.
     auto* region = text_region_ptr;
-    void* text_segment_begin = mmap_with_name(nullptr, region->required_load_size(), region->mmap_prot(), MAP_PRIVATE, m_image_fd, region->offset(), String::format(".text: %s", m_filename.characters()).characters());
+    bool has_text_relocations = !dynamic_region_ptr || image_has_text_relocations(*dynamic_region_ptr);
+    int text_map_flags = (has_text_relocations ? MAP_PRIVATE : MAP_SHARED) | MAP_FIXED;
+    void* text_segment_begin = mmap_with_name(image_begin, region->required_load_size(), region->mmap_prot(), text_map_flags, m_image_fd, region->offset(), String::format(".text: %s", m_filename.characters()).characters());
     if (MAP_FAILED == text_segment_begin) {
-        ASSERT_NOT_REACHED();
+        perror("mmap .text");
+        return false;
     }
     m_text_segment_size = region->required_load_size();
     m_text_segment_load_address = VirtualAddress { (u32)text_segment_begin };
 
-    m_dynamic_section_address = dynamic_region_desired_vaddr.offset(m_text_segment_load_address.get());
+    if (dynamic_region_ptr)
+        m_dynamic_section_address = dynamic_region_ptr->desired_load_address().offset(m_text_segment_load_address.get());
 
     region = data_region_ptr;
-    void* data_segment_begin = mmap_with_name((u8*)text_segment_begin + m_text_segment_size, region->required_load_size(), region->mmap_prot(), MAP_ANONYMOUS | MAP_PRIVATE, 0, 0, String::format(".data: %s", m_filename.characters()).characters());
-    if (MAP_FAILED == data_segment_begin) {
-        ASSERT_NOT_REACHED();
-    }
     VirtualAddress data_segment_actual_addr = region->desired_load_address().offset((u32)text_segment_begin);
-    memcpy(data_segment_actual_addr.as_ptr(), (u8*)m_file_mapping + region->offset(), region->size_in_image());
+    size_t data_page_offset = data_segment_actual_addr.get() % PAGE_SIZE;
+    u8* data_pages_begin = data_segment_actual_addr.as_ptr() - data_page_offset;
+    size_t data_mapping_size = ALIGN_ROUND_UP(data_page_offset + region->size_in_memory(), PAGE_SIZE);
+    size_t data_pages_size = 0;
+    if (region->size_in_image() && region->offset() % PAGE_SIZE == data_page_offset)
+        data_pages_size = ALIGN_ROUND_UP(data_page_offset + region->size_in_image(), PAGE_SIZE);
+
+    m_is_prelinked = m_prelink_fd >= 0
+        && text_segment_begin == preferred_base.as_ptr()
+        && !has_text_relocations
+        && m_prelink_header.data_size == data_pages_size;
+
+    auto data_segment_name = String::format(".data: %s", m_filename.characters());
+    if (data_pages_size) {
+        // Map the initialized part of .data privately from the file instead of copying it, so pages
+        // nobody writes to stay shared with the page cache. A prelink image provides the same pages
+        // with all relocations already applied.
+        void* data_pages;
+        if (m_is_prelinked)
+            data_pages = mmap_with_name(data_pages_begin, data_pages_size, region->mmap_prot(), MAP_PRIVATE | MAP_FIXED, m_prelink_fd, m_prelink_header.data_offset, data_segment_name.characters());
+        else
+            data_pages = mmap_with_name(data_pages_begin, data_pages_size, region->mmap_prot(), MAP_PRIVATE | MAP_FIXED, m_image_fd, region->offset() - data_page_offset, data_segment_name.characters());
+        if (MAP_FAILED == data_pages) {
+            perror("mmap .data");
+            return false;
+        }
+
+        // Whatever follows .data in its last page is the start of .bss, which has to be zero.
+        // The prelink image was saved after doing this.
+        if (!m_is_prelinked) {
+            u8* data_end = data_segment_actual_addr.as_ptr() + region->size_in_image();
+            memset(data_end, 0, data_pages_begin + data_pages_size - data_end);
+        }
+    }
+
+    if (data_mapping_size > data_pages_size) {
+        void* bss_pages = mmap_with_name(data_pages_begin + data_pages_size, data_mapping_size - data_pages_size, region->mmap_prot(), MAP_ANONYMOUS | MAP_PRIVATE | MAP_FIXED, 0, 0, data_segment_name.characters());
+        if (MAP_FAILED == bss_pages) {
+            perror("mmap .bss");
+            return false;
+        }
+    }
+
+    if (!data_pages_size)
+        memcpy(data_segment_actual_addr.as_ptr(), (u8*)m_file_mapping + region->offset(), region->size_in_image());
+
+    m_data_pages_address = VirtualAddress(data_pages_begin);
+    m_data_pages_size = data_pages_size;
+    m_loaded_size = data_pages_begin + data_mapping_size - (u8*)text_segment_begin;
 
     // FIXME: Do some kind of 'allocate TLS section' or some such from a per-application pool
     if (tls_region_ptr) {
@@ -214,6 +409,8 @@ void DynamicLoader::load_program_headers(const Image& elf_image)
         VirtualAddress tls_segment_actual_addr = region->desired_load_address().offset((u32)text_segment_begin);
         memcpy(tls_segment_actual_addr.as_ptr(), (u8*)m_file_mapping + region->offset(), region->size_in_image());
     }
+
+    return true;
 }
 
 void DynamicLoader::do_relocations()
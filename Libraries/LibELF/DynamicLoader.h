@@ -67,6 +67,16 @@ public:
     // Requested program interpreter from program headers. May be empty string
     StringView program_interpreter() const { return m_program_interpreter; }
 
+    // Load the image at exactly base_address and apply its relocations without running any code from it,
+    // then write the relocated data pages to prelink_path. A later load_from_image() that manages to map
+    // the image at the same base maps those pages instead of relocating again.
+    bool prelink(VirtualAddress base_address, const char* prelink_path);
+
+    // Total span of the image once loaded, i.e. where the next library could be prelinked.
+    size_t loaded_size() const { return m_loaded_size; }
+
+    static String prelink_path_for(const String& filename) { return String::format("%s.prelink", filename.characters()); }
+
 private:
     class ProgramHeaderRegion {
     public:
@@ -97,8 +107,21 @@ private:
     explicit DynamicLoader(const char* filename, int fd, size_t file_size);
     explicit DynamicLoader(Elf32_Dyn* dynamic_location, Elf32_Addr load_address);
 
+    struct PrelinkHeader {
+        u32 magic;
+        u32 version;
+        u32 image_size;
+        u32 image_mtime;
+        u32 image_inode;
+        u32 base_address;
+        u32 data_offset;
+        u32 data_size;
+    };
+
     // Stage 1
-    void load_program_headers(const Image& elf_image);
+    bool load_program_headers(const Image& elf_image, VirtualAddress preferred_base = {});
+    bool image_has_text_relocations(const ProgramHeaderRegion& dynamic_region) const;
+    bool open_prelinked_image();
 
     // Stage 2
     void do_relocations();
@@ -116,6 +139,15 @@ private:
 
     VirtualAddress m_text_segment_load_address;
     size_t m_text_segment_size;
+    size_t m_loaded_size { 0 };
+
+    // The file-backed part of .data, in whole pages. This is what a prelink image stores.
+    VirtualAddress m_data_pages_address;
+    size_t m_data_pages_size { 0 };
+
+    int m_prelink_fd { -1 };
+    PrelinkHeader m_prelink_header;
+    bool m_is_prelinked { false };
 
     VirtualAddress m_tls_segment_address;
     VirtualAddress m_dynamic_section_address;
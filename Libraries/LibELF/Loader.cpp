@@ -32,8 +32,10 @@
 #ifdef KERNEL
 #    include <Kernel/VM/MemoryManager.h>
 #    define do_memcpy copy_to_user
+#    define do_memset memset_user
 #else
 #    define do_memcpy memcpy
+#    define do_memset memset
 #endif
 
 //#define Loader_DEBUG
@@ -90,7 +92,51 @@ bool Loader::layout()
         kprintf("PH: V%p %u r:%u w:%u\n", program_header.vaddr().get(), program_header.size_in_memory(), program_header.is_readable(), program_header.is_writable());
 #endif
 #ifdef KERNEL
-        if (program_header.is_writable()) {
+        if (program_header.is_writable() && (program_header.offset() % PAGE_SIZE) == (program_header.vaddr().get() % PAGE_SIZE)) {
+            if (!m_image.is_within_image(program_header.raw_data(), program_header.size_in_image())) {
+                dbg() << "Shenanigans! Writable ELF PT_LOAD header sneaks outside of executable.";
+                failed = true;
+                return;
+            }
+            // The file-backed part of a data segment is mapped privately from the image, so its pages
+            // are only read in (and copied) when touched. Whatever follows it in memory is zero-filled.
+            auto page_offset = program_header.vaddr().get() % PAGE_SIZE;
+            auto file_backed_size = PAGE_ROUND_UP(page_offset + program_header.size_in_image());
+            u8* mapped_section = nullptr;
+            if (program_header.size_in_image()) {
+                mapped_section = (u8*)map_section_hook(
+                    program_header.vaddr().page_base(),
+                    file_backed_size,
+                    program_header.alignment(),
+                    program_header.offset() - page_offset,
+                    program_header.is_readable(),
+                    program_header.is_writable(),
+                    program_header.is_executable(),
+                    String::format("elf-map-%s%s%s", program_header.is_readable() ? "r" : "", program_header.is_writable() ? "w" : "", program_header.is_executable() ? "x" : ""));
+                if (!mapped_section) {
+                    failed = true;
+                    return;
+                }
+                // The rest of the last file-backed page holds whatever comes next in the file, but belongs to .bss.
+                if (program_header.size_in_memory() > program_header.size_in_image())
+                    do_memset(mapped_section + page_offset + program_header.size_in_image(), 0, file_backed_size - page_offset - program_header.size_in_image());
+            } else {
+                file_backed_size = 0;
+            }
+            auto zero_filled_start = program_header.vaddr().page_base().offset(file_backed_size);
+            auto segment_end = program_header.vaddr().offset(program_header.size_in_memory());
+            if (zero_filled_start < segment_end) {
+                auto* allocated_section = alloc_section_hook(
+                    zero_filled_start,
+                    segment_end.get() - zero_filled_start.get(),
+                    program_header.alignment(),
+                    program_header.is_readable(),
+                    program_header.is_writable(),
+                    String::format("elf-alloc-%s%s", program_header.is_readable() ? "r" : "", program_header.is_writable() ? "w" : ""));
+                if (!allocated_section)
+                    failed = true;
+            }
+        } else if (program_header.is_writable()) {
             auto* allocated_section = alloc_section_hook(
                 program_header.vaddr(),
                 program_header.size_in_memory(),
@@ -172,17 +218,12 @@ Optional<Image::Symbol> Loader::find_demangled_function(const String& name) cons
     return found;
 }
 
-#ifndef KERNEL
-Optional<Image::Symbol> Loader::find_symbol(u32 address, u32* out_offset) const
+Loader::SortedSymbol* Loader::sorted_symbols() const
 {
-    if (!m_symbol_count)
-        return {};
-
-    SortedSymbol* sorted_symbols = nullptr;
-#    ifdef KERNEL
+#ifdef KERNEL
     if (!m_sorted_symbols_region) {
         m_sorted_symbols_region = MM.allocate_kernel_region(PAGE_ROUND_UP(m_symbol_count * sizeof(SortedSymbol)), "Sorted symbols", Kernel::Region::Access::Read | Kernel::Region::Access::Write);
-        sorted_symbols = (SortedSymbol*)m_sorted_symbols_region->vaddr().as_ptr();
+        auto* sorted_symbols = (SortedSymbol*)m_sorted_symbols_region->vaddr().as_ptr();
         size_t index = 0;
         m_image.for_each_symbol([&](auto& symbol) {
             sorted_symbols[index++] = { symbol.value(), symbol.name() };
@@ -191,10 +232,9 @@ Optional<Image::Symbol> Loader::find_symbol(u32 address, u32* out_offset) const
         quick_sort(sorted_symbols, sorted_symbols + m_symbol_count, [](auto& a, auto& b) {
             return a.address < b.address;
         });
-    } else {
-        sorted_symbols = (SortedSymbol*)m_sorted_symbols_region->vaddr().as_ptr();
     }
-#    else
+    return (SortedSymbol*)m_sorted_symbols_region->vaddr().as_ptr();
+#else
     if (m_sorted_symbols.is_empty()) {
         m_sorted_symbols.ensure_capacity(m_symbol_count);
         m_image.for_each_symbol([this](auto& symbol) {
@@ -205,20 +245,40 @@ Optional<Image::Symbol> Loader::find_symbol(u32 address, u32* out_offset) const
             return a.address < b.address;
         });
     }
-    sorted_symbols = m_sorted_symbols.data();
-#    endif
+    return m_sorted_symbols.data();
+#endif
+}
 
-    for (size_t i = 0; i < m_symbol_count; ++i) {
-        if (sorted_symbols[i].address > address) {
-            if (i == 0)
-                return {};
-            auto& symbol = sorted_symbols[i - 1];
-            if (out_offset)
-                *out_offset = address - symbol.address;
-            return symbol.symbol;
-        }
+// Returns the number of sorted symbols whose address is <= the given address,
+// i.e. the index one past the symbol that contains it.
+size_t Loader::sorted_symbol_upper_bound(u32 address) const
+{
+    auto* symbols = sorted_symbols();
+    size_t low = 0;
+    size_t high = m_symbol_count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (symbols[middle].address > address)
+            high = middle;
+        else
+            low = middle + 1;
     }
-    return {};
+    return low;
+}
+
+#ifndef KERNEL
+Optional<Image::Symbol> Loader::find_symbol(u32 address, u32* out_offset) const
+{
+    if (!m_symbol_count)
+        return {};
+
+    size_t index = sorted_symbol_upper_bound(address);
+    if (index == 0 || index == m_symbol_count)
+        return {};
+    auto& symbol = sorted_symbols()[index - 1];
+    if (out_offset)
+        *out_offset = address - symbol.address;
+    return symbol.symbol;
 }
 #endif
 
@@ -229,63 +289,34 @@ String Loader::symbolicate(u32 address, u32* out_offset) const
             *out_offset = 0;
         return "??";
     }
-    SortedSymbol* sorted_symbols = nullptr;
-#ifdef KERNEL
-    if (!m_sorted_symbols_region) {
-        m_sorted_symbols_region = MM.allocate_kernel_region(PAGE_ROUND_UP(m_symbol_count * sizeof(SortedSymbol)), "Sorted symbols", Kernel::Region::Access::Read | Kernel::Region::Access::Write);
-        sorted_symbols = (SortedSymbol*)m_sorted_symbols_region->vaddr().as_ptr();
-        size_t index = 0;
-        m_image.for_each_symbol([&](auto& symbol) {
-            sorted_symbols[index++] = { symbol.value(), symbol.name() };
-            return IterationDecision::Continue;
-        });
-        quick_sort(sorted_symbols, sorted_symbols + m_symbol_count, [](auto& a, auto& b) {
-            return a.address < b.address;
-        });
-    } else {
-        sorted_symbols = (SortedSymbol*)m_sorted_symbols_region->vaddr().as_ptr();
+
+    size_t index = sorted_symbol_upper_bound(address);
+    if (index == 0) {
+        if (out_offset)
+            *out_offset = 0;
+        return "!!";
     }
-#else
-    if (m_sorted_symbols.is_empty()) {
-        m_sorted_symbols.ensure_capacity(m_symbol_count);
-        m_image.for_each_symbol([this](auto& symbol) {
-            m_sorted_symbols.append({ symbol.value(), symbol.name(), {}, {} });
-            return IterationDecision::Continue;
-        });
-        quick_sort(m_sorted_symbols, [](auto& a, auto& b) {
-            return a.address < b.address;
-        });
+    if (index == m_symbol_count) {
+        if (out_offset)
+            *out_offset = 0;
+        return "??";
     }
-    sorted_symbols = m_sorted_symbols.data();
-#endif
 
-    for (size_t i = 0; i < m_symbol_count; ++i) {
-        if (sorted_symbols[i].address > address) {
-            if (i == 0) {
-                if (out_offset)
-                    *out_offset = 0;
-                return "!!";
-            }
-            auto& symbol = sorted_symbols[i - 1];
+    auto& symbol = sorted_symbols()[index - 1];
 
 #ifdef KERNEL
-            auto demangled_name = demangle(symbol.name);
+    auto demangled_name = demangle(symbol.name);
 #else
-            auto& demangled_name = symbol.demangled_name;
-            if (demangled_name.is_null())
-                demangled_name = demangle(symbol.name);
+    auto& demangled_name = symbol.demangled_name;
+    if (demangled_name.is_null())
+        demangled_name = demangle(symbol.name);
 #endif
 
-            if (out_offset) {
-                *out_offset = address - symbol.address;
-                return demangled_name;
-            }
-            return String::format("%s +%u", demangled_name.characters(), address - symbol.address);
-        }
+    if (out_offset) {
+        *out_offset = address - symbol.address;
+        return demangled_name;
     }
-    if (out_offset)
-        *out_offset = 0;
-    return "??";
+    return String::format("%s +%u", demangled_name.characters(), address - symbol.address);
 }
 
 } // end namespace ELF
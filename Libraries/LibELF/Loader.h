@@ -99,6 +99,9 @@ private:
         Optional<Image::Symbol> symbol;
 #endif
     };
+    SortedSymbol* sorted_symbols() const;
+    size_t sorted_symbol_upper_bound(u32 address) const;
+
 #ifdef KERNEL
     mutable OwnPtr<Kernel::Region> m_sorted_symbols_region;
 #else
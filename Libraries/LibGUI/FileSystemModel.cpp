@@ -27,6 +27,7 @@
 #include <AK/LexicalPath.h>
 #include <AK/QuickSort.h>
 #include <AK/StringBuilder.h>
+#include <Kernel/API/InodeWatcherEvent.h>
 #include <LibCore/DirIterator.h>
 #include <LibCore/File.h>
 #include <LibCore/StandardPaths.h>
@@ -35,6 +36,8 @@
 #include <LibGfx/Bitmap.h>
 #include <LibThread/BackgroundAction.h>
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <grp.h>
 #include <pwd.h>
 #include <stdio.h>
@@ -106,17 +109,11 @@ void FileSystemModel::Node::traverse_if_needed(const FileSystemModel& model)
     quick_sort(child_names);
 
     for (auto& name : child_names) {
-        String child_path = String::format("%s/%s", full_path.characters(), name.characters());
-        NonnullOwnPtr<Node> child = make<Node>();
-        bool ok = child->fetch_data(child_path, false);
-        if (!ok)
+        auto child = create_child(model, full_path, name);
+        if (!child)
             continue;
-        if (model.m_mode == DirectoriesOnly && !S_ISDIR(child->mode))
-            continue;
-        child->name = name;
-        child->parent = this;
         total_size += child->size;
-        children.append(move(child));
+        children.append(child.release_nonnull());
     }
 
     if (m_watch_fd >= 0)
@@ -128,19 +125,101 @@ void FileSystemModel::Node::traverse_if_needed(const FileSystemModel& model)
         return;
     }
     fcntl(m_watch_fd, F_SETFD, FD_CLOEXEC);
+    // Don't let the UI block in read() when the events that woke us up cancel each other out.
+    fcntl(m_watch_fd, F_SETFL, O_NONBLOCK);
     dbg() << "Watching " << full_path << " for changes, m_watch_fd = " << m_watch_fd;
     m_notifier = Core::Notifier::construct(m_watch_fd, Core::Notifier::Event::Read);
     m_notifier->on_ready_to_read = [this, &model] {
-        char buffer[32];
-        int rc = read(m_notifier->fd(), buffer, sizeof(buffer));
-        ASSERT(rc >= 0);
+        handle_watch_events(model);
+    };
+}
 
+OwnPtr<FileSystemModel::Node> FileSystemModel::Node::create_child(const FileSystemModel& model, const String& full_path, const String& child_name)
+{
+    String child_path = String::format("%s/%s", full_path.characters(), child_name.characters());
+    auto child = make<Node>();
+    bool ok = child->fetch_data(child_path, false);
+    if (!ok)
+        return nullptr;
+    if (model.m_mode == DirectoriesOnly && !S_ISDIR(child->mode))
+        return nullptr;
+    child->name = child_name;
+    child->parent = this;
+    return child;
+}
+
+void FileSystemModel::Node::handle_child_added(const FileSystemModel& model, const String& child_name)
+{
+    if (!model.should_show_dotfiles() && child_name.starts_with('.'))
+        return;
+
+    handle_child_removed(child_name);
+    auto child = create_child(model, full_path(model), child_name);
+    if (!child)
+        return;
+    total_size += child->size;
+
+    // Keep the children sorted by name, the same way traverse_if_needed() does.
+    size_t insertion_index = 0;
+    while (insertion_index < children.size() && children[insertion_index].name < child_name)
+        ++insertion_index;
+    children.insert(insertion_index, child.release_nonnull());
+}
+
+void FileSystemModel::Node::handle_child_removed(const String& child_name)
+{
+    for (size_t i = 0; i < children.size(); ++i) {
+        if (children[i].name != child_name)
+            continue;
+        total_size -= children[i].size;
+        children.remove(i);
+        return;
+    }
+}
+
+void FileSystemModel::Node::handle_watch_events(const FileSystemModel& model)
+{
+    alignas(InodeWatcherEvent) u8 buffer[4096];
+    ssize_t nread = read(m_notifier->fd(), buffer, sizeof(buffer));
+    if (nread < 0) {
+        if (errno == EAGAIN)
+            return;
+        perror("read");
+        return;
+    }
+    if (nread == 0) {
+        // The directory is gone, there's nothing left to watch.
+        m_notifier->set_enabled(false);
+        return;
+    }
+
+    bool should_rescan = false;
+    for (ssize_t offset = 0; offset < nread;) {
+        auto& event = *reinterpret_cast<const InodeWatcherEvent*>(buffer + offset);
+        offset += event.record_size();
+        switch (event.type) {
+        case InodeWatcherEvent::Type::ChildAdded:
+            handle_child_added(model, String(event.name(), event.name_length));
+            break;
+        case InodeWatcherEvent::Type::ChildRemoved:
+            handle_child_removed(String(event.name(), event.name_length));
+            break;
+        case InodeWatcherEvent::Type::Modified:
+            fetch_data(full_path(model), parent == nullptr);
+            break;
+        default:
+            should_rescan = true;
+            break;
+        }
+    }
+
+    if (should_rescan) {
         has_traversed = false;
         mode = 0;
         children.clear();
         reify_if_needed(model);
-        const_cast<FileSystemModel&>(model).did_update();
-    };
+    }
+    const_cast<FileSystemModel&>(model).did_update();
 }
 
 void FileSystemModel::Node::reify_if_needed(const FileSystemModel& model)
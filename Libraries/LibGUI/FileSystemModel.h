@@ -122,6 +122,10 @@ public:
         void traverse_if_needed(const FileSystemModel&);
         void reify_if_needed(const FileSystemModel&);
         bool fetch_data(const String& full_path, bool is_root);
+        OwnPtr<Node> create_child(const FileSystemModel&, const String& full_path, const String& child_name);
+        void handle_child_added(const FileSystemModel&, const String& child_name);
+        void handle_child_removed(const String& child_name);
+        void handle_watch_events(const FileSystemModel&);
     };
 
     static NonnullRefPtr<FileSystemModel> create(const StringView& root_path = "/", Mode mode = Mode::FilesAndDirectories)
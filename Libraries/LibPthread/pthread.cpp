@@ -28,6 +28,7 @@
 #include <AK/Atomic.h>
 #include <AK/StdLibExtras.h>
 #include <Kernel/API/Syscall.h>
+#include <errno.h>
 #include <limits.h>
 #include <pthread.h>
 #include <serenity.h>
@@ -168,31 +169,46 @@ int pthread_mutex_destroy(pthread_mutex_t*)
     return 0;
 }
 
+enum MutexState : u32 {
+    Unlocked = 0,
+    Locked = 1,
+    LockedWithWaiters = 2,
+};
+
+static void mutex_lock_contended(pthread_mutex_t* mutex)
+{
+    auto& atomic = reinterpret_cast<Atomic<u32>&>(mutex->lock);
+    // Once we've had to wait, we can't know whether anybody else is still
+    // waiting, so we always leave the lock in the contended state.
+    while (atomic.exchange(LockedWithWaiters, AK::memory_order_acquire) != Unlocked)
+        futex(reinterpret_cast<i32*>(&mutex->lock), FUTEX_WAIT, LockedWithWaiters, nullptr, nullptr, 0);
+    mutex->owner = pthread_self();
+    mutex->level = 0;
+}
+
 int pthread_mutex_lock(pthread_mutex_t* mutex)
 {
     auto& atomic = reinterpret_cast<Atomic<u32>&>(mutex->lock);
     pthread_t this_thread = pthread_self();
-    for (;;) {
-        u32 expected = false;
-        if (!atomic.compare_exchange_strong(expected, true, AK::memory_order_acq_rel)) {
-            if (mutex->type == PTHREAD_MUTEX_RECURSIVE && mutex->owner == this_thread) {
-                mutex->level++;
-                return 0;
-            }
-            sched_yield();
-            continue;
+    u32 expected = Unlocked;
+    if (!atomic.compare_exchange_strong(expected, Locked, AK::memory_order_acq_rel)) {
+        if (mutex->type == PTHREAD_MUTEX_RECURSIVE && mutex->owner == this_thread) {
+            mutex->level++;
+            return 0;
         }
-        mutex->owner = this_thread;
-        mutex->level = 0;
+        mutex_lock_contended(mutex);
         return 0;
     }
+    mutex->owner = this_thread;
+    mutex->level = 0;
+    return 0;
 }
 
 int pthread_mutex_trylock(pthread_mutex_t* mutex)
 {
     auto& atomic = reinterpret_cast<Atomic<u32>&>(mutex->lock);
-    u32 expected = false;
-    if (!atomic.compare_exchange_strong(expected, true, AK::memory_order_acq_rel)) {
+    u32 expected = Unlocked;
+    if (!atomic.compare_exchange_strong(expected, Locked, AK::memory_order_acq_rel)) {
         if (mutex->type == PTHREAD_MUTEX_RECURSIVE && mutex->owner == pthread_self()) {
             mutex->level++;
             return 0;
@@ -211,7 +227,9 @@ int pthread_mutex_unlock(pthread_mutex_t* mutex)
         return 0;
     }
     mutex->owner = 0;
-    mutex->lock = 0;
+    auto& atomic = reinterpret_cast<Atomic<u32>&>(mutex->lock);
+    if (atomic.exchange(Unlocked, AK::memory_order_release) == LockedWithWaiters)
+        futex(reinterpret_cast<i32*>(&mutex->lock), FUTEX_WAKE, 1, nullptr, nullptr, 0);
     return 0;
 }
 
@@ -476,7 +494,7 @@ int pthread_setschedparam(pthread_t thread, int policy, const struct sched_param
 int pthread_cond_init(pthread_cond_t* cond, const pthread_condattr_t* attr)
 {
     cond->value = 0;
-    cond->previous = 0;
+    cond->mutex = nullptr;
     cond->clockid = attr ? attr->clockid : CLOCK_MONOTONIC;
     return 0;
 }
@@ -488,12 +506,20 @@ int pthread_cond_destroy(pthread_cond_t*)
 
 static int cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* abstime)
 {
-    i32 value = cond->value;
-    cond->previous = value;
+    i32 value = reinterpret_cast<Atomic<i32>&>(cond->value).load(AK::memory_order_acquire);
+    cond->mutex = mutex;
     pthread_mutex_unlock(mutex);
-    int rc = futex(&cond->value, FUTEX_WAIT, value, abstime);
-    pthread_mutex_lock(mutex);
-    return rc;
+    int rc = futex(&cond->value, FUTEX_WAIT, value, abstime, nullptr, 0);
+    bool timed_out = rc < 0 && errno == ETIMEDOUT;
+    // pthread_cond_broadcast() may have moved us onto the mutex's queue with
+    // other waiters behind us, so take it in the contended state to make sure
+    // unlocking it wakes the next one.
+    mutex_lock_contended(mutex);
+    if (timed_out) {
+        errno = ETIMEDOUT;
+        return -1;
+    }
+    return 0;
 }
 
 int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex)
@@ -527,19 +553,24 @@ int pthread_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex, const s
 
 int pthread_cond_signal(pthread_cond_t* cond)
 {
-    u32 value = cond->previous + 1;
-    cond->value = value;
-    int rc = futex(&cond->value, FUTEX_WAKE, 1, nullptr);
-    ASSERT(rc == 0);
+    reinterpret_cast<Atomic<i32>&>(cond->value).fetch_add(1, AK::memory_order_release);
+    futex(&cond->value, FUTEX_WAKE, 1, nullptr, nullptr, 0);
     return 0;
 }
 
 int pthread_cond_broadcast(pthread_cond_t* cond)
 {
-    u32 value = cond->previous + 1;
-    cond->value = value;
-    int rc = futex(&cond->value, FUTEX_WAKE, INT32_MAX, nullptr);
-    ASSERT(rc == 0);
+    i32 value = reinterpret_cast<Atomic<i32>&>(cond->value).fetch_add(1, AK::memory_order_release) + 1;
+    auto* mutex = cond->mutex;
+    if (mutex) {
+        // Only one waiter could take the mutex anyway, so wake just that one and
+        // move the rest directly onto the mutex instead of letting them stampede.
+        int rc = futex(&cond->value, FUTEX_CMP_REQUEUE, 1, reinterpret_cast<const struct timespec*>(INT32_MAX), reinterpret_cast<i32*>(&mutex->lock), value);
+        if (rc >= 0)
+            return 0;
+        // Somebody else signalled in the meantime; fall back to waking everyone.
+    }
+    futex(&cond->value, FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
     return 0;
 }
 
@@ -45,3 +45,14 @@ void FontCache::set(const FontSelector& font_selector, NonnullRefPtr<Gfx::Font>
 {
     m_fonts.set(font_selector, move(font));
 }
+
+void FontCache::evict_unused_fonts()
+{
+    Vector<FontSelector> unused_selectors;
+    for (auto& it : m_fonts) {
+        if (it.value->ref_count() == 1)
+            unused_selectors.append(it.key);
+    }
+    for (auto& selector : unused_selectors)
+        m_fonts.remove(selector);
+}
@@ -54,6 +54,9 @@ public:
     RefPtr<Gfx::Font> get(const FontSelector&) const;
     void set(const FontSelector&, NonnullRefPtr<Gfx::Font>);
 
+    // Forgets every font that nobody but the cache is holding on to.
+    void evict_unused_fonts();
+
 private:
     FontCache() { }
     mutable HashMap<FontSelector, NonnullRefPtr<Gfx::Font>> m_fonts;
@@ -31,9 +31,13 @@
 #include <LibCore/File.h>
 #include <LibProtocol/Client.h>
 #include <LibProtocol/Download.h>
+#include <LibWeb/FontCache.h>
 #include <LibWeb/Loader/LoadRequest.h>
 #include <LibWeb/Loader/Resource.h>
 #include <LibWeb/Loader/ResourceLoader.h>
+#include <fcntl.h>
+#include <serenity.h>
+#include <unistd.h>
 
 //#define CACHE_DEBUG
 
@@ -51,6 +55,19 @@ ResourceLoader::ResourceLoader()
     : m_protocol_client(Protocol::Client::construct())
     , m_user_agent("Mozilla/4.0 (SerenityOS; x86) LibWeb+LibJS (Not KHTML, nor Gecko) LibWeb")
 {
+    int memory_pressure_fd = watch_memory_pressure();
+    if (memory_pressure_fd < 0) {
+        perror("watch_memory_pressure");
+        return;
+    }
+    fcntl(memory_pressure_fd, F_SETFD, FD_CLOEXEC);
+    m_memory_pressure_notifier = Core::Notifier::construct(memory_pressure_fd, Core::Notifier::Event::Read, this);
+    m_memory_pressure_notifier->on_ready_to_read = [this] {
+        unsigned pressure;
+        if (read(m_memory_pressure_notifier->fd(), &pressure, sizeof(pressure)) != sizeof(pressure))
+            return;
+        did_receive_memory_pressure(pressure);
+    };
 }
 
 void ResourceLoader::load_sync(const URL& url, Function<void(const ByteBuffer&, const HashMap<String, String, CaseInsensitiveStringTraits>& response_headers)> success_callback, Function<void(const String&)> error_callback)
@@ -74,6 +91,29 @@ void ResourceLoader::load_sync(const URL& url, Function<void(const ByteBuffer&,
 
 static HashMap<LoadRequest, NonnullRefPtr<Resource>> s_resource_cache;
 
+void ResourceLoader::did_receive_memory_pressure(unsigned pressure)
+{
+    if (pressure == MEMORY_PRESSURE_NORMAL)
+        return;
+
+    // Drop everything that only the caches are keeping alive. Anything still in use
+    // by a document stays around, and decoded images take care of themselves by
+    // going volatile when nobody is looking at them.
+    Vector<LoadRequest> unused_requests;
+    for (auto& it : s_resource_cache) {
+        if (it.value->ref_count() == 1)
+            unused_requests.append(it.key);
+    }
+    for (auto& request : unused_requests)
+        s_resource_cache.remove(request);
+
+    FontCache::the().evict_unused_fonts();
+
+#ifdef CACHE_DEBUG
+    dbg() << "Memory pressure " << pressure << ", evicted " << unused_requests.size() << " cached resources";
+#endif
+}
+
 RefPtr<Resource> ResourceLoader::load_resource(Resource::Type type, const LoadRequest& request)
 {
     if (!request.is_valid())
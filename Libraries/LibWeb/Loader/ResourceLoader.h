@@ -28,6 +28,7 @@
 
 #include <AK/Function.h>
 #include <AK/URL.h>
+#include <LibCore/Notifier.h>
 #include <LibCore/Object.h>
 #include <LibWeb/Loader/Resource.h>
 
@@ -59,11 +60,14 @@ private:
     ResourceLoader();
     static bool is_port_blocked(int port);
 
+    void did_receive_memory_pressure(unsigned pressure);
+
     virtual void save_to(JsonObject&) override;
 
     int m_pending_loads { 0 };
 
     RefPtr<Protocol::Client> m_protocol_client;
+    RefPtr<Core::Notifier> m_memory_pressure_notifier;
     String m_user_agent;
 };
 
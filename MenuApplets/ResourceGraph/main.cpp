@@ -218,11 +218,6 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    if (unveil("/proc/all", "r") < 0) {
-        perror("unveil");
-        return 1;
-    }
-
     if (unveil("/proc/memstat", "r") < 0) {
         perror("unveil");
         return 1;
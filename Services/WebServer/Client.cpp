@@ -32,6 +32,7 @@
 #include <LibCore/File.h>
 #include <LibHTTP/HttpRequest.h>
 #include <stdio.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
@@ -121,10 +122,10 @@ void Client::handle_request(ByteBuffer raw_request)
         return;
     }
 
-    send_response(file->read_all(), request);
+    send_file_response(*file, request);
 }
 
-void Client::send_response(StringView response, const HTTP::HttpRequest& request)
+void Client::send_response_headers()
 {
     StringBuilder builder;
     builder.append("HTTP/1.0 200 OK\r\n");
@@ -133,11 +134,35 @@ void Client::send_response(StringView response, const HTTP::HttpRequest& request
     builder.append("\r\n");
 
     m_socket->write(builder.to_string());
+}
+
+void Client::send_response(StringView response, const HTTP::HttpRequest& request)
+{
+    send_response_headers();
     m_socket->write(response);
 
     log_response(200, request);
 }
 
+void Client::send_file_response(Core::File& file, const HTTP::HttpRequest& request)
+{
+    send_response_headers();
+
+    // Let the kernel move the file contents straight into the socket, so that
+    // large files are neither copied through userspace nor buffered in memory.
+    for (;;) {
+        ssize_t nsent = sendfile(m_socket->fd(), file.fd(), nullptr, 64 * KB);
+        if (nsent < 0) {
+            perror("sendfile");
+            break;
+        }
+        if (nsent == 0)
+            break;
+    }
+
+    log_response(200, request);
+}
+
 void Client::send_redirect(StringView redirect_path, const HTTP::HttpRequest& request)
 {
     StringBuilder builder;
@@ -0,0 +1,105 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+static int s_failures = 0;
+
+static void expect_events(int epoll_fd, int fd, uint32_t expected, const char* what)
+{
+    epoll_event event {};
+    int rc = epoll_wait(epoll_fd, &event, 1, 1000);
+    if (rc != 1 || event.data.fd != fd || event.events != expected) {
+        fprintf(stderr, "FAIL: %s: rc=%d fd=%d events=%x, expected fd=%d events=%x\n", what, rc, event.data.fd, event.events, fd, expected);
+        ++s_failures;
+        return;
+    }
+    printf("PASS: %s\n", what);
+}
+
+static void add(int epoll_fd, int fd, uint32_t events)
+{
+    epoll_event event {};
+    event.events = events;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        perror("epoll_ctl");
+        exit(1);
+    }
+}
+
+static int s_pipe_fds[2];
+
+int main(int, char**)
+{
+    // The read end of a pipe whose writer went away is readable (EOF) and hung up.
+    {
+        int epoll_fd = epoll_create1(0);
+        int fds[2];
+        if (epoll_fd < 0 || pipe(fds) < 0) {
+            perror("setup");
+            return 1;
+        }
+        add(epoll_fd, fds[0], EPOLLIN);
+        close(fds[1]);
+        expect_events(epoll_fd, fds[0], EPOLLIN | EPOLLHUP, "pipe reader sees EPOLLHUP");
+        close(fds[0]);
+        close(epoll_fd);
+    }
+
+    // The write end of a pipe whose reader went away reports an error, even when only EPOLLIN was asked for.
+    {
+        int epoll_fd = epoll_create1(0);
+        int fds[2];
+        if (epoll_fd < 0 || pipe(fds) < 0) {
+            perror("setup");
+            return 1;
+        }
+        add(epoll_fd, fds[1], EPOLLIN);
+        close(fds[0]);
+        expect_events(epoll_fd, fds[1], EPOLLERR, "pipe writer sees EPOLLERR");
+        close(fds[1]);
+        close(epoll_fd);
+    }
+
+    // Closing watched descriptors while another thread is harvesting must not
+    // make the harvester look at a description that's gone.
+    {
+        int epoll_fd = epoll_create1(0);
+        if (epoll_fd < 0) {
+            perror("epoll_create1");
+            return 1;
+        }
+        for (int i = 0; i < 1000; ++i) {
+            if (pipe(s_pipe_fds) < 0) {
+                perror("pipe");
+                return 1;
+            }
+            add(epoll_fd, s_pipe_fds[0], EPOLLIN);
+            add(epoll_fd, s_pipe_fds[1], EPOLLOUT);
+
+            pthread_t tid;
+            pthread_create(
+                &tid, nullptr, [](void*) -> void* {
+                    close(s_pipe_fds[1]);
+                    close(s_pipe_fds[0]);
+                    return nullptr;
+                },
+                nullptr);
+
+            epoll_event events[2];
+            for (int j = 0; j < 10; ++j) {
+                if (epoll_wait(epoll_fd, events, 2, 0) < 0) {
+                    perror("epoll_wait");
+                    return 1;
+                }
+            }
+            pthread_join(tid, nullptr);
+        }
+        close(epoll_fd);
+        printf("PASS: closing during harvest\n");
+    }
+
+    return s_failures ? 1 : 0;
+}
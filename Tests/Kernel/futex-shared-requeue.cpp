@@ -0,0 +1,76 @@
+#include <serenity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// A futex in a MAP_SHARED region must be wakeable from another process,
+// and FUTEX_CMP_REQUEUE must move waiters without waking them.
+
+struct Shared {
+    int32_t ready;
+    int32_t word;
+    int32_t other_word;
+};
+
+int main(int, char**)
+{
+    auto* shared = (Shared*)mmap(nullptr, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, 0, 0);
+    if (shared == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+
+    pid_t child = fork();
+    if (child < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (child == 0) {
+        __atomic_store_n(&shared->ready, 1, __ATOMIC_SEQ_CST);
+        int rc = futex(&shared->word, FUTEX_WAIT, 0, nullptr, nullptr, 0);
+        if (rc != 0) {
+            perror("Child: FUTEX_WAIT");
+            _exit(1);
+        }
+        printf("Child: woke up from shared futex\n");
+        _exit(0);
+    }
+
+    while (!__atomic_load_n(&shared->ready, __ATOMIC_SEQ_CST))
+        usleep(1000);
+    usleep(100000);
+
+    int failures = 0;
+
+    // Nobody should be waiting on the second word; move the child there, then wake it.
+    int rc = futex(&shared->word, FUTEX_CMP_REQUEUE, 0, (const struct timespec*)1, &shared->other_word, 0);
+    if (rc != 1) {
+        fprintf(stderr, "FAIL: FUTEX_CMP_REQUEUE returned %d, expected 1\n", rc);
+        ++failures;
+    }
+    rc = futex(&shared->other_word, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+    if (rc != 1) {
+        fprintf(stderr, "FAIL: FUTEX_WAKE on requeue target returned %d, expected 1\n", rc);
+        ++failures;
+        // Don't leave the child stuck if it's still on either queue.
+        futex(&shared->word, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+        futex(&shared->other_word, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+    }
+
+    int status = 0;
+    if (waitpid(child, &status, 0) < 0) {
+        perror("waitpid");
+        return 1;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "FAIL: child exited with status %d\n", status);
+        ++failures;
+    }
+
+    if (failures)
+        return 1;
+    printf("PASS\n");
+    return 0;
+}
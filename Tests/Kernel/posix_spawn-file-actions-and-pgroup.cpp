@@ -0,0 +1,86 @@
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// posix_spawn() must apply file actions to the child only, honor POSIX_SPAWN_SETPGROUP,
+// and hand back a pid that waitpid() can reap like any other child.
+
+static const char* output_path = "/tmp/posix_spawn-test-output";
+
+int main(int, char**)
+{
+    unlink(output_path);
+    bool parent_had_fd_3 = fcntl(3, F_GETFD) >= 0;
+
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init(&file_actions);
+    posix_spawn_file_actions_addopen(&file_actions, 3, output_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    posix_spawn_file_actions_adddup2(&file_actions, 3, STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&file_actions, 3);
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+    posix_spawnattr_setpgroup(&attr, 0);
+
+    const char* argv[] = { "/bin/echo", "spawned", nullptr };
+    pid_t child;
+    int rc = posix_spawn(&child, "/bin/echo", &file_actions, &attr, const_cast<char**>(argv), environ);
+    posix_spawn_file_actions_destroy(&file_actions);
+    posix_spawnattr_destroy(&attr);
+    if (rc != 0) {
+        fprintf(stderr, "FAIL: posix_spawn: %s\n", strerror(rc));
+        return 1;
+    }
+
+    int failures = 0;
+
+    // The child stays around as a zombie until we reap it, so its pgid can still be queried.
+    pid_t child_pgid = getpgid(child);
+    if (child_pgid != child) {
+        fprintf(stderr, "FAIL: child pgid is %d, expected %d\n", child_pgid, child);
+        ++failures;
+    }
+    if (getpgid(0) == child) {
+        fprintf(stderr, "FAIL: parent moved into the child's process group\n");
+        ++failures;
+    }
+    if (!parent_had_fd_3 && fcntl(3, F_GETFD) >= 0) {
+        fprintf(stderr, "FAIL: file action opened fd 3 in the parent\n");
+        ++failures;
+    }
+
+    int status = 0;
+    if (waitpid(child, &status, 0) != child) {
+        perror("waitpid");
+        return 1;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "FAIL: child exited with status %d\n", status);
+        ++failures;
+    }
+
+    char buffer[32] = {};
+    int fd = open(output_path, O_RDONLY);
+    if (fd < 0) {
+        perror("open");
+        return 1;
+    }
+    ssize_t nread = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    unlink(output_path);
+    if (nread < 0 || strcmp(buffer, "spawned\n") != 0) {
+        fprintf(stderr, "FAIL: child wrote '%s', expected 'spawned\\n'\n", buffer);
+        ++failures;
+    }
+
+    if (failures) {
+        printf("FAIL: %d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
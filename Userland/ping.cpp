@@ -24,6 +24,7 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <AK/InternetChecksum.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <netinet/in.h>
@@ -37,17 +38,9 @@
 
 uint16_t internet_checksum(const void* ptr, size_t count)
 {
-    uint32_t checksum = 0;
-    auto* w = (const uint16_t*)ptr;
-    while (count > 1) {
-        checksum += ntohs(*w++);
-        if (checksum & 0x80000000)
-            checksum = (checksum & 0xffff) | (checksum >> 16);
-        count -= 2;
-    }
-    while (checksum >> 16)
-        checksum = (checksum & 0xffff) + (checksum >> 16);
-    return htons(~checksum);
+    InternetChecksum checksum;
+    checksum.add(ptr, count);
+    return checksum.finish();
 }
 
 int main(int argc, char** argv)
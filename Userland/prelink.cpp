@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <LibELF/DynamicLoader.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Libraries are laid out upwards from here, well clear of where mmap() hands out memory by default.
+static const u32 default_base_address = 0x60000000;
+
+int main(int argc, char** argv)
+{
+    const char* base_address_string = nullptr;
+    bool remove = false;
+    Vector<const char*> libraries;
+
+    Core::ArgsParser args_parser;
+    args_parser.add_option(base_address_string, "Address to place the first library at", "base", 'b', "address");
+    args_parser.add_option(remove, "Remove prelink images instead of creating them", "remove", 'r');
+    args_parser.add_positional_argument(libraries, "Shared libraries to prelink", "libraries");
+    args_parser.parse(argc, argv);
+
+    u32 base_address = default_base_address;
+    if (base_address_string)
+        base_address = strtoul(base_address_string, nullptr, 0);
+    if (base_address % PAGE_SIZE) {
+        fprintf(stderr, "prelink: Base address must be page aligned\n");
+        return 1;
+    }
+
+    int status = 0;
+    for (auto* library : libraries) {
+        auto prelink_path = ELF::DynamicLoader::prelink_path_for(library);
+        if (remove) {
+            if (unlink(prelink_path.characters()) < 0 && errno != ENOENT) {
+                perror(prelink_path.characters());
+                status = 1;
+            }
+            continue;
+        }
+
+        int fd = open(library, O_RDONLY);
+        if (fd < 0) {
+            perror(library);
+            status = 1;
+            continue;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) < 0) {
+            perror("fstat");
+            close(fd);
+            status = 1;
+            continue;
+        }
+
+        auto loader = ELF::DynamicLoader::construct(library, fd, st.st_size);
+        if (!loader->is_valid() || !loader->prelink(VirtualAddress(base_address), prelink_path.characters())) {
+            fprintf(stderr, "prelink: Could not prelink %s at %#08x\n", library, base_address);
+            close(fd);
+            status = 1;
+            continue;
+        }
+        close(fd);
+
+        printf("%s: %#08x-%#08x\n", library, base_address, base_address + (u32)loader->loaded_size());
+
+        // Leave a guard page between libraries.
+        base_address += (loader->loaded_size() + PAGE_SIZE + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+    }
+
+    return status;
+}
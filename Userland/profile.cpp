@@ -38,29 +38,33 @@ int main(int argc, char** argv)
     const char* cmd_argument = nullptr;
     bool enable = false;
     bool disable = false;
+    bool all_processes = false;
+    int samples_per_second = 0;
 
     args_parser.add_option(pid_argument, "Target PID", nullptr, 'p', "PID");
+    args_parser.add_option(all_processes, "Target all processes and kernel threads", nullptr, 'a');
+    args_parser.add_option(samples_per_second, "Samples per second", nullptr, 'f', "frequency");
     args_parser.add_option(enable, "Enable", nullptr, 'e');
     args_parser.add_option(disable, "Disable", nullptr, 'd');
     args_parser.add_option(cmd_argument, "Command", nullptr, 'c', "command");
 
     args_parser.parse(argc, argv);
 
-    if (!pid_argument && !cmd_argument) {
+    if (!pid_argument && !cmd_argument && !all_processes) {
         args_parser.print_usage(stdout, argv[0]);
         return 0;
     }
 
-    if (pid_argument) {
+    if (pid_argument || all_processes) {
         if (!(enable ^ disable)) {
-            fprintf(stderr, "-p <PID> requires -e xor -d.\n");
+            fprintf(stderr, "-p <PID> and -a require -e xor -d.\n");
             return 1;
         }
 
-        pid_t pid = atoi(pid_argument);
+        pid_t pid = all_processes ? PROFILE_ALL_PROCESSES : atoi(pid_argument);
 
         if (enable) {
-            if (profiling_enable(pid) < 0) {
+            if (profiling_enable_with_frequency(pid, samples_per_second) < 0) {
                 perror("profiling_enable");
                 return 1;
             }
@@ -84,7 +88,7 @@ int main(int argc, char** argv)
     cmd_argv.append(nullptr);
 
     dbg() << "Enabling profiling for PID " << getpid();
-    profiling_enable(getpid());
+    profiling_enable_with_frequency(getpid(), samples_per_second);
     if (execvp(cmd_argv[0], const_cast<char**>(cmd_argv.data())) < 0) {
         perror("execv");
         return 1;
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2020, the SerenityOS developers.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <AK/String.h>
+#include <AK/Time.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <dlfcn.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Measures how long it takes from spawning a program until it has exited, which for a
+// program that exits right away is dominated by exec and loading. With --libraries, the
+// program spawned is this one, in a mode where it only dlopen()s the given libraries.
+// Running this before and after prelink(1) shows what prelinking saves.
+
+extern char** environ;
+
+static u64 microseconds_between(const timespec& start, const timespec& end)
+{
+    timespec elapsed;
+    timespec_sub(end, start, elapsed);
+    return (u64)elapsed.tv_sec * 1000000 + elapsed.tv_nsec / 1000;
+}
+
+static int load_libraries(const Vector<const char*>& libraries)
+{
+    for (auto* library : libraries) {
+        if (!dlopen(library, RTLD_LAZY | RTLD_GLOBAL)) {
+            fprintf(stderr, "dlopen(%s): %s\n", library, dlerror());
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static bool run_once(Vector<const char*>& arguments, u64& microseconds)
+{
+    timespec start;
+    timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    pid_t pid;
+    int rc = posix_spawnp(&pid, arguments[0], nullptr, nullptr, const_cast<char**>(arguments.data()), environ);
+    if (rc != 0) {
+        fprintf(stderr, "posix_spawnp(%s): %s\n", arguments[0], strerror(rc));
+        return false;
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) < 0) {
+        perror("waitpid");
+        return false;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    microseconds = microseconds_between(start, end);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "%s did not exit cleanly\n", arguments[0]);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    int runs = 20;
+    bool libraries_mode = false;
+    bool load_only = false;
+    Vector<const char*> arguments;
+
+    Core::ArgsParser args_parser;
+    args_parser.add_option(runs, "Number of runs", "runs", 'n', "count");
+    args_parser.add_option(libraries_mode, "Time loading the given shared libraries instead of running a command", "libraries", 'l');
+    args_parser.add_option(load_only, "Load the given shared libraries and exit (used internally)", "load-only", 0);
+    args_parser.add_positional_argument(arguments, "Command to run, or libraries to load", "arguments");
+    args_parser.parse(argc, argv);
+
+    if (load_only)
+        return load_libraries(arguments);
+
+    if (libraries_mode) {
+        arguments.prepend("--load-only");
+        arguments.prepend(argv[0]);
+    }
+    arguments.append(nullptr);
+
+    if (runs <= 0) {
+        fprintf(stderr, "startup_benchmark: Need at least one run\n");
+        return 1;
+    }
+
+    u64 total = 0;
+    u64 fastest = 0;
+    u64 slowest = 0;
+    for (int i = 0; i < runs; ++i) {
+        u64 microseconds;
+        if (!run_once(arguments, microseconds))
+            return 1;
+        total += microseconds;
+        if (i == 0 || microseconds < fastest)
+            fastest = microseconds;
+        if (microseconds > slowest)
+            slowest = microseconds;
+    }
+
+    printf("%d runs: average %llu us, fastest %llu us, slowest %llu us\n", runs, total / runs, fastest, slowest);
+    return 0;
+}
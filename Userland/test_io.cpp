@@ -27,8 +27,10 @@
 #include <AK/Assertions.h>
 #include <AK/LogStream.h>
 #include <AK/Types.h>
+#include <Kernel/API/IORing.h>
 #include <LibCore/File.h>
 #include <fcntl.h>
+#include <serenity.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/mman.h>
@@ -294,6 +296,135 @@ void test_writev()
     close(pipefds[1]);
 }
 
+void test_positional_and_vectored_io()
+{
+    int fd = open("/tmp/pio", O_CREAT | O_TRUNC | O_RDWR, 0600);
+    ASSERT(fd >= 0);
+
+    int rc = pwrite(fd, "Friends", 7, 5);
+    ASSERT(rc == 7);
+    rc = pwrite(fd, "Hello", 5, 0);
+    ASSERT(rc == 5);
+    if (lseek(fd, 0, SEEK_CUR) != 0) {
+        fprintf(stderr, "Expected pwrite() to leave the file offset alone\n");
+        ASSERT_NOT_REACHED();
+    }
+
+    char buffer[16];
+    rc = pread(fd, buffer, 7, 5);
+    if (rc != 7 || memcmp(buffer, "Friends", 7)) {
+        fprintf(stderr, "Didn't read the expected data with pread\n");
+        ASSERT_NOT_REACHED();
+    }
+
+    char hello[5];
+    char friends[7];
+    iovec iov[2];
+    iov[0].iov_base = hello;
+    iov[0].iov_len = sizeof(hello);
+    iov[1].iov_base = friends;
+    iov[1].iov_len = sizeof(friends);
+    rc = preadv(fd, iov, 2, 0);
+    if (rc != 12 || memcmp(hello, "Hello", 5) || memcmp(friends, "Friends", 7)) {
+        fprintf(stderr, "Didn't read the expected data with preadv\n");
+        ASSERT_NOT_REACHED();
+    }
+
+    rc = readv(fd, iov, 2);
+    if (rc != 12 || lseek(fd, 0, SEEK_CUR) != 12) {
+        fprintf(stderr, "Expected readv() to read 12 bytes and advance the file offset\n");
+        ASSERT_NOT_REACHED();
+    }
+
+    iov[0].iov_base = const_cast<void*>((const void*)"Howdy");
+    iov[1].iov_base = const_cast<void*>((const void*)"Pardner");
+    rc = pwritev(fd, iov, 2, 12);
+    ASSERT(rc == 12);
+    rc = pread(fd, buffer, sizeof(buffer), 12);
+    if (rc != 12 || memcmp(buffer, "HowdyPardner", 12)) {
+        fprintf(stderr, "Didn't read the expected data back after pwritev\n");
+        ASSERT_NOT_REACHED();
+    }
+
+    int pipefds[2];
+    pipe(pipefds);
+    rc = pread(pipefds[0], buffer, 1, 0);
+    if (rc >= 0 || errno != ESPIPE) {
+        fprintf(stderr, "Expected ESPIPE when trying to pread from a pipe\n");
+        ASSERT_NOT_REACHED();
+    }
+    close(pipefds[0]);
+    close(pipefds[1]);
+
+    close(fd);
+    unlink("/tmp/pio");
+}
+
+void test_io_ring()
+{
+    size_t mapping_size = 0;
+    int ring_fd = io_ring_setup(8, &mapping_size);
+    ASSERT(ring_fd >= 0);
+    auto* mapping = (u8*)mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring_fd, 0);
+    ASSERT(mapping != MAP_FAILED);
+    auto& header = *(IORingHeader*)mapping;
+    auto* submissions = (IORingSubmission*)(mapping + header.submissions_offset);
+    auto* completions = (IORingCompletion*)(mapping + header.completions_offset);
+
+    int pipefds[2];
+    pipe(pipefds);
+
+    auto submit = [&](IORingOpcode opcode, int fd, void* buffer, u32 length) {
+        auto& submission = submissions[header.submission_tail & header.submission_mask];
+        memset(&submission, 0, sizeof(submission));
+        submission.user_data = (u64)opcode;
+        submission.opcode = opcode;
+        submission.fd = fd;
+        submission.buffer = buffer;
+        submission.length = length;
+        submission.offset = -1;
+        ++header.submission_tail;
+    };
+
+    char buffer[8] {};
+    submit(IORingOpcode::Nop, -1, nullptr, 0);
+    submit(IORingOpcode::Read, pipefds[0], buffer, sizeof(buffer));
+    submit(IORingOpcode::Write, pipefds[1], const_cast<char*>("Ring!"), 5);
+
+    int rc = io_ring_enter(ring_fd, 3, 3);
+    if (rc != 3 || header.completion_tail - header.completion_head != 3) {
+        fprintf(stderr, "Expected 3 submissions and 3 completions from io_ring_enter, got rc=%d\n", rc);
+        ASSERT_NOT_REACHED();
+    }
+
+    for (; header.completion_head != header.completion_tail; ++header.completion_head) {
+        auto& completion = completions[header.completion_head & header.completion_mask];
+        auto opcode = (IORingOpcode)completion.user_data;
+        i32 expected_result = opcode == IORingOpcode::Nop ? 0 : 5;
+        if (completion.result != expected_result) {
+            fprintf(stderr, "Expected result %d for opcode %d, got %d\n", expected_result, (int)opcode, completion.result);
+            ASSERT_NOT_REACHED();
+        }
+    }
+    if (memcmp(buffer, "Ring!", 5)) {
+        fprintf(stderr, "Didn't read the expected data through the ring\n");
+        ASSERT_NOT_REACHED();
+    }
+
+    submit(IORingOpcode::Read, 1234, buffer, sizeof(buffer));
+    rc = io_ring_enter(ring_fd, 1, 1);
+    auto& completion = completions[header.completion_head++ & header.completion_mask];
+    if (rc != 1 || completion.result != -EBADF) {
+        fprintf(stderr, "Expected EBADF for a read from a bad fd through the ring\n");
+        ASSERT_NOT_REACHED();
+    }
+
+    close(pipefds[0]);
+    close(pipefds[1]);
+    munmap(mapping, mapping_size);
+    close(ring_fd);
+}
+
 void test_rmdir_root()
 {
     int rc = rmdir("/");
@@ -329,6 +460,8 @@ int main(int, char**)
     test_eoverflow();
     test_rmdir_while_inside_dir();
     test_writev();
+    test_positional_and_vectored_io();
+    test_io_ring();
     test_rmdir_root();
 
     EXPECT_ERROR_2(EPERM, link, "/", "/home/anon/lolroot");
@@ -138,11 +138,6 @@ int main(int, char**)
         return 1;
     }
 
-    if (unveil("/proc/all", "r") < 0) {
-        perror("unveil");
-        return 1;
-    }
-
     if (unveil("/etc/passwd", "r") < 0) {
         perror("unveil");
         return 1;